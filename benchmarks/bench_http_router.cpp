@@ -0,0 +1,62 @@
+#include <http/http_router.hpp>
+
+#include <string>
+#include <vector>
+#include <chrono>
+#include <iostream>
+
+// Route table shaped like a REST API: static collections, single and
+// nested parameters, and a few catch-alls.
+constexpr int RESOURCE_COUNT = 300;
+constexpr size_t LOOKUPS = 5'000'000;
+
+int main()
+{
+    using namespace ouc_server::http;
+
+    HttpRouter router;
+    std::vector<std::string> paths;
+    size_t route_count = 0;
+
+    auto noop = [](HttpRequest &, HttpResponseWriter &, const HttpRouteParams &) {};
+    for (int i = 0; i < RESOURCE_COUNT; ++i)
+    {
+        std::string base = "/api/v1/resource" + std::to_string(i);
+        router.add(HttpMethodType::Get, base, noop);
+        router.add(HttpMethodType::Get, base + "/:id", noop);
+        router.add(HttpMethodType::Get, base + "/:id/items/:item", noop);
+        router.add(HttpMethodType::Post, base, noop);
+        route_count += 4;
+
+        paths.push_back(base);
+        paths.push_back(base + "/12345");
+        paths.push_back(base + "/12345/items/678");
+    }
+    for (int i = 0; i < 16; ++i)
+    {
+        router.add(HttpMethodType::Get, "/static" + std::to_string(i) + "/*path", noop);
+        paths.push_back("/static" + std::to_string(i) + "/js/app.min.js");
+        ++route_count;
+    }
+    router.freeze();
+
+    HttpRouteParams params;
+    size_t matched = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < LOOKUPS; ++i)
+    {
+        const std::string &path = paths[(i * 7919) % paths.size()];
+        if (router.lookup(HttpMethodType::Get, path, params) != nullptr)
+            ++matched;
+    }
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "routes:       " << route_count << "\n"
+              << "nodes:        " << router.get_node_count() << "\n"
+              << "lookups:      " << LOOKUPS << " (" << matched << " matched)\n"
+              << "lookups/sec:  " << static_cast<size_t>(LOOKUPS / elapsed) << "\n"
+              << "ns/lookup:    " << elapsed * 1e9 / LOOKUPS << "\n";
+
+    return matched == LOOKUPS ? 0 : 1;
+}
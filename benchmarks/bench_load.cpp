@@ -0,0 +1,497 @@
+// Load generator for TCPServer and HttpServer.
+//
+// Starts the server in-process on loopback (or targets an already running
+// one with --spawn=0) and drives it from several client threads, each with
+// its own epoll instance and a share of the connections. Every connection
+// keeps --pipeline requests in flight; latency is measured from the moment
+// a request is queued until its reply is complete.
+//
+//   ./bench_load --mode=http --connections=64 --threads=4 --pipeline=4
+//                --payload=128 --response=1024 --duration=10 --warmup=2
+//
+// Built with -DOUC_SERVER_TRACE=ON, --trace=out.json saves a Chrome trace
+// of the server hot path.
+
+#include <server/tcp_server.hpp>
+#include <server/http_server.hpp>
+#include <utils/histogram.hpp>
+#include <utils/trace.hpp>
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <iostream>
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    struct BenchConfig
+    {
+        std::string mode = "http"; ///< "tcp" echo or "http" request/response.
+        std::string host = "127.0.0.1";
+        uint16_t port = 18090;
+        bool spawn = true;       ///< Run the server in this process.
+        size_t server_tasks = 8; ///< Worker threads of the spawned server.
+        size_t busy_poll = 0;    ///< Spawned server loop spin window in us.
+        size_t connections = 64;
+        size_t threads = 4;       ///< Client threads.
+        size_t pipeline = 1;      ///< Requests in flight per connection.
+        size_t payload = 64;      ///< Request (tcp message / http body) size.
+        size_t response = 64;     ///< HTTP response body size.
+        double duration = 5.0;    ///< Measured seconds.
+        double warmup = 1.0;      ///< Seconds discarded before measuring.
+        bool json = false;        ///< Print a JSON summary for scripts.
+        std::string trace;        ///< Chrome trace output, needs -DOUC_SERVER_TRACE=ON.
+    };
+
+    struct ThreadResult
+    {
+        ouc_server::utils::Histogram latency;
+        uint64_t completed = 0;
+        uint64_t bytes_out = 0;
+        uint64_t bytes_in = 0;
+        uint64_t errors = 0;
+    };
+
+    struct Connection
+    {
+        int fd = -1;
+        std::string out; ///< Bytes not yet written.
+        size_t out_offset = 0;
+        std::deque<Clock::time_point> inflight;
+        std::string in;    ///< HTTP: unparsed response bytes.
+        size_t echoed = 0; ///< TCP: bytes of the oldest request echoed so far.
+        bool want_write = false;
+    };
+
+    bool parse_args(int argc, char **argv, BenchConfig &config)
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            std::string arg = argv[i];
+            if (arg.rfind("--", 0) != 0)
+            {
+                std::cerr << "bad argument: " << arg << "\n";
+                return false;
+            }
+
+            // A bare --flag means --flag=1
+            auto eq = arg.find('=');
+            std::string key = arg.substr(2, eq == std::string::npos ? std::string::npos : eq - 2);
+            std::string val = eq == std::string::npos ? "1" : arg.substr(eq + 1);
+
+            if (key == "mode")
+                config.mode = val;
+            else if (key == "host")
+                config.host = val;
+            else if (key == "port")
+                config.port = static_cast<uint16_t>(std::stoul(val));
+            else if (key == "spawn")
+                config.spawn = val != "0";
+            else if (key == "server-tasks")
+                config.server_tasks = std::stoul(val);
+            else if (key == "connections")
+                config.connections = std::stoul(val);
+            else if (key == "threads")
+                config.threads = std::stoul(val);
+            else if (key == "pipeline")
+                config.pipeline = std::stoul(val);
+            else if (key == "payload")
+                config.payload = std::stoul(val);
+            else if (key == "response")
+                config.response = std::stoul(val);
+            else if (key == "duration")
+                config.duration = std::stod(val);
+            else if (key == "warmup")
+                config.warmup = std::stod(val);
+            else if (key == "busy-poll")
+                config.busy_poll = std::stoul(val);
+            else if (key == "json")
+                config.json = val != "0";
+            else if (key == "trace")
+                config.trace = val;
+            else
+            {
+                std::cerr << "unknown option: --" << key << "\n";
+                return false;
+            }
+        }
+
+        if (config.mode != "tcp" && config.mode != "http")
+        {
+            std::cerr << "--mode must be tcp or http\n";
+            return false;
+        }
+        if (config.mode == "tcp" && config.payload == 0)
+            config.payload = 1;
+        config.threads = std::max<size_t>(1, std::min(config.threads, config.connections));
+        config.pipeline = std::max<size_t>(1, config.pipeline);
+        return true;
+    }
+
+    int connect_to(const BenchConfig &config)
+    {
+        int fd = socket(AF_INET, SOCK_STREAM, 0);
+        if (fd < 0)
+            return -1;
+
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(config.port);
+        inet_pton(AF_INET, config.host.c_str(), &addr.sin_addr);
+        if (connect(fd, (sockaddr *)&addr, sizeof(addr)) < 0)
+        {
+            close(fd);
+            return -1;
+        }
+
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+        return fd;
+    }
+
+    /// Pop replies completed by the bytes in conn, returns how many.
+    size_t consume_replies(const BenchConfig &config, Connection &conn, const char *data, size_t len)
+    {
+        size_t done = 0;
+        if (config.mode == "tcp")
+        {
+            conn.echoed += len;
+            while (conn.echoed >= config.payload && !conn.inflight.empty())
+            {
+                conn.echoed -= config.payload;
+                ++done;
+            }
+            return done;
+        }
+
+        conn.in.append(data, len);
+        size_t pos = 0;
+        while (true)
+        {
+            size_t head_end = conn.in.find("\r\n\r\n", pos);
+            if (head_end == std::string::npos)
+                break;
+
+            size_t body_len = 0;
+            size_t cl = conn.in.find("Content-Length: ", pos);
+            if (cl != std::string::npos && cl < head_end)
+                body_len = std::strtoul(conn.in.c_str() + cl + 16, nullptr, 10);
+
+            size_t end = head_end + 4 + body_len;
+            if (end > conn.in.size())
+                break;
+            pos = end;
+            ++done;
+        }
+        conn.in.erase(0, pos);
+        return done;
+    }
+
+    void run_client(const BenchConfig &config, size_t conn_count, const std::string &request,
+                    Clock::time_point measure_from, Clock::time_point stop_at,
+                    ThreadResult &result)
+    {
+        int epfd = epoll_create1(0);
+        std::vector<Connection> conns(conn_count);
+        bool measuring = false; ///< Past warmup, refreshed once per wakeup.
+
+        auto queue_requests = [&](Connection &conn)
+        {
+            while (conn.inflight.size() < config.pipeline)
+            {
+                conn.out.append(request);
+                conn.inflight.push_back(Clock::now());
+            }
+        };
+
+        auto flush = [&](Connection &conn, size_t idx)
+        {
+            while (conn.out_offset < conn.out.size())
+            {
+                ssize_t n = send(conn.fd, conn.out.data() + conn.out_offset,
+                                 conn.out.size() - conn.out_offset, MSG_NOSIGNAL);
+                if (n < 0)
+                {
+                    if (errno == EAGAIN || errno == EWOULDBLOCK)
+                        break;
+                    ++result.errors;
+                    return;
+                }
+                conn.out_offset += n;
+                if (measuring)
+                    result.bytes_out += n;
+            }
+            if (conn.out_offset == conn.out.size())
+            {
+                conn.out.clear();
+                conn.out_offset = 0;
+            }
+
+            bool want_write = !conn.out.empty();
+            if (want_write != conn.want_write)
+            {
+                epoll_event ev{};
+                ev.events = EPOLLIN | (want_write ? uint32_t(EPOLLOUT) : 0u);
+                ev.data.u64 = idx;
+                epoll_ctl(epfd, EPOLL_CTL_MOD, conn.fd, &ev);
+                conn.want_write = want_write;
+            }
+        };
+
+        for (size_t i = 0; i < conn_count; ++i)
+        {
+            conns[i].fd = connect_to(config);
+            if (conns[i].fd < 0)
+            {
+                ++result.errors;
+                continue;
+            }
+            epoll_event ev{};
+            ev.events = EPOLLIN;
+            ev.data.u64 = i;
+            epoll_ctl(epfd, EPOLL_CTL_ADD, conns[i].fd, &ev);
+
+            queue_requests(conns[i]);
+            flush(conns[i], i);
+        }
+
+        std::vector<epoll_event> events(256);
+        std::vector<char> buf(64 * 1024);
+        while (Clock::now() < stop_at)
+        {
+            int n = epoll_wait(epfd, events.data(), static_cast<int>(events.size()), 10);
+            measuring = Clock::now() >= measure_from;
+            for (int i = 0; i < n; ++i)
+            {
+                size_t idx = events[i].data.u64;
+                Connection &conn = conns[idx];
+
+                if (events[i].events & EPOLLOUT)
+                    flush(conn, idx);
+
+                if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR))
+                {
+                    while (true)
+                    {
+                        ssize_t r = recv(conn.fd, buf.data(), buf.size(), 0);
+                        if (r <= 0)
+                        {
+                            if (r == 0 || (errno != EAGAIN && errno != EWOULDBLOCK))
+                            {
+                                ++result.errors;
+                                epoll_ctl(epfd, EPOLL_CTL_DEL, conn.fd, nullptr);
+                            }
+                            break;
+                        }
+                        if (measuring)
+                            result.bytes_in += r;
+
+                        size_t done = consume_replies(config, conn, buf.data(), r);
+                        auto now = Clock::now();
+                        for (size_t k = 0; k < done && !conn.inflight.empty(); ++k)
+                        {
+                            if (measuring)
+                            {
+                                auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(now - conn.inflight.front()).count();
+                                result.latency.record(static_cast<uint64_t>(ns));
+                                ++result.completed;
+                            }
+                            conn.inflight.pop_front();
+                        }
+                    }
+
+                    queue_requests(conn);
+                    flush(conn, idx);
+                }
+            }
+        }
+
+        for (auto &conn : conns)
+            if (conn.fd >= 0)
+                close(conn.fd);
+        close(epfd);
+    }
+
+    std::string build_request(const BenchConfig &config)
+    {
+        if (config.mode == "tcp")
+            return std::string(config.payload, 'x');
+
+        if (config.payload == 0)
+            return "GET /bench HTTP/1.1\r\nHost: bench\r\n\r\n";
+        return "POST /bench HTTP/1.1\r\nHost: bench\r\nContent-Length: " +
+               std::to_string(config.payload) + "\r\n\r\n" + std::string(config.payload, 'x');
+    }
+
+    void print_report(const BenchConfig &config, const ThreadResult &total, double seconds)
+    {
+        using ouc_server::utils::Histogram;
+        const Histogram &h = total.latency;
+        double rps = total.completed / seconds;
+        double mbps = (total.bytes_in + total.bytes_out) / seconds / (1024.0 * 1024.0);
+
+        if (config.json)
+        {
+            std::printf(
+                "{\"mode\":\"%s\",\"connections\":%zu,\"threads\":%zu,\"pipeline\":%zu,"
+                "\"payload\":%zu,\"response\":%zu,\"seconds\":%.3f,\"requests\":%llu,"
+                "\"errors\":%llu,\"rps\":%.1f,\"mib_per_sec\":%.2f,"
+                "\"latency_ns\":{\"min\":%llu,\"mean\":%.0f,\"p50\":%llu,\"p90\":%llu,"
+                "\"p99\":%llu,\"p999\":%llu,\"max\":%llu}}\n",
+                config.mode.c_str(), config.connections, config.threads, config.pipeline,
+                config.payload, config.response, seconds,
+                (unsigned long long)total.completed, (unsigned long long)total.errors, rps, mbps,
+                (unsigned long long)h.min(), h.mean(),
+                (unsigned long long)h.percentile(50), (unsigned long long)h.percentile(90),
+                (unsigned long long)h.percentile(99), (unsigned long long)h.percentile(99.9),
+                (unsigned long long)h.max());
+            return;
+        }
+
+        std::printf("mode=%s connections=%zu threads=%zu pipeline=%zu payload=%zu response=%zu\n",
+                    config.mode.c_str(), config.connections, config.threads, config.pipeline,
+                    config.payload, config.response);
+        std::printf("requests:    %llu in %.2fs (%llu errors)\n",
+                    (unsigned long long)total.completed, seconds, (unsigned long long)total.errors);
+        std::printf("throughput:  %.0f req/s, %.2f MiB/s\n", rps, mbps);
+        std::printf("latency us:  min %.1f  mean %.1f  p50 %.1f  p90 %.1f  p99 %.1f  p99.9 %.1f  max %.1f\n",
+                    h.min() / 1e3, h.mean() / 1e3, h.percentile(50) / 1e3, h.percentile(90) / 1e3,
+                    h.percentile(99) / 1e3, h.percentile(99.9) / 1e3, h.max() / 1e3);
+
+        // Coarse distribution: one row per power of two
+        std::printf("distribution:\n");
+        for (size_t base = 0; base < Histogram::BUCKET_COUNT; base += Histogram::SUB_BUCKET_COUNT)
+        {
+            uint64_t n = 0;
+            for (size_t i = base; i < base + Histogram::SUB_BUCKET_COUNT; ++i)
+                n += h.bucket_count(i);
+            if (n == 0)
+                continue;
+
+            int width = static_cast<int>(50.0 * n / h.count());
+            std::printf("  <= %10.1f us %10llu |%s\n",
+                        Histogram::upper_bound_of(base + Histogram::SUB_BUCKET_COUNT - 1) / 1e3,
+                        (unsigned long long)n, std::string(width, '#').c_str());
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    using namespace ouc_server::server;
+    using namespace ouc_server::ouc_socket;
+    using namespace ouc_server::http;
+
+    BenchConfig config;
+    if (!parse_args(argc, argv, config))
+        return 1;
+
+    std::unique_ptr<TCPServer> tcp_server;
+    std::unique_ptr<HttpServer> http_server;
+    std::atomic<bool> running{true};
+    std::thread server_thread;
+
+    if (config.spawn)
+    {
+        bool started;
+        if (config.mode == "tcp")
+        {
+            tcp_server = std::make_unique<TCPServer>(config.server_tasks);
+            TCPServer *server = tcp_server.get();
+            server->on_message(
+                [server](TCPSocket &client, const std::string &msg)
+                { server->send(client, msg); });
+            server->set_busy_poll(std::chrono::microseconds(config.busy_poll));
+            started = server->start(config.host, config.port);
+        }
+        else
+        {
+            http_server = std::make_unique<HttpServer>(config.server_tasks);
+            std::string body(config.response, 'y');
+            http_server->on_request(
+                [body](HttpRequest &, HttpResponseWriter &res)
+                { res.end(body); });
+            http_server->tcp_server().set_busy_poll(std::chrono::microseconds(config.busy_poll));
+            started = http_server->start(config.host, config.port);
+        }
+
+        if (!started)
+        {
+            std::cerr << "failed to start server on port " << config.port << "\n";
+            return 1;
+        }
+
+        server_thread = std::thread(
+            [&]()
+            {
+                while (running.load())
+                {
+                    if (tcp_server)
+                        tcp_server->loop(10);
+                    else
+                        http_server->loop(10);
+                }
+            });
+    }
+
+    std::string request = build_request(config);
+    auto start = Clock::now();
+    auto measure_from = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(config.warmup));
+    auto stop_at = measure_from + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(config.duration));
+
+    std::vector<ThreadResult> results(config.threads);
+    std::vector<std::thread> clients;
+    for (size_t t = 0; t < config.threads; ++t)
+    {
+        // Spread connections evenly, the first threads take the remainder
+        size_t share = config.connections / config.threads + (t < config.connections % config.threads ? 1 : 0);
+        clients.emplace_back(
+            [&, t, share]()
+            { run_client(config, share, request, measure_from, stop_at, results[t]); });
+    }
+    for (auto &t : clients)
+        t.join();
+
+    ThreadResult total;
+    for (auto &r : results)
+    {
+        total.latency.merge(r.latency);
+        total.completed += r.completed;
+        total.bytes_in += r.bytes_in;
+        total.bytes_out += r.bytes_out;
+        total.errors += r.errors;
+    }
+    print_report(config, total, config.duration);
+
+    running.store(false);
+    if (server_thread.joinable())
+        server_thread.join();
+
+    if (!config.trace.empty())
+    {
+#ifdef OUC_SERVER_TRACE
+        if (!ouc_server::utils::trace::dump_chrome_json(config.trace))
+            std::cerr << "failed to write " << config.trace << "\n";
+#else
+        std::cerr << "--trace needs a build with -DOUC_SERVER_TRACE=ON\n";
+#endif
+    }
+    return 0;
+}
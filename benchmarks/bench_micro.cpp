@@ -0,0 +1,233 @@
+// Micro-benchmarks of the building blocks: MPMCQueue, ThreadPool and the
+// HTTP parse/serialize paths. See micro_bench.hpp for the options.
+//
+//   ./bench_micro --json > before.json
+
+#include "micro_bench.hpp"
+
+#include <utils/mpmc_queue.hpp>
+#include <utils/thread_pool.hpp>
+#include <utils/histogram.hpp>
+#include <http/http_request.hpp>
+#include <http/http_response.hpp>
+#include <http/http_response_writer.hpp>
+#include <http/http_format.hpp>
+
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <future>
+#include <chrono>
+
+using micro_bench::Clock;
+using micro_bench::MicroBenchState;
+
+namespace
+{
+    constexpr size_t QUEUE_CAPACITY = 1024;
+    constexpr size_t POOL_THREADS = 4;
+
+    const std::string GET_REQUEST =
+        "GET /api/v1/users/12345?fields=name,email HTTP/1.1\r\n"
+        "Host: example.com\r\n"
+        "User-Agent: bench_micro/1.0\r\n"
+        "Accept: application/json\r\n"
+        "Accept-Encoding: gzip, deflate\r\n"
+        "Connection: keep-alive\r\n"
+        "\r\n";
+
+    const std::string POST_REQUEST =
+        "POST /api/v1/users HTTP/1.1\r\n"
+        "Host: example.com\r\n"
+        "Content-Type: application/json\r\n"
+        "Content-Length: 48\r\n"
+        "\r\n"
+        "{\"name\":\"alice\",\"email\":\"alice@example.com\"}\r\n\r\n";
+
+    uint64_t since_ns(Clock::time_point start)
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+    }
+
+    void bench_mpmc_single_thread(MicroBenchState &state)
+    {
+        pjh_std::MPMCQueue<size_t> queue(QUEUE_CAPACITY);
+        state.reset_timer();
+        for (size_t i = 0; i < state.iterations; ++i)
+        {
+            queue.push(size_t(i));
+            micro_bench::do_not_optimize(queue.pop());
+        }
+    }
+
+    /// Move state.iterations items from producers to consumers through one queue.
+    void bench_mpmc_threads(MicroBenchState &state, size_t producers, size_t consumers)
+    {
+        pjh_std::MPMCQueue<size_t> queue(QUEUE_CAPACITY);
+        std::atomic<size_t> ready{0};
+        std::atomic<bool> go{false};
+        std::atomic<size_t> consumed{0};
+        size_t per_producer = std::max<size_t>(1, state.iterations / producers);
+        size_t total = per_producer * producers;
+
+        std::vector<std::thread> threads;
+        for (size_t p = 0; p < producers; ++p)
+            threads.emplace_back(
+                [&, p]()
+                {
+                    micro_bench::pin_thread(static_cast<unsigned>(p + 1));
+                    ready.fetch_add(1);
+                    while (!go.load(std::memory_order_acquire))
+                        ;
+                    for (size_t i = 0; i < per_producer; ++i)
+                        while (!queue.push(size_t(i)))
+                            std::this_thread::yield();
+                });
+        for (size_t c = 0; c < consumers; ++c)
+            threads.emplace_back(
+                [&, c]()
+                {
+                    micro_bench::pin_thread(static_cast<unsigned>(producers + c + 1));
+                    ready.fetch_add(1);
+                    while (!go.load(std::memory_order_acquire))
+                        ;
+                    while (consumed.load(std::memory_order_relaxed) < total)
+                    {
+                        if (queue.pop())
+                            consumed.fetch_add(1, std::memory_order_relaxed);
+                        else
+                            std::this_thread::yield();
+                    }
+                });
+
+        while (ready.load() < producers + consumers)
+            std::this_thread::yield();
+
+        state.reset_timer();
+        go.store(true, std::memory_order_release);
+        for (auto &t : threads)
+            t.join();
+        state.stop_timer();
+    }
+
+    /// Submit trivial tasks, recording how long submit() blocks the caller
+    /// and how long a task waits before a worker starts it.
+    void bench_pool_submit(MicroBenchState &state)
+    {
+        ouc_server::utils::ThreadPool pool(POOL_THREADS);
+        ouc_server::utils::Histogram submit_ns, wait_ns;
+        std::vector<uint64_t> waits(state.iterations);
+        std::vector<std::future<void>> futures;
+        futures.reserve(state.iterations);
+
+        state.reset_timer();
+        for (size_t i = 0; i < state.iterations; ++i)
+        {
+            auto start = Clock::now();
+            futures.push_back(pool.sumbit([start, &waits, i]()
+                                          { waits[i] = since_ns(start); }));
+            submit_ns.record(since_ns(start));
+        }
+        for (auto &f : futures)
+            f.get();
+        state.stop_timer();
+
+        for (auto w : waits)
+            wait_ns.record(w);
+        state.set_counter("submit_p50_ns", static_cast<double>(submit_ns.percentile(50)));
+        state.set_counter("submit_p99_ns", static_cast<double>(submit_ns.percentile(99)));
+        state.set_counter("wait_p50_ns", static_cast<double>(wait_ns.percentile(50)));
+        state.set_counter("wait_p99_ns", static_cast<double>(wait_ns.percentile(99)));
+    }
+
+    /// One task at a time: submit, then wait for its result.
+    void bench_pool_round_trip(MicroBenchState &state)
+    {
+        ouc_server::utils::ThreadPool pool(POOL_THREADS);
+        state.reset_timer();
+        for (size_t i = 0; i < state.iterations; ++i)
+            micro_bench::do_not_optimize(pool.sumbit([i]()
+                                                     { return i; })
+                                             .get());
+    }
+
+    void bench_request_from_string(MicroBenchState &state, const std::string &raw)
+    {
+        for (size_t i = 0; i < state.iterations; ++i)
+        {
+            auto req = ouc_server::http::HttpRequest::from_string(raw);
+            micro_bench::do_not_optimize(req);
+        }
+    }
+
+    void bench_response_to_string(MicroBenchState &state)
+    {
+        auto res = ouc_server::http::HttpResponse::create()
+                       .version("HTTP/1.1")
+                       .stus_code(200)
+                       .stus_msg("OK")
+                       .header("Content-Type", "application/json")
+                       .header("Content-Length", "27")
+                       .header("Server", "ouc_server")
+                       .header("Cache-Control", "no-cache")
+                       .header("Connection", "keep-alive")
+                       .body("{\"id\":12345,\"name\":\"alice\"}")
+                       .build();
+
+        state.reset_timer();
+        for (size_t i = 0; i < state.iterations; ++i)
+        {
+            auto out = res.to_string();
+            micro_bench::do_not_optimize(out);
+        }
+    }
+
+    /// Status line, Date, Content-Length and body of a small keep-alive response.
+    void bench_response_writer_end(MicroBenchState &state)
+    {
+        ouc_server::http::DateCache date;
+        std::string sink;
+        const std::string body = "{\"id\":12345,\"name\":\"alice\"}";
+
+        state.reset_timer();
+        for (size_t i = 0; i < state.iterations; ++i)
+        {
+            ouc_server::http::HttpResponseWriter writer(
+                [&](std::string &&data)
+                {
+                    sink = std::move(data);
+                    return true;
+                });
+            writer.set_date(&date);
+            writer.status(200).header("Content-Type", "application/json");
+            writer.end(body);
+            micro_bench::do_not_optimize(sink);
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    micro_bench::MicroBenchRunner runner;
+    if (!runner.parse_args(argc, argv))
+        return 1;
+
+    runner.add("mpmc/push_pop_single_thread", bench_mpmc_single_thread);
+    for (auto [p, c] : {std::pair<size_t, size_t>{1, 1}, {2, 2}, {4, 4}, {1, 4}, {4, 1}})
+        runner.add("mpmc/" + std::to_string(p) + "p" + std::to_string(c) + "c",
+                   [p = p, c = c](MicroBenchState &state)
+                   { bench_mpmc_threads(state, p, c); });
+
+    runner.add("pool/submit_throughput", bench_pool_submit);
+    runner.add("pool/submit_round_trip", bench_pool_round_trip);
+
+    runner.add("http/request_from_string_get", [](MicroBenchState &state)
+               { bench_request_from_string(state, GET_REQUEST); });
+    runner.add("http/request_from_string_post", [](MicroBenchState &state)
+               { bench_request_from_string(state, POST_REQUEST); });
+    runner.add("http/response_to_string", bench_response_to_string);
+    runner.add("http/response_writer_end", bench_response_writer_end);
+
+    return runner.run();
+}
@@ -0,0 +1,246 @@
+// Minimal header-only micro-benchmark harness.
+//
+// A benchmark is a function taking a MicroBenchState; it runs its
+// operation state.iterations times. The harness grows the iteration count
+// until a run lasts at least --min-time, repeats it --repetitions times and
+// reports the fastest run, which is the least disturbed by the rest of the
+// machine. The calling thread is pinned to --cpu; benchmarks that start
+// their own threads pin them with pin_thread().
+//
+//   ./bench_micro --filter=mpmc --min-time=0.5 --json > after.json
+
+#ifndef BENCHMARKS_MICRO_BENCH
+#define BENCHMARKS_MICRO_BENCH
+
+#include <pthread.h>
+#include <sched.h>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <utility>
+#include <chrono>
+#include <thread>
+#include <functional>
+#include <algorithm>
+#include <iostream>
+
+namespace micro_bench
+{
+    using Clock = std::chrono::steady_clock;
+
+    /// Keep the compiler from optimizing a computed value away.
+    template <typename T>
+    inline void do_not_optimize(T const &value)
+    {
+        asm volatile("" : : "r,m"(value) : "memory");
+    }
+
+    /**
+     * @brief Pin the calling thread to a CPU, wrapped to the available count.
+     * @return false if the CPU could not be set.
+     */
+    inline bool pin_thread(unsigned cpu)
+    {
+        unsigned count = std::max(1u, std::thread::hardware_concurrency());
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu % count, &set);
+        return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+    }
+
+    /// Per-run state handed to a benchmark.
+    class MicroBenchState
+    {
+    private:
+        Clock::time_point start = Clock::now();
+        Clock::duration elapsed{};
+        bool running = true;
+        std::vector<std::pair<std::string, double>> counters;
+
+    public:
+        const size_t iterations;
+
+    public:
+        explicit MicroBenchState(size_t p_iterations) : iterations(p_iterations) {}
+
+        /// Exclude the setup done so far from the measurement.
+        void reset_timer()
+        {
+            elapsed = {};
+            start = Clock::now();
+            running = true;
+        }
+
+        /// Exclude what follows, e.g. joining threads, from the measurement.
+        void stop_timer()
+        {
+            if (running)
+                elapsed += Clock::now() - start;
+            running = false;
+        }
+
+        /// Extra value reported next to the timing, kept from the fastest run.
+        void set_counter(const std::string &name, double value)
+        {
+            for (auto &counter : counters)
+                if (counter.first == name)
+                {
+                    counter.second = value;
+                    return;
+                }
+            counters.emplace_back(name, value);
+        }
+
+        double seconds()
+        {
+            stop_timer();
+            return std::chrono::duration<double>(elapsed).count();
+        }
+
+        const std::vector<std::pair<std::string, double>> &get_counters() const noexcept { return counters; }
+    };
+
+    using MicroBenchFunc = std::function<void(MicroBenchState &)>;
+
+    struct MicroBenchResult
+    {
+        std::string name;
+        size_t iterations = 0;
+        double seconds = 0;
+        std::vector<std::pair<std::string, double>> counters;
+
+        double ns_per_op() const { return iterations ? seconds * 1e9 / iterations : 0; }
+        double ops_per_sec() const { return seconds > 0 ? iterations / seconds : 0; }
+    };
+
+    class MicroBenchRunner
+    {
+    private:
+        std::vector<std::pair<std::string, MicroBenchFunc>> benches;
+
+        std::string filter;
+        double min_time = 0.2;
+        size_t repetitions = 3;
+        int cpu = 0; ///< CPU of the calling thread, -1 leaves it unpinned.
+        bool json = false;
+
+    public:
+        void add(const std::string &name, MicroBenchFunc &&func) { benches.emplace_back(name, std::move(func)); }
+
+        /**
+         * @brief Parse --filter=, --min-time=, --repetitions=, --cpu= and --json.
+         * @return false on an unknown argument.
+         */
+        bool parse_args(int argc, char **argv)
+        {
+            for (int i = 1; i < argc; ++i)
+            {
+                std::string arg = argv[i];
+                auto eq = arg.find('=');
+                std::string key = arg.substr(0, eq);
+                std::string val = eq == std::string::npos ? "1" : arg.substr(eq + 1);
+
+                if (key == "--filter")
+                    filter = val;
+                else if (key == "--min-time")
+                    min_time = std::stod(val);
+                else if (key == "--repetitions")
+                    repetitions = std::max<size_t>(1, std::stoul(val));
+                else if (key == "--cpu")
+                    cpu = std::stoi(val);
+                else if (key == "--json")
+                    json = val != "0";
+                else
+                {
+                    std::cerr << "unknown argument: " << arg << "\n";
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        int run()
+        {
+            if (cpu >= 0)
+                pin_thread(static_cast<unsigned>(cpu));
+
+            std::vector<MicroBenchResult> results;
+            for (auto &[name, func] : benches)
+            {
+                if (!filter.empty() && name.find(filter) == std::string::npos)
+                    continue;
+
+                results.push_back(measure(name, func));
+                if (!json)
+                    print_text(results.back());
+            }
+
+            if (json)
+                print_json(results);
+            return 0;
+        }
+
+    private:
+        MicroBenchResult measure(const std::string &name, MicroBenchFunc &func)
+        {
+            // Grow the run until it is long enough to time reliably
+            size_t iterations = 1;
+            double seconds = 0;
+            while (true)
+            {
+                MicroBenchState state(iterations);
+                func(state);
+                seconds = state.seconds();
+                if (seconds >= min_time || iterations >= (size_t(1) << 40))
+                    break;
+
+                double scale = seconds > 0 ? min_time * 1.4 / seconds : 100;
+                iterations = static_cast<size_t>(iterations * std::clamp(scale, 2.0, 100.0));
+            }
+
+            MicroBenchResult best;
+            best.name = name;
+            for (size_t rep = 0; rep < repetitions; ++rep)
+            {
+                MicroBenchState state(iterations);
+                func(state);
+                double t = state.seconds();
+                if (rep == 0 || t < best.seconds)
+                {
+                    best.iterations = iterations;
+                    best.seconds = t;
+                    best.counters = state.get_counters();
+                }
+            }
+            return best;
+        }
+
+        static void print_text(const MicroBenchResult &res)
+        {
+            std::printf("%-40s %12zu iters %12.1f ns/op %14.0f ops/s",
+                        res.name.c_str(), res.iterations, res.ns_per_op(), res.ops_per_sec());
+            for (auto &[key, value] : res.counters)
+                std::printf("  %s=%.1f", key.c_str(), value);
+            std::printf("\n");
+        }
+
+        void print_json(const std::vector<MicroBenchResult> &results) const
+        {
+            std::printf("{\"cpu\":%d,\"hardware_concurrency\":%u,\"benchmarks\":[",
+                        cpu, std::thread::hardware_concurrency());
+            for (size_t i = 0; i < results.size(); ++i)
+            {
+                auto &res = results[i];
+                std::printf("%s{\"name\":\"%s\",\"iterations\":%zu,\"seconds\":%.6f,\"ns_per_op\":%.3f,\"ops_per_sec\":%.1f",
+                            i ? "," : "", res.name.c_str(), res.iterations, res.seconds, res.ns_per_op(), res.ops_per_sec());
+                for (auto &[key, value] : res.counters)
+                    std::printf(",\"%s\":%.3f", key.c_str(), value);
+                std::printf("}");
+            }
+            std::printf("]}\n");
+        }
+    };
+}
+
+#endif // BENCHMARKS_MICRO_BENCH
@@ -0,0 +1,305 @@
+#include <client/tcp_client.hpp>
+
+#include <sys/socket.h>
+#include <cerrno>
+#include <vector>
+
+namespace ouc_server
+{
+    namespace client
+    {
+        TCPClient::~TCPClient()
+        {
+            std::lock_guard<std::mutex> lk(mtx);
+            shut(0);
+        }
+
+        void TCPClient::connect(ouc_server::epoll::EpollLoop &loop, const std::string &ip, uint16_t port,
+                                std::chrono::milliseconds timeout, ConnectCallback &&callback)
+        {
+            using ouc_server::ouc_socket::TCPSocket;
+
+            TCPSocket sock = TCPSocket::create(TCPSocket::family_of(ip));
+            if (sock.get_fd() < 0 || !sock.connect(ip, port))
+            {
+                int err = errno != 0 ? errno : EINVAL;
+                callback(nullptr, err);
+                return;
+            }
+
+            auto client = std::make_shared<TCPClient>(Token{}, loop, std::move(sock));
+            int fd = client->socket.get_fd();
+            std::weak_ptr<TCPClient> weak = client;
+
+            // Registered under the lock: neither the handshake nor the
+            // timeout can be handled before both are in place.
+            std::unique_lock<std::mutex> lk(client->mtx);
+            if (!loop.add_fd(
+                    fd, EPOLLOUT | EPOLLONESHOT,
+                    [weak](int)
+                    {
+                        if (auto c = weak.lock())
+                            c->handle_event();
+                    }))
+            {
+                int err = errno;
+                client->shut(err);
+                lk.unlock();
+                callback(nullptr, err);
+                return;
+            }
+
+            client->self = client;
+            client->connect_callback = std::move(callback);
+            client->timer_id = loop.add_timer(
+                timeout,
+                [weak]()
+                {
+                    if (auto c = weak.lock())
+                        c->handle_timeout();
+                });
+        }
+
+        void TCPClient::handle_timeout()
+        {
+            ConnectCallback cb;
+            std::shared_ptr<TCPClient> keep;
+            {
+                std::lock_guard<std::mutex> lk(mtx);
+                if (state != State::Connecting)
+                    return;
+                timer_id = 0;
+                cb = std::move(connect_callback);
+                keep = std::move(self);
+                shut(ETIMEDOUT);
+            }
+            if (cb)
+                cb(nullptr, ETIMEDOUT);
+        }
+
+        void TCPClient::handle_event()
+        {
+            std::unique_lock<std::mutex> lk(mtx);
+            if (state == State::Closed)
+                return;
+
+            if (state == State::Connecting)
+            {
+                ConnectCallback cb = std::move(connect_callback);
+                std::shared_ptr<TCPClient> keep = std::move(self);
+                loop.cancel_timer(timer_id);
+                timer_id = 0;
+
+                int err = socket.get_error();
+                if (err != 0)
+                {
+                    shut(err);
+                    lk.unlock();
+                    if (cb)
+                        cb(nullptr, err);
+                    return;
+                }
+
+                state = State::Open;
+                update_interest();
+                lk.unlock();
+                if (cb)
+                    cb(keep, 0);
+                return;
+            }
+
+            std::vector<WriteCallback> done;
+            bool ok = flush(done);
+
+            ReadCallback read_cb;
+            std::string chunk;
+            if (ok && read_callback)
+            {
+                chunk.resize(READ_CHUNK);
+                while (true)
+                {
+                    ssize_t n = socket.recv(chunk.data(), chunk.size());
+                    if (n > 0)
+                    {
+                        chunk.resize(static_cast<size_t>(n));
+                        read_cb = std::move(read_callback);
+                    }
+                    else if (n == 0)
+                    {
+                        chunk.clear();
+                        read_cb = std::move(read_callback);
+                        ok = false;
+                        errno = 0;
+                    }
+                    else if (errno == EINTR)
+                        continue;
+                    else if (errno != EAGAIN && errno != EWOULDBLOCK)
+                        ok = false;
+                    break;
+                }
+            }
+
+            // Ended: everybody still waiting learns about it
+            std::vector<std::pair<std::string, WriteCallback>> failed_writes;
+            if (!ok)
+            {
+                int err = errno;
+                if (!read_cb && read_callback)
+                    read_cb = std::move(read_callback);
+                chunk.clear();
+                for (auto &entry : outbox)
+                    failed_writes.push_back(std::move(entry));
+                outbox.clear();
+                shut(err);
+            }
+            else
+                update_interest();
+            lk.unlock();
+
+            for (auto &cb : done)
+                if (cb)
+                    cb(true);
+            for (auto &entry : failed_writes)
+                if (entry.second)
+                    entry.second(false);
+            if (read_cb)
+                read_cb(chunk);
+        }
+
+        bool TCPClient::write(std::string &&data, WriteCallback &&done)
+        {
+            std::vector<WriteCallback> finished;
+            {
+                std::lock_guard<std::mutex> lk(mtx);
+                if (state == State::Closed)
+                    return false;
+
+                bool was_empty = outbox.empty();
+                outbox_bytes += data.size();
+                outbox.emplace_back(std::move(data), std::move(done));
+
+                // Still connecting: the handshake's EPOLLOUT flushes it
+                if (state == State::Connecting || !was_empty)
+                    return true;
+
+                if (!flush(finished))
+                {
+                    shut(errno);
+                    return false;
+                }
+                update_interest();
+            }
+
+            for (auto &cb : finished)
+                if (cb)
+                    cb(true);
+            return true;
+        }
+
+        bool TCPClient::read(ReadCallback &&callback)
+        {
+            std::lock_guard<std::mutex> lk(mtx);
+            if (state == State::Closed || read_callback)
+                return false;
+
+            // Data already waiting makes the level-triggered fd fire at once
+            read_callback = std::move(callback);
+            if (state == State::Open)
+                update_interest();
+            return true;
+        }
+
+        void TCPClient::close()
+        {
+            std::lock_guard<std::mutex> lk(mtx);
+            outbox.clear();
+            outbox_bytes = 0;
+            read_callback = nullptr;
+            shut(0);
+        }
+
+        bool TCPClient::is_open()
+        {
+            std::lock_guard<std::mutex> lk(mtx);
+            return state == State::Open;
+        }
+
+        int TCPClient::get_error()
+        {
+            std::lock_guard<std::mutex> lk(mtx);
+            return error;
+        }
+
+        size_t TCPClient::get_pending_bytes()
+        {
+            std::lock_guard<std::mutex> lk(mtx);
+            return outbox_bytes;
+        }
+
+        bool TCPClient::is_reusable()
+        {
+            std::lock_guard<std::mutex> lk(mtx);
+            if (state != State::Open || !outbox.empty() || read_callback)
+                return false;
+
+            // Closed by the peer (0) or stray bytes (> 0) both rule it out
+            char byte;
+            ssize_t n = ::recv(socket.get_fd(), &byte, 1, MSG_PEEK | MSG_DONTWAIT);
+            return n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+        }
+
+        bool TCPClient::flush(std::vector<WriteCallback> &done)
+        {
+            while (!outbox.empty())
+            {
+                auto &front = outbox.front();
+                size_t len = front.first.size() - out_offset;
+                ssize_t n = socket.send(front.first.data() + out_offset, len, outbox.size() > 1 ? MSG_MORE : 0);
+                if (n < 0)
+                    return false;
+
+                out_offset += n;
+                outbox_bytes -= n;
+                if (static_cast<size_t>(n) < len)
+                    break; // socket buffer full
+
+                done.push_back(std::move(front.second));
+                outbox.pop_front();
+                out_offset = 0;
+            }
+            return true;
+        }
+
+        void TCPClient::update_interest()
+        {
+            uint32_t flags = 0;
+            if (read_callback)
+                flags |= EPOLLIN | EPOLLRDHUP;
+            if (!outbox.empty())
+                flags |= EPOLLOUT;
+
+            // Idle connections stay disarmed, e.g. while parked in a pool
+            if (flags != 0)
+                loop.modify_fd(socket.get_fd(), flags | EPOLLONESHOT);
+        }
+
+        void TCPClient::shut(int err)
+        {
+            if (state == State::Closed)
+                return;
+
+            state = State::Closed;
+            error = err;
+            if (timer_id != 0)
+            {
+                loop.cancel_timer(timer_id);
+                timer_id = 0;
+            }
+            if (socket.get_fd() >= 0)
+            {
+                loop.remove_fd(socket.get_fd());
+                socket.close();
+            }
+        }
+    }
+}
@@ -0,0 +1,170 @@
+/**
+ * @file tcp_client.hpp
+ * @brief Outbound TCP connection driven by an EpollLoop.
+ *
+ * Connecting, writing and reading never block: each operation registers
+ * interest with the loop and its callback runs on the loop's pool once
+ * the socket is ready. A handler can therefore call a backend from inside
+ * TCPServer or HttpServer callbacks without a thread of its own, on the
+ * server's loop (TCPServer::get_loop()).
+ *
+ * Example:
+ * @code
+ * TCPClient::connect(loop, "127.0.0.1", 9000, std::chrono::milliseconds(500),
+ *     [](std::shared_ptr<TCPClient> client, int error)
+ *     {
+ *         if (!client) return;
+ *         client->write("ping\n");
+ *         client->read([client](std::string_view reply){ ... });
+ *     });
+ * @endcode
+ */
+
+#ifndef INCLUDE_OUC_SERVER_TCP_CLIENT
+#define INCLUDE_OUC_SERVER_TCP_CLIENT
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <deque>
+#include <vector>
+#include <chrono>
+
+#include <socket/tcp_socket.hpp>
+#include <epoll/epoll_loop.hpp>
+
+namespace ouc_server
+{
+    namespace client
+    {
+        /**
+         * @class TCPClient
+         * @brief One non-blocking outbound connection.
+         *
+         * Owned through shared_ptr by whoever uses it; dropping the last
+         * reference closes the connection and discards pending callbacks.
+         * At most one read is outstanding at a time; writes are queued and
+         * sent in order.
+         */
+        class TCPClient : public std::enable_shared_from_this<TCPClient>
+        {
+        public:
+            /// The client on success, nullptr and an errno value on failure.
+            using ConnectCallback = std::function<void(std::shared_ptr<TCPClient>, int)>;
+
+            /// Received bytes, empty once the connection ended (EOF or error).
+            using ReadCallback = std::function<void(std::string_view)>;
+
+            /// Whether the data was handed to the kernel.
+            using WriteCallback = std::function<void(bool)>;
+
+            /// Largest chunk passed to a ReadCallback.
+            static constexpr size_t READ_CHUNK = 16384;
+
+        private:
+            enum class State
+            {
+                Connecting,
+                Open,
+                Closed,
+            };
+
+            ouc_server::epoll::EpollLoop &loop;
+            ouc_server::ouc_socket::TCPSocket socket;
+
+            std::mutex mtx;                                         ///< Guards the fields below.
+            State state = State::Connecting;
+            int error = 0;                                          ///< errno of the failure that closed the connection.
+            std::shared_ptr<TCPClient> self;                        ///< Keeps a connecting client alive.
+            ConnectCallback connect_callback;
+            uint64_t timer_id = 0;                                  ///< Connect timeout.
+            std::deque<std::pair<std::string, WriteCallback>> outbox; ///< Pending writes, front partially sent.
+            size_t out_offset = 0;                                  ///< Bytes of outbox.front() already sent.
+            size_t outbox_bytes = 0;                                ///< Unsent bytes in outbox.
+            ReadCallback read_callback;                             ///< Outstanding read.
+
+            struct Token
+            {
+            };
+
+        public:
+            /// Use connect(), public only for make_shared.
+            TCPClient(Token, ouc_server::epoll::EpollLoop &p_loop, ouc_server::ouc_socket::TCPSocket &&p_socket)
+                : loop(p_loop), socket(std::move(p_socket)) {}
+
+            ~TCPClient();
+
+            TCPClient(const TCPClient &) = delete;
+            TCPClient &operator=(const TCPClient &) = delete;
+
+            /**
+             * @brief Connect to a numeric IPv4 or IPv6 address.
+             * @param loop Loop driving the connection.
+             * @param ip Address, e.g. "10.0.0.2" or "::1"; host names are not resolved.
+             * @param port Port.
+             * @param timeout Give up with ETIMEDOUT after this long.
+             * @param callback Called once with the result, possibly before connect() returns.
+             */
+            static void connect(ouc_server::epoll::EpollLoop &loop, const std::string &ip, uint16_t port,
+                                std::chrono::milliseconds timeout, ConnectCallback &&callback);
+
+        public:
+            /**
+             * @brief Queue data and send as much as the socket takes right away.
+             * @param data Bytes to send.
+             * @param done Called once all of them were handed to the kernel, or with false on failure.
+             * @return false if the connection is closed.
+             */
+            bool write(std::string &&data, WriteCallback &&done = {});
+
+            /**
+             * @brief Receive the next chunk.
+             * @param callback Called once with up to READ_CHUNK bytes, empty if the connection ended.
+             * @return false if the connection is closed or a read is already outstanding.
+             */
+            bool read(ReadCallback &&callback);
+
+            /// Close now, pending callbacks are discarded.
+            void close();
+
+            bool is_open();
+
+            /// errno value that ended the connection, 0 if none.
+            int get_error();
+
+            /// Bytes queued but not yet sent.
+            size_t get_pending_bytes();
+
+            /**
+             * @brief Whether the connection can serve another exchange.
+             *
+             * Open, nothing pending in either direction, and the peer has
+             * neither closed it nor sent unsolicited data.
+             */
+            bool is_reusable();
+
+            ouc_server::ouc_socket::TCPSocket &get_socket() noexcept { return socket; }
+
+        private:
+            /// Handle readiness of the socket.
+            void handle_event();
+
+            /// Connect timeout fired.
+            void handle_timeout();
+
+            /// Write queued data, collecting completed callbacks; mtx held. false on error.
+            bool flush(std::vector<WriteCallback> &done);
+
+            /// Re-arm the one-shot notification for what is pending; mtx held.
+            void update_interest();
+
+            /// Mark closed and leave the loop; mtx held.
+            void shut(int err);
+        };
+    }
+}
+
+#endif // INCLUDE_OUC_SERVER_TCP_CLIENT
@@ -0,0 +1,139 @@
+#include <client/upstream_pool.hpp>
+
+namespace ouc_server
+{
+    namespace client
+    {
+        UpstreamPool::UpstreamPool(ouc_server::epoll::EpollLoop &loop, const std::string &address, uint16_t port,
+                                   const UpstreamPoolConfig &config)
+            : state(std::make_shared<State>(loop, address, port, config))
+        {
+        }
+
+        UpstreamPool::~UpstreamPool()
+        {
+            std::lock_guard<std::mutex> lk(state->mtx);
+            for (auto &entry : state->idle)
+                entry.first->close();
+            state->idle.clear();
+        }
+
+        void UpstreamPool::State::report(bool ok)
+        {
+            std::lock_guard<std::mutex> lk(mtx);
+            if (ok)
+            {
+                failures = 0;
+                return;
+            }
+
+            if (++failures >= config.max_failures)
+                down_until = Clock::now() + config.down_time;
+        }
+
+        void UpstreamPool::acquire(AcquireCallback &&callback)
+        {
+            std::vector<std::shared_ptr<TCPClient>> stale;
+            std::shared_ptr<TCPClient> reused;
+            bool down = false;
+            {
+                std::lock_guard<std::mutex> lk(state->mtx);
+                auto now = Clock::now();
+
+                // Newest first: the oldest ones are the next to expire anyway
+                while (!state->idle.empty())
+                {
+                    auto entry = std::move(state->idle.back());
+                    state->idle.pop_back();
+                    if (now - entry.second < state->config.idle_timeout && entry.first->is_reusable())
+                    {
+                        reused = std::move(entry.first);
+                        break;
+                    }
+                    stale.push_back(std::move(entry.first));
+                }
+
+                if (!reused && state->failures >= state->config.max_failures)
+                {
+                    if (now < state->down_until)
+                        down = true;
+                    else // let this one through as the probe, hold back the rest
+                        state->down_until = now + state->config.down_time;
+                }
+                if (!down)
+                    state->active.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            for (auto &client : stale)
+                client->close();
+
+            if (down)
+            {
+                callback(nullptr);
+                return;
+            }
+
+            if (reused)
+            {
+                callback(std::move(reused));
+                return;
+            }
+
+            state->connects.fetch_add(1, std::memory_order_relaxed);
+            TCPClient::connect(
+                state->loop, state->address, state->port, state->config.connect_timeout,
+                [state = state, callback = std::move(callback)](std::shared_ptr<TCPClient> client, int)
+                {
+                    state->report(client != nullptr);
+                    if (!client)
+                        state->active.fetch_sub(1, std::memory_order_relaxed);
+                    callback(std::move(client));
+                });
+        }
+
+        void UpstreamPool::release(const std::shared_ptr<TCPClient> &client, bool reusable)
+        {
+            if (!client)
+                return;
+            state->active.fetch_sub(1, std::memory_order_relaxed);
+
+            std::vector<std::shared_ptr<TCPClient>> stale;
+            bool parked = false;
+            {
+                std::lock_guard<std::mutex> lk(state->mtx);
+                auto now = Clock::now();
+
+                // Expired connections sit at the front
+                auto it = state->idle.begin();
+                while (it != state->idle.end() && now - it->second >= state->config.idle_timeout)
+                    ++it;
+                for (auto dead = state->idle.begin(); dead != it; ++dead)
+                    stale.push_back(std::move(dead->first));
+                state->idle.erase(state->idle.begin(), it);
+
+                if (reusable && state->idle.size() < state->config.max_idle && client->is_reusable())
+                {
+                    state->idle.emplace_back(client, now);
+                    parked = true;
+                }
+            }
+
+            for (auto &dead : stale)
+                dead->close();
+            if (!parked)
+                client->close();
+        }
+
+        bool UpstreamPool::is_healthy()
+        {
+            std::lock_guard<std::mutex> lk(state->mtx);
+            return state->failures < state->config.max_failures || Clock::now() >= state->down_until;
+        }
+
+        size_t UpstreamPool::get_idle_count()
+        {
+            std::lock_guard<std::mutex> lk(state->mtx);
+            return state->idle.size();
+        }
+    }
+}
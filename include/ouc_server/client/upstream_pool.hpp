@@ -0,0 +1,136 @@
+/**
+ * @file upstream_pool.hpp
+ * @brief Keep-alive connections to one backend, with health tracking.
+ *
+ * Opening a TCP connection per request costs a round trip and a port;
+ * the pool parks finished connections and hands the most recently used
+ * one out again (its socket buffers and the peer's state are warmest).
+ * Parked connections are dropped once idle too long or no longer clean.
+ *
+ * Consecutive failures mark the upstream down: acquire() then fails at
+ * once instead of waiting for connect timeouts, and after down_time a
+ * single probe connection decides whether it is back.
+ */
+
+#ifndef INCLUDE_OUC_SERVER_UPSTREAM_POOL
+#define INCLUDE_OUC_SERVER_UPSTREAM_POOL
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <client/tcp_client.hpp>
+#include <epoll/epoll_loop.hpp>
+
+namespace ouc_server
+{
+    namespace client
+    {
+        struct UpstreamPoolConfig
+        {
+            size_t max_idle = 16;                                   ///< Parked connections kept at most.
+            std::chrono::milliseconds idle_timeout{30000};          ///< Close parked connections after this long.
+            std::chrono::milliseconds connect_timeout{1000};
+            uint32_t max_failures = 3;                              ///< Consecutive failures marking the upstream down.
+            std::chrono::milliseconds down_time{5000};              ///< Wait before probing a down upstream.
+        };
+
+        /**
+         * @class UpstreamPool
+         * @brief Connection pool for a single backend address.
+         *
+         * Thread-safe. Connections handed out by acquire() go back through
+         * release(); callbacks may outlive the pool.
+         */
+        class UpstreamPool
+        {
+        public:
+            /// A connection, or nullptr if none could be established.
+            using AcquireCallback = std::function<void(std::shared_ptr<TCPClient>)>;
+
+            using Clock = std::chrono::steady_clock;
+
+        private:
+            struct State
+            {
+                ouc_server::epoll::EpollLoop &loop;
+                std::string address;
+                uint16_t port;
+                UpstreamPoolConfig config;
+
+                std::mutex mtx;                                     ///< Guards idle, failures and down_until.
+                std::vector<std::pair<std::shared_ptr<TCPClient>, Clock::time_point>> idle; ///< Oldest first.
+                uint32_t failures = 0;
+                Clock::time_point down_until{};
+
+                std::atomic<size_t> active{0};
+                std::atomic<uint64_t> connects{0};
+
+                State(ouc_server::epoll::EpollLoop &p_loop, std::string p_address, uint16_t p_port, const UpstreamPoolConfig &p_config)
+                    : loop(p_loop), address(std::move(p_address)), port(p_port), config(p_config) {}
+
+                void report(bool ok);
+            };
+
+            std::shared_ptr<State> state;
+
+        public:
+            /**
+             * @param loop Loop driving the connections.
+             * @param address Numeric IPv4 or IPv6 address of the backend.
+             * @param port Port of the backend.
+             * @param config Limits and timeouts.
+             */
+            UpstreamPool(ouc_server::epoll::EpollLoop &loop, const std::string &address, uint16_t port,
+                         const UpstreamPoolConfig &config = UpstreamPoolConfig());
+
+            ~UpstreamPool();
+
+            UpstreamPool(const UpstreamPool &) = delete;
+            UpstreamPool &operator=(const UpstreamPool &) = delete;
+
+            /**
+             * @brief Get a connection: the newest parked one, else a new one.
+             * @param callback Called once, right away when a parked connection
+             *        is reused or the upstream is down, otherwise after connecting.
+             */
+            void acquire(AcquireCallback &&callback);
+
+            /**
+             * @brief Return a connection obtained from acquire().
+             * @param client The connection.
+             * @param reusable false if the exchange on it did not complete
+             *        cleanly; it is closed instead of parked.
+             */
+            void release(const std::shared_ptr<TCPClient> &client, bool reusable = true);
+
+            /// Count a failed exchange (e.g. a reset or timeout) against the upstream.
+            void report_failure() { state->report(false); }
+
+            /// Count a successful exchange, clearing earlier failures.
+            void report_success() { state->report(true); }
+
+            /// Below max_failures, or down_time has passed and a probe is allowed.
+            bool is_healthy();
+
+            /// Connections handed out and not yet released, including those connecting.
+            size_t get_active_count() const noexcept { return state->active.load(std::memory_order_relaxed); }
+
+            size_t get_idle_count();
+
+            /// Connections opened so far.
+            uint64_t get_connect_count() const noexcept { return state->connects.load(std::memory_order_relaxed); }
+
+            const std::string &get_address() const noexcept { return state->address; }
+
+            uint16_t get_port() const noexcept { return state->port; }
+        };
+    }
+}
+
+#endif // INCLUDE_OUC_SERVER_UPSTREAM_POOL
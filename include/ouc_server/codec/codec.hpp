@@ -0,0 +1,78 @@
+/**
+ * @file codec.hpp
+ * @brief Framing between a connection's byte stream and message handlers.
+ *
+ * TCPServer hands out received bytes in arbitrary chunks. A Codec cuts
+ * them into the frames of a protocol and wraps outgoing frames the same
+ * way, so handlers only ever see whole messages.
+ */
+
+#ifndef INCLUDE_OUC_SERVER_CODEC
+#define INCLUDE_OUC_SERVER_CODEC
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace ouc_server
+{
+    namespace codec
+    {
+        /**
+         * @class Codec
+         * @brief Stateful decoder and stateless encoder of one connection's frames.
+         *
+         * decode() keeps partial frames between calls, so each connection
+         * needs its own instance; encode() may be called from any thread.
+         */
+        class Codec
+        {
+        public:
+            /// A complete frame, valid only during the call.
+            using FrameCallback = std::function<void(std::string_view)>;
+
+            virtual ~Codec() = default;
+
+            /**
+             * @brief Consume the next bytes of the stream.
+             * @param data Received bytes.
+             * @param on_frame Called with every frame completed by them, in order.
+             * @return false once the stream is malformed or exceeds a limit.
+             */
+            virtual bool decode(std::string_view data, const FrameCallback &on_frame) = 0;
+
+            /**
+             * @brief Append one frame in wire format.
+             * @param out Buffer to append to.
+             * @param frame Frame payload.
+             */
+            virtual void encode(std::string &out, std::string_view frame) const = 0;
+
+            /// Most bytes encode() adds to a frame, used to size batches.
+            virtual size_t max_overhead() const noexcept { return 0; }
+
+            /// Forget any partial frame and start over.
+            virtual void reset() {}
+
+            /**
+             * @brief Append several frames with a single allocation.
+             * @param out Buffer to append to.
+             * @param frames Frame payloads, in order.
+             */
+            void encode(std::string &out, const std::vector<std::string_view> &frames) const
+            {
+                size_t total = out.size();
+                for (auto frame : frames)
+                    total += frame.size() + max_overhead();
+                out.reserve(total);
+
+                for (auto frame : frames)
+                    encode(out, frame);
+            }
+        };
+    }
+}
+
+#endif // INCLUDE_OUC_SERVER_CODEC
@@ -0,0 +1,163 @@
+#include <codec/length_prefixed_codec.hpp>
+
+#include <algorithm>
+
+namespace ouc_server
+{
+    namespace codec
+    {
+        LengthPrefixedCodec::LengthPrefixedCodec(const LengthPrefixedConfig &p_config)
+            : config(p_config),
+              header{},
+              header_len(0),
+              has_length(false),
+              frame_size(0),
+              failed(false)
+        {
+        }
+
+        void LengthPrefixedCodec::reset()
+        {
+            header_len = 0;
+            has_length = false;
+            frame_size = 0;
+            partial.clear();
+            failed = false;
+        }
+
+        size_t LengthPrefixedCodec::read_header(std::string_view data)
+        {
+            size_t pos = 0;
+            uint64_t len = 0;
+
+            if (config.prefix == LengthPrefix::Fixed32)
+            {
+                size_t n = std::min<size_t>(4 - header_len, data.size());
+                std::copy(data.begin(), data.begin() + n, header + header_len);
+                header_len += n;
+                pos = n;
+                if (header_len < 4)
+                    return pos;
+                len = (uint64_t(header[0]) << 24) | (uint64_t(header[1]) << 16) | (uint64_t(header[2]) << 8) | header[3];
+            }
+            else
+            {
+                // Up to and including the first byte without the continuation bit
+                bool done = false;
+                while (pos < data.size() && !done)
+                {
+                    if (header_len == sizeof(header))
+                    {
+                        failed = true;
+                        return pos;
+                    }
+                    uint8_t byte = static_cast<uint8_t>(data[pos++]);
+                    header[header_len++] = byte;
+                    done = (byte & 0x80) == 0;
+                }
+                if (!done)
+                    return pos;
+
+                // The tenth byte carries the top bit of 64 only
+                if (header_len == sizeof(header) && header[9] > 1)
+                {
+                    failed = true;
+                    return pos;
+                }
+                for (size_t i = header_len; i-- > 0;)
+                    len = (len << 7) | (header[i] & 0x7F);
+            }
+
+            if (len > config.max_frame_size)
+            {
+                failed = true;
+                return pos;
+            }
+            has_length = true;
+            frame_size = static_cast<size_t>(len);
+            header_len = 0;
+            return pos;
+        }
+
+        bool LengthPrefixedCodec::decode(std::string_view data, const FrameCallback &on_frame)
+        {
+            while (!failed && !data.empty())
+            {
+                if (!has_length)
+                {
+                    data.remove_prefix(read_header(data));
+                    if (!has_length)
+                        continue;
+                }
+
+                if (partial.empty() && data.size() >= frame_size)
+                {
+                    // Whole frame in this read: hand out a view, no copy
+                    std::string_view frame = data.substr(0, frame_size);
+                    data.remove_prefix(frame_size);
+                    has_length = false;
+                    if (on_frame)
+                        on_frame(frame);
+                    continue;
+                }
+
+                // Split across reads: collect it
+                if (partial.empty())
+                    partial.reserve(frame_size);
+                size_t n = std::min(frame_size - partial.size(), data.size());
+                partial.append(data.data(), n);
+                data.remove_prefix(n);
+                if (partial.size() < frame_size)
+                    break;
+
+                has_length = false;
+                if (on_frame)
+                    on_frame(partial);
+
+                // A huge frame should not pin its memory for the connection's life
+                if (partial.capacity() > (1 << 20))
+                    partial = std::string();
+                else
+                    partial.clear();
+            }
+
+            // An empty frame completes with its header, possibly at the end of the data
+            if (!failed && has_length && frame_size == 0)
+            {
+                has_length = false;
+                if (on_frame)
+                    on_frame(std::string_view());
+            }
+            return !failed;
+        }
+
+        size_t LengthPrefixedCodec::write_header(char *buf, LengthPrefix prefix, uint64_t len) noexcept
+        {
+            if (prefix == LengthPrefix::Fixed32)
+            {
+                buf[0] = static_cast<char>(len >> 24);
+                buf[1] = static_cast<char>(len >> 16);
+                buf[2] = static_cast<char>(len >> 8);
+                buf[3] = static_cast<char>(len);
+                return 4;
+            }
+
+            size_t n = 0;
+            while (len >= 0x80)
+            {
+                buf[n++] = static_cast<char>((len & 0x7F) | 0x80);
+                len >>= 7;
+            }
+            buf[n++] = static_cast<char>(len);
+            return n;
+        }
+
+        void LengthPrefixedCodec::encode(std::string &out, std::string_view frame) const
+        {
+            char buf[10];
+            size_t n = write_header(buf, config.prefix, frame.size());
+            out.append(buf, n);
+            out.append(frame);
+        }
+    }
+}
@@ -0,0 +1,97 @@
+/**
+ * @file length_prefixed_codec.hpp
+ * @brief Frames preceded by their length, as most binary RPC protocols use.
+ *
+ * Two header forms: a fixed 4-byte big-endian length, or a varint
+ * (7 bits per byte, low group first, as in protobuf). Frames that arrive
+ * whole within one read are handed out as views into the read buffer;
+ * only frames split across reads are assembled in a buffer of their own.
+ */
+
+#ifndef INCLUDE_OUC_SERVER_LENGTH_PREFIXED_CODEC
+#define INCLUDE_OUC_SERVER_LENGTH_PREFIXED_CODEC
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include <codec/codec.hpp>
+
+namespace ouc_server
+{
+    namespace codec
+    {
+        enum class LengthPrefix
+        {
+            Fixed32, ///< 4 bytes, big-endian.
+            Varint,  ///< 1 to 10 bytes, 7 bits each, continuation in the high bit.
+        };
+
+        /**
+         * @brief Header form and limits of a LengthPrefixedCodec.
+         */
+        struct LengthPrefixedConfig
+        {
+            LengthPrefix prefix = LengthPrefix::Fixed32;
+            size_t max_frame_size = 16 << 20; ///< Largest frame accepted, the stream fails beyond it.
+        };
+
+        /**
+         * @class LengthPrefixedCodec
+         * @brief Codec for `length | payload` frames.
+         *
+         * Example:
+         * @code
+         * LengthPrefixedCodec codec({LengthPrefix::Varint, 1 << 20});
+         * if (!codec.decode(chunk, [](std::string_view frame){ handle(frame); }))
+         *     close_connection();
+         * @endcode
+         */
+        class LengthPrefixedCodec : public Codec
+        {
+        private:
+            LengthPrefixedConfig config;
+
+            uint8_t header[10];   ///< Header bytes received so far.
+            size_t header_len;
+            bool has_length;      ///< Header complete, payload follows.
+            size_t frame_size;    ///< Payload length of the current frame.
+            std::string partial;  ///< Payload of a frame split across reads.
+            bool failed;
+
+        public:
+            explicit LengthPrefixedCodec(const LengthPrefixedConfig &p_config = {});
+
+        public:
+            bool decode(std::string_view data, const FrameCallback &on_frame) override;
+
+            void encode(std::string &out, std::string_view frame) const override;
+
+            using Codec::encode;
+
+            size_t max_overhead() const noexcept override { return config.prefix == LengthPrefix::Fixed32 ? 4 : 10; }
+
+            void reset() override;
+
+            const LengthPrefixedConfig &get_config() const noexcept { return config; }
+
+            /**
+             * @brief Write a length header.
+             * @param buf At least 10 bytes.
+             * @param prefix Header form.
+             * @param len Payload length.
+             * @return Bytes written.
+             */
+            static size_t write_header(char *buf, LengthPrefix prefix, uint64_t len) noexcept;
+
+        private:
+            /**
+             * @brief Take header bytes until the length is known.
+             * @return Bytes consumed from data.
+             */
+            size_t read_header(std::string_view data);
+        };
+    }
+}
+
+#endif // INCLUDE_OUC_SERVER_LENGTH_PREFIXED_CODEC
@@ -0,0 +1,358 @@
+/**
+ * @file async_socket.hpp
+ * @brief Awaitable socket operations driven by EpollLoop readiness.
+ *
+ * An operation tries the socket first and suspends only when it would
+ * block; the fd is then armed one-shot and the loop resumes the coroutine
+ * on its pool once the socket is ready. No thread waits on a socket, so a
+ * handful of loop threads serve any number of connections.
+ *
+ * One coroutine at a time may use a socket. Coroutines resume on the
+ * loop's pool threads: an EpollLoop with a single thread runs every
+ * handler on that thread.
+ *
+ * Example:
+ * @code
+ * EpollLoop loop(1);
+ * TCPSocket listener = TCPSocket::create();
+ * listener.bind("127.0.0.1", 8080);
+ * listener.listen();
+ * spawn(serve(loop, std::move(listener), [](AsyncSocket conn) -> Task<void>
+ * {
+ *     while (true)
+ *     {
+ *         std::string line = co_await conn.read_until("\n");
+ *         if (line.empty() || !co_await conn.write_all(line))
+ *             co_return;
+ *     }
+ * }));
+ * while (true) loop.poll(10);
+ * @endcode
+ */
+
+#ifndef INCLUDE_OUC_SERVER_CORO_ASYNC_SOCKET
+#define INCLUDE_OUC_SERVER_CORO_ASYNC_SOCKET
+
+#include <cstdint>
+#include <cerrno>
+#include <algorithm>
+#include <string>
+#include <string_view>
+#include <memory>
+#include <atomic>
+#include <chrono>
+#include <functional>
+
+#include <coro/task.hpp>
+#include <socket/tcp_socket.hpp>
+#include <epoll/epoll_loop.hpp>
+
+namespace ouc_server
+{
+    namespace coro
+    {
+        class AsyncSocket
+        {
+        private:
+            /// Shared with the loop's callback, which may outlive the AsyncSocket briefly.
+            struct State
+            {
+                ouc_server::ouc_socket::TCPSocket socket;
+                ouc_server::epoll::EpollLoop *loop;
+                std::atomic<void *> waiter{nullptr}; ///< Suspended coroutine, resumed on readiness.
+                bool registered = false;             ///< fd added to the loop.
+
+                State(ouc_server::epoll::EpollLoop &p_loop, ouc_server::ouc_socket::TCPSocket &&p_socket)
+                    : socket(std::move(p_socket)), loop(&p_loop) {}
+            };
+
+            /// Suspends until the fd reports the requested events.
+            struct ReadyAwaiter
+            {
+                std::shared_ptr<State> state;
+                uint32_t events;
+                bool ok = true;
+
+                bool await_ready() const noexcept { return false; }
+
+                bool await_suspend(std::coroutine_handle<> h)
+                {
+                    if (!state)
+                    {
+                        ok = false;
+                        return false;
+                    }
+
+                    State &st = *state;
+                    int fd = st.socket.get_fd();
+                    st.waiter.store(h.address(), std::memory_order_release);
+
+                    // The event may fire and resume us on another thread as
+                    // soon as the fd is armed: touch nothing afterwards.
+                    bool armed;
+                    if (st.registered)
+                        armed = st.loop->modify_fd(fd, events | EPOLLONESHOT);
+                    else
+                    {
+                        st.registered = true;
+                        std::weak_ptr<State> weak = state;
+                        armed = st.loop->add_fd(
+                            fd, events | EPOLLONESHOT,
+                            [weak](int)
+                            {
+                                auto st = weak.lock();
+                                if (!st)
+                                    return;
+                                if (void *w = st->waiter.exchange(nullptr, std::memory_order_acquire))
+                                    std::coroutine_handle<>::from_address(w).resume();
+                            });
+                        if (!armed)
+                            st.registered = false;
+                    }
+
+                    if (!armed)
+                    {
+                        st.waiter.store(nullptr, std::memory_order_relaxed);
+                        ok = false;
+                        return false;
+                    }
+                    return true;
+                }
+
+                bool await_resume() const noexcept { return ok; }
+            };
+
+            std::shared_ptr<State> state;
+            /// Largest single recv, kept out of the frames so they stay pooled.
+            static constexpr size_t SCRATCH_SIZE = 16384;
+
+            std::string buffer; ///< Received but not yet returned.
+            bool eof = false;
+
+        public:
+            AsyncSocket() = default;
+
+            /**
+             * @param loop Loop resuming this socket's operations.
+             * @param socket Non-blocking socket, owned from now on.
+             */
+            AsyncSocket(ouc_server::epoll::EpollLoop &loop, ouc_server::ouc_socket::TCPSocket &&socket)
+                : state(std::make_shared<State>(loop, std::move(socket))) {}
+
+            AsyncSocket(AsyncSocket &&) noexcept = default;
+            AsyncSocket &operator=(AsyncSocket &&other) noexcept
+            {
+                if (this != &other)
+                {
+                    close();
+                    state = std::move(other.state);
+                    buffer = std::move(other.buffer);
+                    eof = other.eof;
+                }
+                return *this;
+            }
+
+            ~AsyncSocket() { close(); }
+
+            bool is_open() const noexcept { return state && state->socket.get_fd() >= 0; }
+
+            /// The peer closed its side, no more data will arrive.
+            bool is_eof() const noexcept { return eof && buffer.empty(); }
+
+            ouc_server::ouc_socket::TCPSocket &socket() noexcept { return state->socket; }
+
+            /// Leave the loop and close the socket.
+            void close()
+            {
+                if (!state)
+                    return;
+                if (state->registered)
+                    state->loop->remove_fd(state->socket.get_fd());
+                state->socket.close();
+                state.reset();
+            }
+
+            /// Suspend until the socket is readable.
+            ReadyAwaiter readable() { return ReadyAwaiter{state, EPOLLIN | EPOLLRDHUP}; }
+
+            /// Suspend until the socket is writable.
+            ReadyAwaiter writable() { return ReadyAwaiter{state, EPOLLOUT}; }
+
+            /**
+             * @brief Next received bytes, whatever amount is available.
+             * @param max Most bytes to return.
+             * @return The bytes, empty on end of stream or error.
+             */
+            Task<std::string> read_some(size_t max = SCRATCH_SIZE)
+            {
+                if (buffer.empty() && !co_await fill(max))
+                    co_return std::string();
+
+                std::string out;
+                if (buffer.size() <= max)
+                    out.swap(buffer);
+                else
+                {
+                    out = buffer.substr(0, max);
+                    buffer.erase(0, max);
+                }
+                co_return out;
+            }
+
+            /**
+             * @brief Bytes up to and including a delimiter, the rest stays buffered.
+             * @param delim Delimiter to look for, e.g. "\r\n\r\n".
+             * @param max Give up once this many bytes arrived without it.
+             * @return The bytes, empty on end of stream, error or overflow.
+             */
+            Task<std::string> read_until(std::string_view delim, size_t max = 64 * 1024)
+            {
+                size_t searched = 0;
+                while (true)
+                {
+                    size_t pos = buffer.find(delim, searched);
+                    if (pos != std::string::npos)
+                    {
+                        std::string out = buffer.substr(0, pos + delim.size());
+                        buffer.erase(0, pos + delim.size());
+                        co_return out;
+                    }
+                    if (buffer.size() >= max)
+                        co_return std::string();
+
+                    // Only bytes that arrive next can complete a match
+                    searched = buffer.size() >= delim.size() ? buffer.size() - delim.size() + 1 : 0;
+                    if (!co_await fill(SCRATCH_SIZE))
+                        co_return std::string();
+                }
+            }
+
+            /**
+             * @brief Send all bytes, suspending whenever the socket buffer is full.
+             * @param data Bytes to send, must stay valid until the call completes.
+             * @return false on error.
+             */
+            Task<bool> write_all(std::string_view data)
+            {
+                while (!data.empty())
+                {
+                    ssize_t n = state ? state->socket.send(data.data(), data.size()) : -1;
+                    if (n < 0)
+                        co_return false;
+                    data.remove_prefix(static_cast<size_t>(n));
+                    if (!data.empty() && !co_await writable())
+                        co_return false;
+                }
+                co_return true;
+            }
+
+            /**
+             * @brief Accept a connection on a listening socket.
+             * @return The connection on the same loop, closed on error.
+             */
+            Task<AsyncSocket> accept()
+            {
+                while (state)
+                {
+                    auto client = state->socket.accept();
+                    if (client.get_fd() >= 0)
+                        co_return AsyncSocket(*state->loop, std::move(client));
+                    if (errno == EINTR || errno == ECONNABORTED)
+                        continue;
+                    if ((errno != EAGAIN && errno != EWOULDBLOCK) || !co_await readable())
+                        break;
+                }
+                co_return AsyncSocket();
+            }
+
+        private:
+            /// Receive buffer shared by the coroutines of a thread, no recv spans a suspension.
+            static char *scratch() noexcept
+            {
+                thread_local char chunk[SCRATCH_SIZE];
+                return chunk;
+            }
+
+            /// Append what the socket has to the buffer, false on end of stream or error.
+            Task<bool> fill(size_t max)
+            {
+                max = std::min(max, SCRATCH_SIZE);
+                while (state && !eof)
+                {
+                    char *chunk = scratch();
+                    ssize_t n = state->socket.recv(chunk, max);
+                    if (n > 0)
+                    {
+                        buffer.append(chunk, static_cast<size_t>(n));
+                        co_return true;
+                    }
+                    if (n == 0)
+                    {
+                        eof = true;
+                        break;
+                    }
+                    if (errno == EINTR)
+                        continue;
+                    if ((errno != EAGAIN && errno != EWOULDBLOCK) || !co_await readable())
+                        break;
+                }
+                co_return false;
+            }
+        };
+
+        /// Awaiter resuming after a delay, from the loop's timer.
+        struct SleepAwaiter
+        {
+            ouc_server::epoll::EpollLoop &loop;
+            std::chrono::nanoseconds delay;
+
+            bool await_ready() const noexcept { return delay.count() <= 0; }
+
+            void await_suspend(std::coroutine_handle<> h)
+            {
+                loop.add_timer(delay, [h]()
+                               { h.resume(); });
+            }
+
+            void await_resume() const noexcept {}
+        };
+
+        /**
+         * @brief Suspend for a while without holding a thread.
+         * @param loop Loop whose timer resumes the coroutine.
+         * @param delay Time to sleep.
+         */
+        template <typename Rep, typename Period>
+        SleepAwaiter sleep_for(ouc_server::epoll::EpollLoop &loop, std::chrono::duration<Rep, Period> delay)
+        {
+            return SleepAwaiter{loop, std::chrono::duration_cast<std::chrono::nanoseconds>(delay)};
+        }
+
+        using ConnectionHandler = std::function<Task<void>(AsyncSocket)>;
+
+        /**
+         * @brief Accept connections and spawn a handler coroutine for each.
+         *
+         * Returns once accepting fails, e.g. after the listener was closed.
+         * The handler is copied into the serve() frame, whatever it captures
+         * must outlive the connections.
+         *
+         * @param loop Loop driving the listener and the connections.
+         * @param listener Bound and listening non-blocking socket.
+         * @param handler Coroutine run for each connection.
+         */
+        inline Task<void> serve(ouc_server::epoll::EpollLoop &loop, ouc_server::ouc_socket::TCPSocket listener, ConnectionHandler handler)
+        {
+            AsyncSocket acceptor(loop, std::move(listener));
+            while (true)
+            {
+                AsyncSocket conn = co_await acceptor.accept();
+                if (!conn.is_open())
+                    co_return;
+                spawn(handler(std::move(conn)));
+            }
+        }
+    }
+}
+
+#endif // INCLUDE_OUC_SERVER_CORO_ASYNC_SOCKET
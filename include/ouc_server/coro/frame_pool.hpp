@@ -0,0 +1,120 @@
+/**
+ * @file frame_pool.hpp
+ * @brief Recycling allocator for coroutine frames.
+ *
+ * A connection handler allocates a frame for every coroutine it calls,
+ * several per request. Frames are rounded up to FRAME_GRANULE size classes
+ * and freed frames are kept on a per-thread free list, so steady-state
+ * request handling does not reach malloc. The I/O threads of an EpollLoop
+ * each keep their own lists; a frame freed on another thread simply joins
+ * that thread's list.
+ */
+
+#ifndef INCLUDE_OUC_SERVER_CORO_FRAME_POOL
+#define INCLUDE_OUC_SERVER_CORO_FRAME_POOL
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <array>
+
+namespace ouc_server
+{
+    namespace coro
+    {
+        class FramePool
+        {
+        public:
+            static constexpr size_t FRAME_GRANULE = 64;    ///< Size class step.
+            static constexpr size_t MAX_POOLED_SIZE = 4096; ///< Larger frames go straight to operator new.
+            static constexpr size_t MAX_FREE_PER_CLASS = 256;
+            static constexpr size_t CLASS_COUNT = MAX_POOLED_SIZE / FRAME_GRANULE;
+
+        private:
+            /// Precedes each frame, keeps the frame aligned for any type.
+            struct alignas(std::max_align_t) Header
+            {
+                uint32_t size_class; ///< CLASS_COUNT for unpooled frames.
+            };
+
+            struct FreeNode
+            {
+                FreeNode *next;
+            };
+
+            struct Lists
+            {
+                std::array<FreeNode *, CLASS_COUNT> heads{};
+                std::array<size_t, CLASS_COUNT> counts{};
+
+                ~Lists()
+                {
+                    for (auto *head : heads)
+                        while (head)
+                        {
+                            FreeNode *next = head->next;
+                            ::operator delete(head);
+                            head = next;
+                        }
+                }
+            };
+
+            static Lists &lists()
+            {
+                thread_local Lists instance;
+                return instance;
+            }
+
+        public:
+            static void *allocate(size_t size)
+            {
+                size_t total = size + sizeof(Header);
+                uint32_t size_class = total <= MAX_POOLED_SIZE
+                                          ? static_cast<uint32_t>((total + FRAME_GRANULE - 1) / FRAME_GRANULE - 1)
+                                          : CLASS_COUNT;
+
+                void *block = nullptr;
+                if (size_class < CLASS_COUNT)
+                {
+                    Lists &l = lists();
+                    if (FreeNode *node = l.heads[size_class])
+                    {
+                        l.heads[size_class] = node->next;
+                        --l.counts[size_class];
+                        block = node;
+                    }
+                    else
+                        block = ::operator new((size_class + 1) * FRAME_GRANULE);
+                }
+                else
+                    block = ::operator new(total);
+
+                auto *header = static_cast<Header *>(block);
+                header->size_class = size_class;
+                return header + 1;
+            }
+
+            static void deallocate(void *frame) noexcept
+            {
+                auto *header = static_cast<Header *>(frame) - 1;
+                uint32_t size_class = header->size_class;
+
+                if (size_class < CLASS_COUNT)
+                {
+                    Lists &l = lists();
+                    if (l.counts[size_class] < MAX_FREE_PER_CLASS)
+                    {
+                        auto *node = reinterpret_cast<FreeNode *>(header);
+                        node->next = l.heads[size_class];
+                        l.heads[size_class] = node;
+                        ++l.counts[size_class];
+                        return;
+                    }
+                }
+                ::operator delete(header);
+            }
+        };
+    }
+}
+
+#endif // INCLUDE_OUC_SERVER_CORO_FRAME_POOL
@@ -0,0 +1,204 @@
+/**
+ * @file task.hpp
+ * @brief Lazily started coroutine type and detached spawning.
+ *
+ * Requires C++20. The rest of the library stays C++17; only code that
+ * includes coro/ needs to be built with coroutine support.
+ *
+ * A Task starts when awaited and resumes its awaiter when done, by
+ * symmetric transfer, so deep call chains neither block a thread nor grow
+ * the stack. spawn() starts a Task<void> nobody awaits, e.g. one handler
+ * per accepted connection.
+ *
+ * Example:
+ * @code
+ * Task<int> answer() { co_return 42; }
+ * Task<void> run() { int v = co_await answer(); ... }
+ * spawn(run());
+ * @endcode
+ */
+
+#ifndef INCLUDE_OUC_SERVER_CORO_TASK
+#define INCLUDE_OUC_SERVER_CORO_TASK
+
+#if !defined(__cpp_impl_coroutine)
+#error "coro/ needs C++20 coroutines, build with -std=c++20"
+#endif
+
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <utility>
+
+#include <coro/frame_pool.hpp>
+
+namespace ouc_server
+{
+    namespace coro
+    {
+        template <typename T>
+        class Task;
+
+        namespace detail
+        {
+            /// Frames come from FramePool, the rest is shared by every Task promise.
+            struct PromiseBase
+            {
+                std::coroutine_handle<> continuation; ///< Awaiter resumed at the end.
+                std::exception_ptr exception;
+
+                static void *operator new(size_t size) { return FramePool::allocate(size); }
+                static void operator delete(void *frame) noexcept { FramePool::deallocate(frame); }
+
+                struct FinalAwaiter
+                {
+                    bool await_ready() const noexcept { return false; }
+
+                    template <typename Promise>
+                    std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> h) noexcept
+                    {
+                        auto next = h.promise().continuation;
+                        return next ? next : std::noop_coroutine();
+                    }
+
+                    void await_resume() const noexcept {}
+                };
+
+                std::suspend_always initial_suspend() const noexcept { return {}; }
+                FinalAwaiter final_suspend() const noexcept { return {}; }
+                void unhandled_exception() noexcept { exception = std::current_exception(); }
+            };
+
+            template <typename T>
+            struct Promise : PromiseBase
+            {
+                std::optional<T> value;
+
+                Task<T> get_return_object() noexcept;
+                void return_value(T v) { value.emplace(std::move(v)); }
+
+                T take()
+                {
+                    if (exception)
+                        std::rethrow_exception(exception);
+                    return std::move(*value);
+                }
+            };
+
+            template <>
+            struct Promise<void> : PromiseBase
+            {
+                Task<void> get_return_object() noexcept;
+                void return_void() const noexcept {}
+
+                void take()
+                {
+                    if (exception)
+                        std::rethrow_exception(exception);
+                }
+            };
+        }
+
+        template <typename T = void>
+        class [[nodiscard]] Task
+        {
+        public:
+            using promise_type = detail::Promise<T>;
+
+        private:
+            std::coroutine_handle<promise_type> handle;
+
+        public:
+            explicit Task(std::coroutine_handle<promise_type> h) noexcept : handle(h) {}
+
+            Task(Task &&other) noexcept : handle(std::exchange(other.handle, {})) {}
+
+            Task &operator=(Task &&other) noexcept
+            {
+                if (this != &other)
+                {
+                    if (handle)
+                        handle.destroy();
+                    handle = std::exchange(other.handle, {});
+                }
+                return *this;
+            }
+
+            Task(const Task &) = delete;
+            Task &operator=(const Task &) = delete;
+
+            ~Task()
+            {
+                if (handle)
+                    handle.destroy();
+            }
+
+            auto operator co_await() && noexcept
+            {
+                struct Awaiter
+                {
+                    std::coroutine_handle<promise_type> handle;
+
+                    bool await_ready() const noexcept { return false; }
+
+                    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+                    {
+                        handle.promise().continuation = awaiting;
+                        return handle;
+                    }
+
+                    T await_resume() { return handle.promise().take(); }
+                };
+                return Awaiter{handle};
+            }
+        };
+
+        namespace detail
+        {
+            template <typename T>
+            Task<T> Promise<T>::get_return_object() noexcept
+            {
+                return Task<T>(std::coroutine_handle<Promise<T>>::from_promise(*this));
+            }
+
+            inline Task<void> Promise<void>::get_return_object() noexcept
+            {
+                return Task<void>(std::coroutine_handle<Promise<void>>::from_promise(*this));
+            }
+
+            /// Owner of a spawned task, frees itself when the task ends.
+            struct Detached
+            {
+                struct promise_type
+                {
+                    static void *operator new(size_t size) { return FramePool::allocate(size); }
+                    static void operator delete(void *frame) noexcept { FramePool::deallocate(frame); }
+
+                    Detached get_return_object() const noexcept { return {}; }
+                    std::suspend_never initial_suspend() const noexcept { return {}; }
+                    std::suspend_never final_suspend() const noexcept { return {}; }
+                    void return_void() const noexcept {}
+                    void unhandled_exception() const noexcept {} // nobody to report to
+                };
+            };
+
+            inline Detached run_detached(Task<void> task)
+            {
+                co_await std::move(task);
+            }
+        }
+
+        /**
+         * @brief Start a task that nobody awaits.
+         *
+         * Runs on the calling thread up to its first suspension; exceptions
+         * escaping it are dropped.
+         */
+        inline void spawn(Task<void> &&task)
+        {
+            detail::run_detached(std::move(task));
+        }
+    }
+}
+
+#endif // INCLUDE_OUC_SERVER_CORO_TASK
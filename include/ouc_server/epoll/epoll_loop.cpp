@@ -3,32 +3,70 @@
 #include <unistd.h>
 #include <sys/socket.h>
 #include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
 #include <netinet/in.h>
 #include <vector>
+#include <algorithm>
+
+#include <utils/trace.hpp>
 
 namespace ouc_server
 {
     namespace epoll
     {
 
-        EpollLoop::EpollLoop(size_t n)
-            : pool(n)
+        EpollLoop::EpollLoop(size_t n, const std::vector<int> &cpus)
+            : pool(n, cpus)
         {
             epoll_fd = epoll_create1(0);
             if (epoll_fd < 0)
                 perror("epoll_create1");
+
+            // Level-triggered: every poll() returns until the wakeup is consumed
+            wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+            if (wake_fd < 0)
+                perror("eventfd");
+            else
+            {
+                auto ev = pack_event(wake_fd, EPOLLIN);
+                epoll_ctl(epoll_fd, EPOLL_CTL_ADD, wake_fd, &ev);
+            }
+
+            // steady_clock is CLOCK_MONOTONIC, deadlines are absolute in it
+            timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+            if (timer_fd < 0)
+                perror("timerfd_create");
+            else
+            {
+                auto ev = pack_event(timer_fd, EPOLLIN);
+                epoll_ctl(epoll_fd, EPOLL_CTL_ADD, timer_fd, &ev);
+            }
         }
 
         EpollLoop::~EpollLoop()
         {
             close(epoll_fd);
+            if (wake_fd >= 0)
+                close(wake_fd);
+            if (timer_fd >= 0)
+                close(timer_fd);
+        }
+
+        void EpollLoop::wakeup()
+        {
+            uint64_t one = 1;
+            if (wake_fd >= 0)
+                (void)!write(wake_fd, &one, sizeof(one));
         }
 
         void EpollLoop::poll(const int timeout_ms, const int MAX_EVENTS)
         {
             epoll_event events[MAX_EVENTS];
 
-            int nfds = epoll_wait(epoll_fd, events, MAX_EVENTS, timeout_ms);
+            OUC_TRACE(EpollWaitBegin, -1);
+            int nfds = wait(events, MAX_EVENTS, timeout_ms);
+            OUC_TRACE(EpollWaitEnd, nfds);
             if (nfds < 0)
             {
                 if (errno == EINTR)
@@ -36,24 +74,175 @@ namespace ouc_server
                 perror("epoll_wait");
                 return;
             }
+            events_per_wait.record(static_cast<uint64_t>(nfds));
 
             for (int i = 0; i < nfds; ++i)
             {
                 int fd = events[i].data.fd;
-                if (callbacks.count(fd))
+                if (fd == wake_fd)
+                {
+                    uint64_t count;
+                    (void)!read(wake_fd, &count, sizeof(count));
+                    continue;
+                }
+                if (fd == timer_fd)
+                {
+                    uint64_t count;
+                    (void)!read(timer_fd, &count, sizeof(count));
+                    fire_timers();
+                    continue;
+                }
+
+                EpollCallback callback;
+                {
+                    std::lock_guard<std::mutex> lk(mtx);
+                    auto it = callbacks.find(fd);
+                    if (it == callbacks.end())
+                        continue;
+                    callback = it->second.callback;
+                }
+
+                OUC_TRACE(Dispatch, fd);
+                pool.sumbit(
+                    [callback = std::move(callback), fd]()
+                    {
+                        OUC_TRACE(CallbackBegin, fd);
+                        callback(fd);
+                        OUC_TRACE(CallbackEnd, fd);
+                    });
+            }
+        }
+
+        uint64_t EpollLoop::add_timer(std::chrono::nanoseconds delay, TimerCallback callback)
+        {
+            using namespace std::chrono;
+            int64_t deadline = duration_cast<nanoseconds>(steady_clock::now().time_since_epoch() + std::max(delay, nanoseconds(0))).count();
+
+            std::lock_guard<std::mutex> lk(timers_mtx);
+            uint64_t id = next_timer_id++;
+            timers.emplace(std::make_pair(deadline, id), std::move(callback));
+            timer_deadlines.emplace(id, deadline);
+
+            // New earliest deadline: move the timerfd forward
+            if (timers.begin()->first.second == id)
+                arm_timer_fd();
+            return id;
+        }
+
+        bool EpollLoop::cancel_timer(uint64_t id)
+        {
+            std::lock_guard<std::mutex> lk(timers_mtx);
+            auto it = timer_deadlines.find(id);
+            if (it == timer_deadlines.end())
+                return false;
+
+            timers.erase(std::make_pair(it->second, id));
+            timer_deadlines.erase(it);
+            return true;
+        }
+
+        void EpollLoop::arm_timer_fd()
+        {
+            if (timer_fd < 0)
+                return;
+
+            // A zero it_value disarms, an empty timer set wants exactly that
+            itimerspec spec{};
+            if (!timers.empty())
+            {
+                int64_t deadline = std::max<int64_t>(timers.begin()->first.first, 1);
+                spec.it_value.tv_sec = deadline / 1'000'000'000;
+                spec.it_value.tv_nsec = deadline % 1'000'000'000;
+            }
+            timerfd_settime(timer_fd, TFD_TIMER_ABSTIME, &spec, nullptr);
+        }
+
+        void EpollLoop::fire_timers()
+        {
+            using namespace std::chrono;
+            int64_t now = duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+
+            std::vector<TimerCallback> due;
+            {
+                std::lock_guard<std::mutex> lk(timers_mtx);
+                while (!timers.empty() && timers.begin()->first.first <= now)
+                {
+                    auto it = timers.begin();
+                    timer_deadlines.erase(it->first.second);
+                    due.push_back(std::move(it->second));
+                    timers.erase(it);
+                }
+                arm_timer_fd();
+            }
+
+            for (auto &callback : due)
+                pool.sumbit(std::move(callback));
+        }
+
+        int EpollLoop::wait(epoll_event *events, int max_events, int timeout_ms)
+        {
+            using namespace std::chrono;
+
+            int64_t window = busy_poll_ns.load(std::memory_order_relaxed);
+            if (window <= 0 || timeout_ms == 0)
+                return epoll_wait(epoll_fd, events, max_events, timeout_ms);
+
+            auto now = [] { return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count(); };
+            int64_t start = now();
+            int64_t spin_until = last_activity.load(std::memory_order_relaxed) + window;
+
+            // Recently busy: more events are likely, poll without sleeping.
+            // Each poll starts inside the window, so a hit is a spin win.
+            if (start < spin_until)
+            {
+                while (true)
                 {
-                    pool.sumbit(
-                        [ev = callbacks[fd], fd]()
-                        { ev.callback(fd); });
+                    int nfds = epoll_wait(epoll_fd, events, max_events, 0);
+                    int64_t t = now();
+                    if (nfds != 0)
+                    {
+                        if (nfds > 0)
+                        {
+                            spin_hits.add();
+                            last_activity.store(t, std::memory_order_relaxed);
+                        }
+                        return nfds;
+                    }
+                    if (t >= spin_until || (timeout_ms > 0 && t - start >= int64_t(timeout_ms) * 1'000'000))
+                        break;
+#if defined(__x86_64__) || defined(__i386__)
+                    __builtin_ia32_pause();
+#endif
                 }
             }
+
+            // Quiet for the whole window, or idle before it: block for what is left of the timeout
+            int remaining = timeout_ms;
+            if (timeout_ms > 0)
+                remaining = std::max<int>(0, timeout_ms - static_cast<int>((now() - start) / 1'000'000));
+
+            int nfds = epoll_wait(epoll_fd, events, max_events, remaining);
+            if (nfds > 0)
+                last_activity.store(now(), std::memory_order_relaxed);
+            return nfds;
         }
 
         bool EpollLoop::add_fd(int fd, uint32_t event_flags, EpollCallback callback)
         {
             auto ev = pack_event(fd, event_flags);
+            {
+                // Register the callback first so an event fired right after
+                // EPOLL_CTL_ADD always finds it.
+                std::lock_guard<std::mutex> lk(mtx);
+                callbacks[fd] = Event{fd, event_flags, std::move(callback)};
+            }
+
             int code = epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev);
-            callbacks[fd] = Event{fd, event_flags, std::move(callback)};
+            if (code != 0)
+            {
+                std::lock_guard<std::mutex> lk(mtx);
+                callbacks.erase(fd);
+            }
             return code == 0;
         }
 
@@ -61,13 +250,19 @@ namespace ouc_server
         {
             auto ev = pack_event(fd, event_flags);
             int code = epoll_ctl(epoll_fd, EPOLL_CTL_MOD, fd, &ev);
-            callbacks[fd].events = event_flags;
+
+            std::lock_guard<std::mutex> lk(mtx);
+            auto it = callbacks.find(fd);
+            if (it != callbacks.end())
+                it->second.events = event_flags;
             return code == 0;
         }
 
         bool EpollLoop::remove_fd(int fd)
         {
             int code = epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+
+            std::lock_guard<std::mutex> lk(mtx);
             callbacks.erase(fd);
             return code == 0;
         }
@@ -3,20 +3,27 @@
 
 #include <cstdint>
 #include <string>
+#include <vector>
 #include <functional>
 #include <unordered_map>
+#include <map>
+#include <mutex>
+#include <atomic>
+#include <chrono>
 #include <unistd.h>
 #include <sys/socket.h>
 #include <sys/epoll.h>
 #include <netinet/in.h>
 
 #include <utils/thread_pool.hpp>
+#include <utils/metrics.hpp>
 
 namespace ouc_server
 {
     namespace epoll
     {
         using EpollCallback = std::function<void(int)>;
+        using TimerCallback = std::function<void()>;
 
         struct Event
         {
@@ -29,12 +36,30 @@ namespace ouc_server
         {
         private:
             int epoll_fd;
+            int wake_fd;  ///< eventfd interrupting a blocking poll().
+            int timer_fd; ///< timerfd armed for the earliest timer.
+            std::mutex mtx;
             std::unordered_map<int, Event> callbacks;
 
+            std::mutex timers_mtx;                                           ///< Guards the timer fields.
+            std::map<std::pair<int64_t, uint64_t>, TimerCallback> timers;    ///< Pending timers by deadline and id.
+            std::unordered_map<uint64_t, int64_t> timer_deadlines;           ///< Deadline of each pending timer id.
+            uint64_t next_timer_id = 1;
+
             ouc_server::utils::ThreadPool pool;
 
+            ouc_server::utils::MetricHistogram events_per_wait; ///< Ready fds returned by each epoll_wait.
+
+            std::atomic<int64_t> busy_poll_ns{0};   ///< Spin window after activity, 0 disables spinning.
+            std::atomic<int64_t> last_activity{0};  ///< steady_clock ns of the last non-empty wait.
+            ouc_server::utils::Counter spin_hits;   ///< Waits answered while spinning.
+
         public:
-            EpollLoop(size_t = 64);
+            /**
+             * @param n Callback pool size, 0 for utils::default_thread_count().
+             * @param cpus CPUs to pin the pool to, empty leaves it unpinned.
+             */
+            EpollLoop(size_t n = 0, const std::vector<int> &cpus = {});
 
             ~EpollLoop();
 
@@ -45,8 +70,71 @@ namespace ouc_server
             bool modify_fd(int, uint32_t);
             bool remove_fd(int);
 
+            /**
+             * @brief Spin instead of sleeping for a while after each burst of events.
+             *
+             * For up to `window` after the last wait that returned events,
+             * poll() checks for events without blocking instead of sleeping
+             * in epoll_wait, saving the wakeup latency at the cost of a busy
+             * core. Once the loop has been quiet that long it blocks again.
+             *
+             * @param window Spin duration, zero to always block.
+             */
+            void set_busy_poll(std::chrono::microseconds window)
+            {
+                busy_poll_ns.store(std::chrono::duration_cast<std::chrono::nanoseconds>(window).count());
+            }
+
+            std::chrono::microseconds get_busy_poll() const noexcept
+            {
+                return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::nanoseconds(busy_poll_ns.load()));
+            }
+
+            /// Waits that found events while spinning, i.e. saved a wakeup.
+            uint64_t get_spin_hits() const noexcept { return spin_hits.value(); }
+
+            /**
+             * @brief Run a callback on the pool once a delay has passed.
+             *
+             * Timers fire from poll(), so their resolution is that of the
+             * loop: a callback never runs early, but may run late while the
+             * pool is busy.
+             *
+             * @param delay Time to wait, zero or negative fires on the next poll().
+             * @param callback Function to run.
+             * @return Timer id for cancel_timer(), never 0.
+             */
+            uint64_t add_timer(std::chrono::nanoseconds delay, TimerCallback callback);
+
+            /**
+             * @brief Cancel a pending timer.
+             * @return false if it already fired or was cancelled.
+             */
+            bool cancel_timer(uint64_t id);
+
+            /// Make a poll() blocked in another thread return, safe from any thread.
+            void wakeup();
+
+            /// Let dispatched callbacks finish and join the pool, poll() must not be called afterwards.
+            void shutdown() { pool.shutdown(); }
+
+            /// Its count is the number of completed epoll_wait calls.
+            const ouc_server::utils::MetricHistogram &get_events_histogram() const noexcept { return events_per_wait; }
+
+            /// Pool running the fd callbacks.
+            ouc_server::utils::ThreadPool &get_pool() noexcept { return pool; }
+
         private:
             struct epoll_event pack_event(int, uint32_t);
+
+            /// Point timer_fd at the earliest deadline, timers_mtx held.
+            void arm_timer_fd();
+
+            /// Dispatch every timer that is due.
+            void fire_timers();
+
+            /// epoll_wait, spinning first while within the busy-poll window.
+            int wait(epoll_event *events, int max_events, int timeout_ms);
         };
     }
 }
@@ -0,0 +1,249 @@
+#include <http/http_compression.hpp>
+
+#include <algorithm>
+
+#ifdef OUC_SERVER_ZLIB
+#include <zlib.h>
+#endif
+
+#include <http/http_headers.hpp>
+
+namespace ouc_server
+{
+    namespace http
+    {
+        namespace
+        {
+            std::string_view trim(std::string_view str)
+            {
+                while (!str.empty() && (str.front() == ' ' || str.front() == '\t'))
+                    str.remove_prefix(1);
+                while (!str.empty() && (str.back() == ' ' || str.back() == '\t'))
+                    str.remove_suffix(1);
+                return str;
+            }
+
+            /// q-value of one Accept-Encoding item, e.g. "gzip;q=0.5" gives 500.
+            int quality_of(std::string_view params)
+            {
+                size_t q = params.find("q=");
+                if (q == std::string_view::npos)
+                    return 1000;
+
+                std::string_view value = trim(params.substr(q + 2));
+                if (value.empty() || (value[0] != '0' && value[0] != '1'))
+                    return 0;
+
+                int quality = (value[0] - '0') * 1000;
+                int scale = 100;
+                for (size_t i = 2; i < value.size() && i < 5 && value[1] == '.'; ++i, scale /= 10)
+                {
+                    if (value[i] < '0' || value[i] > '9')
+                        break;
+                    quality += (value[i] - '0') * scale;
+                }
+                return std::min(quality, 1000);
+            }
+
+#ifdef OUC_SERVER_ZLIB
+            /// zlib stream of one coding, reset between bodies.
+            struct Deflater
+            {
+                z_stream stream{};
+                int level = -1; ///< Level the stream was set up with, -1 if not yet.
+
+                ~Deflater()
+                {
+                    if (level >= 0)
+                        deflateEnd(&stream);
+                }
+
+                bool prepare(int window_bits, int p_level)
+                {
+                    if (level == p_level)
+                        return deflateReset(&stream) == Z_OK;
+
+                    if (level >= 0)
+                        deflateEnd(&stream);
+                    level = -1;
+                    stream = z_stream{};
+                    if (deflateInit2(&stream, p_level, Z_DEFLATED, window_bits, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+                        return false;
+                    level = p_level;
+                    return true;
+                }
+            };
+#endif
+        }
+
+        const char *encoding_name(ContentEncoding encoding) noexcept
+        {
+            switch (encoding)
+            {
+            case ContentEncoding::Gzip:
+                return "gzip";
+            case ContentEncoding::Deflate:
+                return "deflate";
+            case ContentEncoding::Identity:
+            default:
+                return "";
+            }
+        }
+
+        ContentEncoding negotiate_encoding(std::string_view accept_encoding)
+        {
+            int gzip = -1, deflate = -1, any = -1;
+            while (!accept_encoding.empty())
+            {
+                size_t comma = accept_encoding.find(',');
+                std::string_view item = accept_encoding.substr(0, comma);
+                accept_encoding = comma == std::string_view::npos ? std::string_view() : accept_encoding.substr(comma + 1);
+
+                size_t semi = item.find(';');
+                std::string_view name = trim(item.substr(0, semi));
+                int quality = semi == std::string_view::npos ? 1000 : quality_of(item.substr(semi + 1));
+
+                if (iequals(name, "gzip") || iequals(name, "x-gzip"))
+                    gzip = quality;
+                else if (iequals(name, "deflate"))
+                    deflate = quality;
+                else if (name == "*")
+                    any = quality;
+            }
+
+            // Codings not listed get the wildcard's preference, if any
+            if (gzip < 0)
+                gzip = any;
+            if (deflate < 0)
+                deflate = any;
+
+            if (gzip > 0 && gzip >= deflate)
+                return ContentEncoding::Gzip;
+            if (deflate > 0)
+                return ContentEncoding::Deflate;
+            return ContentEncoding::Identity;
+        }
+
+        bool is_compressible(std::string_view content_type)
+        {
+            std::string_view type = trim(content_type.substr(0, content_type.find(';')));
+            auto starts = [type](std::string_view prefix)
+            { return type.size() >= prefix.size() && iequals(type.substr(0, prefix.size()), prefix); };
+            auto ends = [type](std::string_view suffix)
+            { return type.size() >= suffix.size() && iequals(type.substr(type.size() - suffix.size()), suffix); };
+
+            return starts("text/") || ends("/json") || ends("+json") || ends("/xml") || ends("+xml") ||
+                   ends("/javascript") || ends("/x-javascript") || iequals(type, "image/svg+xml");
+        }
+
+        bool compress(ContentEncoding encoding, std::string_view in, std::string &out, int level)
+        {
+#ifdef OUC_SERVER_ZLIB
+            if (encoding == ContentEncoding::Identity)
+                return false;
+
+            // One stream per coding and thread, reused for every body
+            thread_local Deflater deflaters[2];
+            bool gzip = encoding == ContentEncoding::Gzip;
+            Deflater &deflater = deflaters[gzip ? 0 : 1];
+            if (!deflater.prepare(gzip ? 15 + 16 : 15, level))
+                return false;
+
+            z_stream &stream = deflater.stream;
+            out.resize(deflateBound(&stream, in.size()));
+            stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(in.data()));
+            stream.avail_in = static_cast<uInt>(in.size());
+            stream.next_out = reinterpret_cast<Bytef *>(out.data());
+            stream.avail_out = static_cast<uInt>(out.size());
+
+            // deflateBound leaves room for everything: a single call finishes
+            if (deflate(&stream, Z_FINISH) != Z_STREAM_END)
+                return false;
+            out.resize(stream.total_out);
+            return true;
+#else
+            (void)encoding;
+            (void)in;
+            (void)out;
+            (void)level;
+            return false;
+#endif
+        }
+
+        CompressionCache::CompressionCache(const CompressionConfig &p_config)
+            : config(p_config)
+        {
+        }
+
+        CompressionCache::Variant CompressionCache::get(const std::string &key, ContentEncoding encoding, std::string_view body)
+        {
+            std::string full_key = key;
+            full_key.push_back('\0');
+            full_key.append(encoding_name(encoding));
+
+            {
+                std::lock_guard<std::mutex> lk(mtx);
+                auto it = index.find(full_key);
+                if (it != index.end())
+                {
+                    lru.splice(lru.begin(), lru, it->second);
+                    ++hits;
+                    return it->second->data;
+                }
+                ++misses;
+            }
+
+            // Compressed outside the lock: two threads may race on the same
+            // key, the second insert is simply dropped
+            auto data = std::make_shared<std::string>();
+            if (!compress(encoding, body, *data, config.level))
+                return nullptr;
+            Variant variant = std::move(data);
+            if (variant->size() > config.cache_bytes)
+                return variant;
+
+            std::lock_guard<std::mutex> lk(mtx);
+            if (index.count(full_key) != 0)
+                return variant;
+
+            lru.push_front(Entry{std::move(full_key), variant});
+            index.emplace(lru.front().key, lru.begin());
+            bytes += variant->size();
+
+            while (bytes > config.cache_bytes && !lru.empty())
+            {
+                Entry &last = lru.back();
+                bytes -= last.data->size();
+                index.erase(last.key);
+                lru.pop_back();
+            }
+            return variant;
+        }
+
+        void CompressionCache::clear()
+        {
+            std::lock_guard<std::mutex> lk(mtx);
+            index.clear();
+            lru.clear();
+            bytes = 0;
+        }
+
+        size_t CompressionCache::get_bytes()
+        {
+            std::lock_guard<std::mutex> lk(mtx);
+            return bytes;
+        }
+
+        uint64_t CompressionCache::get_hits()
+        {
+            std::lock_guard<std::mutex> lk(mtx);
+            return hits;
+        }
+
+        uint64_t CompressionCache::get_misses()
+        {
+            std::lock_guard<std::mutex> lk(mtx);
+            return misses;
+        }
+    }
+}
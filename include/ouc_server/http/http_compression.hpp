@@ -0,0 +1,128 @@
+/**
+ * @file http_compression.hpp
+ * @brief gzip / deflate response bodies negotiated from Accept-Encoding.
+ *
+ * Compression runs on the thread producing the response, with zlib stream
+ * state kept per thread and reset between bodies instead of allocated for
+ * each one. Bodies that do not change, static files or pre-serialized
+ * payloads, can be given a key: their compressed variants are kept in a
+ * CompressionCache and served again without touching zlib.
+ *
+ * Built without zlib (OUC_SERVER_ZLIB undefined) compress() always fails
+ * and responses go out uncompressed.
+ */
+
+#ifndef INCLUDE_OUC_SERVER_HTTP_COMPRESSION
+#define INCLUDE_OUC_SERVER_HTTP_COMPRESSION
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace ouc_server
+{
+    namespace http
+    {
+        enum class ContentEncoding
+        {
+            Identity,
+            Gzip,
+            Deflate,
+        };
+
+        /// Name used in Content-Encoding, empty for Identity.
+        const char *encoding_name(ContentEncoding) noexcept;
+
+        /**
+         * @brief Pick the coding for a response from the request's Accept-Encoding.
+         *
+         * Honors q-values and `*`; on equal preference gzip wins over
+         * deflate, which some clients mis-decode.
+         *
+         * @param accept_encoding Header value, empty if absent.
+         */
+        ContentEncoding negotiate_encoding(std::string_view accept_encoding);
+
+        /**
+         * @brief Whether a media type is worth compressing: text, JSON, XML, JavaScript, SVG.
+         * @param content_type Content-Type value, parameters allowed.
+         */
+        bool is_compressible(std::string_view content_type);
+
+        /**
+         * @brief Compress a whole body with this thread's zlib stream.
+         * @param encoding Gzip or Deflate.
+         * @param in Body.
+         * @param out Replaced with the compressed bytes.
+         * @param level zlib level, 1 (fast) to 9 (small).
+         * @return false if the coding is unsupported or zlib failed.
+         */
+        bool compress(ContentEncoding encoding, std::string_view in, std::string &out, int level = 6);
+
+        struct CompressionConfig
+        {
+            size_t min_size = 1024;         ///< Smaller bodies are sent as is, the headers would eat the gain.
+            int level = 6;                  ///< zlib level.
+            size_t cache_bytes = 16 << 20;  ///< Compressed variants kept by CompressionCache, 0 disables it.
+        };
+
+        /**
+         * @class CompressionCache
+         * @brief Compressed variants of keyed bodies, least recently used evicted first.
+         *
+         * The key names the content, so it must change with it, e.g. a
+         * path plus its ETag. Thread-safe.
+         */
+        class CompressionCache
+        {
+        public:
+            using Variant = std::shared_ptr<const std::string>;
+
+        private:
+            struct Entry
+            {
+                std::string key; ///< Content key, followed by the coding.
+                Variant data;
+            };
+
+            CompressionConfig config;
+            std::mutex mtx;                                                      ///< Guards the fields below.
+            std::list<Entry> lru;                                                ///< Most recently used first.
+            std::unordered_map<std::string_view, std::list<Entry>::iterator> index; ///< Views into lru keys.
+            size_t bytes = 0;                                                    ///< Size of the cached variants.
+            uint64_t hits = 0;
+            uint64_t misses = 0;
+
+        public:
+            explicit CompressionCache(const CompressionConfig &p_config = CompressionConfig());
+
+            CompressionCache(const CompressionCache &) = delete;
+            CompressionCache &operator=(const CompressionCache &) = delete;
+
+            /**
+             * @brief The compressed variant of a body, compressed on first use.
+             * @param key Names the body's content.
+             * @param encoding Gzip or Deflate.
+             * @param body The body, only read on a miss.
+             * @return The variant, nullptr if it cannot be compressed.
+             */
+            Variant get(const std::string &key, ContentEncoding encoding, std::string_view body);
+
+            /// Drop every variant.
+            void clear();
+
+            const CompressionConfig &get_config() const noexcept { return config; }
+
+            size_t get_bytes();
+            uint64_t get_hits();
+            uint64_t get_misses();
+        };
+    }
+}
+
+#endif // INCLUDE_OUC_SERVER_HTTP_COMPRESSION
@@ -0,0 +1,268 @@
+#include <http/http_format.hpp>
+
+#include <cstring>
+#include <ctime>
+
+namespace ouc_server
+{
+    namespace http
+    {
+        namespace
+        {
+            constexpr int MIN_CODE = 100;
+            constexpr int MAX_CODE = 599;
+
+            const char *reason_of(int code) noexcept
+            {
+                switch (code)
+                {
+                case 100: return "Continue";
+                case 101: return "Switching Protocols";
+                case 102: return "Processing";
+                case 103: return "Early Hints";
+                case 200: return "OK";
+                case 201: return "Created";
+                case 202: return "Accepted";
+                case 203: return "Non-Authoritative Information";
+                case 204: return "No Content";
+                case 205: return "Reset Content";
+                case 206: return "Partial Content";
+                case 207: return "Multi-Status";
+                case 208: return "Already Reported";
+                case 226: return "IM Used";
+                case 300: return "Multiple Choices";
+                case 301: return "Moved Permanently";
+                case 302: return "Found";
+                case 303: return "See Other";
+                case 304: return "Not Modified";
+                case 305: return "Use Proxy";
+                case 307: return "Temporary Redirect";
+                case 308: return "Permanent Redirect";
+                case 400: return "Bad Request";
+                case 401: return "Unauthorized";
+                case 402: return "Payment Required";
+                case 403: return "Forbidden";
+                case 404: return "Not Found";
+                case 405: return "Method Not Allowed";
+                case 406: return "Not Acceptable";
+                case 407: return "Proxy Authentication Required";
+                case 408: return "Request Timeout";
+                case 409: return "Conflict";
+                case 410: return "Gone";
+                case 411: return "Length Required";
+                case 412: return "Precondition Failed";
+                case 413: return "Payload Too Large";
+                case 414: return "URI Too Long";
+                case 415: return "Unsupported Media Type";
+                case 416: return "Range Not Satisfiable";
+                case 417: return "Expectation Failed";
+                case 421: return "Misdirected Request";
+                case 422: return "Unprocessable Entity";
+                case 423: return "Locked";
+                case 424: return "Failed Dependency";
+                case 425: return "Too Early";
+                case 426: return "Upgrade Required";
+                case 428: return "Precondition Required";
+                case 429: return "Too Many Requests";
+                case 431: return "Request Header Fields Too Large";
+                case 451: return "Unavailable For Legal Reasons";
+                case 500: return "Internal Server Error";
+                case 501: return "Not Implemented";
+                case 502: return "Bad Gateway";
+                case 503: return "Service Unavailable";
+                case 504: return "Gateway Timeout";
+                case 505: return "HTTP Version Not Supported";
+                case 506: return "Variant Also Negotiates";
+                case 507: return "Insufficient Storage";
+                case 508: return "Loop Detected";
+                case 510: return "Not Extended";
+                case 511: return "Network Authentication Required";
+                default: return nullptr;
+                }
+            }
+
+            /// "HTTP/1.1 <code> <reason>\r\n" of every standard code, built on first use.
+            struct StatusLines
+            {
+                std::string text;
+                std::string_view lines[MAX_CODE - MIN_CODE + 1];
+
+                StatusLines()
+                {
+                    size_t offsets[MAX_CODE - MIN_CODE + 1] = {};
+                    for (int code = MIN_CODE; code <= MAX_CODE; ++code)
+                    {
+                        const char *reason = reason_of(code);
+                        if (reason == nullptr)
+                            continue;
+                        offsets[code - MIN_CODE] = text.size();
+                        text.append("HTTP/1.1 ");
+                        text.append(std::to_string(code));
+                        text.push_back(' ');
+                        text.append(reason);
+                        text.append("\r\n");
+                    }
+
+                    // Views only once text stopped growing
+                    for (int code = MIN_CODE; code <= MAX_CODE; ++code)
+                    {
+                        const char *reason = reason_of(code);
+                        if (reason != nullptr)
+                            lines[code - MIN_CODE] = std::string_view(text).substr(offsets[code - MIN_CODE], 15 + std::strlen(reason));
+                    }
+                }
+            };
+
+            const StatusLines &status_lines()
+            {
+                static const StatusLines lines;
+                return lines;
+            }
+
+            constexpr char DIGIT_PAIRS[] =
+                "00010203040506070809"
+                "10111213141516171819"
+                "20212223242526272829"
+                "30313233343536373839"
+                "40414243444546474849"
+                "50515253545556575859"
+                "60616263646566676869"
+                "70717273747576777879"
+                "80818283848586878889"
+                "90919293949596979899";
+
+            constexpr char WEEKDAYS[] = "SunMonTueWedThuFriSat";
+            constexpr char MONTHS[] = "JanFebMarAprMayJunJulAugSepOctNovDec";
+
+            void put2(char *out, int value) noexcept { std::memcpy(out, DIGIT_PAIRS + value * 2, 2); }
+        }
+
+        const char *reason_phrase(int code) noexcept { return reason_of(code); }
+
+        std::string_view status_line(int code) noexcept
+        {
+            if (code < MIN_CODE || code > MAX_CODE)
+                return {};
+            return status_lines().lines[code - MIN_CODE];
+        }
+
+        size_t format_uint(uint64_t value, char *out) noexcept
+        {
+            // Fill from the end two digits per division, then move into place
+            char buf[MAX_UINT_DIGITS];
+            char *p = buf + MAX_UINT_DIGITS;
+            while (value >= 100)
+            {
+                p -= 2;
+                std::memcpy(p, DIGIT_PAIRS + (value % 100) * 2, 2);
+                value /= 100;
+            }
+            if (value >= 10)
+            {
+                p -= 2;
+                std::memcpy(p, DIGIT_PAIRS + value * 2, 2);
+            }
+            else
+                *--p = static_cast<char>('0' + value);
+
+            size_t n = buf + MAX_UINT_DIGITS - p;
+            std::memcpy(out, p, n);
+            return n;
+        }
+
+        void append_uint(std::string &out, uint64_t value)
+        {
+            char buf[MAX_UINT_DIGITS];
+            out.append(buf, format_uint(value, buf));
+        }
+
+        void append_hex(std::string &out, uint64_t value)
+        {
+            char buf[16];
+            char *p = buf + sizeof(buf);
+            do
+            {
+                *--p = "0123456789abcdef"[value & 0xf];
+                value >>= 4;
+            } while (value != 0);
+            out.append(p, buf + sizeof(buf) - p);
+        }
+
+        void append_status_line(std::string &out, std::string_view version, int code, std::string_view msg)
+        {
+            std::string_view line = status_line(code);
+            if (!line.empty() && version == "HTTP/1.1" && msg == line.substr(13, line.size() - 15))
+            {
+                out.append(line);
+                return;
+            }
+
+            out.append(version);
+            out.push_back(' ');
+            append_uint(out, code < 0 ? 0 : code);
+            out.push_back(' ');
+            out.append(msg);
+            out.append("\r\n");
+        }
+
+        void append_header(std::string &out, std::string_view key, std::string_view value)
+        {
+            out.append(key);
+            out.append(": ");
+            out.append(value);
+            out.append("\r\n");
+        }
+
+        void format_http_date(int64_t seconds, char *out) noexcept
+        {
+            time_t t = static_cast<time_t>(seconds);
+            tm utc{};
+            gmtime_r(&t, &utc);
+
+            // Fixed layout, independent of the C locale strftime would use
+            std::memcpy(out, WEEKDAYS + utc.tm_wday * 3, 3);
+            std::memcpy(out + 3, ", ", 2);
+            put2(out + 5, utc.tm_mday);
+            out[7] = ' ';
+            std::memcpy(out + 8, MONTHS + utc.tm_mon * 3, 3);
+            out[11] = ' ';
+            int year = (utc.tm_year + 1900) % 10000;
+            put2(out + 12, year / 100);
+            put2(out + 14, year % 100);
+            out[16] = ' ';
+            put2(out + 17, utc.tm_hour);
+            out[19] = ':';
+            put2(out + 20, utc.tm_min);
+            out[22] = ':';
+            put2(out + 23, utc.tm_sec % 60);
+            std::memcpy(out + 25, " GMT", 4);
+        }
+
+        std::chrono::nanoseconds DateCache::refresh() noexcept
+        {
+            namespace chrono = std::chrono;
+            auto now = chrono::duration_cast<chrono::nanoseconds>(chrono::system_clock::now().time_since_epoch());
+            auto whole = chrono::duration_cast<chrono::seconds>(now);
+            seconds.store(whole.count(), std::memory_order_relaxed);
+            return whole + chrono::seconds(1) - now;
+        }
+
+        void DateCache::append_header(std::string &out) const
+        {
+            // One formatted second per thread, so readers never share a buffer
+            thread_local int64_t formatted = -1;
+            thread_local char text[HTTP_DATE_SIZE];
+
+            int64_t now = get_seconds();
+            if (now != formatted)
+            {
+                format_http_date(now, text);
+                formatted = now;
+            }
+
+            out.append("Date: ");
+            out.append(text, HTTP_DATE_SIZE);
+            out.append("\r\n");
+        }
+    }
+}
@@ -0,0 +1,105 @@
+/**
+ * @file http_format.hpp
+ * @brief Fast paths for serializing response heads.
+ *
+ * Status lines of the standard codes are built once, integers are
+ * formatted two digits at a time and the Date header is formatted at most
+ * once per second per thread, so writing a head is mostly memcpy.
+ */
+
+#ifndef INCLUDE_OUC_SERVER_HTTP_FORMAT
+#define INCLUDE_OUC_SERVER_HTTP_FORMAT
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace ouc_server
+{
+    namespace http
+    {
+        /// Longest decimal form of a uint64_t.
+        constexpr size_t MAX_UINT_DIGITS = 20;
+
+        /// Length of an IMF-fixdate, e.g. "Sun, 06 Nov 1994 08:49:37 GMT".
+        constexpr size_t HTTP_DATE_SIZE = 29;
+
+        /**
+         * @brief Standard reason phrase of a status code.
+         * @return The phrase, nullptr for codes without one.
+         */
+        const char *reason_phrase(int code) noexcept;
+
+        /**
+         * @brief Precomputed "HTTP/1.1 <code> <reason>\r\n" of a standard code.
+         * @return The line, empty for codes without a standard reason phrase.
+         */
+        std::string_view status_line(int code) noexcept;
+
+        /**
+         * @brief Write the decimal form of value, without terminating NUL.
+         * @param out At least MAX_UINT_DIGITS bytes.
+         * @return Number of characters written.
+         */
+        size_t format_uint(uint64_t value, char *out) noexcept;
+
+        /// Append the decimal form of value.
+        void append_uint(std::string &out, uint64_t value);
+
+        /// Append the lowercase hexadecimal form of value, as chunk sizes use.
+        void append_hex(std::string &out, uint64_t value);
+
+        /**
+         * @brief Append a status line, the precomputed one when it matches.
+         * @param version Protocol version, e.g. "HTTP/1.1".
+         * @param code Status code.
+         * @param msg Reason phrase.
+         */
+        void append_status_line(std::string &out, std::string_view version, int code, std::string_view msg);
+
+        /// Append "key: value\r\n".
+        void append_header(std::string &out, std::string_view key, std::string_view value);
+
+        /**
+         * @brief Write the IMF-fixdate of a Unix time.
+         * @param out At least HTTP_DATE_SIZE bytes, no NUL is written.
+         */
+        void format_http_date(int64_t seconds, char *out) noexcept;
+
+        /**
+         * @class DateCache
+         * @brief Current time as an HTTP date, refreshed once per second.
+         *
+         * The owner calls refresh() from a timer, typically one armed on its
+         * EpollLoop for the returned delay; readers on any thread only load
+         * the second and format it again when it changed.
+         */
+        class DateCache
+        {
+        private:
+            std::atomic<int64_t> seconds{0}; ///< Unix time of the last refresh.
+
+        public:
+            DateCache() { refresh(); }
+
+            DateCache(const DateCache &) = delete;
+            DateCache &operator=(const DateCache &) = delete;
+
+            /**
+             * @brief Read the wall clock.
+             * @return Time until the next second starts, when to refresh again.
+             */
+            std::chrono::nanoseconds refresh() noexcept;
+
+            int64_t get_seconds() const noexcept { return seconds.load(std::memory_order_relaxed); }
+
+            /// Append "Date: <IMF-fixdate>\r\n".
+            void append_header(std::string &out) const;
+        };
+    }
+}
+
+#endif // INCLUDE_OUC_SERVER_HTTP_FORMAT
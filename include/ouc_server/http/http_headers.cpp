@@ -0,0 +1,37 @@
+#include <http/http_headers.hpp>
+
+namespace ouc_server
+{
+    namespace http
+    {
+        bool iequals(std::string_view lhs, std::string_view rhs) noexcept
+        {
+            if (lhs.size() != rhs.size())
+                return false;
+            for (size_t i = 0; i < lhs.size(); ++i)
+            {
+                char a = lhs[i], b = rhs[i];
+                if (a >= 'A' && a <= 'Z')
+                    a += 'a' - 'A';
+                if (b >= 'A' && b <= 'Z')
+                    b += 'a' - 'A';
+                if (a != b)
+                    return false;
+            }
+            return true;
+        }
+
+        const std::string *find_header(const HttpHeaders &headers, std::string_view key)
+        {
+            // Exact match is the common case, fall back to a scan
+            auto it = headers.find(std::string(key));
+            if (it != headers.end())
+                return &it->second;
+
+            for (auto &[k, v] : headers)
+                if (iequals(k, key))
+                    return &v;
+            return nullptr;
+        }
+    }
+}
@@ -0,0 +1,27 @@
+#ifndef INCLUDE_OUC_SERVER_HTTP_HEADERS
+#define INCLUDE_OUC_SERVER_HTTP_HEADERS
+
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace ouc_server
+{
+    namespace http
+    {
+        using HttpHeaders = std::unordered_map<std::string, std::string>;
+
+        /**
+         * @brief Compare two header names or tokens ignoring ASCII case.
+         */
+        bool iequals(std::string_view, std::string_view) noexcept;
+
+        /**
+         * @brief Find a header by name ignoring case.
+         * @return Pointer to the value, or nullptr if absent.
+         */
+        const std::string *find_header(const HttpHeaders &, std::string_view);
+    }
+}
+
+#endif // INCLUDE_OUC_SERVER_HTTP_HEADERS
@@ -1,6 +1,7 @@
 #ifndef INCLUDE_OUC_SERVER_HTTP_METHOD_TYPE
 #define INCLUDE_OUC_SERVER_HTTP_METHOD_TYPE
 
+#include <cstddef>
 #include <string>
 
 namespace ouc_server
@@ -19,6 +20,8 @@ namespace ouc_server
             Trace
         };
 
+        constexpr size_t HTTP_METHOD_TYPE_COUNT = 8;
+
         HttpMethodType str2type(const std::string &);
 
         std::string type2str(HttpMethodType);
@@ -3,7 +3,6 @@
 
 #include <string>
 #include <unordered_map>
-#include <sstream>
 
 #include <http/http_method_type.hpp>
 
@@ -21,12 +20,15 @@ namespace ouc_server
             std::unordered_map<std::string, std::string> headers;
             std::string body;
 
-            static HttpRequest from_string(const std::string &);
-
-        private:
-            static void parse_top_line(HttpRequest &, std::istringstream &);
+            std::string remote_address; ///< Client address as text, set by HttpServer.
 
-            static void parse_get_request(HttpRequest &, std::istringstream &);
+            /**
+             * @brief Parse a request held entirely in memory.
+             *
+             * The body is collected byte-exact into `body`. For bodies too
+             * large to buffer use HttpRequestParser and consume it in chunks.
+             */
+            static HttpRequest from_string(const std::string &);
         };
     }
 }
@@ -0,0 +1,434 @@
+#include <http/http_request_parser.hpp>
+
+#include <cstring>
+#include <limits>
+#include <algorithm>
+
+#include <http/http_headers.hpp>
+
+namespace ouc_server
+{
+    namespace http
+    {
+        namespace
+        {
+            /// Longest chunk-size line, extensions included.
+            constexpr size_t MAX_CHUNK_LINE = 1024;
+
+            std::string_view trim(std::string_view str)
+            {
+                while (!str.empty() && (str.front() == ' ' || str.front() == '\t'))
+                    str.remove_prefix(1);
+                while (!str.empty() && (str.back() == ' ' || str.back() == '\t'))
+                    str.remove_suffix(1);
+                return str;
+            }
+
+            /// RFC 7230 token: method names and header field names.
+            bool is_token(std::string_view str)
+            {
+                if (str.empty())
+                    return false;
+                for (unsigned char c : str)
+                {
+                    bool is_alnum = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9');
+                    if (!is_alnum && (c == '\0' || std::strchr("!#$%&'*+-.^_`|~", c) == nullptr))
+                        return false;
+                }
+                return true;
+            }
+
+            /// Field value: visible characters, spaces, tabs and obs-text; no CR, LF or NUL.
+            bool is_field_value(std::string_view str)
+            {
+                for (unsigned char c : str)
+                    if ((c < 0x20 && c != '\t') || c == 0x7f)
+                        return false;
+                return true;
+            }
+
+            /// Request target: anything but controls and spaces.
+            bool is_target(std::string_view str)
+            {
+                if (str.empty())
+                    return false;
+                for (unsigned char c : str)
+                    if (c <= 0x20 || c == 0x7f)
+                        return false;
+                return true;
+            }
+        }
+
+        HttpRequestParser::HttpRequestParser(const HttpParserConfig &p_config)
+            : config(p_config)
+        {
+            reset();
+        }
+
+        void HttpRequestParser::reset()
+        {
+            state = State::RequestLine;
+            req = HttpRequest();
+            line.clear();
+            content_length = 0;
+            remaining = 0;
+            body_size = 0;
+            header_size = 0;
+            header_count = 0;
+            chunked = false;
+            has_length = false;
+            has_encoding = false;
+            has_host = false;
+            error_code = 0;
+        }
+
+        bool HttpRequestParser::feed(const char *data, size_t len)
+        {
+            paused = false;
+            consumed = len;
+            size_t pos = 0;
+            while (pos < len)
+            {
+                if (paused)
+                {
+                    consumed = pos;
+                    return true;
+                }
+
+                switch (state)
+                {
+                case State::Error:
+                    return false;
+
+                case State::Body:
+                case State::ChunkData:
+                {
+                    // Hand out body bytes straight from the caller's buffer
+                    size_t n = std::min(remaining, len - pos);
+                    remaining -= n;
+                    body_size += n;
+                    if (on_body_callback)
+                        on_body_callback(req, std::string_view(data + pos, n));
+                    pos += n;
+
+                    if (remaining == 0)
+                    {
+                        if (state == State::Body)
+                            complete();
+                        else
+                            state = State::ChunkDataEnd;
+                    }
+                    break;
+                }
+
+                default:
+                {
+                    // Line oriented states: collect up to the next LF
+                    const char *lf = static_cast<const char *>(
+                        std::memchr(data + pos, '\n', len - pos));
+                    size_t n = lf != nullptr ? lf - (data + pos) : len - pos;
+
+                    // Checked before buffering, so an endless line costs nothing
+                    int code = 400;
+                    if (line.size() + n > line_limit(code))
+                        return fail(code);
+
+                    if (lf == nullptr)
+                    {
+                        line.append(data + pos, n);
+                        return true;
+                    }
+
+                    std::string_view view;
+                    if (line.empty())
+                        view = std::string_view(data + pos, n);
+                    else
+                    {
+                        line.append(data + pos, n);
+                        view = line;
+                    }
+                    pos += n + 1;
+
+                    if (!view.empty() && view.back() == '\r')
+                        view.remove_suffix(1);
+                    else if (config.strict)
+                        return fail(400);
+
+                    bool ok = parse_line(view);
+                    line.clear();
+                    if (!ok)
+                        return false;
+                    break;
+                }
+                }
+            }
+
+            // A message without body may end exactly at the fed boundary
+            return state != State::Error;
+        }
+
+        size_t HttpRequestParser::line_limit(int &code) const noexcept
+        {
+            switch (state)
+            {
+            case State::RequestLine:
+                code = 414;
+                return config.max_request_line + 1;
+
+            case State::Headers:
+            case State::ChunkTrailer:
+                code = 431;
+                return config.max_header_size - std::min(header_size, config.max_header_size);
+
+            default:
+                code = 400;
+                return MAX_CHUNK_LINE;
+            }
+        }
+
+        bool HttpRequestParser::parse_line(std::string_view view)
+        {
+            // The CRLF ends up on the header budget too
+            if (state == State::Headers || state == State::ChunkTrailer)
+                header_size += view.size() + 2;
+
+            switch (state)
+            {
+            case State::RequestLine:
+                // Tolerate empty lines before a request (RFC 7230 3.5)
+                if (view.empty())
+                    return true;
+                return parse_request_line(view);
+
+            case State::Headers:
+                if (view.empty())
+                    return finish_headers();
+                return parse_header_line(view);
+
+            case State::ChunkSize:
+                return parse_chunk_size(view);
+
+            case State::ChunkDataEnd:
+                if (!view.empty())
+                    return fail(400);
+                state = State::ChunkSize;
+                return true;
+
+            case State::ChunkTrailer:
+                // Trailer fields are accepted but not exposed
+                if (view.empty())
+                    complete();
+                return true;
+
+            default:
+                return fail(400);
+            }
+        }
+
+        bool HttpRequestParser::parse_request_line(std::string_view view)
+        {
+            size_t first = view.find(' ');
+            if (first == std::string_view::npos)
+                return fail(400);
+            size_t second = view.find(' ', first + 1);
+            if (second == std::string_view::npos || second == first + 1)
+                return fail(400);
+
+            std::string method(view.substr(0, first));
+            std::string_view target = view.substr(first + 1, second - first - 1);
+            std::string_view version = view.substr(second + 1);
+            if (version.empty())
+                return fail(400);
+
+            if (config.strict)
+            {
+                if (!is_token(method) || !is_target(target))
+                    return fail(400);
+                if (version.size() != 8 || version.substr(0, 5) != "HTTP/" || version[6] != '.' ||
+                    version[5] < '0' || version[5] > '9' || version[7] < '0' || version[7] > '9')
+                    return fail(400);
+                if (version[5] != '1')
+                    return fail(505);
+                // str2type() maps anything unknown to GET
+                if (type2str(str2type(method)) != method)
+                    return fail(501);
+            }
+
+            req.method = str2type(method);
+            req.path = std::string(target);
+            req.version = std::string(version);
+
+            state = State::Headers;
+            return true;
+        }
+
+        bool HttpRequestParser::parse_header_line(std::string_view view)
+        {
+            if (++header_count > config.max_header_count)
+                return fail(431);
+
+            // obs-fold: a continuation line proxies may not join the same way
+            if (config.strict && (view.front() == ' ' || view.front() == '\t'))
+                return fail(400);
+
+            size_t pos = view.find(':');
+            if (pos == std::string_view::npos || pos == 0)
+                return fail(400);
+
+            std::string_view key = view.substr(0, pos);
+            std::string_view val = trim(view.substr(pos + 1));
+
+            // "Content-Length :" included: the name must be a token
+            if (config.strict && (!is_token(key) || !is_field_value(val)))
+                return fail(400);
+
+            if (iequals(key, "Content-Length"))
+            {
+                if (val.empty())
+                    return fail(400);
+
+                size_t len = 0;
+                for (char c : val)
+                {
+                    if (c < '0' || c > '9')
+                        return fail(400);
+                    if (len > (std::numeric_limits<size_t>::max() - 9) / 10)
+                        return fail(413);
+                    len = len * 10 + (c - '0');
+                }
+
+                // Two lengths: no way to tell which one a front-end used
+                if (has_length && len != content_length)
+                    return fail(400);
+                content_length = len;
+                has_length = true;
+            }
+            else if (iequals(key, "Transfer-Encoding"))
+            {
+                if (!parse_transfer_encoding(val))
+                    return false;
+            }
+            else if (iequals(key, "Host"))
+            {
+                if (config.strict && has_host)
+                    return fail(400);
+                has_host = true;
+            }
+
+            req.headers[std::string(key)] = std::string(val);
+            return true;
+        }
+
+        bool HttpRequestParser::parse_transfer_encoding(std::string_view val)
+        {
+            has_encoding = true;
+            if (!config.strict)
+            {
+                // chunked must be the final coding applied
+                size_t comma = val.rfind(',');
+                std::string_view last = comma == std::string_view::npos ? val : trim(val.substr(comma + 1));
+                chunked = iequals(last, "chunked");
+                return true;
+            }
+
+            // Across repeated headers too: chunked once, and nothing after it
+            while (!val.empty())
+            {
+                size_t comma = val.find(',');
+                std::string_view coding = trim(val.substr(0, comma));
+                val = comma == std::string_view::npos ? std::string_view() : val.substr(comma + 1);
+                if (coding.empty())
+                    continue;
+                if (chunked)
+                    return fail(400);
+                chunked = iequals(coding, "chunked");
+            }
+            return true;
+        }
+
+        bool HttpRequestParser::finish_headers()
+        {
+            // RFC 7230 3.3.3: a body framed two ways, or in a way only some
+            // hops understand, is how requests get smuggled
+            if (config.strict && has_encoding && (has_length || !chunked || req.version != "HTTP/1.1"))
+                return fail(400);
+
+            // Reject oversized bodies before a single byte of them is read
+            if (!chunked && content_length > config.max_body_size)
+                return fail(413);
+
+            if (on_headers_callback)
+                on_headers_callback(req);
+
+            if (chunked)
+                state = State::ChunkSize;
+            else if (content_length > 0)
+            {
+                remaining = content_length;
+                state = State::Body;
+            }
+            else
+                complete();
+
+            return true;
+        }
+
+        bool HttpRequestParser::parse_chunk_size(std::string_view view)
+        {
+            // Drop chunk extensions
+            size_t semi = view.find(';');
+            if (semi != std::string_view::npos)
+                view = view.substr(0, semi);
+            view = trim(view);
+            if (view.empty())
+                return fail(400);
+
+            size_t size = 0;
+            for (char c : view)
+            {
+                int digit;
+                if (c >= '0' && c <= '9')
+                    digit = c - '0';
+                else if (c >= 'a' && c <= 'f')
+                    digit = c - 'a' + 10;
+                else if (c >= 'A' && c <= 'F')
+                    digit = c - 'A' + 10;
+                else
+                    return fail(400);
+
+                if (size > (std::numeric_limits<size_t>::max() >> 4))
+                    return fail(413);
+                size = (size << 4) | digit;
+            }
+
+            if (size == 0)
+            {
+                state = State::ChunkTrailer;
+                return true;
+            }
+
+            if (size > config.max_body_size - std::min(body_size, config.max_body_size))
+                return fail(413);
+
+            remaining = size;
+            state = State::ChunkData;
+            return true;
+        }
+
+        void HttpRequestParser::complete()
+        {
+            if (on_complete_callback)
+                on_complete_callback(req);
+
+            // Ready for the next pipelined request
+            reset();
+        }
+
+        bool HttpRequestParser::fail(int code)
+        {
+            state = State::Error;
+            error_code = code;
+            return false;
+        }
+    }
+}
@@ -0,0 +1,189 @@
+/**
+ * @file http_request_parser.hpp
+ * @brief Incremental HTTP/1.1 request parser with streaming body delivery.
+ *
+ * The parser is fed raw bytes as they arrive from the socket, in chunks of
+ * any size. Request line and headers are collected into an HttpRequest,
+ * while the body (Content-Length or chunked) is handed to the caller piece
+ * by piece as views into the fed buffer, so it is never accumulated.
+ */
+
+#ifndef INCLUDE_OUC_SERVER_HTTP_REQUEST_PARSER
+#define INCLUDE_OUC_SERVER_HTTP_REQUEST_PARSER
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <functional>
+
+#include <http/http_request.hpp>
+
+namespace ouc_server
+{
+    namespace http
+    {
+        /**
+         * @brief Limits applied while parsing requests.
+         *
+         * Size limits are checked as bytes arrive, so a request over one is
+         * rejected before the parser buffers more than the limit.
+         */
+        struct HttpParserConfig
+        {
+            size_t max_body_size = 8 * 1024 * 1024;  ///< Largest body accepted, answered with 413 beyond it.
+            size_t max_request_line = 8 * 1024;     ///< Longest request line, answered with 414 beyond it.
+            size_t max_header_size = 64 * 1024;     ///< Bytes of all header (and trailer) lines, answered with 431 beyond it.
+            size_t max_header_count = 100;          ///< Header fields per request, answered with 431 beyond it.
+
+            /**
+             * @brief Reject anything a front-end could frame differently.
+             *
+             * Bare LF line endings, obs-fold, whitespace before the colon,
+             * invalid field names or values, unknown methods, repeated Host,
+             * Content-Length together with Transfer-Encoding and a
+             * Transfer-Encoding not ending in a single chunked all fail with
+             * 400 (501 for methods, 505 for versions). Without it they are
+             * tolerated, Transfer-Encoding winning over Content-Length.
+             * Content-Length headers that disagree are rejected either way.
+             */
+            bool strict = true;
+        };
+
+        /**
+         * @class HttpRequestParser
+         * @brief Push-style request parser supporting pipelining.
+         *
+         * Example:
+         * @code
+         * HttpRequestParser parser;
+         * parser.on_body([](HttpRequest &req, std::string_view chunk){ ... });
+         * parser.on_complete([](HttpRequest &req){ ... });
+         * if (!parser.feed(buf, n))
+         *     reply(parser.get_error_code());
+         * @endcode
+         */
+        class HttpRequestParser
+        {
+        public:
+            enum class State
+            {
+                RequestLine,
+                Headers,
+                Body,
+                ChunkSize,
+                ChunkData,
+                ChunkDataEnd,
+                ChunkTrailer,
+                Error
+            };
+
+            template <typename... Args>
+            using Callback = std::function<void(HttpRequest &, Args...)>;
+
+        private:
+            HttpParserConfig config;
+            State state;
+            HttpRequest req;
+            std::string line; ///< Partial line carried over between feeds.
+
+            size_t content_length; ///< Declared Content-Length of the current request.
+            size_t remaining;      ///< Body bytes left in the message or current chunk.
+            size_t body_size;      ///< Body bytes delivered so far.
+            size_t header_size;    ///< Header and trailer bytes received so far.
+            size_t header_count;   ///< Header fields received so far.
+            bool chunked;          ///< Body uses chunked transfer coding.
+            bool has_length;       ///< A Content-Length header was seen.
+            bool has_encoding;     ///< A Transfer-Encoding header was seen.
+            bool has_host;         ///< A Host header was seen.
+            int error_code;        ///< HTTP status describing the failure, 0 if none.
+            bool paused = false;   ///< pause() was called, feed() stops.
+            size_t consumed = 0;   ///< Bytes of its input the last feed() parsed.
+
+            Callback<> on_headers_callback;
+            Callback<std::string_view> on_body_callback;
+            Callback<> on_complete_callback;
+
+        public:
+            explicit HttpRequestParser(const HttpParserConfig &p_config = {});
+
+        public:
+            /**
+             * @brief Register callback fired once request line and headers are parsed.
+             * @param callback Function receiving the request without body.
+             */
+            void on_headers(Callback<> &&callback) { on_headers_callback = std::move(callback); }
+
+            /**
+             * @brief Register callback fired for every piece of body received.
+             * @param callback Function receiving a view valid only during the call.
+             */
+            void on_body(Callback<std::string_view> &&callback) { on_body_callback = std::move(callback); }
+
+            /**
+             * @brief Register callback fired when a whole request has been received.
+             * @param callback Function receiving the finished request.
+             */
+            void on_complete(Callback<> &&callback) { on_complete_callback = std::move(callback); }
+
+        public:
+            /**
+             * @brief Consume the next bytes of the stream.
+             * @param data Received bytes.
+             * @param len Number of bytes.
+             * @return false once the stream is malformed or exceeds a limit.
+             */
+            bool feed(const char *data, size_t len);
+
+            bool feed(std::string_view data) { return feed(data.data(), data.size()); }
+
+            /**
+             * @brief Make feed() return once the callback running now does.
+             *
+             * Call from a callback. feed() then returns true with part of its
+             * input unparsed, see get_consumed(); the next feed() goes on.
+             */
+            void pause() noexcept { paused = true; }
+
+            /// Bytes of its input the last feed() parsed, all of them unless paused.
+            size_t get_consumed() const noexcept { return consumed; }
+
+            /**
+             * @brief Forget any partial request and start over.
+             */
+            void reset();
+
+            State get_state() const noexcept { return state; }
+
+            int get_error_code() const noexcept { return error_code; }
+
+            /**
+             * @brief Whether the parser stands between two requests.
+             */
+            bool is_idle() const noexcept { return state == State::RequestLine && line.empty(); }
+
+            HttpRequest &request() noexcept { return req; }
+            const HttpRequest &request() const noexcept { return req; }
+
+            const HttpParserConfig &get_config() const noexcept { return config; }
+            void set_config(const HttpParserConfig &p_config) { config = p_config; }
+
+        private:
+            /**
+             * @brief Longest line the current state may still accept.
+             * @param code Set to the status reported when it is exceeded.
+             */
+            size_t line_limit(int &code) const noexcept;
+
+            bool parse_line(std::string_view);
+            bool parse_request_line(std::string_view);
+            bool parse_header_line(std::string_view);
+            bool parse_transfer_encoding(std::string_view);
+            bool finish_headers();
+            bool parse_chunk_size(std::string_view);
+            void complete();
+            bool fail(int);
+        };
+    }
+}
+
+#endif // INCLUDE_OUC_SERVER_HTTP_REQUEST_PARSER
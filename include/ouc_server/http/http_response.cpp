@@ -1,6 +1,6 @@
 #include <http/http_response.hpp>
 
-#include <sstream>
+#include <http/http_format.hpp>
 
 namespace ouc_server
 {
@@ -8,18 +8,18 @@ namespace ouc_server
     {
         std::string HttpResponse::to_string() const
         {
-            std::ostringstream oss;
-            oss << version << " "
-                << stus_code << " "
-                << stus_msg << "\r\n";
-
+            size_t size = version.size() + stus_msg.size() + 8 + body.size();
             for (auto &[k, v] : headers)
-                oss << k << ": " << v << "\r\n";
-
-            oss << "\r\n"
-                << body;
+                size += k.size() + v.size() + 4;
 
-            return oss.str();
+            std::string out;
+            out.reserve(size);
+            append_status_line(out, version, stus_code, stus_msg);
+            for (auto &[k, v] : headers)
+                append_header(out, k, v);
+            out.append("\r\n");
+            out.append(body);
+            return out;
         }
 
         HttpResponseBuilder HttpResponse::create() { return {}; }
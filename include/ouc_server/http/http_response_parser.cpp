@@ -0,0 +1,288 @@
+#include <http/http_response_parser.hpp>
+
+#include <cstring>
+#include <limits>
+#include <algorithm>
+
+#include <http/http_headers.hpp>
+
+namespace ouc_server
+{
+    namespace http
+    {
+        namespace
+        {
+            std::string_view trim(std::string_view str)
+            {
+                while (!str.empty() && (str.front() == ' ' || str.front() == '\t'))
+                    str.remove_prefix(1);
+                while (!str.empty() && (str.back() == ' ' || str.back() == '\t'))
+                    str.remove_suffix(1);
+                return str;
+            }
+        }
+
+        HttpResponseParser::HttpResponseParser()
+        {
+            reset();
+        }
+
+        void HttpResponseParser::reset(bool p_no_body)
+        {
+            state = State::StatusLine;
+            res = HttpResponse();
+            line.clear();
+            remaining = 0;
+            chunked = false;
+            has_length = false;
+            no_body = p_no_body;
+        }
+
+        bool HttpResponseParser::feed(const char *data, size_t len)
+        {
+            size_t pos = 0;
+            while (pos < len)
+            {
+                switch (state)
+                {
+                case State::Error:
+                case State::Complete:
+                    // Nothing may follow a response nobody asked for
+                    return fail();
+
+                case State::BodyUntilClose:
+                    if (on_body_callback)
+                        on_body_callback(res, std::string_view(data + pos, len - pos));
+                    return true;
+
+                case State::Body:
+                case State::ChunkData:
+                {
+                    // Hand out body bytes straight from the caller's buffer
+                    size_t n = std::min(remaining, len - pos);
+                    remaining -= n;
+                    if (on_body_callback)
+                        on_body_callback(res, std::string_view(data + pos, n));
+                    pos += n;
+
+                    if (remaining == 0)
+                    {
+                        if (state == State::Body)
+                            complete();
+                        else
+                            state = State::ChunkDataEnd;
+                    }
+                    break;
+                }
+
+                default:
+                {
+                    // Line oriented states: collect up to the next LF
+                    const char *lf = static_cast<const char *>(
+                        std::memchr(data + pos, '\n', len - pos));
+                    if (lf == nullptr)
+                    {
+                        line.append(data + pos, len - pos);
+                        return true;
+                    }
+
+                    size_t n = lf - (data + pos);
+                    std::string_view view;
+                    if (line.empty())
+                        view = std::string_view(data + pos, n);
+                    else
+                    {
+                        line.append(data + pos, n);
+                        view = line;
+                    }
+                    pos += n + 1;
+
+                    if (!view.empty() && view.back() == '\r')
+                        view.remove_suffix(1);
+
+                    bool ok = parse_line(view);
+                    line.clear();
+                    if (!ok)
+                        return false;
+                    break;
+                }
+                }
+            }
+
+            return state != State::Error;
+        }
+
+        bool HttpResponseParser::finish()
+        {
+            if (state == State::BodyUntilClose)
+                complete();
+            else if (state != State::Complete)
+                return fail();
+            return true;
+        }
+
+        bool HttpResponseParser::parse_line(std::string_view view)
+        {
+            switch (state)
+            {
+            case State::StatusLine:
+                return parse_status_line(view);
+
+            case State::Headers:
+                if (view.empty())
+                    return finish_headers();
+                return parse_header_line(view);
+
+            case State::ChunkSize:
+                return parse_chunk_size(view);
+
+            case State::ChunkDataEnd:
+                if (!view.empty())
+                    return fail();
+                state = State::ChunkSize;
+                return true;
+
+            case State::ChunkTrailer:
+                if (view.empty())
+                    complete();
+                return true;
+
+            default:
+                return fail();
+            }
+        }
+
+        bool HttpResponseParser::parse_status_line(std::string_view view)
+        {
+            // "HTTP/1.1 200 OK", the reason phrase may be empty or missing
+            size_t first = view.find(' ');
+            if (first == std::string_view::npos || view.substr(0, 5) != "HTTP/")
+                return fail();
+
+            std::string_view code = view.substr(first + 1, 3);
+            if (code.size() != 3 || !std::all_of(code.begin(), code.end(), [](char c)
+                                                 { return c >= '0' && c <= '9'; }))
+                return fail();
+
+            res.version = std::string(view.substr(0, first));
+            res.stus_code = (code[0] - '0') * 100 + (code[1] - '0') * 10 + (code[2] - '0');
+            res.stus_msg = first + 5 <= view.size() ? std::string(view.substr(first + 5)) : std::string();
+
+            state = State::Headers;
+            return true;
+        }
+
+        bool HttpResponseParser::parse_header_line(std::string_view view)
+        {
+            size_t pos = view.find(':');
+            if (pos == std::string_view::npos || pos == 0)
+                return fail();
+
+            std::string_view key = view.substr(0, pos);
+            std::string_view val = trim(view.substr(pos + 1));
+
+            if (iequals(key, "Content-Length"))
+            {
+                if (val.empty())
+                    return fail();
+
+                size_t len = 0;
+                for (char c : val)
+                {
+                    if (c < '0' || c > '9' || len > (std::numeric_limits<size_t>::max() - 9) / 10)
+                        return fail();
+                    len = len * 10 + (c - '0');
+                }
+                remaining = len;
+                has_length = true;
+            }
+            else if (iequals(key, "Transfer-Encoding"))
+            {
+                size_t comma = val.rfind(',');
+                std::string_view last = comma == std::string_view::npos ? val : trim(val.substr(comma + 1));
+                chunked = iequals(last, "chunked");
+            }
+
+            res.headers[std::string(key)] = std::string(val);
+            return true;
+        }
+
+        bool HttpResponseParser::finish_headers()
+        {
+            // Interim response (100 Continue and the like): the real one follows
+            if (res.stus_code >= 100 && res.stus_code < 200 && res.stus_code != 101)
+            {
+                reset(no_body);
+                return true;
+            }
+
+            if (on_headers_callback)
+                on_headers_callback(res);
+
+            if (no_body || res.stus_code < 200 || res.stus_code == 204 || res.stus_code == 304)
+                complete();
+            else if (chunked)
+                state = State::ChunkSize;
+            else if (has_length && remaining > 0)
+                state = State::Body;
+            else if (has_length)
+                complete();
+            else
+                state = State::BodyUntilClose;
+
+            return true;
+        }
+
+        bool HttpResponseParser::parse_chunk_size(std::string_view view)
+        {
+            // Drop chunk extensions
+            size_t semi = view.find(';');
+            if (semi != std::string_view::npos)
+                view = view.substr(0, semi);
+            view = trim(view);
+            if (view.empty())
+                return fail();
+
+            size_t size = 0;
+            for (char c : view)
+            {
+                int digit;
+                if (c >= '0' && c <= '9')
+                    digit = c - '0';
+                else if (c >= 'a' && c <= 'f')
+                    digit = c - 'a' + 10;
+                else if (c >= 'A' && c <= 'F')
+                    digit = c - 'A' + 10;
+                else
+                    return fail();
+
+                if (size > (std::numeric_limits<size_t>::max() >> 4))
+                    return fail();
+                size = (size << 4) | digit;
+            }
+
+            if (size == 0)
+            {
+                state = State::ChunkTrailer;
+                return true;
+            }
+
+            remaining = size;
+            state = State::ChunkData;
+            return true;
+        }
+
+        void HttpResponseParser::complete()
+        {
+            state = State::Complete;
+            if (on_complete_callback)
+                on_complete_callback(res);
+        }
+
+        bool HttpResponseParser::fail()
+        {
+            state = State::Error;
+            return false;
+        }
+    }
+}
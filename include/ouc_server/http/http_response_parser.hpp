@@ -0,0 +1,141 @@
+/**
+ * @file http_response_parser.hpp
+ * @brief Incremental HTTP/1.1 response parser with streaming body delivery.
+ *
+ * The counterpart of HttpRequestParser for the client side, e.g. reading
+ * an upstream's answer in ReverseProxy. Interim 1xx responses are skipped;
+ * a body without Content-Length or chunked coding runs until the peer
+ * closes, which the caller reports through finish().
+ */
+
+#ifndef INCLUDE_OUC_SERVER_HTTP_RESPONSE_PARSER
+#define INCLUDE_OUC_SERVER_HTTP_RESPONSE_PARSER
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <functional>
+
+#include <http/http_response.hpp>
+
+namespace ouc_server
+{
+    namespace http
+    {
+        /**
+         * @class HttpResponseParser
+         * @brief Push-style parser for a single response.
+         *
+         * Example:
+         * @code
+         * HttpResponseParser parser;
+         * parser.on_body([](HttpResponse &res, std::string_view chunk){ ... });
+         * while (!parser.is_complete() && (n = recv(...)) > 0)
+         *     if (!parser.feed(buf, n)) break;
+         * if (n == 0) parser.finish();
+         * @endcode
+         */
+        class HttpResponseParser
+        {
+        public:
+            enum class State
+            {
+                StatusLine,
+                Headers,
+                Body,
+                BodyUntilClose,
+                ChunkSize,
+                ChunkData,
+                ChunkDataEnd,
+                ChunkTrailer,
+                Complete,
+                Error
+            };
+
+            template <typename... Args>
+            using Callback = std::function<void(HttpResponse &, Args...)>;
+
+        private:
+            State state;
+            HttpResponse res;
+            std::string line; ///< Partial line carried over between feeds.
+
+            size_t remaining; ///< Body bytes left in the message or current chunk.
+            bool chunked;     ///< Body uses chunked transfer coding.
+            bool has_length;  ///< Content-Length was given.
+            bool no_body;     ///< Answer to HEAD: whatever the headers say, no body follows.
+
+            Callback<> on_headers_callback;
+            Callback<std::string_view> on_body_callback;
+            Callback<> on_complete_callback;
+
+        public:
+            HttpResponseParser();
+
+        public:
+            /**
+             * @brief Register callback fired once status line and headers are parsed.
+             * @param callback Function receiving the response without body.
+             */
+            void on_headers(Callback<> &&callback) { on_headers_callback = std::move(callback); }
+
+            /**
+             * @brief Register callback fired for every piece of body received.
+             * @param callback Function receiving a view valid only during the call.
+             */
+            void on_body(Callback<std::string_view> &&callback) { on_body_callback = std::move(callback); }
+
+            /**
+             * @brief Register callback fired when the whole response has been received.
+             * @param callback Function receiving the finished response.
+             */
+            void on_complete(Callback<> &&callback) { on_complete_callback = std::move(callback); }
+
+        public:
+            /**
+             * @brief Consume the next bytes of the stream.
+             * @param data Received bytes.
+             * @param len Number of bytes.
+             * @return false once the stream is malformed, or has bytes past the end of the response.
+             */
+            bool feed(const char *data, size_t len);
+
+            bool feed(std::string_view data) { return feed(data.data(), data.size()); }
+
+            /**
+             * @brief Report that the peer closed the connection.
+             * @return true if that ended the response, false if it was cut short.
+             */
+            bool finish();
+
+            /**
+             * @brief Forget any partial response and start over.
+             * @param p_no_body The response answers a HEAD request.
+             */
+            void reset(bool p_no_body = false);
+
+            State get_state() const noexcept { return state; }
+
+            bool is_complete() const noexcept { return state == State::Complete; }
+
+            /**
+             * @brief Whether the body is delimited by closing the connection.
+             */
+            bool is_until_close() const noexcept { return state == State::BodyUntilClose; }
+
+            HttpResponse &response() noexcept { return res; }
+            const HttpResponse &response() const noexcept { return res; }
+
+        private:
+            bool parse_line(std::string_view);
+            bool parse_status_line(std::string_view);
+            bool parse_header_line(std::string_view);
+            bool finish_headers();
+            bool parse_chunk_size(std::string_view);
+            void complete();
+            bool fail();
+        };
+    }
+}
+
+#endif // INCLUDE_OUC_SERVER_HTTP_RESPONSE_PARSER
@@ -0,0 +1,270 @@
+#include <http/http_response_writer.hpp>
+
+#include <http/http_headers.hpp>
+
+namespace ouc_server
+{
+    namespace http
+    {
+        HttpResponseWriter::HttpResponseWriter(Sink &&p_sink, EndCallback &&on_end)
+            : sink(std::move(p_sink)),
+              on_end_callback(std::move(on_end))
+        {
+        }
+
+        HttpResponseWriter &HttpResponseWriter::status(int code, const std::string &msg)
+        {
+            if (!head_sent)
+            {
+                res.stus_code = code;
+                res.stus_msg = msg;
+            }
+            return *this;
+        }
+
+        HttpResponseWriter &HttpResponseWriter::status(int code)
+        {
+            const char *msg = reason_phrase(code);
+            return status(code, msg != nullptr ? msg : "Unknown");
+        }
+
+        HttpResponseWriter &HttpResponseWriter::header(const std::string &key, const std::string &value)
+        {
+            if (!head_sent)
+                res.headers[key] = value;
+            return *this;
+        }
+
+        bool HttpResponseWriter::write_head()
+        {
+            if (head_sent)
+                return is_ok;
+
+            std::string out;
+            serialize_head(out);
+            return emit(std::move(out));
+        }
+
+        bool HttpResponseWriter::write(std::string_view chunk)
+        {
+            if (ended)
+                return false;
+
+            // Headers and the first piece go out in a single send
+            std::string out;
+            if (!head_sent)
+                serialize_head(out);
+            if (!chunk.empty() && !head_only)
+                serialize_chunk(out, chunk);
+
+            if (out.empty())
+                return is_ok;
+            return emit(std::move(out));
+        }
+
+        bool HttpResponseWriter::end(std::string_view chunk)
+        {
+            if (ended)
+                return is_ok;
+
+            // Whole body known up front: the only case compressed
+            thread_local std::string scratch;
+            CompressionCache::Variant variant;
+            if (!head_sent && compression != nullptr)
+                chunk = compress_body(chunk, variant, scratch);
+
+            std::string out;
+            if (!head_sent)
+            {
+                // Whole body known up front: no need for chunked framing
+                if (has_body() && find_header(res.headers, "Content-Length") == nullptr &&
+                    find_header(res.headers, "Transfer-Encoding") == nullptr)
+                    content_length = chunk.size();
+                serialize_head(out);
+            }
+            if (!chunk.empty() && !head_only)
+                serialize_chunk(out, chunk);
+            if (chunked && !head_only)
+                out.append("0\r\n\r\n");
+
+            if (!out.empty())
+                emit(std::move(out));
+
+            // Do not pin the largest body ever compressed to the thread
+            if (scratch.capacity() > (1 << 20))
+                std::string().swap(scratch);
+
+            // The callback may let the owner destroy the writer: touch nothing after it
+            bool ok = is_ok;
+            ended = true;
+            if (on_end_callback)
+            {
+                EndCallback done = std::move(on_end_callback);
+                done(keep_alive);
+            }
+            return ok;
+        }
+
+        bool HttpResponseWriter::send(const HttpResponse &p_res)
+        {
+            if (!head_sent)
+            {
+                res.version = p_res.version;
+                res.stus_code = p_res.stus_code;
+                res.stus_msg = p_res.stus_msg;
+                for (auto &[k, v] : p_res.headers)
+                    res.headers[k] = v;
+            }
+            return end(p_res.body);
+        }
+
+        HttpResponseWriter &HttpResponseWriter::cache_as(std::string key)
+        {
+            if (!head_sent)
+                cache_key = std::move(key);
+            return *this;
+        }
+
+        std::string_view HttpResponseWriter::compress_body(std::string_view chunk, CompressionCache::Variant &variant, std::string &scratch)
+        {
+            const CompressionConfig &config = compression->get_config();
+            bool has_body = res.stus_code >= 200 && res.stus_code != 204 && res.stus_code != 206 && res.stus_code != 304;
+            auto *type = find_header(res.headers, "Content-Type");
+            if (!has_body || chunk.size() < config.min_size || (type != nullptr && !is_compressible(*type)) ||
+                find_header(res.headers, "Content-Encoding") != nullptr || find_header(res.headers, "Content-Length") != nullptr)
+                return chunk;
+
+            // The body depends on Accept-Encoding, whatever this client sent
+            res.headers["Vary"] = "Accept-Encoding";
+            if (encoding == ContentEncoding::Identity)
+                return chunk;
+
+            std::string_view body;
+            if (!cache_key.empty() && config.cache_bytes > 0)
+            {
+                variant = compression->get(cache_key, encoding, chunk);
+                if (variant)
+                    body = *variant;
+            }
+            else if (ouc_server::http::compress(encoding, chunk, scratch, config.level))
+                body = scratch;
+
+            // Incompressible after all: not worth the client's CPU
+            if (body.empty() || body.size() >= chunk.size())
+                return chunk;
+
+            res.headers["Content-Encoding"] = encoding_name(encoding);
+            return body;
+        }
+
+        void HttpResponseWriter::abort()
+        {
+            if (ended)
+                return;
+
+            ended = true;
+            keep_alive = false;
+            if (on_end_callback)
+            {
+                EndCallback done = std::move(on_end_callback);
+                done(false);
+            }
+        }
+
+        bool HttpResponseWriter::pause_input()
+        {
+            if (!input_control)
+                return false;
+            input_control(true);
+            return true;
+        }
+
+        void HttpResponseWriter::resume_input()
+        {
+            if (input_control)
+                input_control(false);
+        }
+
+        bool HttpResponseWriter::when_writable(std::function<void()> &&callback)
+        {
+            if (ended || !is_ok)
+                return false;
+            if (!writable_notifier)
+            {
+                callback();
+                return true;
+            }
+            return writable_notifier(std::move(callback));
+        }
+
+        void HttpResponseWriter::serialize_head(std::string &out)
+        {
+            if (!has_body())
+            {
+                // RFC 7230 3.3.2: no length on 1xx and 204, and no body on any of them
+                if (res.stus_code < 200 || res.stus_code == 204)
+                    for (auto it = res.headers.begin(); it != res.headers.end();)
+                        it = iequals(it->first, "Content-Length") || iequals(it->first, "Transfer-Encoding")
+                                 ? res.headers.erase(it)
+                                 : std::next(it);
+                head_only = true;
+            }
+            else if (content_length < 0 && find_header(res.headers, "Content-Length") == nullptr)
+            {
+                // Unknown length: chunked on HTTP/1.1, otherwise the end of
+                // the body can only be signalled by closing the connection.
+                auto *te = find_header(res.headers, "Transfer-Encoding");
+                if (te != nullptr && iequals(*te, "chunked"))
+                    chunked = true;
+                else if (te == nullptr && res.version == "HTTP/1.1")
+                {
+                    res.headers["Transfer-Encoding"] = "chunked";
+                    chunked = true;
+                }
+                else
+                    keep_alive = false;
+            }
+
+            if (!keep_alive)
+                res.headers["Connection"] = "close";
+
+            out.reserve(out.size() + 256);
+            append_status_line(out, res.version, res.stus_code, res.stus_msg);
+            for (auto &[k, v] : res.headers)
+                append_header(out, k, v);
+            if (date != nullptr && find_header(res.headers, "Date") == nullptr)
+                date->append_header(out);
+            if (content_length >= 0)
+            {
+                out.append("Content-Length: ");
+                append_uint(out, content_length);
+                out.append("\r\n");
+            }
+            out.append("\r\n");
+            head_sent = true;
+        }
+
+        void HttpResponseWriter::serialize_chunk(std::string &out, std::string_view chunk)
+        {
+            if (!chunked)
+            {
+                out.append(chunk);
+                return;
+            }
+
+            append_hex(out, chunk.size());
+            out.append("\r\n");
+            out.append(chunk);
+            out.append("\r\n");
+        }
+
+        bool HttpResponseWriter::emit(std::string &&out)
+        {
+            if (!is_ok)
+                return false;
+            if (!sink || !sink(std::move(out)))
+                is_ok = false;
+            return is_ok;
+        }
+    }
+}
@@ -0,0 +1,249 @@
+/**
+ * @file http_response_writer.hpp
+ * @brief Incremental HTTP response writer.
+ *
+ * Lets a handler send the status line and headers first and the body in
+ * as many pieces as it likes afterwards. Without a Content-Length header
+ * the body is framed with `Transfer-Encoding: chunked`. Bytes are handed to
+ * a sink, normally TCPServer::send, which blocks while the client is slow
+ * so the producer is throttled instead of the buffer growing.
+ *
+ * A response can also be deferred and finished later from another thread,
+ * e.g. from the callbacks of a backend connection; the server then
+ * provides flow control instead of blocking: see defer(), pause_input()
+ * and when_writable().
+ */
+
+#ifndef INCLUDE_OUC_SERVER_HTTP_RESPONSE_WRITER
+#define INCLUDE_OUC_SERVER_HTTP_RESPONSE_WRITER
+
+#include <string>
+#include <string_view>
+#include <functional>
+
+#include <http/http_response.hpp>
+#include <http/http_compression.hpp>
+#include <http/http_format.hpp>
+
+namespace ouc_server
+{
+    namespace http
+    {
+        /**
+         * @class HttpResponseWriter
+         * @brief Writes one response to a byte sink.
+         *
+         * Example:
+         * @code
+         * writer.status(200, "OK").header("Content-Type", "text/plain");
+         * writer.write_head();
+         * while (produce(piece))
+         *     if (!writer.write(piece))
+         *         break; // client went away
+         * writer.end();
+         * @endcode
+         */
+        class HttpResponseWriter
+        {
+        public:
+            /// Receives serialized bytes, returns false once the peer is gone.
+            using Sink = std::function<bool(std::string &&)>;
+            /// Called once by end() with whether the connection may be reused.
+            using EndCallback = std::function<void(bool)>;
+            /// Stops (true) or resumes (false) reading the request.
+            using InputControl = std::function<void(bool)>;
+            /// Runs a callback once the sink takes more without blocking, false if the peer is gone.
+            using WritableNotifier = std::function<bool(std::function<void()> &&)>;
+
+        private:
+            Sink sink;
+            EndCallback on_end_callback;
+            HttpResponse res; ///< Status line and headers, body is never used.
+
+            bool keep_alive = true; ///< Connection may serve another request afterwards.
+            bool head_only = false; ///< Answering HEAD: headers are sent, body is dropped.
+            bool head_sent = false;
+            bool chunked = false;
+            bool ended = false;
+            bool is_ok = true; ///< Every write so far reached the sink.
+            bool deferred = false; ///< Finished later, not when the handler returns.
+
+            InputControl input_control;         ///< Flow control of the request, empty if unsupported.
+            WritableNotifier writable_notifier; ///< Room notification of the sink, empty if it never blocks.
+
+            int64_t content_length = -1;    ///< Length end() found, -1 if not known there.
+            const DateCache *date = nullptr; ///< Source of the Date header, nullptr to send none.
+
+            ContentEncoding encoding = ContentEncoding::Identity; ///< Coding the client accepts.
+            CompressionCache *compression = nullptr;             ///< Settings and cache, nullptr disables compression.
+            std::string cache_key;                               ///< Names a static body, see cache_as().
+
+        public:
+            explicit HttpResponseWriter(Sink &&p_sink, EndCallback &&on_end = {});
+
+            HttpResponseWriter(const HttpResponseWriter &) = delete;
+            HttpResponseWriter &operator=(const HttpResponseWriter &) = delete;
+
+        public:
+            /**
+             * @brief Set the status line, ignored once headers are sent.
+             */
+            HttpResponseWriter &status(int code, const std::string &msg);
+
+            /**
+             * @brief Set the status line with the standard reason phrase of code.
+             */
+            HttpResponseWriter &status(int code);
+
+            /**
+             * @brief Add or replace a header, ignored once headers are sent.
+             */
+            HttpResponseWriter &header(const std::string &key, const std::string &value);
+
+            /**
+             * @brief Send status line and headers now.
+             * @return false if the peer is gone.
+             */
+            bool write_head();
+
+            /**
+             * @brief Send a piece of body, sending headers first if needed.
+             * @param chunk Body bytes, copied before the call returns.
+             * @return false if the peer is gone.
+             */
+            bool write(std::string_view chunk);
+
+            /**
+             * @brief Finish the response, optionally with a last piece of body.
+             *
+             * If nothing was sent yet and no length was declared, the body is
+             * sent with a Content-Length instead of chunked framing.
+             *
+             * @return false if the peer is gone.
+             */
+            bool end(std::string_view chunk = {});
+
+            /**
+             * @brief Send a fully materialized response and finish.
+             */
+            bool send(const HttpResponse &p_res);
+
+            /**
+             * @brief Give up on a response that cannot be completed.
+             *
+             * Nothing more is sent, not even the last chunk, and the
+             * connection is not reused: the client sees a truncated
+             * response instead of one that looks complete.
+             */
+            void abort();
+
+            /**
+             * @brief Keep the response open once the handler returns.
+             *
+             * The server neither ends it after on_request nor reads further
+             * requests of the connection until end() or abort() is called,
+             * from any thread, e.g. a backend connection's callback. Use
+             * when_writable() before each write so no thread blocks.
+             */
+            void defer() noexcept { deferred = true; }
+
+            /**
+             * @brief Stop reading the request once the running callback returns.
+             *
+             * Backpressure for a handler forwarding the body somewhere slow:
+             * the client is no longer read instead of a thread waiting. Call
+             * from the request's callbacks.
+             *
+             * @return false if the server does not support it, the body keeps coming.
+             */
+            bool pause_input();
+
+            /// Read the request again after pause_input(), from any thread.
+            void resume_input();
+
+            /**
+             * @brief Run a callback once write() would not block.
+             *
+             * It runs on another thread, soon if the sink has room already.
+             * Without a notifier (a sink that never throttles) it runs right
+             * away, before the call returns.
+             *
+             * @return false if the peer is gone, the callback then never runs.
+             */
+            bool when_writable(std::function<void()> &&callback);
+
+        public:
+            bool is_head_sent() const noexcept { return head_sent; }
+            bool is_ended() const noexcept { return ended; }
+            bool is_deferred() const noexcept { return deferred; }
+
+            bool get_keep_alive() const noexcept { return keep_alive; }
+            void set_keep_alive(bool p_keep_alive) noexcept { keep_alive = p_keep_alive; }
+
+            void set_head_only(bool p_head_only) noexcept { head_only = p_head_only; }
+
+            /**
+             * @brief Compress a body passed whole to end() or send().
+             *
+             * Applies to compressible media types of at least
+             * CompressionConfig::min_size bytes, unless the handler set
+             * Content-Encoding or Content-Length itself. Streamed bodies are
+             * sent as they are.
+             *
+             * @param p_encoding Coding negotiated with the client.
+             * @param p_compression Settings and cache of variants, nullptr to disable.
+             */
+            void set_compression(ContentEncoding p_encoding, CompressionCache *p_compression) noexcept
+            {
+                encoding = p_encoding;
+                compression = p_compression;
+            }
+
+            /**
+             * @brief Add a Date header to the response unless the handler set one.
+             * @param p_date Clock shared by the server's writers, nullptr for none.
+             */
+            void set_date(const DateCache *p_date) noexcept { date = p_date; }
+
+            /**
+             * @brief Connect the flow control of a deferred response to the server.
+             * @param p_input Pauses and resumes reading the request.
+             * @param p_writable Tells when the sink has room again.
+             */
+            void set_flow_control(InputControl &&p_input, WritableNotifier &&p_writable)
+            {
+                input_control = std::move(p_input);
+                writable_notifier = std::move(p_writable);
+            }
+
+            /**
+             * @brief Declare the body static content named key, ignored once headers are sent.
+             *
+             * Its compressed variant is taken from the CompressionCache, and
+             * compressed only the first time. The key must change whenever
+             * the content does.
+             */
+            HttpResponseWriter &cache_as(std::string key);
+
+        private:
+            /// Whether the status may carry a body: not 1xx, 204 or 304.
+            bool has_body() const noexcept { return res.stus_code >= 200 && res.stus_code != 204 && res.stus_code != 304; }
+
+            /// Append status line and headers to out, choosing the body framing.
+            void serialize_head(std::string &out);
+
+            /**
+             * @brief Compress a whole body if the response qualifies, adding the headers.
+             * @return The body to send: chunk itself, a cached variant or scratch.
+             */
+            std::string_view compress_body(std::string_view chunk, CompressionCache::Variant &variant, std::string &scratch);
+
+            /// Append one piece of body to out, framed if chunked.
+            void serialize_chunk(std::string &out, std::string_view chunk);
+
+            bool emit(std::string &&out);
+        };
+    }
+}
+
+#endif // INCLUDE_OUC_SERVER_HTTP_RESPONSE_WRITER
@@ -0,0 +1,303 @@
+#include <http/http_router.hpp>
+
+#include <stdexcept>
+#include <algorithm>
+
+namespace ouc_server
+{
+    namespace http
+    {
+        HttpRouter::HttpRouter()
+        {
+            roots.fill(-1);
+        }
+
+        void HttpRouter::add(HttpMethodType method, std::string_view pattern, HttpRouteHandler &&handler)
+        {
+            if (frozen)
+                throw std::logic_error("HttpRouter: cannot add routes after freeze()");
+            if (pattern.empty() || pattern.front() != '/')
+                throw std::invalid_argument("HttpRouter: pattern must start with '/'");
+
+            auto &root = trees[static_cast<size_t>(method)];
+            if (!root)
+                root = std::make_unique<BuildNode>();
+
+            BuildNode *node = root.get();
+            size_t param_count = 0;
+            size_t pos = 0;
+            while (pos < pattern.size())
+            {
+                // Captures only start a segment
+                char c = pattern[pos];
+                bool at_segment = pos > 0 && pattern[pos - 1] == '/';
+                if ((c == ':' || c == '*') && at_segment)
+                {
+                    size_t end = c == '*' ? pattern.size() : pattern.find('/', pos);
+                    if (end == std::string_view::npos)
+                        end = pattern.size();
+
+                    std::string_view name = pattern.substr(pos + 1, end - pos - 1);
+                    if (name.empty())
+                        throw std::invalid_argument("HttpRouter: unnamed capture");
+                    if (++param_count > HttpRouteParams::MAX_PARAMS)
+                        throw std::invalid_argument("HttpRouter: too many captures");
+
+                    auto &child = c == ':' ? node->param_child : node->wildcard_child;
+                    if (!child)
+                    {
+                        child = std::make_unique<BuildNode>();
+                        child->kind = c == ':' ? NodeKind::Param : NodeKind::Wildcard;
+                        child->label = std::string(name);
+                    }
+                    else if (child->label != name)
+                        throw std::invalid_argument("HttpRouter: conflicting capture names");
+
+                    node = child.get();
+                    pos = end;
+                    continue;
+                }
+
+                // Static run up to the next capture
+                size_t end = pos;
+                while (end < pattern.size() &&
+                       !((pattern[end] == ':' || pattern[end] == '*') && end > 0 && pattern[end - 1] == '/'))
+                    ++end;
+                node = insert_static(node, pattern.substr(pos, end - pos));
+                pos = end;
+            }
+
+            if (node->handler >= 0)
+                throw std::invalid_argument("HttpRouter: duplicate route");
+            node->handler = static_cast<int32_t>(handlers.size());
+            handlers.push_back(std::move(handler));
+        }
+
+        HttpRouter::BuildNode *HttpRouter::insert_static(BuildNode *node, std::string_view text)
+        {
+            while (!text.empty())
+            {
+                BuildNode *next = nullptr;
+                for (auto &child : node->children)
+                {
+                    // Longest common prefix with this child
+                    size_t common = 0;
+                    size_t limit = std::min(child->label.size(), text.size());
+                    while (common < limit && child->label[common] == text[common])
+                        ++common;
+                    if (common == 0)
+                        continue;
+
+                    if (common < child->label.size())
+                    {
+                        // Split the edge: child keeps the tail under a new parent
+                        auto mid = std::make_unique<BuildNode>();
+                        mid->label = child->label.substr(0, common);
+                        child->label.erase(0, common);
+                        mid->children.push_back(std::move(child));
+                        child = std::move(mid);
+                    }
+
+                    next = child.get();
+                    text.remove_prefix(common);
+                    break;
+                }
+
+                if (next == nullptr)
+                {
+                    auto leaf = std::make_unique<BuildNode>();
+                    leaf->label = std::string(text);
+                    next = leaf.get();
+                    node->children.push_back(std::move(leaf));
+                    text = {};
+                }
+                node = next;
+            }
+            return node;
+        }
+
+        void HttpRouter::freeze()
+        {
+            if (frozen)
+                return;
+
+            nodes.clear();
+            labels.clear();
+            for (size_t m = 0; m < HTTP_METHOD_TYPE_COUNT; ++m)
+            {
+                if (!trees[m])
+                    continue;
+                roots[m] = static_cast<int32_t>(nodes.size());
+                nodes.emplace_back();
+                flatten(trees[m].get(), roots[m]);
+                trees[m].reset();
+            }
+
+            nodes.shrink_to_fit();
+            labels.shrink_to_fit();
+            frozen = true;
+        }
+
+        void HttpRouter::flatten(const BuildNode *src, uint32_t idx)
+        {
+            std::vector<const BuildNode *> children;
+            for (auto &child : src->children)
+                children.push_back(child.get());
+            std::sort(
+                children.begin(),
+                children.end(),
+                [](const BuildNode *a, const BuildNode *b)
+                { return a->label[0] < b->label[0]; });
+
+            Node node{};
+            node.label_offset = static_cast<uint32_t>(labels.size());
+            node.label_len = static_cast<uint32_t>(src->label.size());
+            node.kind = src->kind;
+            node.first = src->label.empty() ? '\0' : src->label[0];
+            node.handler = src->handler;
+            node.param_child = -1;
+            node.wildcard_child = -1;
+            labels.append(src->label);
+
+            // Reserve the static children as one contiguous block
+            node.first_child = static_cast<uint32_t>(nodes.size());
+            node.child_count = static_cast<uint32_t>(children.size());
+            nodes.resize(nodes.size() + children.size());
+
+            if (src->param_child)
+            {
+                node.param_child = static_cast<int32_t>(nodes.size());
+                nodes.emplace_back();
+            }
+            if (src->wildcard_child)
+            {
+                node.wildcard_child = static_cast<int32_t>(nodes.size());
+                nodes.emplace_back();
+            }
+            nodes[idx] = node;
+
+            for (size_t i = 0; i < children.size(); ++i)
+                flatten(children[i], node.first_child + static_cast<uint32_t>(i));
+            if (src->param_child)
+                flatten(src->param_child.get(), node.param_child);
+            if (src->wildcard_child)
+                flatten(src->wildcard_child.get(), node.wildcard_child);
+        }
+
+        const HttpRouteHandler *HttpRouter::lookup(HttpMethodType method, std::string_view path, HttpRouteParams &params) const
+        {
+            params.clear();
+
+            int32_t root = frozen ? roots[static_cast<size_t>(method)] : -1;
+            if (root < 0)
+                return nullptr;
+
+            size_t query = path.find('?');
+            if (query != std::string_view::npos)
+                path = path.substr(0, query);
+
+            int32_t handler = -1;
+            if (!match(root, path, 0, params, handler))
+                return nullptr;
+            return &handlers[handler];
+        }
+
+        bool HttpRouter::match(uint32_t idx, std::string_view path, size_t pos, HttpRouteParams &params, int32_t &handler) const
+        {
+            const Node &node = nodes[idx];
+
+            if (pos == path.size() && node.handler >= 0)
+            {
+                handler = node.handler;
+                return true;
+            }
+
+            // 1. static children, sorted so the scan stops early
+            if (pos < path.size())
+            {
+                char c = path[pos];
+                for (uint32_t i = 0; i < node.child_count; ++i)
+                {
+                    const Node &child = nodes[node.first_child + i];
+                    if (child.first > c)
+                        break;
+                    if (child.first < c)
+                        continue;
+
+                    std::string_view label(labels.data() + child.label_offset, child.label_len);
+                    if (path.compare(pos, label.size(), label) == 0 &&
+                        match(node.first_child + i, path, pos + label.size(), params, handler))
+                        return true;
+                    break; // first bytes are unique among siblings
+                }
+            }
+
+            // 2. parameter: one non-empty segment
+            if (node.param_child >= 0 && pos < path.size())
+            {
+                size_t end = path.find('/', pos);
+                if (end == std::string_view::npos)
+                    end = path.size();
+                if (end > pos)
+                {
+                    const Node &param = nodes[node.param_child];
+                    params.push(
+                        std::string_view(labels.data() + param.label_offset, param.label_len),
+                        path.substr(pos, end - pos));
+                    if (match(node.param_child, path, end, params, handler))
+                        return true;
+                    params.pop();
+                }
+            }
+
+            // 3. wildcard: everything left, possibly empty
+            if (node.wildcard_child >= 0)
+            {
+                const Node &wildcard = nodes[node.wildcard_child];
+                if (wildcard.handler >= 0)
+                {
+                    params.push(
+                        std::string_view(labels.data() + wildcard.label_offset, wildcard.label_len),
+                        path.substr(pos));
+                    handler = wildcard.handler;
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
+        bool HttpRouter::handle(HttpRequest &req, HttpResponseWriter &res) const
+        {
+            HttpRouteParams params;
+            const HttpRouteHandler *handler = lookup(req.method, req.path, params);
+            if (handler == nullptr && req.method == HttpMethodType::Head)
+                handler = lookup(HttpMethodType::Get, req.path, params);
+
+            if (handler != nullptr)
+            {
+                (*handler)(req, res, params);
+                return true;
+            }
+
+            // Tell 405 apart from 404 by trying the other methods
+            std::string allow;
+            for (size_t m = 0; m < HTTP_METHOD_TYPE_COUNT; ++m)
+            {
+                HttpRouteParams unused;
+                if (lookup(static_cast<HttpMethodType>(m), req.path, unused) != nullptr)
+                {
+                    if (!allow.empty())
+                        allow += ", ";
+                    allow += type2str(static_cast<HttpMethodType>(m));
+                }
+            }
+
+            if (allow.empty())
+                res.status(404, "Not Found").end();
+            else
+                res.status(405, "Method Not Allowed").header("Allow", allow).end();
+            return false;
+        }
+    }
+}
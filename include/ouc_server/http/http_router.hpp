@@ -0,0 +1,181 @@
+/**
+ * @file http_router.hpp
+ * @brief Radix tree router with path parameters.
+ *
+ * Routes are added to a mutable compressed radix tree, one tree per
+ * HttpMethodType, then frozen into a single contiguous array of nodes
+ * whose static children sit next to each other, so a lookup walks a few
+ * cache lines without chasing heap pointers or allocating.
+ *
+ * Pattern syntax:
+ * - `/users/list` static text
+ * - `/users/:id` a named parameter matching one non-empty path segment
+ * - `*path` as the last segment, a wildcard matching the rest of the path
+ *
+ * Static text wins over a parameter, which wins over a wildcard; the
+ * lookup backtracks when a more specific branch dead-ends.
+ */
+
+#ifndef INCLUDE_OUC_SERVER_HTTP_ROUTER
+#define INCLUDE_OUC_SERVER_HTTP_ROUTER
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <array>
+#include <memory>
+#include <functional>
+
+#include <http/http_method_type.hpp>
+#include <http/http_request.hpp>
+#include <http/http_response_writer.hpp>
+
+namespace ouc_server
+{
+    namespace http
+    {
+        /**
+         * @brief Parameters captured by a route lookup.
+         *
+         * Names point into the router, values into the looked up path, so
+         * both stay valid only as long as the router and the path do.
+         */
+        class HttpRouteParams
+        {
+        public:
+            static constexpr size_t MAX_PARAMS = 8; ///< Captures allowed per route.
+
+        private:
+            std::array<std::pair<std::string_view, std::string_view>, MAX_PARAMS> items;
+            size_t count = 0;
+
+        public:
+            /**
+             * @brief Value of a named capture, empty if absent.
+             */
+            std::string_view get(std::string_view name) const noexcept
+            {
+                for (size_t i = 0; i < count; ++i)
+                    if (items[i].first == name)
+                        return items[i].second;
+                return {};
+            }
+
+            size_t size() const noexcept { return count; }
+
+            const std::pair<std::string_view, std::string_view> &operator[](size_t idx) const noexcept { return items[idx]; }
+
+            void push(std::string_view name, std::string_view value) noexcept { items[count++] = {name, value}; }
+            void pop() noexcept { --count; }
+            void clear() noexcept { count = 0; }
+        };
+
+        using HttpRouteHandler = std::function<void(HttpRequest &, HttpResponseWriter &, const HttpRouteParams &)>;
+
+        /**
+         * @class HttpRouter
+         * @brief Maps method and path to a handler.
+         *
+         * Example:
+         * @code
+         * HttpRouter router;
+         * router.add(HttpMethodType::Get, "/users/:id",
+         *     [](HttpRequest &req, HttpResponseWriter &res, const HttpRouteParams &params)
+         *     { res.end(std::string(params.get("id"))); });
+         * router.freeze();
+         * server.on_request([&](HttpRequest &req, HttpResponseWriter &res){ router.handle(req, res); });
+         * @endcode
+         */
+        class HttpRouter
+        {
+        private:
+            enum class NodeKind : uint8_t
+            {
+                Static,
+                Param,
+                Wildcard
+            };
+
+            /// Mutable node used while routes are being added.
+            struct BuildNode
+            {
+                NodeKind kind = NodeKind::Static;
+                std::string label; ///< Static text, or the capture name.
+                std::vector<std::unique_ptr<BuildNode>> children;
+                std::unique_ptr<BuildNode> param_child;
+                std::unique_ptr<BuildNode> wildcard_child;
+                int32_t handler = -1;
+            };
+
+            /// Read-only node of the frozen layout.
+            struct Node
+            {
+                uint32_t label_offset;  ///< Label position in labels.
+                uint32_t label_len;     ///< Label length.
+                uint32_t first_child;   ///< Index of the first static child.
+                uint32_t child_count;   ///< Static children, contiguous and sorted by first byte.
+                int32_t param_child;    ///< Index of the parameter child, -1 if none.
+                int32_t wildcard_child; ///< Index of the wildcard child, -1 if none.
+                int32_t handler;        ///< Index in handlers, -1 if no route ends here.
+                char first;             ///< First byte of a static label.
+                NodeKind kind;
+            };
+
+            std::array<std::unique_ptr<BuildNode>, HTTP_METHOD_TYPE_COUNT> trees;
+            std::vector<HttpRouteHandler> handlers;
+
+            bool frozen = false;
+            std::vector<Node> nodes;
+            std::string labels;
+            std::array<int32_t, HTTP_METHOD_TYPE_COUNT> roots;
+
+        public:
+            HttpRouter();
+
+        public:
+            /**
+             * @brief Register a route.
+             * @throw std::invalid_argument on malformed, duplicate or conflicting patterns.
+             * @throw std::logic_error once the router is frozen.
+             */
+            void add(HttpMethodType method, std::string_view pattern, HttpRouteHandler &&handler);
+
+            /**
+             * @brief Compile the routes into the read-only lookup layout.
+             */
+            void freeze();
+
+            bool is_frozen() const noexcept { return frozen; }
+
+            size_t get_node_count() const noexcept { return nodes.size(); }
+
+            /**
+             * @brief Find the handler of a path, ignoring any query string.
+             * @param method Request method.
+             * @param path Request target, must outlive the captured values.
+             * @param params Filled with the captures of the matched route.
+             * @return The handler, or nullptr if no route matches or not frozen.
+             */
+            const HttpRouteHandler *lookup(HttpMethodType method, std::string_view path, HttpRouteParams &params) const;
+
+            /**
+             * @brief Dispatch a request, answering 404 or 405 if no route matches.
+             *
+             * HEAD falls back to the GET route when it has none of its own.
+             *
+             * @return true if a route handled the request.
+             */
+            bool handle(HttpRequest &req, HttpResponseWriter &res) const;
+
+        private:
+            BuildNode *insert_static(BuildNode *node, std::string_view text);
+
+            void flatten(const BuildNode *node, uint32_t idx);
+
+            bool match(uint32_t idx, std::string_view path, size_t pos, HttpRouteParams &params, int32_t &handler) const;
+        };
+    }
+}
+
+#endif // INCLUDE_OUC_SERVER_HTTP_ROUTER
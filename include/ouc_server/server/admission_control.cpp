@@ -0,0 +1,173 @@
+#include <server/admission_control.hpp>
+
+#include <netinet/in.h>
+#include <cstring>
+#include <algorithm>
+
+namespace ouc_server
+{
+    namespace server
+    {
+        namespace
+        {
+            constexpr uint64_t pack(uint64_t milli_tokens, uint32_t time_ms) { return milli_tokens << 32 | time_ms; }
+            constexpr uint64_t tokens_of(uint64_t bucket) { return bucket >> 32; }
+            constexpr uint32_t time_of(uint64_t bucket) { return static_cast<uint32_t>(bucket); }
+
+            /// Spread keys whose low bits agree, e.g. neighbouring /64 prefixes.
+            uint64_t mix(uint64_t key)
+            {
+                key ^= key >> 33;
+                key *= 0xff51afd7ed558ccdULL;
+                key ^= key >> 33;
+                return key;
+            }
+        }
+
+        AdmissionControl::AdmissionControl(const AdmissionConfig &p_config)
+            : config(p_config),
+              epoch(std::chrono::steady_clock::now())
+        {
+            size_t size = 1;
+            while (size < std::max<size_t>(config.table_size, MAX_PROBE))
+                size <<= 1;
+            slots.reset(new Slot[size]);
+            mask = size - 1;
+
+            double burst = config.burst > 0 ? config.burst : config.requests_per_second;
+            burst_milli = std::min<uint64_t>(static_cast<uint64_t>(std::max(burst, 1.0) * 1000), UINT32_MAX);
+        }
+
+        uint64_t AdmissionControl::key_of(const sockaddr_storage &peer) noexcept
+        {
+            if (peer.ss_family == AF_INET)
+            {
+                auto &in = reinterpret_cast<const sockaddr_in &>(peer);
+                return uint64_t(1) << 32 | ntohl(in.sin_addr.s_addr);
+            }
+            if (peer.ss_family == AF_INET6)
+            {
+                auto &in6 = reinterpret_cast<const sockaddr_in6 &>(peer);
+                const uint8_t *bytes = in6.sin6_addr.s6_addr;
+
+                // IPv4 reaching a dual-stack listener counts as that IPv4 client
+                if (IN6_IS_ADDR_V4MAPPED(&in6.sin6_addr))
+                {
+                    uint32_t v4;
+                    std::memcpy(&v4, bytes + 12, sizeof(v4));
+                    return uint64_t(1) << 32 | ntohl(v4);
+                }
+
+                uint64_t prefix = 0;
+                for (int i = 0; i < 8; ++i)
+                    prefix = prefix << 8 | bytes[i];
+                return prefix != 0 ? prefix : 1;
+            }
+            return 0;
+        }
+
+        uint32_t AdmissionControl::now_ms() const noexcept
+        {
+            // Wraps after 49 days, only differences of recent times are used
+            auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - epoch).count();
+            return static_cast<uint32_t>(ms);
+        }
+
+        uint64_t AdmissionControl::refill(uint64_t bucket, uint32_t now) const noexcept
+        {
+            // Another thread may have refilled at a later time than ours
+            if (static_cast<int32_t>(now - time_of(bucket)) <= 0)
+                return bucket;
+
+            uint64_t tokens = tokens_of(bucket);
+            uint32_t elapsed = now - time_of(bucket);
+
+            // requests_per_second tokens per second is that many milli-tokens per ms
+            uint64_t added = static_cast<uint64_t>(elapsed * config.requests_per_second);
+            if (tokens + added >= burst_milli)
+                return pack(burst_milli, now);
+
+            // Advance the clock only by the time the whole milli-tokens took,
+            // so slow rates still accumulate across frequent calls.
+            if (added == 0)
+                return bucket;
+            uint32_t used = static_cast<uint32_t>(added / config.requests_per_second);
+            return pack(tokens + added, time_of(bucket) + used);
+        }
+
+        bool AdmissionControl::is_reclaimable(Slot &slot, uint32_t now) const noexcept
+        {
+            if (slot.connections.load(std::memory_order_acquire) != 0)
+                return false;
+            if (config.requests_per_second <= 0)
+                return true;
+            return tokens_of(refill(slot.bucket.load(std::memory_order_relaxed), now)) >= burst_milli;
+        }
+
+        bool AdmissionControl::admit(uint64_t key, int &slot_index)
+        {
+            slot_index = -1;
+            if (key == 0)
+                return true;
+
+            uint32_t now = now_ms();
+            size_t start = mix(key) & mask;
+            Slot *free_slot = nullptr;
+
+            for (size_t i = 0; i < MAX_PROBE; ++i)
+            {
+                size_t index = (start + i) & mask;
+                Slot &slot = slots[index];
+                uint64_t current = slot.key.load(std::memory_order_relaxed);
+
+                if (current == key)
+                {
+                    uint32_t limit = config.max_connections_per_client;
+                    if (limit > 0 && slot.connections.load(std::memory_order_relaxed) >= limit)
+                        return false;
+                    slot.connections.fetch_add(1, std::memory_order_acq_rel);
+                    slot_index = static_cast<int>(index);
+                    return true;
+                }
+                if (free_slot == nullptr && (current == 0 || is_reclaimable(slot, now)))
+                    free_slot = &slot;
+            }
+
+            // Table crowded around this key: admit without per-client limits
+            if (free_slot == nullptr)
+                return true;
+
+            free_slot->connections.store(1, std::memory_order_relaxed);
+            free_slot->bucket.store(pack(burst_milli, now), std::memory_order_relaxed);
+            free_slot->key.store(key, std::memory_order_release);
+            slot_index = static_cast<int>(free_slot - slots.get());
+            return true;
+        }
+
+        void AdmissionControl::release(int slot) noexcept
+        {
+            if (slot >= 0)
+                slots[slot].connections.fetch_sub(1, std::memory_order_acq_rel);
+        }
+
+        bool AdmissionControl::take(int slot_index) noexcept
+        {
+            if (slot_index < 0 || config.requests_per_second <= 0)
+                return true;
+
+            Slot &slot = slots[slot_index];
+            uint32_t now = now_ms();
+            uint64_t bucket = slot.bucket.load(std::memory_order_relaxed);
+            while (true)
+            {
+                uint64_t filled = refill(bucket, now);
+                if (tokens_of(filled) < 1000)
+                    return false;
+
+                uint64_t next = pack(tokens_of(filled) - 1000, time_of(filled));
+                if (slot.bucket.compare_exchange_weak(bucket, next, std::memory_order_relaxed))
+                    return true;
+            }
+        }
+    }
+}
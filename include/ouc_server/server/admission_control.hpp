@@ -0,0 +1,104 @@
+/**
+ * @file admission_control.hpp
+ * @brief Per-client connection caps and request rate limiting.
+ *
+ * Clients are keyed by source address: the IPv4 address, or the /64 prefix
+ * of an IPv6 one since a single host usually owns a whole /64. Each key has
+ * a slot in a fixed open-addressing table holding its open connection count
+ * and a token bucket packed into one 64-bit word, so the request path is a
+ * single CAS loop with no lock.
+ *
+ * Only the accepting thread inserts keys; TCPServer accepts under one lock.
+ * A slot is recycled once it has no connection left and its bucket would
+ * be full again, so forgetting it loses nothing.
+ */
+
+#ifndef INCLUDE_OUC_SERVER_ADMISSION_CONTROL
+#define INCLUDE_OUC_SERVER_ADMISSION_CONTROL
+
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include <memory>
+#include <chrono>
+
+#include <sys/socket.h>
+
+namespace ouc_server
+{
+    namespace server
+    {
+        /// Limits enforced by AdmissionControl, 0 means unlimited throughout.
+        struct AdmissionConfig
+        {
+            size_t max_connections = 0;              ///< Open connections in total.
+            uint32_t max_connections_per_client = 0; ///< Open connections per source address.
+            double requests_per_second = 0;          ///< Sustained request rate per source address.
+            double burst = 0;                        ///< Requests allowed at once, 0 for requests_per_second.
+            size_t table_size = 65536;               ///< Clients tracked at once, rounded up to a power of two.
+        };
+
+        class AdmissionControl
+        {
+        public:
+            /// Slots probed for a key before the client is let in untracked.
+            static constexpr size_t MAX_PROBE = 16;
+
+        private:
+            struct Slot
+            {
+                std::atomic<uint64_t> key{0};         ///< Client key, 0 while free.
+                std::atomic<uint64_t> bucket{0};      ///< Milli-tokens << 32 | refill time in ms.
+                std::atomic<uint32_t> connections{0}; ///< Open connections of the client.
+            };
+
+            AdmissionConfig config;
+            std::unique_ptr<Slot[]> slots;
+            size_t mask;
+            uint64_t burst_milli; ///< Bucket capacity in milli-tokens.
+            std::chrono::steady_clock::time_point epoch;
+
+        public:
+            explicit AdmissionControl(const AdmissionConfig &config);
+
+            const AdmissionConfig &get_config() const noexcept { return config; }
+
+            /**
+             * @brief Key of a peer address, 0 for addresses that are not tracked (Unix sockets).
+             */
+            static uint64_t key_of(const sockaddr_storage &peer) noexcept;
+
+            /**
+             * @brief Count a new connection of a client against its cap.
+             * @param key Client key from key_of().
+             * @param slot Set to the client's slot, -1 if it is not tracked.
+             * @return false if the client already has its maximum of connections.
+             */
+            bool admit(uint64_t key, int &slot);
+
+            /**
+             * @brief Forget a connection counted by admit().
+             * @param slot Slot returned by admit(), -1 is ignored.
+             */
+            void release(int slot) noexcept;
+
+            /**
+             * @brief Take one token from the client's bucket.
+             * @param slot Slot returned by admit(), -1 always passes.
+             * @return false if the client exceeds its request rate.
+             */
+            bool take(int slot) noexcept;
+
+        private:
+            uint32_t now_ms() const noexcept;
+
+            /// Bucket refilled up to now, as packed in Slot::bucket.
+            uint64_t refill(uint64_t bucket, uint32_t now) const noexcept;
+
+            /// No open connection and a full bucket: the slot holds nothing worth keeping.
+            bool is_reclaimable(Slot &slot, uint32_t now) const noexcept;
+        };
+    }
+}
+
+#endif // INCLUDE_OUC_SERVER_ADMISSION_CONTROL
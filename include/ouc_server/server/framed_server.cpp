@@ -0,0 +1,114 @@
+#include <server/framed_server.hpp>
+
+#include <codec/length_prefixed_codec.hpp>
+
+namespace ouc_server
+{
+    namespace server
+    {
+        FramedServer::FramedServer(CodecFactory p_factory, size_t task_count)
+            : factory(std::move(p_factory)), server(task_count)
+        {
+            using ouc_server::ouc_socket::TCPSocket;
+
+            if (!factory)
+                factory = []
+                { return std::make_unique<ouc_server::codec::LengthPrefixedCodec>(); };
+            encoder = factory();
+
+            server.on_connection(
+                [this](TCPSocket &client)
+                {
+                    auto session = std::make_shared<Session>();
+                    session->codec = factory();
+                    {
+                        std::lock_guard<std::mutex> lk(sessions_mtx);
+                        sessions[client.get_fd()] = std::move(session);
+                    }
+                    if (on_connection_callback)
+                        on_connection_callback(client);
+                });
+
+            server.on_message(
+                [this](TCPSocket &client, const std::string &data)
+                { handle_message(client, data); });
+
+            server.on_close(
+                [this](TCPSocket &client)
+                {
+                    {
+                        std::lock_guard<std::mutex> lk(sessions_mtx);
+                        if (sessions.erase(client.get_fd()) == 0)
+                            return;
+                    }
+                    if (on_close_callback)
+                        on_close_callback(client);
+                });
+        }
+
+        std::shared_ptr<FramedServer::Session> FramedServer::find_session(int fd)
+        {
+            std::lock_guard<std::mutex> lk(sessions_mtx);
+            auto it = sessions.find(fd);
+            return it == sessions.end() ? nullptr : it->second;
+        }
+
+        void FramedServer::handle_message(ouc_server::ouc_socket::TCPSocket &client, const std::string &data)
+        {
+            auto session = find_session(client.get_fd());
+            if (!session)
+                return;
+
+            // Messages of one connection are never dispatched concurrently,
+            // so the codec needs no locking of its own.
+            bool ok = session->codec->decode(
+                data,
+                [this, &client](std::string_view frame)
+                {
+                    frames_in.add();
+                    if (on_frame_callback)
+                        on_frame_callback(client, frame);
+                });
+            if (!ok)
+            {
+                codec_errors.add();
+                server.close_after_flush(client);
+            }
+        }
+
+        bool FramedServer::send(ouc_server::ouc_socket::TCPSocket &client, std::string_view frame)
+        {
+            std::string out;
+            out.reserve(frame.size() + encoder->max_overhead());
+            encoder->encode(out, frame);
+            return server.send(client, std::move(out));
+        }
+
+        bool FramedServer::send(ouc_server::ouc_socket::TCPSocket &client, const std::vector<std::string_view> &frames)
+        {
+            std::string out;
+            encoder->encode(out, frames);
+            return server.send(client, std::move(out));
+        }
+
+        size_t FramedServer::publish(const std::string &topic, std::string_view frame, SlowConsumerPolicy policy)
+        {
+            std::string out;
+            out.reserve(frame.size() + encoder->max_overhead());
+            encoder->encode(out, frame);
+            return server.publish(topic, std::make_shared<const std::string>(std::move(out)), policy);
+        }
+
+        void FramedServer::write_metrics(std::string &out)
+        {
+            using namespace ouc_server::utils;
+
+            prometheus::write_header(out, "ouc_framed_frames_total", "counter", "Frames decoded.");
+            prometheus::write_value(out, "ouc_framed_frames_total", "", static_cast<double>(frames_in.value()));
+            prometheus::write_header(out, "ouc_framed_codec_errors_total", "counter", "Connections closed for a malformed stream.");
+            prometheus::write_value(out, "ouc_framed_codec_errors_total", "", static_cast<double>(codec_errors.value()));
+
+            server.write_metrics(out);
+        }
+    }
+}
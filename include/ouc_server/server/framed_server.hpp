@@ -0,0 +1,146 @@
+/**
+ * @file framed_server.hpp
+ * @brief Message server for binary protocols, built on top of TCPServer.
+ *
+ * Each connection owns a Codec that cuts the received bytes into frames;
+ * handlers see whole frames only. The codec is pluggable, by default a
+ * LengthPrefixedCodec with a 4-byte header.
+ */
+
+#ifndef INCLUDE_OUC_SERVER_FRAMED_SERVER
+#define INCLUDE_OUC_SERVER_FRAMED_SERVER
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include <server/tcp_server.hpp>
+#include <codec/codec.hpp>
+
+namespace ouc_server
+{
+    namespace server
+    {
+        /**
+         * @class FramedServer
+         * @brief Decodes frames off TCPServer connections and dispatches them.
+         *
+         * Frames of one connection are delivered in order and never
+         * concurrently. A connection whose stream the codec rejects is
+         * closed.
+         *
+         * Example:
+         * @code
+         * FramedServer server;
+         * server.on_frame([&](TCPSocket &client, std::string_view frame){ server.send(client, handle(frame)); });
+         * server.start("127.0.0.1", 9000);
+         * while(true) server.loop(10);
+         * @endcode
+         */
+        class FramedServer
+        {
+        public:
+            template <typename... Args>
+            using Callback = std::function<void(ouc_server::ouc_socket::TCPSocket &, Args...)>;
+
+            /// Makes the codec of each new connection.
+            using CodecFactory = std::function<std::unique_ptr<ouc_server::codec::Codec>()>;
+
+        private:
+            /// Decoder state bound to one client connection.
+            struct Session
+            {
+                std::unique_ptr<ouc_server::codec::Codec> codec;
+            };
+
+            CodecFactory factory;
+            std::unique_ptr<ouc_server::codec::Codec> encoder; ///< Encodes publish() frames once for everyone.
+
+            std::mutex sessions_mtx;                                    ///< Guards sessions.
+            std::unordered_map<int, std::shared_ptr<Session>> sessions; ///< Codec per client fd.
+
+            Callback<> on_connection_callback;             ///< Callback for new connections.
+            Callback<std::string_view> on_frame_callback;  ///< Callback for each decoded frame.
+            Callback<> on_close_callback;                  ///< Callback for closed connections.
+
+            ouc_server::utils::Counter frames_in;     ///< Frames decoded.
+            ouc_server::utils::Counter codec_errors;  ///< Connections closed for a malformed stream.
+
+            // Declared last so it is destroyed first: its worker threads are
+            // joined while the sessions and callbacks they use still exist.
+            TCPServer server; ///< Underlying TCP transport.
+
+        public:
+            /**
+             * @brief Construct a new FramedServer instance.
+             * @param p_factory Codec for each connection, empty for a 4-byte length prefix.
+             * @param task_count Number of thread in the thread pool, 0 for one per CPU.
+             */
+            explicit FramedServer(CodecFactory p_factory = {}, size_t task_count = 0);
+
+        public:
+            void on_connection(Callback<> &&callback) { on_connection_callback = std::move(callback); }
+
+            /**
+             * @brief Register callback for decoded frames.
+             * @param callback Function receiving a view valid only during the call.
+             */
+            void on_frame(Callback<std::string_view> &&callback) { on_frame_callback = std::move(callback); }
+
+            void on_close(Callback<> &&callback) { on_close_callback = std::move(callback); }
+
+        public:
+            /**
+             * @brief Send one frame, see TCPServer::send() for blocking.
+             * @return false if the connection is gone.
+             */
+            bool send(ouc_server::ouc_socket::TCPSocket &client, std::string_view frame);
+
+            /**
+             * @brief Send several frames encoded into one buffer, written with one system call.
+             * @return false if the connection is gone.
+             */
+            bool send(ouc_server::ouc_socket::TCPSocket &client, const std::vector<std::string_view> &frames);
+
+            /**
+             * @brief Encode a frame once and queue it on every subscriber, see TCPServer::publish().
+             * @return Number of subscribers it was queued on.
+             */
+            size_t publish(const std::string &topic, std::string_view frame, SlowConsumerPolicy policy = SlowConsumerPolicy::Drop);
+
+            /**
+             * @brief Append frame and transport metrics in Prometheus text format.
+             * @param out Buffer to append to.
+             */
+            void write_metrics(std::string &out);
+
+        public:
+            bool start(const std::string &address, uint16_t port) { return server.start(address, port); }
+
+            /**
+             * @brief Run the event loop for one time.
+             * @param timeout_ms Maximum time to block waiting for events.
+             */
+            void loop(int timeout_ms = 0) { server.loop(timeout_ms); }
+
+            void stop() { server.stop(); }
+
+            TCPServer &tcp_server() noexcept { return server; }
+
+        private:
+            std::shared_ptr<Session> find_session(int fd);
+
+            /**
+             * @brief Feed received bytes into the connection's codec.
+             */
+            void handle_message(ouc_server::ouc_socket::TCPSocket &client, const std::string &data);
+        };
+    }
+}
+
+#endif // INCLUDE_OUC_SERVER_FRAMED_SERVER
@@ -0,0 +1,333 @@
+#include <server/http_server.hpp>
+
+#include <http/http_response.hpp>
+#include <http/http_headers.hpp>
+
+namespace ouc_server
+{
+    namespace server
+    {
+        HttpServer::HttpServer(size_t task_count)
+            : HttpServer(TCPServerConfig::with_threads(0, task_count))
+        {
+        }
+
+        HttpServer::HttpServer(const TCPServerConfig &config)
+            : server(config)
+        {
+            using ouc_server::http::HttpRequest;
+            using ouc_server::ouc_socket::TCPSocket;
+
+            server.on_connection(
+                [this](TCPSocket &client)
+                {
+                    auto session = std::make_shared<Session>(parser_config);
+                    session->remote_address = server.peer_address(client);
+                    Session *raw = session.get();
+
+                    session->parser.on_headers(
+                        [this, raw](HttpRequest &req)
+                        {
+                            begin_response(*raw, req);
+                            if (raw->is_internal)
+                                return;
+                            raw->in_request.store(true);
+                            if (on_headers_callback)
+                                on_headers_callback(req, *raw->writer);
+                        });
+                    session->parser.on_body(
+                        [this, raw](HttpRequest &req, std::string_view chunk)
+                        {
+                            if (on_body_callback && !raw->is_internal)
+                                on_body_callback(req, *raw->writer, chunk);
+                        });
+                    session->parser.on_complete(
+                        [this, raw](HttpRequest &req)
+                        {
+                            if (on_request_callback && !raw->is_internal)
+                                on_request_callback(req, *raw->writer);
+
+                            // Deferred and still open: hold later requests until it ends
+                            if (raw->writer->is_deferred())
+                            {
+                                std::lock_guard<std::mutex> lk(raw->flow_mtx);
+                                if (!raw->response_done)
+                                {
+                                    raw->response_pending = true;
+                                    if (!raw->input_paused)
+                                    {
+                                        raw->parser.pause();
+                                        server.hold(*raw->socket);
+                                    }
+                                    return;
+                                }
+                            }
+                            raw->in_request.store(false);
+
+            // Keep pipelined responses in order
+                            if (!raw->writer->is_ended())
+                                raw->writer->end();
+                            raw->writer.reset();
+                        });
+
+                    std::lock_guard<std::mutex> lk(sessions_mtx);
+                    sessions[client.get_fd()] = std::move(session);
+                });
+
+            server.on_message(
+                [this](TCPSocket &client, const std::string &data)
+                { handle_message(client, data); });
+
+            server.on_close(
+                [this](TCPSocket &client)
+                {
+                    std::shared_ptr<Session> session;
+                    {
+                        std::lock_guard<std::mutex> lk(sessions_mtx);
+                        auto it = sessions.find(client.get_fd());
+                        if (it == sessions.end())
+                            return;
+                        session = std::move(it->second);
+                        sessions.erase(it);
+                    }
+
+                    if (!on_abort_callback || !session->in_request.load())
+                        return;
+
+                    // Not on this thread: the close may come from a send of this
+                    // very response, inside a writer call that must not see the
+                    // writer destroyed. The task keeps the session alive.
+                    auto abort = [this, session]
+                    { on_abort_callback(session->parser.request()); };
+                    try
+                    {
+                        server.get_loop().get_pool().sumbit(abort);
+                    }
+                    catch (...)
+                    {
+                        // Pool already stopped: no other callback is left running
+                        abort();
+                    }
+                });
+
+            // Between requests: nothing parsed of the next one, no response open
+            server.set_idle_check(
+                [this](TCPSocket &client)
+                {
+                    std::lock_guard<std::mutex> lk(sessions_mtx);
+                    auto it = sessions.find(client.get_fd());
+                    return it == sessions.end() ||
+                           (it->second->parser.is_idle() && (!it->second->writer || it->second->writer->is_ended()));
+                });
+
+            // Fires from loop(); the loop is destroyed before date is
+            refresh_date();
+        }
+
+        void HttpServer::handle_message(ouc_server::ouc_socket::TCPSocket &client, const std::string &data)
+        {
+            std::shared_ptr<Session> session;
+            {
+                std::lock_guard<std::mutex> lk(sessions_mtx);
+                auto it = sessions.find(client.get_fd());
+                if (it == sessions.end())
+                    return;
+                session = it->second;
+            }
+
+            // Messages of one connection are never dispatched concurrently,
+            // so the parser needs no locking of its own.
+            session->socket = &client;
+            std::string_view rest = data;
+            while (true)
+            {
+                if (!session->parser.feed(rest))
+                {
+                    rejections.add();
+                    reject(*session, session->parser.get_error_code());
+                    return;
+                }
+                rest.remove_prefix(session->parser.get_consumed());
+                if (rest.empty())
+                    return;
+
+                // Paused by a handler: the rest waits for release(), unless
+                // the input was resumed already
+                std::lock_guard<std::mutex> lk(session->flow_mtx);
+                if (session->input_paused || session->response_pending)
+                {
+                    session->unread.assign(rest);
+                    return;
+                }
+            }
+        }
+
+        void HttpServer::set_input_paused(Session &session, bool paused)
+        {
+            std::lock_guard<std::mutex> lk(session.flow_mtx);
+            if (session.input_paused == paused)
+                return;
+            session.input_paused = paused;
+            if (session.response_pending)
+                return;
+
+            if (paused)
+            {
+                session.parser.pause();
+                server.hold(*session.socket);
+            }
+            else
+                server.release(*session.socket, std::move(session.unread));
+        }
+
+        void HttpServer::finish_response(Session &session, bool closing)
+        {
+            // Answered: a close from here on aborts nothing
+            session.in_request.store(false);
+
+            std::lock_guard<std::mutex> lk(session.flow_mtx);
+            session.response_done = true;
+            if (!session.response_pending)
+                return;
+
+            session.response_pending = false;
+            if (!session.input_paused && !closing)
+                server.release(*session.socket, std::move(session.unread));
+        }
+
+        void HttpServer::write_metrics(std::string &out)
+        {
+            using namespace ouc_server::utils;
+
+            prometheus::write_header(out, "ouc_http_requests_total", "counter", "Requests received.");
+            prometheus::write_value(out, "ouc_http_requests_total", "", static_cast<double>(requests.value()));
+            prometheus::write_header(out, "ouc_http_rejected_requests_total", "counter", "Requests rejected as malformed or too large.");
+            prometheus::write_value(out, "ouc_http_rejected_requests_total", "", static_cast<double>(rejections.value()));
+
+            if (compression)
+            {
+                prometheus::write_header(out, "ouc_http_compression_cache_hits_total", "counter", "Responses served from cached compressed variants.");
+                prometheus::write_value(out, "ouc_http_compression_cache_hits_total", "", static_cast<double>(compression->get_hits()));
+                prometheus::write_header(out, "ouc_http_compression_cache_misses_total", "counter", "Cacheable responses compressed anew.");
+                prometheus::write_value(out, "ouc_http_compression_cache_misses_total", "", static_cast<double>(compression->get_misses()));
+            }
+
+            server.write_metrics(out);
+        }
+
+        void HttpServer::refresh_date()
+        {
+            auto delay = date.refresh();
+            server.get_loop().add_timer(delay, [this]
+                                        { refresh_date(); });
+        }
+
+        void HttpServer::begin_response(Session &session, ouc_server::http::HttpRequest &req)
+        {
+            using ouc_server::http::find_header;
+            using ouc_server::http::iequals;
+
+            // HTTP/1.1 keeps the connection unless told otherwise, 1.0 the opposite
+            auto *connection = find_header(req.headers, "Connection");
+            bool keep_alive = req.version == "HTTP/1.1"
+                                  ? !(connection && iequals(*connection, "close"))
+                                  : (connection && iequals(*connection, "keep-alive"));
+
+            // Draining: finish this request, then let the client reconnect elsewhere
+            if (server.is_stopped())
+                keep_alive = false;
+
+            req.remote_address = session.remote_address;
+
+            auto *client = session.socket;
+            {
+                std::lock_guard<std::mutex> lk(session.flow_mtx);
+                session.response_done = false;
+            }
+            session.writer.emplace(
+                [this, client](std::string &&data)
+                { return server.send(*client, std::move(data)); },
+                [this, client, &session](bool keep_alive)
+                {
+                    // Also covers requests that were already running when stop() was called
+                    bool closing = !keep_alive || server.is_stopped();
+
+                    // First: closing may drop the session
+                    finish_response(session, closing);
+                    if (closing)
+                        server.close_after_flush(*client);
+                });
+            session.writer->set_flow_control(
+                [this, &session](bool paused)
+                { set_input_paused(session, paused); },
+                [this, client](std::function<void()> &&callback)
+                { return server.notify_writable(*client, std::move(callback)); });
+            session.writer->set_date(&date);
+            session.writer->set_keep_alive(keep_alive);
+            session.writer->set_head_only(req.method == ouc_server::http::HttpMethodType::Head);
+            if (compression)
+            {
+                auto *accept = find_header(req.headers, "Accept-Encoding");
+                session.writer->set_compression(
+                    accept ? ouc_server::http::negotiate_encoding(*accept) : ouc_server::http::ContentEncoding::Identity,
+                    compression.get());
+            }
+
+            requests.add();
+
+            // Over the client's request rate: answer here, the body is skipped
+            if (!server.allow_request(*client))
+            {
+                session.is_internal = true;
+                session.writer->status(429, "Too Many Requests").header("Retry-After", "1").end();
+                return;
+            }
+
+            // Overloaded and this request already waited too long: a fast 503
+            // frees the worker for requests that can still be served in time
+            if (server.should_shed())
+            {
+                session.is_internal = true;
+                session.writer->status(503, "Service Unavailable").header("Retry-After", "1").end();
+                return;
+            }
+
+            // Body was accepted: let a waiting client start sending it
+            auto *expect = find_header(req.headers, "Expect");
+            if (expect && iequals(*expect, "100-continue"))
+                server.send(*client, std::string("HTTP/1.1 100 Continue\r\n\r\n"));
+
+            // Metrics endpoint: answered right away, the request body is ignored
+            session.is_internal = !metrics_path.empty() &&
+                                  (req.method == ouc_server::http::HttpMethodType::Get ||
+                                   req.method == ouc_server::http::HttpMethodType::Head) &&
+                                  std::string_view(req.path).substr(0, req.path.find('?')) == metrics_path;
+            if (session.is_internal)
+            {
+                std::string body;
+                write_metrics(body);
+                session.writer->header("Content-Type", "text/plain; version=0.0.4").end(body);
+            }
+        }
+
+        void HttpServer::reject(Session &session, int code)
+        {
+            auto *client = session.socket;
+
+            // Too late for a status once the response has started
+            if (session.writer && session.writer->is_head_sent())
+            {
+                server.close_after_flush(*client);
+                return;
+            }
+
+            session.writer.reset();
+            ouc_server::http::HttpResponseWriter writer(
+                [this, client](std::string &&data)
+                { return server.send(*client, std::move(data)); });
+            writer.set_keep_alive(false);
+            writer.status(code).end();
+            server.close_after_flush(*client);
+        }
+    }
+}
@@ -0,0 +1,304 @@
+/**
+ * @file http_server.hpp
+ * @brief HTTP/1.1 server built on top of TCPServer.
+ *
+ * Each connection owns an incremental HttpRequestParser. Request bodies are
+ * streamed to the user as they arrive, so a large upload is processed in
+ * constant memory instead of being buffered whole. Responses are produced
+ * through an HttpResponseWriter that streams into the connection's output
+ * buffer.
+ */
+
+#ifndef INCLUDE_OUC_SERVER_HTTP_SERVER
+#define INCLUDE_OUC_SERVER_HTTP_SERVER
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <functional>
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <chrono>
+
+#include <server/tcp_server.hpp>
+#include <http/http_request.hpp>
+#include <http/http_request_parser.hpp>
+#include <http/http_response_writer.hpp>
+#include <http/http_compression.hpp>
+#include <http/http_format.hpp>
+
+namespace ouc_server
+{
+    namespace server
+    {
+        /**
+         * @class HttpServer
+         * @brief Parses HTTP requests off TCPServer connections and dispatches them.
+         *
+         * Callbacks of one connection run in order and never concurrently.
+         * Requests whose declared body exceeds HttpParserConfig::max_body_size
+         * are answered with 413 before any body byte is read; clients sending
+         * `Expect: 100-continue` are only told to continue once accepted.
+         * Request lines and headers over the other limits are answered with
+         * 414 or 431 as soon as the partial line crosses them, malformed or
+         * ambiguously framed requests with 400; the connection is closed.
+         *
+         * Each request gets a writer valid from on_headers until on_request
+         * returns; a response not ended by then is ended automatically, so
+         * pipelined responses always go out in request order. A deferred one
+         * (HttpResponseWriter::defer()) stays valid until it is ended or the
+         * request is aborted, and the connection's next request waits for it
+         * without holding a thread.
+         *
+         * Example:
+         * @code
+         * HttpServer server;
+         * server.on_body([](HttpRequest &req, HttpResponseWriter &res, std::string_view chunk){ ... });
+         * server.on_request([](HttpRequest &req, HttpResponseWriter &res){ res.end("hello"); });
+         * server.start("127.0.0.1", 8080);
+         * while(true) server.loop(10);
+         * @endcode
+         */
+        class HttpServer
+        {
+        public:
+            template <typename... Args>
+            using Callback = std::function<void(
+                ouc_server::http::HttpRequest &,
+                ouc_server::http::HttpResponseWriter &,
+                Args...)>;
+
+        private:
+            /// Parser state bound to one client connection.
+            struct Session
+            {
+                ouc_server::http::HttpRequestParser parser;
+                ouc_server::ouc_socket::TCPSocket *socket = nullptr;        ///< Connection currently being fed.
+                std::optional<ouc_server::http::HttpResponseWriter> writer; ///< Response to the current request.
+                bool is_internal = false;                                   ///< Current request is answered by the server itself.
+                std::string remote_address;                                 ///< Client address, copied into each request.
+                std::atomic<bool> in_request{false};                        ///< From on_headers until the response ends, or the request does unless deferred.
+
+                std::mutex flow_mtx;           ///< Guards the fields below.
+                bool input_paused = false;     ///< Handler paused the request input.
+                bool response_pending = false; ///< Deferred response still open, later requests wait.
+                bool response_done = false;    ///< The current response has ended.
+                std::string unread;            ///< Input the parser stopped short of while paused.
+
+                explicit Session(const ouc_server::http::HttpParserConfig &config)
+                    : parser(config) {}
+            };
+
+            ouc_server::http::HttpParserConfig parser_config;           ///< Limits for new connections.
+            std::mutex sessions_mtx;                                    ///< Guards sessions.
+            std::unordered_map<int, std::shared_ptr<Session>> sessions; ///< Parser state per client fd.
+
+            Callback<> on_headers_callback;              ///< Callback once headers are parsed.
+            Callback<std::string_view> on_body_callback; ///< Callback for each received body chunk.
+            Callback<> on_request_callback;              ///< Callback once a request is complete.
+            std::function<void(ouc_server::http::HttpRequest &)> on_abort_callback; ///< Callback for requests cut short.
+
+            std::unique_ptr<ouc_server::http::CompressionCache> compression; ///< Response compression, nullptr if disabled.
+            std::string metrics_path;              ///< Path served with metrics, empty if disabled.
+            ouc_server::utils::Counter requests;   ///< Requests whose headers were parsed.
+            ouc_server::utils::Counter rejections; ///< Requests answered with a parse error.
+            ouc_server::http::DateCache date;      ///< Date header of every response, refreshed by a loop timer.
+
+            // Declared last so it is destroyed first: its worker threads are
+            // joined while the sessions and callbacks they use still exist.
+            TCPServer server; ///< Underlying TCP transport.
+
+        public:
+            /**
+             * @brief Construct a new HttpServer instance.
+             * @param task_count Number of thread in the thread pool, 0 for one per CPU.
+             */
+            HttpServer(size_t task_count = 0);
+
+            /**
+             * @brief Construct a new HttpServer with explicit thread placement.
+             * @param config Thread counts and CPUs of the underlying TCPServer.
+             */
+            explicit HttpServer(const TCPServerConfig &config);
+
+        public:
+            /**
+             * @brief Register callback for parsed request headers.
+             * @param callback Function to call before any body chunk arrives.
+             */
+            void on_headers(Callback<> &&callback) { on_headers_callback = std::move(callback); }
+
+            /**
+             * @brief Register callback for streamed body chunks.
+             * @param callback Function to call with each chunk, valid only during the call.
+             */
+            void on_body(Callback<std::string_view> &&callback) { on_body_callback = std::move(callback); }
+
+            /**
+             * @brief Register callback for completed requests.
+             * @param callback Function to call once the whole body has been received.
+             */
+            void on_request(Callback<> &&callback) { on_request_callback = std::move(callback); }
+
+            /**
+             * @brief Register callback for requests whose connection closed before they completed.
+             *
+             * Runs on the loop's pool once the connection closed, possibly
+             * while another callback of the same request is still running:
+             * use the request only to identify it, e.g. to drop state kept
+             * for it. The writer stays valid until the callback returns.
+             *
+             * @param callback Function receiving the unfinished request.
+             */
+            void on_abort(std::function<void(ouc_server::http::HttpRequest &)> &&callback) { on_abort_callback = std::move(callback); }
+
+            const ouc_server::http::HttpParserConfig &get_parser_config() const noexcept { return parser_config; }
+
+            /**
+             * @brief Set parser limits, applied to connections accepted afterwards.
+             * @param config New parser configuration.
+             */
+            void set_parser_config(const ouc_server::http::HttpParserConfig &config) { parser_config = config; }
+
+            /**
+             * @brief Compress responses for clients that accept it, call before start().
+             *
+             * Bodies passed whole to HttpResponseWriter::end() are sent with
+             * gzip or deflate as negotiated from Accept-Encoding; those marked
+             * with HttpResponseWriter::cache_as() are compressed only once.
+             *
+             * @param config Thresholds, zlib level and cache size.
+             */
+            void set_compression(const ouc_server::http::CompressionConfig &config = ouc_server::http::CompressionConfig())
+            {
+                compression = std::make_unique<ouc_server::http::CompressionCache>(config);
+            }
+
+            /// Cache of compressed variants, nullptr unless set_compression() was called.
+            ouc_server::http::CompressionCache *get_compression_cache() noexcept { return compression.get(); }
+
+            /**
+             * @brief Answer GET requests for a path with write_metrics() instead of on_request.
+             * @param path Path to serve, an empty one disables the endpoint.
+             */
+            void serve_metrics(const std::string &path = "/metrics") { metrics_path = path; }
+
+            /**
+             * @brief Append HTTP and transport metrics in Prometheus text format.
+             * @param out Buffer to append to.
+             */
+            void write_metrics(std::string &out);
+
+        public:
+            /**
+             * @brief Set the options of accepted sockets, see TCPServer::set_socket_options().
+             */
+            void set_socket_options(const ouc_server::ouc_socket::SocketOptions &options) { server.set_socket_options(options); }
+
+            /**
+             * @brief Limit connections and request rates, see TCPServer::set_admission().
+             *
+             * Requests over a client's rate are answered with 429 Too Many
+             * Requests and skip the callbacks; the connection stays open.
+             */
+            void set_admission(const AdmissionConfig &config) { server.set_admission(config); }
+
+            /**
+             * @brief Shed load when requests queue up, see TCPServer::set_load_shedding().
+             *
+             * While overloaded, requests that waited longer than the target
+             * are answered with 503 Service Unavailable and skip the callbacks.
+             */
+            void set_load_shedding(std::chrono::microseconds target, std::chrono::milliseconds interval = std::chrono::milliseconds(100))
+            {
+                server.set_load_shedding(target, interval);
+            }
+
+            /**
+             * @brief Start the server listening, see TCPServer::start() for the address forms.
+             * @param address Address to bind.
+             * @param port Port number to bind.
+             * @return true if the server started successfully, false otherwise.
+             */
+            bool start(const std::string &address, uint16_t port) { return server.start(address, port); }
+
+            /**
+             * @brief Start on an inherited listening socket, see TCPServer::start().
+             */
+            bool start(ouc_server::ouc_socket::TCPSocket &&listener) { return server.start(std::move(listener)); }
+
+            /**
+             * @brief Pass the listening socket to a successor process, see TCPServer::hand_off().
+             */
+            bool hand_off(const std::string &path, std::chrono::milliseconds timeout) { return server.hand_off(path, timeout); }
+
+            /**
+             * @brief Run the event loop for one time.
+             * @param timeout_ms Maximum time to block waiting for events.
+             */
+            void loop(int timeout_ms = 0) { server.loop(timeout_ms); }
+
+            /**
+             * @brief Stop accepting connections, see TCPServer::stop().
+             *
+             * Responses started afterwards carry `Connection: close`.
+             */
+            void stop() { server.stop(); }
+
+            bool is_stopped() const noexcept { return server.is_stopped(); }
+
+            /**
+             * @brief Finish in-flight requests, close keep-alive connections between requests.
+             * @param timeout Longest time to wait, see TCPServer::drain().
+             * @return true if all connections finished before the timeout.
+             */
+            bool drain(std::chrono::milliseconds timeout) { return server.drain(timeout); }
+
+            TCPServer &tcp_server() noexcept { return server; }
+
+        private:
+            /**
+             * @brief Feed received bytes into the connection's parser.
+             * @param client Connection the bytes came from.
+             * @param data Received bytes.
+             */
+            void handle_message(ouc_server::ouc_socket::TCPSocket &client, const std::string &data);
+
+            /**
+             * @brief Start the response of a request whose headers were parsed.
+             * @param session Session the request belongs to.
+             * @param req Parsed request.
+             */
+            void begin_response(Session &session, ouc_server::http::HttpRequest &req);
+
+            /**
+             * @brief Stop or resume the request input on behalf of the handler.
+             *
+             * Pausing runs in the request's callbacks, resuming on any thread.
+             */
+            void set_input_paused(Session &session, bool paused);
+
+            /**
+             * @brief Record the end of the current response, resuming input held for it.
+             * @param session Session whose writer just ended.
+             * @param closing The connection closes after this response, nothing more is read.
+             */
+            void finish_response(Session &session, bool closing);
+
+            /// Refresh the Date header and re-arm the timer for the next second.
+            void refresh_date();
+
+            /**
+             * @brief Answer with an error status and close the connection.
+             * @param session Session to reject.
+             * @param code HTTP status code.
+             */
+            void reject(Session &session, int code);
+        };
+    }
+}
+
+#endif // INCLUDE_OUC_SERVER_HTTP_SERVER
@@ -0,0 +1,641 @@
+#include <server/reverse_proxy.hpp>
+
+#include <algorithm>
+
+#include <server/http_server.hpp>
+#include <client/tcp_client.hpp>
+#include <http/http_format.hpp>
+#include <http/http_headers.hpp>
+#include <http/http_response_parser.hpp>
+
+namespace ouc_server
+{
+    namespace server
+    {
+        using ouc_server::client::TCPClient;
+        using ouc_server::client::UpstreamPool;
+        using ouc_server::http::HttpRequest;
+        using ouc_server::http::HttpResponse;
+        using ouc_server::http::HttpResponseWriter;
+        using ouc_server::http::find_header;
+        using ouc_server::http::iequals;
+
+        /// One request in flight to an upstream.
+        struct ReverseProxy::Exchange
+        {
+            const HttpRequest *req = nullptr;     ///< Key in exchanges.
+            std::atomic<size_t> *count = nullptr; ///< Proxy's exchange count, decremented once done.
+            size_t first = 0;                     ///< Upstream the policy chose.
+            size_t attempts = 0;                  ///< Upstreams tried so far, from first on.
+            bool chunked = false;                 ///< Request body is re-chunked on the way up.
+
+            std::mutex mtx;                       ///< Guards the fields below and every use of res.
+            HttpResponseWriter *res = nullptr;    ///< Client's deferred response.
+            UpstreamPool *pool = nullptr;
+            std::shared_ptr<TCPClient> client;    ///< Set once the queued request bytes went out.
+            std::string pending;                  ///< Request bytes produced before client was set.
+            bool request_done = false;            ///< The client's request arrived whole.
+            bool input_paused = false;            ///< Client input paused until the upstream catches up.
+            bool client_gone = false;             ///< The client stopped taking the response.
+            bool finished = false;                ///< Answered, failed or aborted: nothing more happens.
+            uint64_t reads = 0;                   ///< Reads of the response so far, tells timeouts apart.
+            uint64_t read_timer = 0;              ///< Timeout of the outstanding read, 0 if none.
+            uint64_t drain_timer = 0;             ///< Timeout of a paused upload, 0 if none.
+            ouc_server::http::HttpResponseParser parser;
+
+            /// Hand the connection back to its pool and stop counting the exchange, once.
+            void release(bool reusable)
+            {
+                if (client)
+                    pool->release(client, reusable);
+                client.reset();
+                if (count)
+                    count->fetch_sub(1, std::memory_order_relaxed);
+                count = nullptr;
+            }
+
+            // Dropped mid-request, e.g. the client went away: never reused
+            ~Exchange() { release(false); }
+        };
+
+        namespace
+        {
+            /// Unsent request bytes per upstream before the client's input is paused.
+            constexpr size_t MAX_UPSTREAM_PENDING = 256 * 1024;
+
+            /// FNV-1a with a final mix so nearby keys spread over the ring.
+            uint32_t hash_key(std::string_view key)
+            {
+                uint32_t h = 2166136261u;
+                for (unsigned char c : key)
+                    h = (h ^ c) * 16777619u;
+                h ^= h >> 16;
+                h *= 0x85ebca6bu;
+                h ^= h >> 13;
+                return h;
+            }
+
+            /// Whether a comma separated list, e.g. a Connection header, names token.
+            bool lists(std::string_view list, std::string_view token)
+            {
+                while (!list.empty())
+                {
+                    size_t comma = list.find(',');
+                    std::string_view item = list.substr(0, comma);
+                    while (!item.empty() && item.front() == ' ')
+                        item.remove_prefix(1);
+                    while (!item.empty() && item.back() == ' ')
+                        item.remove_suffix(1);
+                    if (iequals(item, token))
+                        return true;
+                    if (comma == std::string_view::npos)
+                        break;
+                    list.remove_prefix(comma + 1);
+                }
+                return false;
+            }
+
+            /// Headers describing one connection, never forwarded (RFC 7230 6.1).
+            bool is_hop_by_hop(std::string_view key, const std::string *connection)
+            {
+                static const char *const names[] = {"Connection", "Keep-Alive", "Proxy-Connection", "TE",
+                                                    "Trailer", "Transfer-Encoding", "Upgrade"};
+                for (const char *name : names)
+                    if (iequals(key, name))
+                        return true;
+                return connection != nullptr && lists(*connection, key);
+            }
+
+            bool is_chunked(const std::string *te)
+            {
+                return te != nullptr && te->size() >= 7 && iequals(std::string_view(*te).substr(te->size() - 7), "chunked");
+            }
+
+            /// Whether the upstream keeps the connection open after this response.
+            bool keeps_alive(const HttpResponse &res)
+            {
+                auto *connection = find_header(res.headers, "Connection");
+                if (res.version == "HTTP/1.1")
+                    return !(connection && lists(*connection, "close"));
+                return connection && lists(*connection, "keep-alive");
+            }
+        }
+
+        ReverseProxy::ReverseProxy(ouc_server::epoll::EpollLoop &p_loop, const ReverseProxyConfig &p_config)
+            : loop(p_loop), config(p_config)
+        {
+        }
+
+        void ReverseProxy::add_upstream(const std::string &address, uint16_t port)
+        {
+            size_t index = upstreams.size();
+            upstreams.push_back(std::make_unique<UpstreamPool>(loop, address, port, config.pool));
+
+            std::string name = address + ":" + std::to_string(port) + "#";
+            for (size_t i = 0; i < std::max<size_t>(config.virtual_nodes, 1); ++i)
+                ring.emplace_back(hash_key(name + std::to_string(i)), index);
+            std::sort(ring.begin(), ring.end());
+        }
+
+        void ReverseProxy::attach(HttpServer &server)
+        {
+            server.on_headers([this](HttpRequest &req, HttpResponseWriter &res)
+                              { handle_headers(req, res); });
+            server.on_body([this](HttpRequest &req, HttpResponseWriter &res, std::string_view chunk)
+                           { handle_body(req, res, chunk); });
+            server.on_request([this](HttpRequest &req, HttpResponseWriter &res)
+                              { handle_request(req, res); });
+            server.on_abort([this](HttpRequest &req)
+                            { handle_abort(req); });
+        }
+
+        size_t ReverseProxy::select(const HttpRequest &req)
+        {
+            size_t n = upstreams.size();
+            switch (config.policy)
+            {
+            case BalancePolicy::LeastConnections:
+            {
+                // Rotate the starting point so ties do not all land on the first
+                size_t start = next.fetch_add(1, std::memory_order_relaxed);
+                size_t best = start % n;
+                for (size_t i = 1; i < n; ++i)
+                {
+                    size_t index = (start + i) % n;
+                    if (upstreams[index]->get_active_count() < upstreams[best]->get_active_count())
+                        best = index;
+                }
+                return best;
+            }
+
+            case BalancePolicy::ConsistentHash:
+            {
+                const std::string *key = config.hash_header.empty() ? nullptr : find_header(req.headers, config.hash_header);
+                uint32_t h = hash_key(key ? *key : req.remote_address);
+                auto it = std::lower_bound(ring.begin(), ring.end(), std::make_pair(h, size_t(0)));
+                return it == ring.end() ? ring.front().second : it->second;
+            }
+
+            case BalancePolicy::RoundRobin:
+            default:
+                return next.fetch_add(1, std::memory_order_relaxed) % n;
+            }
+        }
+
+        std::shared_ptr<ReverseProxy::Exchange> ReverseProxy::find_exchange(const HttpRequest &req)
+        {
+            std::lock_guard<std::mutex> lk(exchanges_mtx);
+            auto it = exchanges.find(&req);
+            return it == exchanges.end() ? nullptr : it->second;
+        }
+
+        void ReverseProxy::handle_headers(HttpRequest &req, HttpResponseWriter &res)
+        {
+            auto ex = std::make_shared<Exchange>();
+            ex->req = &req;
+            ex->res = &res;
+            ex->count = &exchange_count;
+            size_t in_flight = exchange_count.fetch_add(1, std::memory_order_relaxed);
+            {
+                std::lock_guard<std::mutex> lk(exchanges_mtx);
+                exchanges[&req] = ex;
+            }
+
+            if (upstreams.empty() || (config.max_exchanges > 0 && in_flight >= config.max_exchanges))
+            {
+                std::lock_guard<std::mutex> lk(ex->mtx);
+                finish(*ex, upstreams.empty() ? 502 : 503, false);
+                return;
+            }
+
+            // Relay the answer as it arrives: headers first, then each body piece.
+            // Only called from handle_response(), with mtx held and res set.
+            Exchange *raw = ex.get();
+            ex->parser.reset(req.method == ouc_server::http::HttpMethodType::Head);
+            ex->parser.on_headers(
+                [raw](HttpResponse &up)
+                {
+                    auto *connection = find_header(up.headers, "Connection");
+                    raw->res->status(up.stus_code, up.stus_msg);
+                    for (auto &[key, value] : up.headers)
+                        if (!is_hop_by_hop(key, connection))
+                            raw->res->header(key, value);
+                    raw->client_gone = !raw->res->write_head();
+                });
+            ex->parser.on_body(
+                [raw](HttpResponse &, std::string_view chunk)
+                {
+                    if (!raw->client_gone && !raw->res->write(chunk))
+                        raw->client_gone = true;
+                });
+
+            res.defer();
+            ex->chunked = is_chunked(find_header(req.headers, "Transfer-Encoding"));
+            ex->pending = serialize_head(req, ex->chunked);
+            ex->first = select(req);
+            connect(ex);
+        }
+
+        void ReverseProxy::handle_body(HttpRequest &req, HttpResponseWriter &, std::string_view chunk)
+        {
+            auto ex = find_exchange(req);
+            if (!ex || chunk.empty())
+                return;
+
+            // The parser removed the client's chunk framing, frame it again
+            std::string data;
+            if (ex->chunked)
+            {
+                data.reserve(chunk.size() + 20);
+                ouc_server::http::append_hex(data, chunk.size());
+                data.append("\r\n").append(chunk).append("\r\n");
+            }
+            else
+                data.assign(chunk);
+            send_upstream(ex, std::move(data));
+        }
+
+        void ReverseProxy::handle_request(HttpRequest &req, HttpResponseWriter &)
+        {
+            auto ex = find_exchange(req);
+            if (!ex)
+                return;
+
+            if (ex->chunked)
+                send_upstream(ex, std::string("0\r\n\r\n"));
+
+            // Whoever sees both the connection and the whole request starts reading
+            {
+                std::lock_guard<std::mutex> lk(ex->mtx);
+                if (ex->finished)
+                    return;
+                ex->request_done = true;
+                if (!ex->client)
+                    return;
+            }
+            read_response(ex);
+        }
+
+        void ReverseProxy::handle_abort(HttpRequest &req)
+        {
+            std::shared_ptr<Exchange> ex;
+            {
+                std::lock_guard<std::mutex> lk(exchanges_mtx);
+                auto it = exchanges.find(&req);
+                if (it == exchanges.end())
+                    return;
+                ex = std::move(it->second);
+                exchanges.erase(it);
+            }
+
+            // The writer is gone once this returns: nothing may touch it afterwards
+            std::lock_guard<std::mutex> lk(ex->mtx);
+            if (ex->finished)
+                return;
+            ex->res = nullptr;
+            finish(*ex, 0, false);
+        }
+
+        void ReverseProxy::connect(const std::shared_ptr<Exchange> &ex)
+        {
+            // First healthy upstream that takes a connection, from the policy's choice on
+            size_t n = upstreams.size();
+            while (ex->attempts < n)
+            {
+                UpstreamPool *pool = upstreams[(ex->first + ex->attempts++) % n].get();
+                if (!pool->is_healthy())
+                    continue;
+
+                {
+                    std::lock_guard<std::mutex> lk(ex->mtx);
+                    if (ex->finished)
+                        return;
+                    ex->pool = pool;
+                }
+
+                std::weak_ptr<Exchange> weak = ex;
+                pool->acquire(
+                    [this, weak, pool](std::shared_ptr<TCPClient> client)
+                    {
+                        if (auto e = weak.lock())
+                            handle_connected(e, std::move(client));
+                        else if (client)
+                            pool->release(client, false);
+                    });
+                return;
+            }
+
+            std::lock_guard<std::mutex> lk(ex->mtx);
+            if (!ex->finished)
+                finish(*ex, 502, false);
+        }
+
+        void ReverseProxy::handle_connected(const std::shared_ptr<Exchange> &ex, std::shared_ptr<TCPClient> client)
+        {
+            if (!client)
+            {
+                connect(ex);
+                return;
+            }
+
+            // Written outside the lock, a write may complete and call back right away;
+            // body pieces arriving meanwhile keep queueing until client is set
+            while (true)
+            {
+                std::string data;
+                {
+                    std::lock_guard<std::mutex> lk(ex->mtx);
+                    if (ex->finished)
+                    {
+                        ex->pool->release(client, false);
+                        return;
+                    }
+                    if (ex->pending.empty())
+                    {
+                        ex->client = std::move(client);
+                        if (ex->input_paused && ex->client->get_pending_bytes() <= MAX_UPSTREAM_PENDING / 2)
+                        {
+                            ex->input_paused = false;
+                            if (ex->drain_timer != 0)
+                                loop.cancel_timer(ex->drain_timer);
+                            ex->drain_timer = 0;
+                            ex->res->resume_input();
+                        }
+                        if (!ex->request_done)
+                            return;
+                        break;
+                    }
+                    data.swap(ex->pending);
+                }
+
+                if (!client->write(std::move(data), on_sent(ex)))
+                {
+                    std::lock_guard<std::mutex> lk(ex->mtx);
+                    if (!ex->finished)
+                    {
+                        ex->pool->report_failure();
+                        ex->client = std::move(client);
+                        finish(*ex, 502, false);
+                    }
+                    return;
+                }
+            }
+            read_response(ex);
+        }
+
+        void ReverseProxy::send_upstream(const std::shared_ptr<Exchange> &ex, std::string &&data)
+        {
+            std::shared_ptr<TCPClient> client;
+            {
+                std::lock_guard<std::mutex> lk(ex->mtx);
+                if (ex->finished)
+                    return;
+                if (!ex->client)
+                    ex->pending.append(data);
+                client = ex->client;
+            }
+
+            if (client && !client->write(std::move(data), on_sent(ex)))
+            {
+                std::lock_guard<std::mutex> lk(ex->mtx);
+                if (!ex->finished)
+                {
+                    ex->pool->report_failure();
+                    finish(*ex, 502, false);
+                }
+                return;
+            }
+
+            // Backpressure: stop reading the client until the upstream took most of
+            // it; the callback of the last write still unsent resumes it
+            std::lock_guard<std::mutex> lk(ex->mtx);
+            size_t queued = ex->client ? ex->client->get_pending_bytes() : ex->pending.size();
+            if (ex->finished || ex->input_paused || queued <= MAX_UPSTREAM_PENDING || !ex->res->pause_input())
+                return;
+
+            ex->input_paused = true;
+            std::weak_ptr<Exchange> weak = ex;
+            ex->drain_timer = loop.add_timer(
+                config.response_timeout,
+                [this, weak]
+                {
+                    auto e = weak.lock();
+                    if (!e)
+                        return;
+                    std::lock_guard<std::mutex> lk(e->mtx);
+                    if (e->finished || !e->input_paused)
+                        return;
+                    e->drain_timer = 0;
+                    e->pool->report_failure();
+                    finish(*e, 502, false);
+                });
+        }
+
+        TCPClient::WriteCallback ReverseProxy::on_sent(const std::shared_ptr<Exchange> &ex)
+        {
+            std::weak_ptr<Exchange> weak = ex;
+            return [this, weak](bool ok)
+            {
+                auto e = weak.lock();
+                if (!e)
+                    return;
+                std::lock_guard<std::mutex> lk(e->mtx);
+                if (e->finished)
+                    return;
+                if (!ok)
+                {
+                    e->pool->report_failure();
+                    finish(*e, 502, false);
+                    return;
+                }
+
+                // Before client is set handle_connected() checks this itself
+                if (e->input_paused && e->client && e->client->get_pending_bytes() <= MAX_UPSTREAM_PENDING / 2)
+                {
+                    e->input_paused = false;
+                    if (e->drain_timer != 0)
+                        loop.cancel_timer(e->drain_timer);
+                    e->drain_timer = 0;
+                    e->res->resume_input();
+                }
+            };
+        }
+
+        void ReverseProxy::read_response(const std::shared_ptr<Exchange> &ex)
+        {
+            // Backpressure: read on only once the client has room for more
+            std::weak_ptr<Exchange> weak = ex;
+            std::lock_guard<std::mutex> lk(ex->mtx);
+            if (ex->finished)
+                return;
+            bool waiting = ex->res->when_writable(
+                [this, weak]
+                {
+                    if (auto e = weak.lock())
+                        receive(e);
+                });
+            if (!waiting)
+                finish(*ex, 502, false);
+        }
+
+        void ReverseProxy::receive(const std::shared_ptr<Exchange> &ex)
+        {
+            std::weak_ptr<Exchange> weak = ex;
+            std::shared_ptr<TCPClient> client;
+            {
+                std::lock_guard<std::mutex> lk(ex->mtx);
+                if (ex->finished)
+                    return;
+                client = ex->client;
+
+                uint64_t read = ++ex->reads;
+                ex->read_timer = loop.add_timer(
+                    config.response_timeout,
+                    [this, weak, read]
+                    {
+                        auto e = weak.lock();
+                        if (!e)
+                            return;
+                        std::lock_guard<std::mutex> lk(e->mtx);
+                        if (e->finished || e->reads != read || e->read_timer == 0)
+                            return;
+                        e->read_timer = 0;
+                        e->pool->report_failure();
+                        finish(*e, 504, false);
+                    });
+            }
+
+            bool reading = client->read(
+                [this, weak](std::string_view chunk)
+                {
+                    if (auto e = weak.lock())
+                        handle_response(e, chunk);
+                });
+            if (!reading)
+                handle_response(ex, {});
+        }
+
+        void ReverseProxy::handle_response(const std::shared_ptr<Exchange> &ex, std::string_view chunk)
+        {
+            {
+                std::lock_guard<std::mutex> lk(ex->mtx);
+                if (ex->finished)
+                    return;
+                if (ex->read_timer != 0)
+                    loop.cancel_timer(ex->read_timer);
+                ex->read_timer = 0;
+
+                int error = 0;
+                if (chunk.empty())
+                    error = ex->parser.finish() ? 0 : 502;
+                else if (!ex->parser.feed(chunk))
+                    error = 502;
+
+                if (ex->client_gone)
+                {
+                    // A client that went away says nothing about the upstream
+                    finish(*ex, 502, false);
+                    return;
+                }
+                if (error != 0)
+                {
+                    ex->pool->report_failure();
+                    finish(*ex, error, false);
+                    return;
+                }
+                if (ex->parser.is_complete())
+                {
+                    ex->pool->report_success();
+                    finish(*ex, 0, keeps_alive(ex->parser.response()) && ex->client->is_open());
+                    return;
+                }
+                if (chunk.empty())
+                {
+                    finish(*ex, 502, false);
+                    return;
+                }
+            }
+            read_response(ex);
+        }
+
+        void ReverseProxy::finish(Exchange &ex, int code, bool reusable)
+        {
+            ex.finished = true;
+            if (ex.read_timer != 0)
+                loop.cancel_timer(ex.read_timer);
+            if (ex.drain_timer != 0)
+                loop.cancel_timer(ex.drain_timer);
+            ex.read_timer = ex.drain_timer = 0;
+
+            // The connection goes back before the client learns the response ended
+            ex.release(reusable);
+
+            if (ex.res)
+            {
+                HttpResponseWriter &res = *ex.res;
+                ex.res = nullptr;
+                if (ex.input_paused)
+                    res.resume_input();
+                ex.input_paused = false;
+                if (code == 0)
+                    res.end();
+                else
+                    fail(res, code);
+            }
+
+            // The next request of the connection may already have its own exchange
+            std::lock_guard<std::mutex> lk(exchanges_mtx);
+            auto it = exchanges.find(ex.req);
+            if (it != exchanges.end() && it->second.get() == &ex)
+                exchanges.erase(it);
+        }
+
+        std::string ReverseProxy::serialize_head(const HttpRequest &req, bool chunked)
+        {
+            std::string out = ouc_server::http::type2str(req.method);
+            out.append(" ").append(req.path).append(" HTTP/1.1\r\n");
+
+            auto *connection = find_header(req.headers, "Connection");
+            const std::string *forwarded = nullptr;
+            for (auto &[key, value] : req.headers)
+            {
+                // The server already answered 100-continue, the upstream gets the body right away
+                if (is_hop_by_hop(key, connection) || iequals(key, "Expect"))
+                    continue;
+                if (iequals(key, "X-Forwarded-For"))
+                {
+                    forwarded = &value;
+                    continue;
+                }
+                out.append(key).append(": ").append(value).append("\r\n");
+            }
+
+            if (!req.remote_address.empty())
+            {
+                out.append("X-Forwarded-For: ");
+                if (forwarded)
+                    out.append(*forwarded).append(", ");
+                out.append(req.remote_address).append("\r\n");
+            }
+            else if (forwarded)
+                out.append("X-Forwarded-For: ").append(*forwarded).append("\r\n");
+
+            if (chunked)
+                out.append("Transfer-Encoding: chunked\r\n");
+            out.append("\r\n");
+            return out;
+        }
+
+        void ReverseProxy::fail(HttpResponseWriter &res, int code)
+        {
+            if (res.is_ended())
+                return;
+            if (res.is_head_sent())
+            {
+                res.abort();
+                return;
+            }
+            res.status(code).end();
+        }
+    }
+}
@@ -0,0 +1,191 @@
+/**
+ * @file reverse_proxy.hpp
+ * @brief Forward HttpServer requests to a set of upstream servers.
+ *
+ * Each request goes to one upstream picked by the balancing policy, over
+ * a keep-alive connection from that upstream's UpstreamPool. Bodies are
+ * streamed in both directions a chunk at a time as they arrive, so
+ * neither a large upload nor a large download is held in memory.
+ *
+ * No thread waits for an upstream: the handlers return right away with
+ * the response deferred, and the exchange goes on from the upstream
+ * connection's callbacks. A slow side throttles the other by pausing its
+ * reads, the client's request input or the upstream's response.
+ *
+ * Example:
+ * @code
+ * HttpServer server;
+ * ReverseProxy proxy(server.tcp_server().get_loop());
+ * proxy.add_upstream("127.0.0.1", 9001);
+ * proxy.add_upstream("127.0.0.1", 9002);
+ * proxy.attach(server);
+ * server.start("0.0.0.0", 8080);
+ * while (true) server.loop(10);
+ * @endcode
+ */
+
+#ifndef INCLUDE_OUC_SERVER_REVERSE_PROXY
+#define INCLUDE_OUC_SERVER_REVERSE_PROXY
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <client/upstream_pool.hpp>
+#include <epoll/epoll_loop.hpp>
+#include <http/http_request.hpp>
+#include <http/http_response_writer.hpp>
+
+namespace ouc_server
+{
+    namespace server
+    {
+        class HttpServer;
+
+        enum class BalancePolicy
+        {
+            RoundRobin,       ///< Upstreams in turn.
+            LeastConnections, ///< Upstream with the fewest requests in flight.
+            ConsistentHash,   ///< Same key, same upstream; see ReverseProxyConfig::hash_header.
+        };
+
+        struct ReverseProxyConfig
+        {
+            BalancePolicy policy = BalancePolicy::RoundRobin;
+            std::string hash_header;                          ///< ConsistentHash key, the client address if empty or absent.
+            size_t virtual_nodes = 160;                       ///< Points per upstream on the hash ring.
+            std::chrono::milliseconds response_timeout{30000}; ///< Longest wait for the next piece of the upstream's response.
+            size_t max_exchanges = 0;                         ///< Requests forwarded at once, more get 503; 0 for no limit.
+            ouc_server::client::UpstreamPoolConfig pool;      ///< Keep-alive and health settings of every upstream.
+        };
+
+        /**
+         * @class ReverseProxy
+         * @brief HTTP/1.1 reverse proxy with load balancing.
+         *
+         * Each request is an exchange driven by callbacks: the upstream
+         * connection is acquired, the request streamed up and the response
+         * relayed through a deferred HttpResponseWriter, so a slow upstream
+         * costs no thread and the number of requests in flight is bounded
+         * only by memory, or by max_exchanges if set.
+         *
+         * Unhealthy upstreams (see UpstreamPool) are skipped; with none left
+         * the client gets 502 Bad Gateway, or 504 Gateway Timeout if the
+         * upstream stopped answering for response_timeout.
+         *
+         * Destroy the proxy only once the server stopped running handlers
+         * (HttpServer::drain()), and before the loop it was given.
+         */
+        class ReverseProxy
+        {
+        private:
+            struct Exchange;
+
+            ouc_server::epoll::EpollLoop &loop;
+            ReverseProxyConfig config;
+            std::vector<std::unique_ptr<ouc_server::client::UpstreamPool>> upstreams;
+            std::vector<std::pair<uint32_t, size_t>> ring; ///< Hash ring: point, upstream index; sorted.
+            std::atomic<size_t> next{0};                   ///< Round-robin position.
+            std::atomic<size_t> exchange_count{0};         ///< Requests being forwarded.
+
+            std::mutex exchanges_mtx;                      ///< Guards exchanges.
+            std::unordered_map<const ouc_server::http::HttpRequest *, std::shared_ptr<Exchange>> exchanges; ///< Requests being forwarded.
+
+        public:
+            /**
+             * @param p_loop Loop driving the upstream connections, normally TCPServer::get_loop().
+             * @param p_config Balancing policy and timeouts.
+             */
+            explicit ReverseProxy(ouc_server::epoll::EpollLoop &p_loop, const ReverseProxyConfig &p_config = ReverseProxyConfig());
+
+            ReverseProxy(const ReverseProxy &) = delete;
+            ReverseProxy &operator=(const ReverseProxy &) = delete;
+
+        public:
+            /**
+             * @brief Add an upstream server, call before serving.
+             * @param address Numeric IPv4 or IPv6 address.
+             * @param port Port.
+             */
+            void add_upstream(const std::string &address, uint16_t port);
+
+            /**
+             * @brief Install the handlers as the server's on_headers, on_body, on_request and on_abort.
+             * @param server Server whose requests are all forwarded.
+             */
+            void attach(HttpServer &server);
+
+            /// Pick the upstream and start sending it the request.
+            void handle_headers(ouc_server::http::HttpRequest &req, ouc_server::http::HttpResponseWriter &res);
+
+            /// Forward a piece of the request body.
+            void handle_body(ouc_server::http::HttpRequest &req, ouc_server::http::HttpResponseWriter &res, std::string_view chunk);
+
+            /// Finish the request and start relaying the upstream's response.
+            void handle_request(ouc_server::http::HttpRequest &req, ouc_server::http::HttpResponseWriter &res);
+
+            /// Drop the upstream connection of a request the client gave up on.
+            void handle_abort(ouc_server::http::HttpRequest &req);
+
+            size_t get_upstream_count() const noexcept { return upstreams.size(); }
+
+            ouc_server::client::UpstreamPool &get_upstream(size_t index) { return *upstreams[index]; }
+
+            /// Requests being forwarded right now.
+            size_t get_exchange_count() const noexcept { return exchange_count.load(std::memory_order_relaxed); }
+
+        private:
+            /**
+             * @brief First choice of upstream for a request, following the policy.
+             *
+             * If it is down the next ones in order are tried.
+             */
+            size_t select(const ouc_server::http::HttpRequest &req);
+
+            std::shared_ptr<Exchange> find_exchange(const ouc_server::http::HttpRequest &req);
+
+            /// Acquire a connection from the next healthy upstream, 502 once none is left.
+            void connect(const std::shared_ptr<Exchange> &ex);
+
+            /// Flush what was queued for the upstream meanwhile and start the exchange on it.
+            void handle_connected(const std::shared_ptr<Exchange> &ex, std::shared_ptr<ouc_server::client::TCPClient> client);
+
+            /// Queue bytes to the upstream, pausing the client's input while too much of them is unsent.
+            void send_upstream(const std::shared_ptr<Exchange> &ex, std::string &&data);
+
+            /// Callback of a write to the upstream, resumes the client's input once drained.
+            ouc_server::client::TCPClient::WriteCallback on_sent(const std::shared_ptr<Exchange> &ex);
+
+            /// Read the next piece of the upstream's response once the client has room for it.
+            void read_response(const std::shared_ptr<Exchange> &ex);
+
+            /// Ask for the next piece of the upstream's response, timing out after response_timeout.
+            void receive(const std::shared_ptr<Exchange> &ex);
+
+            /// Relay a piece of the upstream's response, empty once it closed.
+            void handle_response(const std::shared_ptr<Exchange> &ex, std::string_view chunk);
+
+            /**
+             * @brief End the exchange, its mtx must be held.
+             * @param code 0 once the response was relayed whole, else the status of the failure.
+             * @param reusable Whether the upstream connection may serve another exchange.
+             */
+            void finish(Exchange &ex, int code, bool reusable);
+
+            /// Request line and headers as sent upstream, hop-by-hop headers removed.
+            static std::string serialize_head(const ouc_server::http::HttpRequest &req, bool chunked);
+
+            /// Answer with an error status unless the response already started, then cut it.
+            static void fail(ouc_server::http::HttpResponseWriter &res, int code);
+        };
+    }
+}
+
+#endif // INCLUDE_OUC_SERVER_REVERSE_PROXY
@@ -1,14 +1,26 @@
 #include <server/tcp_server.hpp>
 
 #include <stdexcept>
+#include <chrono>
+#include <vector>
+
+#include <socket/listen_handoff.hpp>
+#include <utils/trace.hpp>
 
 namespace ouc_server
 {
     namespace server
     {
         TCPServer::TCPServer(size_t task_count)
+            : TCPServer(TCPServerConfig::with_threads(0, task_count))
+        {
+        }
+
+        TCPServer::TCPServer(const TCPServerConfig &config)
             : server_socket(ouc_server::ouc_socket::TCPSocket::create()),
-              tasks(task_count)
+              epoll_loop(config.io_threads, config.io_cpus),
+              tasks(config.task_threads, config.task_cpus),
+              steer_by_incoming_cpu(config.steer_by_incoming_cpu)
         {
         }
 
@@ -18,11 +30,37 @@ namespace ouc_server
             // Wrap all potentially throwing operations in try/catch.
             try
             {
+                stop();
+
+                // Stop pool tasks still in flight from touching epoll or clients
+                is_stopping.store(true);
+
+                // Join the readers first: in-flight events may still queue
+                // messages, which the task pool then runs below.
+                epoll_loop.shutdown();
+
+                {
+                    // Release producers blocked on a full outbox, later
+                    // sends fail fast instead of touching the socket.
+                    std::lock_guard<std::mutex> lk(clients_mtx);
+                    for (auto &[k, v] : clients)
+                    {
+                        {
+                            std::lock_guard<std::mutex> conn_lk(v->mtx);
+                            v->is_closed = true;
+                        }
+                        v->writable.notify_all();
+                    }
+                }
+
+                tasks.shutdown();
+
+                std::lock_guard<std::mutex> lk(clients_mtx);
                 for (auto &[k, v] : clients)
                 {
                     try
                     {
-                        v.close(); // ensure socket closed
+                        v->socket.close(); // ensure socket closed
                     }
                     catch (...)
                     {
@@ -47,26 +85,75 @@ namespace ouc_server
 
         bool TCPServer::start(const std::string &ip, uint16_t port)
         {
+            // The constructor made an IPv4 socket, replace it for other families
+            int family = ouc_server::ouc_socket::TCPSocket::family_of(ip);
+            if (family != AF_INET)
+                server_socket = ouc_server::ouc_socket::TCPSocket::create(family);
+
             // Validate socket
             if (server_socket.get_fd() < 0)
                 return false;
 
-            // Bind to IP and port
-            if (!server_socket.bind(ip, port))
+            // Bind to IP and port, or to a path
+            bool bound = family == AF_UNIX ? server_socket.bind_unix(ip) : server_socket.bind(ip, port);
+            if (!bound)
                 return false;
 
             // Start listening
             if (!server_socket.listen())
                 return false;
 
+            return watch_listener();
+        }
+
+        bool TCPServer::start(ouc_server::ouc_socket::TCPSocket &&listener)
+        {
+            if (listener.get_fd() < 0)
+                return false;
+
+            // Replaces the unbound socket made by the constructor
+            server_socket = std::move(listener);
+            return watch_listener();
+        }
+
+        bool TCPServer::hand_off(const std::string &path, std::chrono::milliseconds timeout)
+        {
+            int fd;
+            {
+                std::lock_guard<std::mutex> lk(accept_mtx);
+                if (stopped.load())
+                    return false;
+                fd = server_socket.get_fd();
+            }
+
+            // Keep accepting until the successor owns the socket as well
+            if (!ouc_server::ouc_socket::send_listener(path, fd, static_cast<int>(timeout.count())))
+                return false;
+
+            stop();
+            return true;
+        }
+
+        bool TCPServer::watch_listener()
+        {
             // Register listening socket with epoll
             // Important: wrap callback in try/catch to prevent exception
             // escaping into epoll loop.
+            // One-shot: a single pool thread accepts until EAGAIN, then re-arms.
             return epoll_loop.add_fd(
                 server_socket.get_fd(),
-                EPOLLIN,
-                [this](int)
+                EPOLLIN | EPOLLONESHOT,
+                [this](int fd)
                 {
+                    if (is_stopping.load())
+                        return;
+
+                    // stop() closes the listener under this lock, so it can
+                    // neither vanish mid-accept nor be re-armed after closing.
+                    std::lock_guard<std::mutex> lk(accept_mtx);
+                    if (stopped.load())
+                        return;
+
                     try
                     {
                         handle_new_connection();
@@ -79,65 +166,173 @@ namespace ouc_server
                     {
                         // unknown error happened
                     }
+
+                    epoll_loop.modify_fd(fd, EPOLLIN | EPOLLONESHOT);
                 });
         }
 
+        void TCPServer::stop()
+        {
+            {
+                std::lock_guard<std::mutex> lk(accept_mtx);
+                if (stopped.exchange(true))
+                    return;
+
+                if (server_socket.get_fd() >= 0)
+                {
+                    epoll_loop.remove_fd(server_socket.get_fd());
+                    server_socket.close();
+                }
+            }
+
+            epoll_loop.wakeup();
+        }
+
+        bool TCPServer::drain(std::chrono::milliseconds timeout)
+        {
+            stop();
+
+            auto deadline = std::chrono::steady_clock::now() + timeout;
+            while (true)
+            {
+                close_idle_connections();
+                if (get_connection_count() == 0)
+                    return true;
+                if (std::chrono::steady_clock::now() >= deadline)
+                    break;
+
+                // Keep serving the busy connections, harmless if another
+                // thread is running loop() at the same time.
+                epoll_loop.poll(10);
+            }
+
+            // Out of time: drop whatever is left
+            std::vector<int> fds;
+            {
+                std::lock_guard<std::mutex> lk(clients_mtx);
+                for (auto &[fd, conn] : clients)
+                    fds.push_back(fd);
+            }
+            for (int fd : fds)
+                remove_fd(fd);
+            return false;
+        }
+
+        void TCPServer::close_idle_connections()
+        {
+            std::vector<std::shared_ptr<Connection>> conns;
+            {
+                std::lock_guard<std::mutex> lk(clients_mtx);
+                for (auto &[fd, conn] : clients)
+                    conns.push_back(conn);
+            }
+
+            for (auto &conn : conns)
+            {
+                {
+                    std::lock_guard<std::mutex> lk(conn->mtx);
+                    if (conn->is_closed || conn->draining || !conn->inbox.empty() || !conn->outbox.empty())
+                        continue;
+                }
+
+                if (idle_check && !idle_check(conn->socket))
+                    continue;
+
+                // Still referenced here, so the fd cannot have been reused
+                remove_fd(conn->socket.get_fd());
+            }
+        }
+
         bool TCPServer::add_fd(int fd, ouc_server::ouc_socket::TCPSocket &&tcp_socket)
         {
-            if (fd != tcp_socket.get_fd())
-                return false;
+            return add_connection(fd, std::move(tcp_socket), sockaddr_storage{}, -1);
+        }
 
-            // Check for duplicates or invalid socket
-            if (clients.count(fd) || tcp_socket.get_fd() < 0)
+        bool TCPServer::add_connection(int fd, ouc_server::ouc_socket::TCPSocket &&tcp_socket, const sockaddr_storage &peer, int client_slot)
+        {
+            // Every failure below gives the admission slot back
+            auto release_slot = [this, client_slot]
+            {
+                if (admission)
+                    admission->release(client_slot);
+            };
+
+            if (fd != tcp_socket.get_fd())
                 return false;
 
-            // First try adding to epoll
-            if (!epoll_loop.add_fd(
-                    fd,
-                    EPOLLIN,
-                    [this](int fd)
-                    {
-                        this->handle_client_event(fd);
-                    }))
-            {
+            // Check for invalid socket
+            if (tcp_socket.get_fd() < 0)
                 return false;
-            }
 
             // Use temporary to ensure strong exception safety:
-            // if emplace throws, tmp will be destroyed properly.
-            ouc_server::ouc_socket::TCPSocket temp = std::move(tcp_socket);
+            // if make_shared throws, tcp_socket is left untouched.
+            auto conn = std::make_shared<Connection>(std::move(tcp_socket));
+            conn->peer = peer;
+            conn->client_slot = client_slot;
+            if (steer_by_incoming_cpu)
+                conn->worker = tasks.find_worker(conn->socket.get_incoming_cpu());
+            if (tls_context)
+                conn->tls = std::make_unique<ouc_server::ouc_socket::TLSSession>(*tls_context, fd);
+            else if (zerocopy_threshold.load() > 0)
+                conn->zerocopy = conn->socket.set_zerocopy(true);
 
-            // Only insert into clients if epoll registration succeeded
-            auto [it, inserted] = clients.emplace(fd, std::move(temp));
-            if (!inserted)
             {
-                // Rollback epoll registration if insertion failed
-                epoll_loop.remove_fd(fd);
-                return false;
+                std::lock_guard<std::mutex> lk(clients_mtx);
+                auto [it, inserted] = clients.emplace(fd, conn);
+                if (!inserted)
+                {
+                    // Duplicate fd: hand the socket back to the caller
+                    tcp_socket = std::move(conn->socket);
+                    release_slot();
+                    return false;
+                }
             }
+            metrics.active_connections.inc();
 
+            // Notify before the fd is armed so on_connection always happens
+            // before the first on_message of this client.
             if (on_connection_callback)
             {
                 try
                 {
-                    on_connection_callback(it->second);
+                    on_connection_callback(conn->socket);
                 }
                 catch (...)
                 {
                     // Rollback if callback throws
-                    epoll_loop.remove_fd(fd);
-                    clients.erase(it);
+                    std::lock_guard<std::mutex> lk(clients_mtx);
+                    clients.erase(fd);
+                    metrics.active_connections.dec();
+                    release_slot();
                     // Do NOT rethrow: keep server stable
+                    return true;
                 }
             }
 
+            // Only arm epoll once the connection is tracked, otherwise an
+            // early event could not find it and would never be re-armed.
+            if (!epoll_loop.add_fd(
+                    fd,
+                    EPOLLIN | EPOLLONESHOT,
+                    [this](int fd)
+                    {
+                        this->handle_client_event(fd);
+                    }))
+            {
+                std::lock_guard<std::mutex> lk(clients_mtx);
+                clients.erase(fd);
+                metrics.active_connections.dec();
+                release_slot();
+                return false;
+            }
+
             return true;
         }
 
         bool TCPServer::add_fd(int fd)
         {
-            // Check for duplicates or invalid socket
-            if (clients.count(fd) || fd < 0)
+            // Check for invalid socket
+            if (fd < 0)
                 return false;
 
             // Construct socket from raw fd and reuse add_fd logic
@@ -146,19 +341,35 @@ namespace ouc_server
 
         bool TCPServer::remove_fd(ouc_server::ouc_socket::TCPSocket &client)
         {
-            int fd = client.get_fd();
+            return remove_fd(client.get_fd());
+        }
 
-            // Ensure socket is tracked
-            if ((!clients.count(fd)) || fd < 0)
+        bool TCPServer::remove_fd(int fd)
+        {
+            if (fd < 0)
                 return false;
 
             // Always erase from map first to keep internal state consistent
-            auto it = clients.find(fd);
-            if (it == clients.end())
-                return false;
+            std::shared_ptr<Connection> conn;
+            {
+                std::lock_guard<std::mutex> lk(clients_mtx);
+                auto it = clients.find(fd);
+                if (it == clients.end())
+                    return false;
 
-            auto rm_socket = std::move(it->second);
-            clients.erase(it);
+                conn = std::move(it->second);
+                clients.erase(it);
+            }
+            metrics.active_connections.dec();
+            if (admission)
+                admission->release(conn->client_slot);
+
+            {
+                std::lock_guard<std::mutex> lk(topics_mtx);
+                for (auto &topic : conn->topics)
+                    remove_subscriber(topic, conn.get());
+                conn->topics.clear();
+            }
 
             // Try to remove from epoll
             if (!epoll_loop.remove_fd(fd))
@@ -167,15 +378,28 @@ namespace ouc_server
                 // maybe log warning here
             }
 
-            // Safe to close now
-            bool closed = rm_socket.close();
+            {
+                // Wake producers blocked in send() and drop unsent output
+                std::lock_guard<std::mutex> lk(conn->mtx);
+                conn->is_closed = true;
+                conn->outbox.clear();
+                conn->outbox_bytes = 0;
+                signal_writable(*conn);
+            }
+
+            if (conn->tls)
+                conn->tls->shutdown();
+
+            // Tell the peer right away; the fd itself is closed once the last
+            // pending task drops its reference to the connection.
+            bool closed = conn->socket.shutdown();
 
             // Callback is external, wrap in try/catch to not break server loop
             if (on_close_callback)
             {
                 try
                 {
-                    on_close_callback(rm_socket);
+                    on_close_callback(conn->socket);
                 }
                 catch (...)
                 {
@@ -186,70 +410,854 @@ namespace ouc_server
             return closed;
         }
 
-        bool TCPServer::remove_fd(int fd)
-        {
-            if ((!clients.count(fd)) || fd < 0)
-                return false;
-
-            auto &client = clients.at(fd);
-
-            return remove_fd(client);
-        }
-
         void TCPServer::handle_new_connection()
         {
             // Accept all pending connections in a loop
             while (true)
             {
-                auto client = server_socket.accept();
+                sockaddr_storage peer{};
+                auto client = server_socket.accept(&peer);
+
+                if (client.get_fd() < 0)
+                {
+                    // Retry if accept was interrupted, otherwise the backlog
+                    // is empty (EAGAIN) or accept failed: wait for next event
+                    if (errno == EINTR)
+                        continue;
+                    return;
+                }
+
+                metrics.accepts.add();
+                OUC_TRACE(Accept, client.get_fd());
+
+                // Over a limit: close before any byte is read or callback run
+                int client_slot = -1;
+                if (admission)
+                {
+                    size_t limit = admission->get_config().max_connections;
+                    if ((limit > 0 && get_connection_count() >= limit) ||
+                        !admission->admit(AdmissionControl::key_of(peer), client_slot))
+                    {
+                        metrics.admission_rejects.add();
+                        client.close();
+                        continue;
+                    }
+                }
 
-                // Retry if accept failed (could be interrupted)
-                while (client.get_fd() < 0)
-                    client = server_socket.accept();
+                socket_options.apply(client.get_fd());
+                if (int usec = socket_busy_poll_us.load(); usec > 0)
+                    client.set_busy_poll(usec);
 
                 // Add new client to epoll and client map
-                add_fd(client.get_fd(), std::move(client));
+                int fd = client.get_fd();
+                add_connection(fd, std::move(client), peer, client_slot);
             }
         }
 
         void TCPServer::handle_client_event(int fd)
         {
-            auto &client = clients[fd];
+            if (is_stopping.load())
+                return;
+
+            auto conn = find_connection(fd);
+            if (!conn)
+                return;
+
+            std::unique_lock<std::mutex> read_lk(conn->read_mtx);
+
+            // No application data before the TLS handshake is done
+            if (conn->tls && !conn->tls_ready)
+            {
+                if (!advance_handshake(*conn))
+                {
+                    read_lk.unlock();
+                    remove_fd(fd);
+                    return;
+                }
+                if (!conn->tls_ready)
+                {
+                    std::lock_guard<std::mutex> lk(conn->mtx);
+                    update_interest(*conn);
+                    return;
+                }
+            }
+
+            // Flush pending output first, the event may be write readiness
+            bool is_paused;
+            {
+                std::unique_lock<std::mutex> lk(conn->mtx);
+                if (!flush(*conn))
+                {
+                    lk.unlock();
+                    read_lk.unlock();
+                    remove_fd(fd);
+                    return;
+                }
+                if (conn->close_pending && conn->outbox.empty())
+                {
+                    lk.unlock();
+                    read_lk.unlock();
+                    remove_fd(fd);
+                    return;
+                }
+                is_paused = conn->paused;
+            }
+
             char buf[4096];
 
             // Keep reading until socket would block or closed
-            while (true)
+            while (!is_paused)
             {
-                ssize_t n = client.recv(buf, sizeof(buf));
+                ssize_t n = conn->tls ? conn->tls->read(buf, sizeof(buf)) : conn->socket.recv(buf, sizeof(buf));
                 if (n > 0)
                 {
-                    // Convert received buffer to string
-                    std::string data(buf, n);
+                    metrics.bytes_in.add(n);
+                    std::lock_guard<std::mutex> lk(conn->mtx);
+
+                    // Queue the chunk; a single dispatch task per connection
+                    // keeps on_message calls ordered and non-overlapping.
+                    conn->inbox.emplace_back(buf, n);
+                    conn->inbox_bytes += n;
+                    if (!conn->draining && !conn->held)
+                    {
+                        conn->draining = true;
+                        OUC_TRACE(MessageQueued, fd);
+                        tasks.sumbit_to(
+                            conn->worker,
+                            [this, conn]()
+                            { drain_messages(conn); });
+                    }
 
-                    // Dispatch message callback asynchronously via thread pool
-                    if (on_message_callback)
-                        tasks.sumbit(on_message_callback, std::ref(client), data);
+                    // Backpressure: stop reading, drain_messages re-arms
+                    // EPOLLIN once on_message has caught up. Overloaded,
+                    // input is not read ahead of what is being handled.
+                    if (conn->inbox_bytes >= MAX_INBOX_BYTES || tasks.is_overloaded())
+                    {
+                        conn->paused = true;
+                        is_paused = true;
+                    }
                 }
                 else if (n == 0)
                 {
                     // n == 0 means peer has closed connection gracefully
+                    read_lk.unlock();
                     remove_fd(fd);
                     return;
                 }
                 else
                 {
                     // Handle read error
-                    // - EAGAIN / EWOULDBLOCK: no more data available, try again on next epoll event
+                    // - EAGAIN / EWOULDBLOCK: no more data available, wait for next epoll event
                     // - EINTR: system call interrupted, retry
                     // - otherwise: critical error, close the connection
-                    if (errno == EAGAIN || errno == EWOULDBLOCK)
-                        continue;
                     if (errno == EINTR)
                         continue;
+                    if (errno == EAGAIN || errno == EWOULDBLOCK)
+                        break;
 
+                    read_lk.unlock();
                     remove_fd(fd);
+                    return;
+                }
+            }
+
+            std::lock_guard<std::mutex> lk(conn->mtx);
+            update_interest(*conn);
+        }
+
+        bool TCPServer::advance_handshake(Connection &conn)
+        {
+            int code = conn.tls->handshake();
+
+            std::lock_guard<std::mutex> lk(conn.mtx);
+            if (code < 0)
+            {
+                metrics.tls_failures.add();
+                return false;
+            }
+
+            conn.tls_want_write = code == 0 && conn.tls->wants_write();
+            if (code == 1)
+            {
+                conn.tls_ready = true;
+                conn.tls_user_space = !conn.tls->is_ktls_send();
+                metrics.tls_handshakes.add();
+                if (conn.tls->is_resumed())
+                    metrics.tls_resumed.add();
+                if (!conn.tls_user_space)
+                    metrics.tls_ktls.add();
+            }
+            return true;
+        }
+
+        void TCPServer::resume_reading(Connection &conn)
+        {
+            update_interest(conn);
+
+            // OpenSSL may hold records already taken off the socket,
+            // which epoll cannot report: look for them right away
+            if (conn.tls)
+            {
+                int fd = conn.socket.get_fd();
+                epoll_loop.get_pool().sumbit([this, fd]
+                                             { handle_client_event(fd); });
+            }
+        }
+
+        void TCPServer::drain_messages(const std::shared_ptr<Connection> &conn)
+        {
+            while (true)
+            {
+                std::string data;
+                {
+                    std::lock_guard<std::mutex> lk(conn->mtx);
+
+                    // Held by the handler: release() starts a new dispatch
+                    if (conn->held)
+                    {
+                        conn->draining = false;
+                        return;
+                    }
+
+                    if (conn->inbox.empty())
+                    {
+                        conn->draining = false;
+                        if (conn->paused)
+                        {
+                            conn->paused = false;
+                            if (!conn->is_closed && !is_stopping.load())
+                                resume_reading(*conn);
+                        }
+                        return;
+                    }
+
+                    data = std::move(conn->inbox.front());
+                    conn->inbox.pop_front();
+                    conn->inbox_bytes -= data.size();
+
+                    if (conn->paused && conn->inbox_bytes < MAX_INBOX_BYTES / 2 && !tasks.is_overloaded())
+                    {
+                        conn->paused = false;
+                        if (!conn->is_closed && !is_stopping.load())
+                            resume_reading(*conn);
+                    }
+                }
+
+                if (on_message_callback)
+                {
+                    auto start = std::chrono::steady_clock::now();
+                    OUC_TRACE(HandlerBegin, conn->socket.get_fd());
+                    try
+                    {
+                        on_message_callback(conn->socket, data);
+                    }
+                    catch (...)
+                    {
+                        // swallow to keep the dispatcher of this connection alive
+                    }
+                    OUC_TRACE(HandlerEnd, conn->socket.get_fd());
+                    auto elapsed = std::chrono::steady_clock::now() - start;
+                    metrics.handler_ns.record(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+                }
+            }
+        }
+
+        std::shared_ptr<TCPServer::Connection> TCPServer::find_connection(int fd)
+        {
+            std::lock_guard<std::mutex> lk(clients_mtx);
+            auto it = clients.find(fd);
+            if (it == clients.end())
+                return nullptr;
+            return it->second;
+        }
+
+        bool TCPServer::send(ouc_server::ouc_socket::TCPSocket &client, std::string &&data, bool more)
+        {
+            return enqueue(client, OutChunk{std::move(data), nullptr}, more);
+        }
+
+        bool TCPServer::send(ouc_server::ouc_socket::TCPSocket &client, SharedBuffer data, bool more)
+        {
+            if (!data)
+                return true;
+            return enqueue(client, OutChunk{std::string(), std::move(data)}, more);
+        }
+
+        bool TCPServer::enqueue(ouc_server::ouc_socket::TCPSocket &client, OutChunk &&chunk, bool more)
+        {
+            auto conn = find_connection(client.get_fd());
+            if (!conn)
+                return false;
+
+            std::unique_lock<std::mutex> lk(conn->mtx);
+
+            // Throttle the producer while the client is not reading
+            conn->writable.wait(
+                lk,
+                [&conn]
+                { return conn->is_closed || conn->outbox_bytes < MAX_OUTBOX_BYTES; });
+            if (conn->is_closed || conn->close_pending)
+                return false;
+
+            bool was_empty = conn->outbox.empty();
+            conn->outbox_bytes += chunk.bytes().size();
+            conn->outbox.push_back(std::move(chunk));
+            conn->more = more;
+
+            // Nothing in front of us: try the socket right away and only
+            // fall back to EPOLLOUT for the part it does not take.
+            if (was_empty)
+            {
+                if (!flush(*conn))
+                {
+                    lk.unlock();
+                    remove_fd(client.get_fd());
+                    return false;
+                }
+                if (!conn->outbox.empty())
+                    update_interest(*conn);
+            }
+
+            return true;
+        }
+
+        void TCPServer::hold(ouc_server::ouc_socket::TCPSocket &client)
+        {
+            auto conn = find_connection(client.get_fd());
+            if (!conn)
+                return;
+
+            std::lock_guard<std::mutex> lk(conn->mtx);
+            conn->held = true;
+        }
+
+        void TCPServer::release(ouc_server::ouc_socket::TCPSocket &client, std::string &&unread)
+        {
+            auto conn = find_connection(client.get_fd());
+            if (!conn)
+                return;
+
+            std::lock_guard<std::mutex> lk(conn->mtx);
+            conn->held = false;
+            if (!unread.empty())
+            {
+                conn->inbox_bytes += unread.size();
+                conn->inbox.push_front(std::move(unread));
+            }
+
+            // Still inside the held call: its dispatcher carries on
+            if (conn->draining || conn->is_closed)
+                return;
+
+            if (!conn->inbox.empty())
+            {
+                conn->draining = true;
+                tasks.sumbit_to(
+                    conn->worker,
+                    [this, conn]()
+                    { drain_messages(conn); });
+            }
+            else if (conn->paused)
+            {
+                conn->paused = false;
+                if (!is_stopping.load())
+                    resume_reading(*conn);
+            }
+        }
+
+        bool TCPServer::notify_writable(ouc_server::ouc_socket::TCPSocket &client, std::function<void()> &&callback)
+        {
+            auto conn = find_connection(client.get_fd());
+            if (!conn)
+                return false;
+
+            {
+                std::lock_guard<std::mutex> lk(conn->mtx);
+                if (conn->is_closed)
+                    return false;
+                if (conn->outbox_bytes >= MAX_OUTBOX_BYTES / 2)
+                {
+                    conn->on_writable = std::move(callback);
+                    return true;
                 }
             }
+
+            epoll_loop.get_pool().sumbit(std::move(callback));
+            return true;
+        }
+
+        void TCPServer::close_after_flush(ouc_server::ouc_socket::TCPSocket &client)
+        {
+            auto conn = find_connection(client.get_fd());
+            if (!conn)
+                return;
+
+            {
+                std::lock_guard<std::mutex> lk(conn->mtx);
+                conn->close_pending = true;
+                if (!conn->outbox.empty())
+                    return;
+            }
+
+            remove_fd(client.get_fd());
+        }
+
+        bool TCPServer::offer(ouc_server::ouc_socket::TCPSocket &client, SharedBuffer data, SlowConsumerPolicy policy)
+        {
+            auto conn = find_connection(client.get_fd());
+            if (!conn || !data)
+                return false;
+            return deliver(*conn, data, policy, BROADCAST_STREAM);
+        }
+
+        bool TCPServer::subscribe(ouc_server::ouc_socket::TCPSocket &client, const std::string &topic)
+        {
+            auto conn = find_connection(client.get_fd());
+            if (!conn)
+                return false;
+
+            std::lock_guard<std::mutex> lk(topics_mtx);
+            auto &entry = topics[topic];
+            if (entry.stream == 0)
+                entry.stream = next_stream++;
+
+            auto subscribers = std::make_shared<std::vector<std::shared_ptr<Connection>>>();
+            if (entry.subscribers)
+            {
+                for (auto &subscriber : *entry.subscribers)
+                    if (subscriber == conn)
+                        return false;
+                subscribers->reserve(entry.subscribers->size() + 1);
+                *subscribers = *entry.subscribers;
+            }
+            subscribers->push_back(conn);
+            entry.subscribers = std::move(subscribers);
+            conn->topics.push_back(topic);
+            return true;
+        }
+
+        bool TCPServer::unsubscribe(ouc_server::ouc_socket::TCPSocket &client, const std::string &topic)
+        {
+            auto conn = find_connection(client.get_fd());
+            if (!conn)
+                return false;
+
+            std::lock_guard<std::mutex> lk(topics_mtx);
+            if (!remove_subscriber(topic, conn.get()))
+                return false;
+
+            auto &names = conn->topics;
+            for (auto it = names.begin(); it != names.end(); ++it)
+                if (*it == topic)
+                {
+                    names.erase(it);
+                    break;
+                }
+            return true;
+        }
+
+        bool TCPServer::remove_subscriber(const std::string &topic, const Connection *conn)
+        {
+            auto it = topics.find(topic);
+            if (it == topics.end() || !it->second.subscribers)
+                return false;
+
+            auto subscribers = std::make_shared<std::vector<std::shared_ptr<Connection>>>();
+            subscribers->reserve(it->second.subscribers->size());
+            for (auto &subscriber : *it->second.subscribers)
+                if (subscriber.get() != conn)
+                    subscribers->push_back(subscriber);
+            if (subscribers->size() == it->second.subscribers->size())
+                return false;
+
+            if (subscribers->empty())
+                topics.erase(it);
+            else
+                it->second.subscribers = std::move(subscribers);
+            return true;
+        }
+
+        size_t TCPServer::get_subscriber_count(const std::string &topic)
+        {
+            std::lock_guard<std::mutex> lk(topics_mtx);
+            auto it = topics.find(topic);
+            return it == topics.end() || !it->second.subscribers ? 0 : it->second.subscribers->size();
+        }
+
+        size_t TCPServer::publish(const std::string &topic, SharedBuffer data, SlowConsumerPolicy policy)
+        {
+            if (!data)
+                return 0;
+
+            Topic snapshot;
+            {
+                std::lock_guard<std::mutex> lk(topics_mtx);
+                auto it = topics.find(topic);
+                if (it == topics.end() || !it->second.subscribers)
+                    return 0;
+                snapshot = it->second;
+            }
+
+            size_t count = 0;
+            for (auto &conn : *snapshot.subscribers)
+                if (deliver(*conn, data, policy, snapshot.stream))
+                    ++count;
+            return count;
+        }
+
+        size_t TCPServer::broadcast(SharedBuffer data, SlowConsumerPolicy policy)
+        {
+            if (!data)
+                return 0;
+
+            std::vector<std::shared_ptr<Connection>> targets;
+            {
+                std::lock_guard<std::mutex> lk(clients_mtx);
+                targets.reserve(clients.size());
+                for (auto &entry : clients)
+                    targets.push_back(entry.second);
+            }
+
+            size_t count = 0;
+            for (auto &conn : targets)
+                if (deliver(*conn, data, policy, BROADCAST_STREAM))
+                    ++count;
+            return count;
+        }
+
+        bool TCPServer::deliver(Connection &conn, const SharedBuffer &data, SlowConsumerPolicy policy, uint64_t stream)
+        {
+            std::lock_guard<std::mutex> lk(conn.mtx);
+            if (conn.is_closed || conn.close_pending)
+                return false;
+
+            if (conn.outbox_bytes >= MAX_OUTBOX_BYTES)
+            {
+                switch (policy)
+                {
+                case SlowConsumerPolicy::Drop:
+                    metrics.fanout_dropped.add();
+                    return false;
+
+                case SlowConsumerPolicy::Disconnect:
+                    // The event loop sees the shutdown and removes the connection
+                    metrics.slow_disconnects.add();
+                    conn.close_pending = true;
+                    conn.socket.shutdown();
+                    return false;
+
+                case SlowConsumerPolicy::Coalesce:
+                    // Newest queued chunk of the stream, unless writing it has begun.
+                    // Through OpenSSL the front may be encrypted already though
+                    // out_offset is 0: SSL_write() must be retried with its bytes.
+                    for (size_t i = conn.outbox.size(); i-- > 0;)
+                    {
+                        OutChunk &chunk = conn.outbox[i];
+                        if (chunk.stream != stream)
+                            continue;
+                        if (i == 0 && (conn.out_offset > 0 || conn.front_zerocopy || conn.tls_user_space))
+                            break;
+
+                        conn.outbox_bytes = conn.outbox_bytes - chunk.bytes().size() + data->size();
+                        chunk.owned.clear();
+                        chunk.shared = data;
+                        metrics.fanout_coalesced.add();
+                        return true;
+                    }
+                    break; // nothing to replace: queue it, one chunk per stream over the limit
+                }
+            }
+
+            // Left to the event loop: it writes the backlog with one sendmsg()
+            bool was_empty = conn.outbox.empty();
+            conn.outbox_bytes += data->size();
+            conn.outbox.push_back(OutChunk{std::string(), data, stream});
+            if (was_empty)
+                update_interest(conn);
+            return true;
+        }
+
+        bool TCPServer::should_shed()
+        {
+            if (!tasks.is_overloaded() || ouc_server::utils::ThreadPool::current_task_wait() <= tasks.get_overload_target())
+                return false;
+
+            metrics.shed.add();
+            return true;
+        }
+
+        bool TCPServer::allow_request(ouc_server::ouc_socket::TCPSocket &client)
+        {
+            if (!admission || admission->get_config().requests_per_second <= 0)
+                return true;
+
+            auto conn = find_connection(client.get_fd());
+            if (!conn || admission->take(conn->client_slot))
+                return true;
+
+            metrics.rate_limited.add();
+            return false;
+        }
+
+        std::string TCPServer::peer_address(ouc_server::ouc_socket::TCPSocket &client)
+        {
+            auto conn = find_connection(client.get_fd());
+            if (!conn)
+                return "";
+            return ouc_server::ouc_socket::TCPSocket::format_address(conn->peer);
+        }
+
+        bool TCPServer::flush(Connection &conn)
+        {
+            // Held until the handshake is done
+            if (conn.tls && !conn.tls_ready)
+                return true;
+            if (conn.tls_user_space)
+                return flush_tls(conn);
+
+            if (!conn.zc_sends.empty())
+                reap_zerocopy(conn);
+
+            // The kernel may still read a zero-copy buffer: keep it until completion.
+            // Moving the chunk keeps the bytes in place only because they are
+            // on the heap: a shared buffer, or an owned string far longer than
+            // the small-string buffer, which MIN_ZEROCOPY_BYTES guarantees.
+            auto pop_front = [&conn]
+            {
+                if (conn.front_zerocopy)
+                    conn.zc_buffers.emplace_back(conn.zc_next - 1, std::move(conn.outbox.front()));
+                conn.outbox.pop_front();
+                conn.out_offset = 0;
+                conn.front_zerocopy = false;
+            };
+
+            constexpr int MAX_IOV = 64;
+            size_t threshold = zerocopy_threshold.load(std::memory_order_relaxed);
+            auto wants_zerocopy = [&](size_t len)
+            { return conn.zerocopy && threshold > 0 && len >= threshold; };
+
+            while (!conn.outbox.empty())
+            {
+                const std::string &front = conn.outbox.front().bytes();
+                const char *data = front.data() + conn.out_offset;
+                size_t len = front.size() - conn.out_offset;
+
+                if (wants_zerocopy(len))
+                {
+                    // Cork the chunk while more output is queued or announced
+                    int flags = conn.outbox.size() > 1 || conn.more ? MSG_MORE : 0;
+                    ssize_t n = conn.socket.send_zerocopy(data, len, flags);
+                    if (n < 0)
+                        return false;
+                    if (n > 0)
+                    {
+                        conn.zc_sends.emplace_back(conn.zc_next++, false);
+                        conn.front_zerocopy = true;
+                        metrics.bytes_zerocopy.add(n);
+                    }
+
+                    metrics.bytes_out.add(n);
+                    conn.out_offset += n;
+                    conn.outbox_bytes -= n;
+                    if (conn.out_offset < front.size())
+                    {
+                        // One zero-copy send may take less than the buffer has room for
+                        if (n > 0)
+                            continue;
+                        break; // socket buffer full
+                    }
+                    pop_front();
+                    continue;
+                }
+
+                // Gather the plain chunks up to the next zero-copy one into one call
+                iovec iov[MAX_IOV];
+                int count = 0;
+                size_t total = 0;
+                for (auto it = conn.outbox.begin(); it != conn.outbox.end() && count < MAX_IOV; ++it)
+                {
+                    const std::string &bytes = it->bytes();
+                    size_t offset = count == 0 ? conn.out_offset : 0;
+                    if (count > 0 && wants_zerocopy(bytes.size()))
+                        break;
+                    iov[count].iov_base = const_cast<char *>(bytes.data() + offset);
+                    iov[count].iov_len = bytes.size() - offset;
+                    total += iov[count].iov_len;
+                    ++count;
+                }
+
+                int flags = conn.outbox.size() > static_cast<size_t>(count) || conn.more ? MSG_MORE : 0;
+                ssize_t n = conn.socket.sendv(iov, count, flags);
+                if (n < 0)
+                    return false;
+
+                metrics.bytes_out.add(n);
+                conn.outbox_bytes -= n;
+                size_t left = n;
+                for (int i = 0; i < count; ++i)
+                {
+                    size_t remaining = conn.outbox.front().bytes().size() - conn.out_offset;
+                    if (remaining > left)
+                    {
+                        conn.out_offset += left;
+                        break;
+                    }
+                    left -= remaining;
+                    pop_front();
+                }
+                if (static_cast<size_t>(n) < total)
+                    break; // socket buffer full
+            }
+
+            // Hysteresis: wake producers only once half the budget is free
+            if (conn.outbox_bytes < MAX_OUTBOX_BYTES / 2)
+                signal_writable(conn);
+            return true;
+        }
+
+        bool TCPServer::flush_tls(Connection &conn)
+        {
+            while (!conn.outbox.empty())
+            {
+                const std::string &front = conn.outbox.front().bytes();
+                ssize_t n = conn.tls->write(front.data() + conn.out_offset, front.size() - conn.out_offset);
+                if (n < 0)
+                    return false;
+
+                metrics.bytes_out.add(n);
+                conn.out_offset += n;
+                conn.outbox_bytes -= n;
+                if (conn.out_offset < front.size())
+                    break; // socket buffer full
+
+                conn.outbox.pop_front();
+                conn.out_offset = 0;
+            }
+
+            if (conn.outbox_bytes < MAX_OUTBOX_BYTES / 2)
+                signal_writable(conn);
+            return true;
+        }
+
+        void TCPServer::signal_writable(Connection &conn)
+        {
+            conn.writable.notify_all();
+
+            // Never run under the lock, the callback usually sends right away
+            if (conn.on_writable)
+            {
+                epoll_loop.get_pool().sumbit(std::move(conn.on_writable));
+                conn.on_writable = nullptr;
+            }
+        }
+
+        void TCPServer::reap_zerocopy(Connection &conn)
+        {
+            conn.socket.read_zerocopy_completions(
+                [&conn](uint32_t lo, uint32_t hi, bool copied)
+                {
+                    // Ranges usually complete in order, but need not
+                    for (auto &[id, done] : conn.zc_sends)
+                        if (static_cast<int32_t>(id - lo) >= 0 && static_cast<int32_t>(hi - id) >= 0)
+                            done = true;
+
+                    // The kernel copied anyway: skip the notification overhead from now on
+                    if (copied)
+                        conn.zerocopy = false;
+                });
+
+            while (!conn.zc_sends.empty() && conn.zc_sends.front().second)
+                conn.zc_sends.pop_front();
+
+            // Buffers whose last send is older than every pending one are free
+            uint32_t oldest = conn.zc_sends.empty() ? conn.zc_next : conn.zc_sends.front().first;
+            while (!conn.zc_buffers.empty() && static_cast<int32_t>(conn.zc_buffers.front().first - oldest) < 0)
+                conn.zc_buffers.pop_front();
+        }
+
+        void TCPServer::update_interest(Connection &conn)
+        {
+            uint32_t flags = 0;
+            if (!conn.paused)
+                flags |= EPOLLIN;
+            if (!conn.outbox.empty() || conn.tls_want_write)
+                flags |= EPOLLOUT;
+
+            // Neither reading nor writing wanted: stay disarmed, whoever
+            // unblocks the connection re-arms it.
+            if (flags == 0)
+                return;
+            epoll_loop.modify_fd(conn.socket.get_fd(), flags | EPOLLONESHOT);
+        }
+
+        void TCPServer::write_metrics(std::string &out)
+        {
+            using namespace ouc_server::utils;
+
+            // Latencies are exported in seconds, 1 us to ~17 s
+            constexpr double NS = 1e-9;
+            constexpr size_t FIRST_NS_BUCKET = 10, LAST_NS_BUCKET = 34;
+
+            prometheus::write_header(out, "ouc_tcp_accepts_total", "counter", "Connections accepted.");
+            prometheus::write_value(out, "ouc_tcp_accepts_total", "", static_cast<double>(metrics.accepts.value()));
+            prometheus::write_header(out, "ouc_tcp_rejected_connections_total", "counter", "Connections closed by admission control.");
+            prometheus::write_value(out, "ouc_tcp_rejected_connections_total", "", static_cast<double>(metrics.admission_rejects.value()));
+            prometheus::write_header(out, "ouc_tcp_rate_limited_requests_total", "counter", "Requests refused by the per-client rate limit.");
+            prometheus::write_value(out, "ouc_tcp_rate_limited_requests_total", "", static_cast<double>(metrics.rate_limited.value()));
+            prometheus::write_header(out, "ouc_tcp_shed_messages_total", "counter", "Messages refused because the server was overloaded.");
+            prometheus::write_value(out, "ouc_tcp_shed_messages_total", "", static_cast<double>(metrics.shed.value()));
+            prometheus::write_header(out, "ouc_tcp_active_connections", "gauge", "Connections currently open.");
+            prometheus::write_value(out, "ouc_tcp_active_connections", "", static_cast<double>(metrics.active_connections.value()));
+            prometheus::write_header(out, "ouc_tcp_received_bytes_total", "counter", "Bytes received from clients.");
+            prometheus::write_value(out, "ouc_tcp_received_bytes_total", "", static_cast<double>(metrics.bytes_in.value()));
+            prometheus::write_header(out, "ouc_tcp_sent_bytes_total", "counter", "Bytes written to clients.");
+            prometheus::write_value(out, "ouc_tcp_sent_bytes_total", "", static_cast<double>(metrics.bytes_out.value()));
+            prometheus::write_header(out, "ouc_tcp_zerocopy_sent_bytes_total", "counter", "Bytes written to clients with MSG_ZEROCOPY.");
+            prometheus::write_value(out, "ouc_tcp_zerocopy_sent_bytes_total", "", static_cast<double>(metrics.bytes_zerocopy.value()));
+            prometheus::write_header(out, "ouc_tcp_fanout_dropped_total", "counter", "Fan-out messages dropped for lagging clients.");
+            prometheus::write_value(out, "ouc_tcp_fanout_dropped_total", "", static_cast<double>(metrics.fanout_dropped.value()));
+            prometheus::write_header(out, "ouc_tcp_fanout_coalesced_total", "counter", "Fan-out messages that replaced a queued one.");
+            prometheus::write_value(out, "ouc_tcp_fanout_coalesced_total", "", static_cast<double>(metrics.fanout_coalesced.value()));
+            prometheus::write_header(out, "ouc_tcp_slow_disconnects_total", "counter", "Lagging clients disconnected by fan-out.");
+            prometheus::write_value(out, "ouc_tcp_slow_disconnects_total", "", static_cast<double>(metrics.slow_disconnects.value()));
+            prometheus::write_header(out, "ouc_tls_handshakes_total", "counter", "TLS handshakes completed.");
+            prometheus::write_value(out, "ouc_tls_handshakes_total", "", static_cast<double>(metrics.tls_handshakes.value()));
+            prometheus::write_header(out, "ouc_tls_resumed_total", "counter", "TLS handshakes that resumed a session.");
+            prometheus::write_value(out, "ouc_tls_resumed_total", "", static_cast<double>(metrics.tls_resumed.value()));
+            prometheus::write_header(out, "ouc_tls_ktls_total", "counter", "TLS connections offloaded to kernel TLS.");
+            prometheus::write_value(out, "ouc_tls_ktls_total", "", static_cast<double>(metrics.tls_ktls.value()));
+            prometheus::write_header(out, "ouc_tls_failures_total", "counter", "Connections closed during the TLS handshake.");
+            prometheus::write_value(out, "ouc_tls_failures_total", "", static_cast<double>(metrics.tls_failures.value()));
+            prometheus::write_header(out, "ouc_tcp_handler_seconds", "histogram", "Time spent in on_message.");
+            prometheus::write_histogram(out, "ouc_tcp_handler_seconds", "", metrics.handler_ns.snapshot(), NS, FIRST_NS_BUCKET, LAST_NS_BUCKET);
+
+            prometheus::write_header(out, "ouc_epoll_ready_events", "histogram", "Ready file descriptors per epoll_wait.");
+            prometheus::write_histogram(out, "ouc_epoll_ready_events", "", epoll_loop.get_events_histogram().snapshot(), 1, 0, 7);
+            prometheus::write_header(out, "ouc_epoll_spin_hits_total", "counter", "Waits that found events while busy-polling.");
+            prometheus::write_value(out, "ouc_epoll_spin_hits_total", "", static_cast<double>(epoll_loop.get_spin_hits()));
+
+            // Reader pool dispatching epoll callbacks and the message task pool
+            std::pair<const char *, ThreadPool *> pools[] = {{"pool=\"epoll\"", &epoll_loop.get_pool()},
+                                                             {"pool=\"tasks\"", &tasks}};
+
+            prometheus::write_header(out, "ouc_pool_threads", "gauge", "Worker threads per pool.");
+            for (auto &[labels, pool] : pools)
+                prometheus::write_value(out, "ouc_pool_threads", labels, static_cast<double>(pool->get_thread_count()));
+            prometheus::write_header(out, "ouc_pool_queue_depth", "gauge", "Tasks waiting for a worker.");
+            for (auto &[labels, pool] : pools)
+                prometheus::write_value(out, "ouc_pool_queue_depth", labels, static_cast<double>(pool->get_queue_depth()));
+            prometheus::write_header(out, "ouc_pool_sojourn_seconds", "gauge", "Queue wait of the most recently started task.");
+            for (auto &[labels, pool] : pools)
+                prometheus::write_value(out, "ouc_pool_sojourn_seconds", labels, static_cast<double>(pool->get_sojourn().count()) * NS);
+            prometheus::write_header(out, "ouc_pool_overloaded", "gauge", "1 while the queue wait stays above its target.");
+            for (auto &[labels, pool] : pools)
+                prometheus::write_value(out, "ouc_pool_overloaded", labels, pool->is_overloaded() ? 1 : 0);
+            prometheus::write_header(out, "ouc_pool_tasks_total", "counter", "Tasks started by a worker.");
+            for (auto &[labels, pool] : pools)
+                prometheus::write_value(out, "ouc_pool_tasks_total", labels, static_cast<double>(pool->get_executed_count()));
+            prometheus::write_header(out, "ouc_pool_wait_seconds", "histogram", "Time tasks spent queued.");
+            for (auto &[labels, pool] : pools)
+                prometheus::write_histogram(out, "ouc_pool_wait_seconds", labels, pool->get_wait_histogram().snapshot(), NS, FIRST_NS_BUCKET, LAST_NS_BUCKET);
         }
     }
-}
\ No newline at end of file
+}
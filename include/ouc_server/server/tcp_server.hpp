@@ -18,16 +18,97 @@
 #include <string>
 #include <functional>
 #include <utility>
+#include <algorithm>
 #include <map>
+#include <unordered_map>
+#include <deque>
+#include <mutex>
+#include <memory>
+#include <atomic>
+#include <condition_variable>
+#include <vector>
+#include <chrono>
 
 #include <socket/tcp_socket.hpp>
+#include <socket/socket_options.hpp>
+#include <socket/tls.hpp>
+#include <server/admission_control.hpp>
 #include <epoll/epoll_loop.hpp>
 #include <utils/thread_pool.hpp>
+#include <utils/metrics.hpp>
 
 namespace ouc_server
 {
     namespace server
     {
+        /**
+         * @brief Runtime metrics maintained by a TCPServer.
+         *
+         * Updates are sharded per thread and summed only when read, so
+         * they stay on in production.
+         */
+        struct TCPServerMetrics
+        {
+            ouc_server::utils::Counter accepts;                ///< Connections accepted.
+            ouc_server::utils::Counter admission_rejects;      ///< Accepted connections closed by admission control.
+            ouc_server::utils::Counter rate_limited;           ///< Requests refused by allow_request().
+            ouc_server::utils::Counter shed;                   ///< Messages shed by should_shed().
+            ouc_server::utils::Gauge active_connections;       ///< Connections currently tracked.
+            ouc_server::utils::Counter bytes_in;               ///< Bytes received from clients.
+            ouc_server::utils::Counter bytes_out;              ///< Bytes written to clients.
+            ouc_server::utils::Counter bytes_zerocopy;         ///< Part of bytes_out sent with MSG_ZEROCOPY.
+            ouc_server::utils::Counter fanout_dropped;         ///< Fan-out messages dropped for lagging clients.
+            ouc_server::utils::Counter fanout_coalesced;       ///< Fan-out messages that replaced a queued one.
+            ouc_server::utils::Counter slow_disconnects;       ///< Lagging clients disconnected by fan-out.
+            ouc_server::utils::Counter tls_handshakes;         ///< TLS handshakes completed.
+            ouc_server::utils::Counter tls_resumed;            ///< Part of tls_handshakes that resumed a session.
+            ouc_server::utils::Counter tls_ktls;               ///< Part of tls_handshakes offloaded to kernel TLS.
+            ouc_server::utils::Counter tls_failures;           ///< Connections closed during the TLS handshake.
+            ouc_server::utils::MetricHistogram handler_ns;     ///< Duration of on_message calls, in ns.
+        };
+
+        /**
+         * @brief Thread counts and placement of a TCPServer.
+         *
+         * The thread calling loop() is the caller's; pin it with
+         * utils::pin_current_thread() if wanted.
+         */
+        struct TCPServerConfig
+        {
+            size_t io_threads = 0;      ///< EpollLoop callback pool, 0 for utils::default_thread_count().
+            size_t task_threads = 0;    ///< on_message pool, 0 for utils::default_thread_count().
+            std::vector<int> io_cpus;   ///< CPUs for the callback pool, empty leaves it unpinned.
+            std::vector<int> task_cpus; ///< CPUs for the on_message pool, empty leaves it unpinned.
+
+            /// Run each connection's on_message on the task worker pinned to
+            /// the CPU its packets arrive on (SO_INCOMING_CPU at accept time),
+            /// so the handler shares that core's caches with the network stack.
+            bool steer_by_incoming_cpu = false;
+
+            /// Config with only the thread counts set, everything else at its default.
+            static TCPServerConfig with_threads(size_t p_io_threads, size_t p_task_threads)
+            {
+                TCPServerConfig config;
+                config.io_threads = p_io_threads;
+                config.task_threads = p_task_threads;
+                return config;
+            }
+        };
+
+        /**
+         * @brief What fan-out does with a client whose outbox is full.
+         *
+         * A full outbox is where send() would block; publish() and
+         * broadcast() never wait, so one laggard does not hold up the
+         * delivery to everyone else.
+         */
+        enum class SlowConsumerPolicy
+        {
+            Drop,       ///< Skip the message for this client.
+            Disconnect, ///< Close the client.
+            Coalesce,   ///< Replace its newest unsent message of the same stream: only the latest state matters.
+        };
+
         /**
          * @class TCPServer
          * @brief A TCP server wrapper with epoll-based I/O and callback support.
@@ -51,22 +132,134 @@ namespace ouc_server
             template <typename... Args>
             using Callback = std::function<void(ouc_server::ouc_socket::TCPSocket &, Args...)>;
 
+            /// Tells drain() whether a connection with nothing buffered is between requests.
+            using IdleCheck = std::function<bool(ouc_server::ouc_socket::TCPSocket &)>;
+
+            /// Bytes buffered per connection before reading is paused until
+            /// on_message catches up.
+            static constexpr size_t MAX_INBOX_BYTES = 256 * 1024;
+
+            /// Bytes queued per connection before send() blocks the producer
+            /// until the client has read enough of them.
+            static constexpr size_t MAX_OUTBOX_BYTES = 256 * 1024;
+
+            /// Smallest zero-copy threshold: below it MSG_ZEROCOPY costs more
+            /// than the copy it saves, and every such chunk is heap allocated.
+            static constexpr size_t MIN_ZEROCOPY_BYTES = 4 * 1024;
+
+            /// Immutable bytes shared by several connections' outboxes, e.g. one broadcast frame.
+            using SharedBuffer = std::shared_ptr<const std::string>;
+
         private:
-            ouc_server::ouc_socket::TCPSocket server_socket;          ///< Listening socket for the server.
-            ouc_server::epoll::EpollLoop epoll_loop;                  ///< Epoll event loop instance.
-            ouc_server::utils::ThreadPool tasks;                      ///< Thread pool for async tasks.
-            std::map<int, ouc_server::ouc_socket::TCPSocket> clients; ///< Active client sockets.
+            /// One queued piece of output, owned by the connection or shared.
+            struct OutChunk
+            {
+                std::string owned;
+                SharedBuffer shared;
+                uint64_t stream = 0; ///< Fan-out stream it belongs to, 0 if none.
+
+                const std::string &bytes() const noexcept { return shared ? *shared : owned; }
+            };
+
+            /**
+             * @brief Per-client state shared between the reader and the message dispatcher.
+             *
+             * Chunks are delivered to on_message strictly in arrival order and
+             * never concurrently for the same connection. The socket is closed
+             * only when the last task referencing the connection releases it,
+             * so its fd number cannot be reused while a handler still runs.
+             *
+             * Output the socket cannot take right away is queued in the outbox
+             * and flushed when epoll reports the fd writable.
+             */
+            struct Connection
+            {
+                ouc_server::ouc_socket::TCPSocket socket;
+
+                std::mutex read_mtx;                ///< Serializes reads on the socket.
+                std::mutex mtx;                     ///< Guards the fields below.
+                std::deque<std::string> inbox;      ///< Received chunks not yet passed to on_message.
+                size_t inbox_bytes = 0;             ///< Total size of inbox.
+                bool draining = false;              ///< A dispatch task is queued or running.
+                bool held = false;                  ///< on_message paused by hold() until release().
+                bool paused = false;                ///< Reading stopped until the inbox drains.
+                std::deque<OutChunk> outbox;        ///< Pending output, front partially sent.
+                size_t out_offset = 0;              ///< Bytes of outbox.front() already sent.
+                size_t outbox_bytes = 0;            ///< Unsent bytes in outbox.
+                std::condition_variable writable;   ///< Signalled when outbox shrinks or closes.
+                std::function<void()> on_writable;  ///< notify_writable() callback waiting for room.
+                bool close_pending = false;         ///< Close once the outbox is flushed.
+                bool is_closed = false;             ///< Removed from the server.
+                int worker = -1;                    ///< Task worker bound to the connection, -1 for any.
+                sockaddr_storage peer{};            ///< Client address, family AF_UNSPEC if unknown.
+                int client_slot = -1;               ///< AdmissionControl slot, -1 if untracked.
+                bool more = false;                  ///< The producer sends more soon, cork the tail.
+
+                bool zerocopy = false;              ///< MSG_ZEROCOPY enabled and worth it.
+                bool front_zerocopy = false;        ///< outbox.front() was partly sent zero-copy.
+                uint32_t zc_next = 0;               ///< Number of the next zero-copy send.
+                std::deque<std::pair<uint32_t, bool>> zc_sends;          ///< Zero-copy sends in order, and whether completed.
+                std::deque<std::pair<uint32_t, OutChunk>> zc_buffers;    ///< Sent buffers, by their last send number.
+
+                std::vector<std::string> topics;    ///< Subscribed topics, guarded by topics_mtx.
+
+                std::unique_ptr<ouc_server::ouc_socket::TLSSession> tls; ///< TLS state, nullptr for plain TCP.
+                bool tls_ready = false;             ///< Handshake done, output may be written.
+                bool tls_user_space = false;        ///< Output goes through OpenSSL, not kTLS.
+                bool tls_want_write = false;        ///< Handshake waits for writability.
+
+                explicit Connection(ouc_server::ouc_socket::TCPSocket &&p_socket)
+                    : socket(std::move(p_socket)) {}
+                ~Connection() { socket.close(); }
+            };
+
+            std::atomic<bool> is_stopping{false};               ///< Set once destruction begins.
+            std::atomic<bool> stopped{false};                   ///< No longer accepting connections.
+            std::mutex accept_mtx;                              ///< Orders accepting against stop().
+            TCPServerMetrics metrics;                           ///< Counters updated by the I/O paths.
+            ouc_server::ouc_socket::TCPSocket server_socket;    ///< Listening socket for the server.
+            ouc_server::epoll::EpollLoop epoll_loop;            ///< Epoll event loop instance.
+            ouc_server::utils::ThreadPool tasks;                ///< Thread pool for async tasks.
+            std::mutex clients_mtx;                             ///< Guards clients.
+            std::map<int, std::shared_ptr<Connection>> clients; ///< Active client connections.
+
+            /// Subscribers of a topic, replaced rather than modified so publish() iterates a snapshot.
+            struct Topic
+            {
+                uint64_t stream = 0;
+                std::shared_ptr<const std::vector<std::shared_ptr<Connection>>> subscribers;
+            };
+
+            /// Stream of broadcast() and offer(), topics count up from 1.
+            static constexpr uint64_t BROADCAST_STREAM = UINT64_MAX;
+
+            std::mutex topics_mtx;                          ///< Guards topics, next_stream and Connection::topics.
+            std::unordered_map<std::string, Topic> topics;  ///< Subscriptions by topic name.
+            uint64_t next_stream = 1;                       ///< Stream id of the next new topic.
 
             Callback<> on_connection_callback;                 ///< Callback for new connection event.
             Callback<const std::string &> on_message_callback; ///< Callback for message received event.
             Callback<> on_close_callback;                      ///< Callback for client close event.
+            IdleCheck idle_check;                              ///< Protocol-level idleness, optional.
+            bool steer_by_incoming_cpu;                        ///< See TCPServerConfig.
+            std::atomic<int> socket_busy_poll_us{0};           ///< SO_BUSY_POLL for accepted sockets.
+            ouc_server::ouc_socket::SocketOptions socket_options; ///< Applied to every accepted socket.
+            std::atomic<size_t> zerocopy_threshold{0};          ///< Smallest chunk sent zero-copy, 0 for never.
+            std::unique_ptr<AdmissionControl> admission;        ///< Connection and rate limits, optional.
+            std::shared_ptr<ouc_server::ouc_socket::TLSContext> tls_context; ///< TLS for accepted connections, optional.
 
         public:
             /**
              * @brief Construct a new TCPServer instance.
-             * @param task_count Number of thread in the thread pool.
+             * @param task_count Number of thread in the thread pool, 0 for one per CPU.
              */
-            TCPServer(size_t task_count = 64);
+            TCPServer(size_t task_count = 0);
+
+            /**
+             * @brief Construct a new TCPServer with explicit thread placement.
+             * @param config Thread counts and CPUs.
+             */
+            explicit TCPServer(const TCPServerConfig &config);
 
             /**
              * @brief Destroy the TCPServer instance.
@@ -92,19 +285,188 @@ namespace ouc_server
              */
             void on_close(Callback<> &&callback) { on_close_callback = std::move(callback); }
 
+            /**
+             * @brief Register the idleness test used by drain().
+             * @param callback Returns true if the client may be closed without losing a request.
+             */
+            void set_idle_check(IdleCheck &&callback) { idle_check = std::move(callback); }
+
         public:
+            /**
+             * @brief Set the options of accepted sockets, call before start().
+             * @param options TCP_NODELAY, buffer sizes, keepalive and the like.
+             */
+            void set_socket_options(const ouc_server::ouc_socket::SocketOptions &options) { socket_options = options; }
+
+            /**
+             * @brief Limit connections and request rates, call before start().
+             *
+             * Connections over a limit are closed right after accept, before
+             * on_connection. The request rate is only enforced where a
+             * protocol calls allow_request(); HttpServer does for each request.
+             *
+             * @param config Limits, all zero to disable admission control.
+             */
+            void set_admission(const AdmissionConfig &config) { admission = std::make_unique<AdmissionControl>(config); }
+
+            /**
+             * @brief Charge one request to the client's rate limit.
+             * @param client Connection the request arrived on.
+             * @return false if the client is over its rate and the request should be refused.
+             */
+            bool allow_request(ouc_server::ouc_socket::TCPSocket &client);
+
+            /**
+             * @brief Address of the client as text, e.g. "192.0.2.1" or "2001:db8::1".
+             * @param client Accepted connection.
+             * @return The address, empty if unknown.
+             */
+            std::string peer_address(ouc_server::ouc_socket::TCPSocket &client);
+
+            /**
+             * @brief Shed load once on_message tasks queue up, see ThreadPool::set_overload_target().
+             *
+             * While overloaded, connections that still have unhandled input
+             * are not read any further until it is handled, and should_shed()
+             * tells handlers which messages waited too long to be worth
+             * serving.
+             *
+             * @param target Acceptable wait of an on_message task, zero to disable.
+             * @param interval Time above the target that counts as overload.
+             */
+            void set_load_shedding(std::chrono::microseconds target, std::chrono::milliseconds interval = std::chrono::milliseconds(100))
+            {
+                tasks.set_overload_target(target, interval);
+            }
+
+            bool is_overloaded() const noexcept { return tasks.is_overloaded(); }
+
+            /**
+             * @brief Whether the message being handled should get a cheap refusal instead.
+             *
+             * Call from on_message. True while the server is overloaded and
+             * the task delivering the message waited longer than the target:
+             * its client is likely to have given up already.
+             */
+            bool should_shed();
+
+            /**
+             * @brief Send large output chunks with MSG_ZEROCOPY.
+             *
+             * The kernel then transmits straight from the queued buffer
+             * instead of copying it, which pays off from about 10 KB on; the
+             * buffer is released once the completion arrives. Connections
+             * where the kernel copies anyway (loopback, devices without
+             * scatter-gather) fall back to plain sends. Applies to
+             * connections accepted from now on.
+             *
+             * @param bytes Smallest chunk sent zero-copy, raised to
+             *        MIN_ZEROCOPY_BYTES, 0 to disable.
+             */
+            void set_zerocopy_threshold(size_t bytes) { zerocopy_threshold.store(bytes == 0 ? 0 : std::max(bytes, MIN_ZEROCOPY_BYTES)); }
+
+            /**
+             * @brief Serve TLS on connections accepted from now on, call before start().
+             *
+             * The handshake runs on the event loop before any input reaches
+             * on_message; output sent earlier is held until it completes.
+             * Connections the kernel can offload to kTLS keep the plain
+             * gathered-write path, the others are written through OpenSSL.
+             * MSG_ZEROCOPY is not used on TLS connections.
+             *
+             * @param context Certificate and ticket keys, nullptr for plain TCP.
+             */
+            void set_tls(std::shared_ptr<ouc_server::ouc_socket::TLSContext> context) { tls_context = std::move(context); }
+
             /**
              * @brief Start the server listening.
-             * @param address IP address to bind.
+             *
+             * The address picks the family: "0.0.0.0" listens on IPv4,
+             * "::" or "[::1]" on IPv6, "unix:/run/app.sock" or "/run/app.sock"
+             * on a Unix-domain socket, where the port is ignored.
+             *
+             * @param address Address to bind.
              * @param port Port number to bind.
              * @return true if the server started successfully, false otherwise.
              */
             bool start(const std::string &address, uint16_t port);
 
+            /**
+             * @brief Start on an already bound and listening socket.
+             *
+             * For sockets inherited from a service manager or a previous
+             * process, see socket/listen_handoff.hpp.
+             *
+             * @param listener Listening socket, owned by the server from now on.
+             * @return true if the server started successfully, false otherwise.
+             */
+            bool start(ouc_server::ouc_socket::TCPSocket &&listener);
+
+            /**
+             * @brief Pass the listening socket to a successor process, then stop().
+             *
+             * Blocks until a process calls receive_listener() on the same
+             * path. Accepting goes on until the successor holds the socket,
+             * so no connection is refused during the switch; call drain()
+             * afterwards to finish the established connections.
+             *
+             * @param path Unix socket path the successor connects to.
+             * @param timeout Longest wait for the successor.
+             * @return true if the socket was handed off.
+             */
+            bool hand_off(const std::string &path, std::chrono::milliseconds timeout);
+
             /**
              * @brief Run the event loop for one time.
+             * @param timeout_ms Maximum time to block waiting for events.
+             */
+            void loop(int timeout_ms = 0) { epoll_loop.poll(timeout_ms); }
+
+            /**
+             * @brief Trade CPU for latency, see EpollLoop::set_busy_poll().
+             *
+             * Run the loop with a non-zero timeout: it spins for `window`
+             * after activity and only then blocks.
+             *
+             * @param window Loop spin duration after activity, zero to disable.
+             * @param socket_busy_poll_us SO_BUSY_POLL applied to connections
+             *        accepted from now on, zero to leave the socket default.
+             */
+            void set_busy_poll(std::chrono::microseconds window, int socket_busy_poll_us = 0)
+            {
+                epoll_loop.set_busy_poll(window);
+                this->socket_busy_poll_us.store(socket_busy_poll_us);
+            }
+
+            /**
+             * @brief Stop accepting connections and wake a blocked loop().
+             *
+             * Established connections keep being served. Safe to call from
+             * any thread, more than once.
              */
-            void loop() { epoll_loop.poll(); }
+            void stop();
+
+            bool is_stopped() const noexcept { return stopped.load(); }
+
+            /**
+             * @brief Stop, then wait for the connections to wind down.
+             *
+             * Runs the event loop itself until every connection is closed:
+             * idle ones right away, busy ones once their pending input was
+             * handled and their output flushed. Connections still open when
+             * the timeout expires are closed abruptly. Without an IdleCheck,
+             * any connection with nothing buffered counts as idle.
+             *
+             * @param timeout Longest time to wait.
+             * @return true if all connections finished before the timeout.
+             */
+            bool drain(std::chrono::milliseconds timeout);
+
+            size_t get_connection_count()
+            {
+                std::lock_guard<std::mutex> lk(clients_mtx);
+                return clients.size();
+            }
 
             /**
              * @brief Add a client socket by file descriptor and socket object.
@@ -135,7 +497,148 @@ namespace ouc_server
              */
             bool remove_fd(int);
 
+            /**
+             * @brief Queue data for a client and flush as much as the socket takes.
+             *
+             * Whatever cannot be written right away is sent once the socket
+             * becomes writable. When MAX_OUTBOX_BYTES are already pending the
+             * call blocks until the client catches up, so a slow reader
+             * throttles the producer instead of growing the buffer.
+             *
+             * Queued chunks are sent with MSG_MORE while another one follows,
+             * so a header and body queued together leave in full segments.
+             *
+             * @param client Connection to write to.
+             * @param data Bytes to send.
+             * @param more More data follows right away: hold a partial last
+             *        segment back until the next send (at most 200 ms).
+             * @return false if the connection is gone.
+             */
+            bool send(ouc_server::ouc_socket::TCPSocket &client, std::string &&data, bool more = false);
+
+            bool send(ouc_server::ouc_socket::TCPSocket &client, const std::string &data, bool more = false) { return send(client, std::string(data), more); }
+
+            bool send(ouc_server::ouc_socket::TCPSocket &client, const char *data, size_t len, bool more = false) { return send(client, std::string(data, len), more); }
+
+            /**
+             * @brief Queue a buffer shared with other connections, without copying it.
+             * @param client Connection to send to.
+             * @param data Bytes to send, never modified while queued.
+             * @param more See send(client, data, more).
+             * @return false if the connection is gone.
+             */
+            bool send(ouc_server::ouc_socket::TCPSocket &client, SharedBuffer data, bool more = false);
+
+            /**
+             * @brief Queue a shared buffer without blocking.
+             *
+             * Like send(), except that a client whose outbox is full gets
+             * the policy applied instead of stalling the caller. Coalescing
+             * replaces the newest unsent buffer offered or broadcast earlier.
+             *
+             * @param client Connection to send to.
+             * @param data Bytes to send, never modified while queued.
+             * @param policy What to do if the client lags.
+             * @return true if the buffer was queued or replaced a queued one.
+             */
+            bool offer(ouc_server::ouc_socket::TCPSocket &client, SharedBuffer data, SlowConsumerPolicy policy = SlowConsumerPolicy::Drop);
+
+            /**
+             * @brief Subscribe a client to a topic, see publish().
+             * @return false if the client is gone or already subscribed.
+             */
+            bool subscribe(ouc_server::ouc_socket::TCPSocket &client, const std::string &topic);
+
+            /**
+             * @brief Cancel a subscription; closing a client cancels all of its own.
+             * @return false if the client was not subscribed.
+             */
+            bool unsubscribe(ouc_server::ouc_socket::TCPSocket &client, const std::string &topic);
+
+            size_t get_subscriber_count(const std::string &topic);
+
+            /**
+             * @brief Queue one buffer on every subscriber of a topic.
+             *
+             * The buffer is referenced by each outbox, never copied, and
+             * left to the connections' event loop callbacks to write, so
+             * the caller does not pay a system call per subscriber.
+             *
+             * @param topic Topic to publish on.
+             * @param data Bytes to send, e.g. one encoded message.
+             * @param policy What to do with subscribers whose outbox is full.
+             * @return Number of subscribers it was queued on.
+             */
+            size_t publish(const std::string &topic, SharedBuffer data, SlowConsumerPolicy policy = SlowConsumerPolicy::Drop);
+
+            /**
+             * @brief Queue one buffer on every connection, see publish().
+             * @return Number of connections it was queued on.
+             */
+            size_t broadcast(SharedBuffer data, SlowConsumerPolicy policy = SlowConsumerPolicy::Drop);
+
+            /**
+             * @brief Stop passing this client's input to on_message once the running call returns.
+             *
+             * For a handler that finishes its work asynchronously: input
+             * keeps being buffered up to MAX_INBOX_BYTES, then reading
+             * pauses, so the client is throttled without a thread waiting.
+             * Call from on_message; release() resumes.
+             */
+            void hold(ouc_server::ouc_socket::TCPSocket &client);
+
+            /**
+             * @brief Resume on_message after hold(), from any thread.
+             * @param unread Bytes passed to on_message again before anything
+             *        received since, e.g. the part the held call did not consume.
+             */
+            void release(ouc_server::ouc_socket::TCPSocket &client, std::string &&unread = {});
+
+            /**
+             * @brief Run a callback once send() to this client would not block.
+             *
+             * It runs on the loop's pool, soon if the outbox is less than
+             * half full, otherwise once it drained that far or the client
+             * closed. A later call replaces a callback still waiting.
+             *
+             * @return false if the client is gone, the callback never runs.
+             */
+            bool notify_writable(ouc_server::ouc_socket::TCPSocket &client, std::function<void()> &&callback);
+
+            /**
+             * @brief Close a client once everything queued for it has been sent.
+             * @param client Connection to close.
+             */
+            void close_after_flush(ouc_server::ouc_socket::TCPSocket &client);
+
+            const TCPServerMetrics &get_metrics() const noexcept { return metrics; }
+
+            /// Loop driving the connections, shared with outbound clients (client::TCPClient).
+            ouc_server::epoll::EpollLoop &get_loop() noexcept { return epoll_loop; }
+
+            /**
+             * @brief Append all server, event loop and thread pool metrics in Prometheus text format.
+             * @param out Buffer to append to.
+             */
+            void write_metrics(std::string &out);
+
         private:
+            /**
+             * @brief Track a new client and arm it in the event loop.
+             * @param fd File descriptor of the client.
+             * @param tcp_socket Client socket, handed back if fd is already tracked.
+             * @param peer Client address.
+             * @param client_slot Slot from AdmissionControl::admit(), released on failure.
+             * @return true if added successfully.
+             */
+            bool add_connection(int fd, ouc_server::ouc_socket::TCPSocket &&tcp_socket, const sockaddr_storage &peer, int client_slot);
+
+            /**
+             * @brief Register the listening socket with the event loop.
+             * @return true on success.
+             */
+            bool watch_listener();
+
             /**
              * @brief Handle a new client connection.
              */
@@ -146,6 +649,102 @@ namespace ouc_server
              * @param fd File descriptor of the client.
              */
             void handle_client_event(int);
+
+            /**
+             * @brief Advance a pending TLS handshake, its read_mtx must be held.
+             * @param conn Connection still negotiating.
+             * @return false if the handshake failed.
+             */
+            bool advance_handshake(Connection &conn);
+
+            /**
+             * @brief Deliver queued chunks of a connection to on_message in order.
+             * @param conn Connection whose inbox is drained.
+             */
+            void drain_messages(const std::shared_ptr<Connection> &conn);
+
+            /**
+             * @brief Close connections with no buffered input or output that IdleCheck approves.
+             */
+            void close_idle_connections();
+
+            /**
+             * @brief Look up a tracked connection.
+             * @param fd File descriptor of the client.
+             * @return The connection, or nullptr if it is not tracked.
+             */
+            std::shared_ptr<Connection> find_connection(int fd);
+
+            /**
+             * @brief Write queued output until it is empty or the socket would block.
+             *
+             * Consecutive chunks go out together in one sendmsg(), so a
+             * backlog of small fan-out messages costs one system call.
+             *
+             * @param conn Connection to flush, its mtx must be held.
+             * @return false on a write error.
+             */
+            bool flush(Connection &conn);
+
+            /**
+             * @brief Append output to a connection, waiting while its outbox is full.
+             * @param client Connection to send to.
+             * @param chunk Output to queue.
+             * @param more See send().
+             * @return false if the connection is gone.
+             */
+            bool enqueue(ouc_server::ouc_socket::TCPSocket &client, OutChunk &&chunk, bool more);
+
+            /**
+             * @brief Queue fan-out output without blocking, applying the policy to a laggard.
+             * @param conn Connection to queue on.
+             * @param data Bytes to send.
+             * @param policy See SlowConsumerPolicy.
+             * @param stream Fan-out stream, what coalescing replaces within.
+             * @return true if queued or coalesced.
+             */
+            bool deliver(Connection &conn, const SharedBuffer &data, SlowConsumerPolicy policy, uint64_t stream);
+
+            /**
+             * @brief Drop a connection from a topic, topics_mtx must be held.
+             * @return false if it was not subscribed.
+             */
+            bool remove_subscriber(const std::string &topic, const Connection *conn);
+
+            /**
+             * @brief flush() for TLS connections encrypted in user space.
+             * @param conn Connection to flush, its mtx must be held.
+             * @return false on a write error.
+             */
+            bool flush_tls(Connection &conn);
+
+            /**
+             * @brief Wake producers waiting for room in the outbox, its mtx must be held.
+             */
+            void signal_writable(Connection &conn);
+
+            /**
+             * @brief Re-arm reading after a pause.
+             * @param conn Connection to resume, its mtx must be held.
+             */
+            void resume_reading(Connection &conn);
+
+            /**
+             * @brief Release output buffers whose zero-copy sends have completed.
+             * @param conn Connection to check, its mtx must be held.
+             */
+            void reap_zerocopy(Connection &conn);
+
+            /**
+             * @brief Re-arm the one-shot notification of a connection.
+             *
+             * Asks for EPOLLIN unless reading is paused and for EPOLLOUT while
+             * output or a TLS handshake write is pending; leaves the fd
+             * disarmed if neither applies.
+             *
+             * @param conn Connection to re-arm, its mtx must be held.
+             */
+            void update_interest(Connection &conn);
         };
     }
 }
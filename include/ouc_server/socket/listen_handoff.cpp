@@ -0,0 +1,215 @@
+#include <socket/listen_handoff.hpp>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/stat.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+namespace ouc_server
+{
+    namespace ouc_socket
+    {
+        namespace
+        {
+            bool make_address(const std::string &path, sockaddr_un &addr)
+            {
+                if (path.size() >= sizeof(addr.sun_path))
+                    return false;
+
+                std::memset(&addr, 0, sizeof(addr));
+                addr.sun_family = AF_UNIX;
+                std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+                return true;
+            }
+
+            /// Milliseconds left until deadline for poll(), -1 when there is none.
+            int remaining_ms(bool has_deadline, std::chrono::steady_clock::time_point deadline)
+            {
+                if (!has_deadline)
+                    return -1;
+                auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+                return left.count() > 0 ? static_cast<int>(left.count()) : 0;
+            }
+
+            /// Whether the process at the other end runs as our effective user.
+            bool is_same_user(int peer)
+            {
+                ucred cred{};
+                socklen_t len = sizeof(cred);
+                if (getsockopt(peer, SOL_SOCKET, SO_PEERCRED, &cred, &len) != 0)
+                    return false;
+                return cred.uid == geteuid();
+            }
+
+            /// Prepare an inherited listener for this process's event loop.
+            void adopt(int fd)
+            {
+                fcntl(fd, F_SETFD, FD_CLOEXEC);
+                fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+            }
+        }
+
+        std::vector<TCPSocket> listen_fds_from_env()
+        {
+            std::vector<TCPSocket> sockets;
+
+            const char *pid = std::getenv("LISTEN_PID");
+            const char *fds = std::getenv("LISTEN_FDS");
+            if (pid == nullptr || fds == nullptr || std::strtol(pid, nullptr, 10) != getpid())
+                return sockets;
+
+            long count = std::strtol(fds, nullptr, 10);
+            for (long i = 0; i < count; ++i)
+            {
+                int fd = LISTEN_FDS_START + static_cast<int>(i);
+                adopt(fd);
+                sockets.emplace_back(fd);
+            }
+
+            unsetenv("LISTEN_PID");
+            unsetenv("LISTEN_FDS");
+            unsetenv("LISTEN_FDNAMES");
+            return sockets;
+        }
+
+        bool send_listener(const std::string &path, int fd, int timeout_ms)
+        {
+            sockaddr_un addr;
+            if (fd < 0 || !make_address(path, addr))
+                return false;
+
+            int server = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+            if (server < 0)
+            {
+                perror("socket");
+                return false;
+            }
+
+            ::unlink(path.c_str());
+            if (::bind(server, (sockaddr *)&addr, sizeof(addr)) != 0 || ::listen(server, 1) != 0)
+            {
+                perror("bind");
+                ::close(server);
+                return false;
+            }
+            ::chmod(path.c_str(), 0600);
+
+            bool has_deadline = timeout_ms >= 0;
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(std::max(timeout_ms, 0));
+
+            bool sent = false;
+            pollfd pfd{server, POLLIN, 0};
+            while (::poll(&pfd, 1, remaining_ms(has_deadline, deadline)) == 1)
+            {
+                int peer = ::accept4(server, nullptr, nullptr, SOCK_CLOEXEC);
+                if (peer < 0)
+                    continue;
+
+                // The listener is only for our own successor, not any local user
+                if (!is_same_user(peer))
+                {
+                    fprintf(stderr, "send_listener: refused a peer running as another user\n");
+                    ::close(peer);
+                    continue;
+                }
+
+                // One byte of payload carries the descriptor
+                char byte = 'L';
+                iovec iov{&byte, 1};
+                alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))] = {};
+
+                msghdr msg{};
+                msg.msg_iov = &iov;
+                msg.msg_iovlen = 1;
+                msg.msg_control = control;
+                msg.msg_controllen = sizeof(control);
+
+                cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+                cmsg->cmsg_level = SOL_SOCKET;
+                cmsg->cmsg_type = SCM_RIGHTS;
+                cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+                std::memcpy(CMSG_DATA(cmsg), &fd, sizeof(int));
+
+                if (::sendmsg(peer, &msg, MSG_NOSIGNAL) == 1)
+                {
+                    // Wait for the successor to acknowledge it owns the socket,
+                    // a successor that never does must not hang us
+                    char ack;
+                    pollfd ack_pfd{peer, POLLIN, 0};
+                    sent = ::poll(&ack_pfd, 1, remaining_ms(has_deadline, deadline)) == 1 &&
+                           ::recv(peer, &ack, 1, MSG_DONTWAIT) == 1;
+                }
+                ::close(peer);
+
+                // The fd has been offered: do not wait for another peer
+                break;
+            }
+
+            ::close(server);
+            ::unlink(path.c_str());
+            return sent;
+        }
+
+        TCPSocket receive_listener(const std::string &path, int timeout_ms)
+        {
+            sockaddr_un addr;
+            if (!make_address(path, addr))
+                return TCPSocket();
+
+            // The old process may not be waiting yet: retry until the deadline
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+            int conn = -1;
+            while (true)
+            {
+                conn = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+                if (conn < 0)
+                    return TCPSocket();
+                if (::connect(conn, (sockaddr *)&addr, sizeof(addr)) == 0)
+                    break;
+
+                ::close(conn);
+                conn = -1;
+                if (std::chrono::steady_clock::now() >= deadline)
+                    return TCPSocket();
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+
+            char byte;
+            iovec iov{&byte, 1};
+            alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))] = {};
+
+            msghdr msg{};
+            msg.msg_iov = &iov;
+            msg.msg_iovlen = 1;
+            msg.msg_control = control;
+            msg.msg_controllen = sizeof(control);
+
+            int fd = -1;
+            if (::recvmsg(conn, &msg, MSG_CMSG_CLOEXEC) == 1)
+            {
+                cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+                if (cmsg != nullptr && cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS)
+                    std::memcpy(&fd, CMSG_DATA(cmsg), sizeof(int));
+            }
+
+            if (fd >= 0)
+            {
+                adopt(fd);
+                char ack = 'A';
+                ::send(conn, &ack, 1, MSG_NOSIGNAL);
+            }
+
+            ::close(conn);
+            return TCPSocket(fd);
+        }
+    }
+}
@@ -0,0 +1,74 @@
+/**
+ * @file listen_handoff.hpp
+ * @brief Pass listening sockets between processes for zero-downtime restarts.
+ *
+ * Two ways for a new process to get its listening socket without binding:
+ * - From the service manager, systemd-style: `LISTEN_PID` / `LISTEN_FDS`
+ *   describe descriptors inherited starting at fd 3.
+ * - From the running process over a Unix socket with `SCM_RIGHTS`: the old
+ *   process waits in send_listener(), the new one calls receive_listener().
+ *
+ * Both processes then share one accept queue, so the old one can stop
+ * accepting and drain while the new one already serves: no connection is
+ * refused in between.
+ *
+ * Example, new process:
+ * @code
+ * auto inherited = listen_fds_from_env();
+ * TCPSocket listener = inherited.empty() ? receive_listener("/run/app.sock", 5000) : std::move(inherited[0]);
+ * if (listener.get_fd() >= 0) server.start(std::move(listener));
+ * else server.start("0.0.0.0", 8080);
+ * @endcode
+ */
+
+#ifndef INCLUDE_OUC_SERVER_LISTEN_HANDOFF
+#define INCLUDE_OUC_SERVER_LISTEN_HANDOFF
+
+#include <string>
+#include <vector>
+
+#include <socket/tcp_socket.hpp>
+
+namespace ouc_server
+{
+    namespace ouc_socket
+    {
+        /// First descriptor passed by the service manager.
+        constexpr int LISTEN_FDS_START = 3;
+
+        /**
+         * @brief Take the sockets passed through LISTEN_PID / LISTEN_FDS.
+         *
+         * Ignored unless LISTEN_PID names this process. The variables are
+         * removed so child processes do not claim the sockets again.
+         *
+         * @return The inherited sockets, empty if there are none.
+         */
+        std::vector<TCPSocket> listen_fds_from_env();
+
+        /**
+         * @brief Wait for a successor on a Unix socket and pass it a listening fd.
+         *
+         * The fd stays open in this process; stop accepting on it afterwards.
+         * The Unix socket is created with mode 0600 and peers running as
+         * another user are refused, so only our own successor gets the fd.
+         *
+         * @param path Filesystem path of the Unix socket, replaced if present.
+         * @param fd Listening socket to share.
+         * @param timeout_ms Longest wait for the successor to connect and
+         *        acknowledge, -1 for no limit.
+         * @return true once the successor has received the fd.
+         */
+        bool send_listener(const std::string &path, int fd, int timeout_ms);
+
+        /**
+         * @brief Fetch a listening socket from a process waiting in send_listener().
+         * @param path Filesystem path of the Unix socket.
+         * @param timeout_ms Keep retrying the connection this long.
+         * @return The socket, invalid (fd -1) on failure.
+         */
+        TCPSocket receive_listener(const std::string &path, int timeout_ms);
+    }
+}
+
+#endif // INCLUDE_OUC_SERVER_LISTEN_HANDOFF
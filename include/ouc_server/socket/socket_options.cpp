@@ -0,0 +1,55 @@
+#include <socket/socket_options.hpp>
+
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+namespace ouc_server
+{
+    namespace ouc_socket
+    {
+        namespace
+        {
+            bool set_int(int fd, int level, int name, int value)
+            {
+                return setsockopt(fd, level, name, &value, sizeof(value)) == 0;
+            }
+        }
+
+        bool SocketOptions::apply(int fd) const
+        {
+            bool ok = true;
+
+            if (sndbuf)
+                ok &= set_int(fd, SOL_SOCKET, SO_SNDBUF, *sndbuf);
+            if (rcvbuf)
+                ok &= set_int(fd, SOL_SOCKET, SO_RCVBUF, *rcvbuf);
+            if (busy_poll_us)
+                ok &= set_int(fd, SOL_SOCKET, SO_BUSY_POLL, *busy_poll_us);
+
+            // Everything below is TCP only
+            int domain = 0;
+            socklen_t len = sizeof(domain);
+            if (getsockopt(fd, SOL_SOCKET, SO_DOMAIN, &domain, &len) != 0)
+                return false;
+            if (domain != AF_INET && domain != AF_INET6)
+                return ok;
+
+            if (nodelay)
+                ok &= set_int(fd, IPPROTO_TCP, TCP_NODELAY, *nodelay);
+            if (quickack)
+                ok &= set_int(fd, IPPROTO_TCP, TCP_QUICKACK, *quickack);
+            if (lowat)
+                ok &= set_int(fd, IPPROTO_TCP, TCP_NOTSENT_LOWAT, *lowat);
+            if (keepalive_params)
+            {
+                ok &= set_int(fd, SOL_SOCKET, SO_KEEPALIVE, 1);
+                ok &= set_int(fd, IPPROTO_TCP, TCP_KEEPIDLE, keepalive_params->idle_s);
+                ok &= set_int(fd, IPPROTO_TCP, TCP_KEEPINTVL, keepalive_params->interval_s);
+                ok &= set_int(fd, IPPROTO_TCP, TCP_KEEPCNT, keepalive_params->count);
+            }
+
+            return ok;
+        }
+    }
+}
@@ -0,0 +1,101 @@
+/**
+ * @file socket_options.hpp
+ * @brief Builder for per-connection socket options.
+ *
+ * Only the options that were set are applied; TCP-level ones are skipped
+ * on Unix-domain sockets, so one set of options serves every listener.
+ *
+ * Example:
+ * @code
+ * server.set_socket_options(SocketOptions().tcp_nodelay().send_buffer(256 * 1024).keepalive(60, 10, 5));
+ * @endcode
+ */
+
+#ifndef INCLUDE_OUC_SERVER_SOCKET_OPTIONS
+#define INCLUDE_OUC_SERVER_SOCKET_OPTIONS
+
+#include <optional>
+
+namespace ouc_server
+{
+    namespace ouc_socket
+    {
+        class SocketOptions
+        {
+        private:
+            struct KeepAlive
+            {
+                int idle_s;
+                int interval_s;
+                int count;
+            };
+
+            std::optional<bool> nodelay;
+            std::optional<bool> quickack;
+            std::optional<int> sndbuf;
+            std::optional<int> rcvbuf;
+            std::optional<int> lowat;
+            std::optional<int> busy_poll_us;
+            std::optional<KeepAlive> keepalive_params;
+
+        public:
+            /// TCP_NODELAY: send small writes right away instead of coalescing them.
+            SocketOptions &tcp_nodelay(bool on = true)
+            {
+                nodelay = on;
+                return *this;
+            }
+
+            /// TCP_QUICKACK: acknowledge at once; the kernel may fall back to delayed ACKs later.
+            SocketOptions &tcp_quickack(bool on = true)
+            {
+                quickack = on;
+                return *this;
+            }
+
+            /// SO_SNDBUF in bytes, the kernel doubles it for bookkeeping.
+            SocketOptions &send_buffer(int bytes)
+            {
+                sndbuf = bytes;
+                return *this;
+            }
+
+            /// SO_RCVBUF in bytes, the kernel doubles it for bookkeeping.
+            SocketOptions &recv_buffer(int bytes)
+            {
+                rcvbuf = bytes;
+                return *this;
+            }
+
+            /// TCP_NOTSENT_LOWAT: report writable only while fewer unsent bytes are queued.
+            SocketOptions &notsent_lowat(int bytes)
+            {
+                lowat = bytes;
+                return *this;
+            }
+
+            /// SO_BUSY_POLL: busy-poll the device queue on blocking reads.
+            SocketOptions &busy_poll(int usec)
+            {
+                busy_poll_us = usec;
+                return *this;
+            }
+
+            /// SO_KEEPALIVE with TCP_KEEPIDLE, TCP_KEEPINTVL and TCP_KEEPCNT.
+            SocketOptions &keepalive(int idle_s, int interval_s, int count)
+            {
+                keepalive_params = KeepAlive{idle_s, interval_s, count};
+                return *this;
+            }
+
+            /**
+             * @brief Set the configured options on a socket.
+             * @param fd Socket to configure.
+             * @return false if any option was rejected, the others are still applied.
+             */
+            bool apply(int fd) const;
+        };
+    }
+}
+
+#endif // INCLUDE_OUC_SERVER_SOCKET_OPTIONS
@@ -1,9 +1,15 @@
 #include <socket/tcp_socket.hpp>
 
 #include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/stat.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <linux/errqueue.h>
 #include <arpa/inet.h>
 #include <unistd.h>
+#include <cstring>
+#include <cerrno>
 
 namespace ouc_server
 {
@@ -33,45 +39,199 @@ namespace ouc_server
             return *this;
         }
 
-        TCPSocket TCPSocket::create()
+        TCPSocket TCPSocket::create(int family)
         {
-            int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+            int fd = socket(family, SOCK_STREAM | SOCK_NONBLOCK, 0);
             if (fd < 0)
+            {
                 perror("socket");
+                return TCPSocket();
+            }
 
-            int opt = 1;
-            setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+            if (family != AF_UNIX)
+            {
+                int opt = 1;
+                setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+            }
             return TCPSocket(fd);
         }
 
+        int TCPSocket::family_of(const std::string &address)
+        {
+            if (address.rfind("unix:", 0) == 0 || (!address.empty() && address[0] == '/'))
+                return AF_UNIX;
+            if (address.find(':') != std::string::npos)
+                return AF_INET6;
+            return AF_INET;
+        }
+
+        std::string TCPSocket::format_address(const sockaddr_storage &addr)
+        {
+            char buf[INET6_ADDRSTRLEN];
+            const void *src;
+            if (addr.ss_family == AF_INET)
+                src = &reinterpret_cast<const sockaddr_in &>(addr).sin_addr;
+            else if (addr.ss_family == AF_INET6)
+                src = &reinterpret_cast<const sockaddr_in6 &>(addr).sin6_addr;
+            else
+                return "";
+
+            if (inet_ntop(addr.ss_family, src, buf, sizeof(buf)) == nullptr)
+                return "";
+            return buf;
+        }
+
+        namespace
+        {
+            /// Fill addr from a numeric IPv4 or IPv6 address ("[::1]" accepted), 0 length if invalid.
+            socklen_t make_inet_address(int family, const std::string &ip, uint16_t port, sockaddr_storage &addr)
+            {
+                std::memset(&addr, 0, sizeof(addr));
+                if (family == AF_INET6)
+                {
+                    std::string host = ip;
+                    if (host.size() >= 2 && host.front() == '[' && host.back() == ']')
+                        host = host.substr(1, host.size() - 2);
+
+                    auto &in6 = reinterpret_cast<sockaddr_in6 &>(addr);
+                    in6.sin6_family = AF_INET6;
+                    in6.sin6_port = htons(port);
+                    if (inet_pton(AF_INET6, host.c_str(), &in6.sin6_addr) != 1)
+                        return 0;
+                    return sizeof(sockaddr_in6);
+                }
+
+                auto &in = reinterpret_cast<sockaddr_in &>(addr);
+                in.sin_family = AF_INET;
+                in.sin_port = htons(port);
+                if (inet_pton(AF_INET, ip.c_str(), &in.sin_addr) != 1)
+                    return 0;
+                return sizeof(sockaddr_in);
+            }
+
+            int domain_of(int fd)
+            {
+                int domain = AF_INET;
+                socklen_t len = sizeof(domain);
+                getsockopt(fd, SOL_SOCKET, SO_DOMAIN, &domain, &len);
+                return domain;
+            }
+        }
+
         bool TCPSocket::bind(const std::string &ip, uint16_t port)
         {
-            sockaddr_in addr{};
-            addr.sin_family = AF_INET;
-            addr.sin_port = htons(port);
-            if (inet_pton(AF_INET, ip.c_str(), &addr.sin_addr) != 1)
+            sockaddr_storage addr;
+            socklen_t len = make_inet_address(domain_of(listen_fd), ip, port, addr);
+            if (len == 0)
                 return false;
+            return ::bind(listen_fd, (sockaddr *)&addr, len) == 0;
+        }
+
+        bool TCPSocket::connect(const std::string &ip, uint16_t port)
+        {
+            sockaddr_storage addr;
+            socklen_t len = make_inet_address(domain_of(listen_fd), ip, port, addr);
+            if (len == 0)
+            {
+                errno = EINVAL;
+                return false;
+            }
+
+            // Interrupted, the connect carries on in the background
+            if (::connect(listen_fd, (sockaddr *)&addr, len) != 0)
+                return errno == EINPROGRESS || errno == EINTR;
+            return true;
+        }
+
+        int TCPSocket::get_error() const
+        {
+            int err = 0;
+            socklen_t len = sizeof(err);
+            if (getsockopt(listen_fd, SOL_SOCKET, SO_ERROR, &err, &len) != 0)
+                return errno;
+            return err;
+        }
+
+        bool TCPSocket::bind_unix(const std::string &path)
+        {
+            std::string file = path.rfind("unix:", 0) == 0 ? path.substr(5) : path;
+
+            sockaddr_un addr{};
+            if (file.empty() || file.size() >= sizeof(addr.sun_path))
+                return false;
+            addr.sun_family = AF_UNIX;
+            std::memcpy(addr.sun_path, file.c_str(), file.size() + 1);
+
+            // A previous run leaves its socket file behind, bind fails on it.
+            // Never remove anything that is not a socket.
+            struct stat st;
+            if (::stat(file.c_str(), &st) == 0 && S_ISSOCK(st.st_mode))
+                ::unlink(file.c_str());
             return ::bind(listen_fd, (sockaddr *)&addr, sizeof(addr)) == 0;
         }
 
         bool TCPSocket::listen(int backlog) { return ::listen(listen_fd, backlog) == 0; }
 
-        TCPSocket TCPSocket::accept()
+        TCPSocket TCPSocket::accept(sockaddr_storage *peer)
         {
-            int client_fd = ::accept4(listen_fd, nullptr, nullptr, SOCK_NONBLOCK);
+            socklen_t len = sizeof(sockaddr_storage);
+            int client_fd = ::accept4(listen_fd, (sockaddr *)peer, peer ? &len : nullptr, SOCK_NONBLOCK);
             if (client_fd < 0)
                 return TCPSocket();
             return TCPSocket(client_fd);
         }
 
-        bool TCPSocket::close() { return ::close(listen_fd) == 0; }
+        bool TCPSocket::shutdown() { return ::shutdown(listen_fd, SHUT_RDWR) == 0; }
+
+        bool TCPSocket::set_busy_poll(int usec)
+        {
+            return setsockopt(listen_fd, SOL_SOCKET, SO_BUSY_POLL, &usec, sizeof(usec)) == 0;
+        }
 
-        ssize_t TCPSocket::send(const char *buf, size_t len)
+        bool TCPSocket::set_incoming_cpu(int cpu)
+        {
+            return setsockopt(listen_fd, SOL_SOCKET, SO_INCOMING_CPU, &cpu, sizeof(cpu)) == 0;
+        }
+
+        int TCPSocket::get_incoming_cpu() const
+        {
+            int cpu = -1;
+            socklen_t len = sizeof(cpu);
+            if (getsockopt(listen_fd, SOL_SOCKET, SO_INCOMING_CPU, &cpu, &len) != 0)
+                return -1;
+            return cpu;
+        }
+
+        bool TCPSocket::close()
+        {
+            if (listen_fd < 0)
+                return false;
+
+            // Forget the fd before closing so a stale copy can never touch
+            // a descriptor number the kernel has already handed out again.
+            int fd = listen_fd;
+            listen_fd = -1;
+            return ::close(fd) == 0;
+        }
+
+        bool TCPSocket::set_cork(bool on)
+        {
+            int opt = on;
+            return setsockopt(listen_fd, IPPROTO_TCP, TCP_CORK, &opt, sizeof(opt)) == 0;
+        }
+
+        bool TCPSocket::set_zerocopy(bool on)
+        {
+            int opt = on;
+            return setsockopt(listen_fd, SOL_SOCKET, SO_ZEROCOPY, &opt, sizeof(opt)) == 0;
+        }
+
+        ssize_t TCPSocket::send(const char *buf, size_t len, int flags)
         {
             size_t sent = 0;
             while (sent < len)
             {
-                ssize_t n = ::send(listen_fd, buf + sent, len - sent, 0);
+                ssize_t n = ::send(listen_fd, buf + sent, len - sent, flags | MSG_NOSIGNAL);
                 if (n < 0)
                 {
                     if (errno == EINTR)
@@ -88,9 +248,79 @@ namespace ouc_server
             return sent;
         }
 
-        ssize_t TCPSocket::send(const char *buf) { return this->send(buf, sizeof(buf)); }
+        ssize_t TCPSocket::send(const char *buf) { return this->send(buf, std::strlen(buf)); }
+
+        ssize_t TCPSocket::send(const std::string &str) { return this->send(str.data(), str.size()); }
+
+        ssize_t TCPSocket::sendv(const iovec *iov, int count, int flags)
+        {
+            msghdr msg{};
+            msg.msg_iov = const_cast<iovec *>(iov);
+            msg.msg_iovlen = count;
+
+            // A single call: the caller advances through the buffers itself
+            while (true)
+            {
+                ssize_t n = ::sendmsg(listen_fd, &msg, flags | MSG_NOSIGNAL);
+                if (n >= 0)
+                    return n;
+                if (errno == EINTR)
+                    continue;
+                if (errno == EAGAIN || errno == EWOULDBLOCK)
+                    return 0;
+                return -1;
+            }
+        }
+
+        ssize_t TCPSocket::send_zerocopy(const char *buf, size_t len, int flags)
+        {
+            // A single call: every successful one consumes a completion number
+            while (true)
+            {
+                ssize_t n = ::send(listen_fd, buf, len, flags | MSG_ZEROCOPY | MSG_NOSIGNAL);
+                if (n >= 0)
+                    return n;
+                if (errno == EINTR)
+                    continue;
+                // ENOBUFS: out of optmem for notifications, same as a full buffer
+                if (errno == EAGAIN || errno == EWOULDBLOCK || errno == ENOBUFS)
+                    return 0;
+                return -1;
+            }
+        }
+
+        size_t TCPSocket::read_zerocopy_completions(const std::function<void(uint32_t, uint32_t, bool)> &on_range)
+        {
+            size_t count = 0;
+            while (true)
+            {
+                alignas(cmsghdr) char control[CMSG_SPACE(sizeof(sock_extended_err)) + 64];
+                msghdr msg{};
+                msg.msg_control = control;
+                msg.msg_controllen = sizeof(control);
 
-        ssize_t TCPSocket::send(const std::string &str) { return this->send(str.c_str()); }
+                if (::recvmsg(listen_fd, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) < 0)
+                    break;
+
+                for (cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr; cmsg = CMSG_NXTHDR(&msg, cmsg))
+                {
+                    bool is_recverr = (cmsg->cmsg_level == SOL_IP && cmsg->cmsg_type == IP_RECVERR) ||
+                                      (cmsg->cmsg_level == SOL_IPV6 && cmsg->cmsg_type == IPV6_RECVERR);
+                    if (!is_recverr)
+                        continue;
+
+                    sock_extended_err err;
+                    std::memcpy(&err, CMSG_DATA(cmsg), sizeof(err));
+                    if (err.ee_errno != 0 || err.ee_origin != SO_EE_ORIGIN_ZEROCOPY)
+                        continue;
+
+                    // ee_info..ee_data is the range of finished sends
+                    on_range(err.ee_info, err.ee_data, (err.ee_code & SO_EE_CODE_ZEROCOPY_COPIED) != 0);
+                    ++count;
+                }
+            }
+            return count;
+        }
 
         ssize_t TCPSocket::recv(void *buf, size_t len) { return ::recv(listen_fd, buf, len, 0); }
     }
@@ -3,6 +3,10 @@
 
 #include <cstdint>
 #include <string>
+#include <functional>
+
+#include <sys/socket.h>
+#include <sys/uio.h>
 
 namespace ouc_server
 {
@@ -22,21 +26,108 @@ namespace ouc_server
             TCPSocket(TCPSocket &&);
             TCPSocket &operator=(TCPSocket &&);
 
-            static TCPSocket create();
+            /**
+             * @brief Open a non-blocking stream socket.
+             * @param family AF_INET, AF_INET6 or AF_UNIX.
+             */
+            static TCPSocket create(int family = AF_INET);
+
+            /**
+             * @brief Address family a listen address asks for.
+             *
+             * "unix:/path" or "/path" is a Unix-domain socket, an address
+             * containing ':' is IPv6, anything else IPv4.
+             */
+            static int family_of(const std::string &address);
+
+            /// Text form of an IPv4 or IPv6 address, empty for other families.
+            static std::string format_address(const sockaddr_storage &addr);
 
         public:
             int get_fd() const { return listen_fd; }
 
+            /// Bind to an IPv4 or IPv6 address, matching the socket's family.
             bool bind(const std::string &, uint16_t);
+
+            /// Bind to a filesystem path, replacing a stale socket file left there.
+            bool bind_unix(const std::string &path);
+
             bool listen(int = 128);
-            TCPSocket accept();
+
+            /**
+             * @brief Start connecting a non-blocking socket to an IPv4 or IPv6 address.
+             *
+             * Completion is signalled by the socket becoming writable,
+             * get_error() then tells whether it succeeded.
+             *
+             * @return true if connected or in progress.
+             */
+            bool connect(const std::string &ip, uint16_t port);
+
+            /// Pending SO_ERROR, e.g. the outcome of a connect, 0 if none.
+            int get_error() const;
+            /// Accept a connection, storing the client address in peer if given.
+            TCPSocket accept(sockaddr_storage *peer = nullptr);
+            bool shutdown();
             bool close();
 
         public:
-            ssize_t send(const char *, size_t);
+            /// SO_BUSY_POLL: let blocking reads busy-poll the device queue for usec.
+            bool set_busy_poll(int usec);
+
+            /// SO_INCOMING_CPU: prefer this socket for flows received on cpu.
+            bool set_incoming_cpu(int cpu);
+
+            /// CPU the last packet of this socket was processed on, -1 if unknown.
+            int get_incoming_cpu() const;
+
+            /// TCP_CORK: hold partial segments back until uncorked or 200 ms pass.
+            bool set_cork(bool on);
+
+            /// SO_ZEROCOPY: allow send_zerocopy() on this socket.
+            bool set_zerocopy(bool on);
+
+        public:
+            /**
+             * @brief Write as much as the socket takes without blocking.
+             * @param flags Extra send() flags, e.g. MSG_MORE when more data follows right away.
+             * @return Bytes written, -1 on error.
+             */
+            ssize_t send(const char *, size_t, int flags = 0);
+
+            /// Send a NUL-terminated string.
             ssize_t send(const char *);
             ssize_t send(const std::string &);
 
+            /**
+             * @brief Gather several buffers into one sendmsg() call.
+             * @param iov Buffers in order.
+             * @param count Number of buffers, at most IOV_MAX.
+             * @param flags Extra send() flags.
+             * @return Bytes written, 0 if the socket is full, -1 on error.
+             */
+            ssize_t sendv(const iovec *iov, int count, int flags = 0);
+
+            /**
+             * @brief One send() with MSG_ZEROCOPY: the kernel reads the pages in place.
+             *
+             * Each call that returns > 0 is numbered, starting at 0, and
+             * the buffer must stay untouched until read_zerocopy_completions()
+             * reports that number. Needs set_zerocopy(true) first.
+             *
+             * @param flags Extra send() flags.
+             * @return Bytes written, -1 on error.
+             */
+            ssize_t send_zerocopy(const char *, size_t, int flags = 0);
+
+            /**
+             * @brief Read finished MSG_ZEROCOPY sends from the error queue.
+             * @param on_range Called with each completed, inclusive range of
+             *        send numbers, and whether the kernel copied the data anyway.
+             * @return Notifications read.
+             */
+            size_t read_zerocopy_completions(const std::function<void(uint32_t, uint32_t, bool)> &on_range);
+
             ssize_t recv(void *, size_t);
         };
     }
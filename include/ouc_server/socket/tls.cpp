@@ -0,0 +1,246 @@
+#include <socket/tls.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstdio>
+
+#ifdef OUC_SERVER_TLS
+#include <openssl/ssl.h>
+#include <openssl/err.h>
+#include <openssl/bio.h>
+#endif
+
+namespace ouc_server
+{
+    namespace ouc_socket
+    {
+#ifdef OUC_SERVER_TLS
+        std::shared_ptr<TLSContext> TLSContext::create(const std::string &cert_file, const std::string &key_file, bool ktls)
+        {
+            SSL_CTX *ctx = SSL_CTX_new(TLS_server_method());
+            if (ctx == nullptr)
+            {
+                ERR_print_errors_fp(stderr);
+                return nullptr;
+            }
+
+            SSL_CTX_set_min_proto_version(ctx, TLS1_2_VERSION);
+
+            // A peer closing without close_notify reads as a plain EOF
+            uint64_t options = SSL_OP_NO_RENEGOTIATION | SSL_OP_IGNORE_UNEXPECTED_EOF;
+            if (ktls)
+                options |= SSL_OP_ENABLE_KTLS;
+            SSL_CTX_set_options(ctx, options);
+
+            // Output is written from a queue that may move and be cut anywhere
+            SSL_CTX_set_mode(ctx, SSL_MODE_ENABLE_PARTIAL_WRITE | SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER | SSL_MODE_RELEASE_BUFFERS);
+
+            // Tickets and cached sessions are shared by every connection of the context
+            static const unsigned char session_id_context[] = "ouc_server";
+            SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_SERVER);
+            SSL_CTX_set_session_id_context(ctx, session_id_context, sizeof(session_id_context) - 1);
+
+            if (SSL_CTX_use_certificate_chain_file(ctx, cert_file.c_str()) != 1 ||
+                SSL_CTX_use_PrivateKey_file(ctx, key_file.c_str(), SSL_FILETYPE_PEM) != 1 ||
+                SSL_CTX_check_private_key(ctx) != 1)
+            {
+                ERR_print_errors_fp(stderr);
+                SSL_CTX_free(ctx);
+                return nullptr;
+            }
+
+            return std::shared_ptr<TLSContext>(new TLSContext(ctx));
+        }
+
+        TLSContext::~TLSContext() { SSL_CTX_free(ctx); }
+
+        bool TLSContext::set_ticket_keys(std::string_view keys)
+        {
+            if (keys.size() != TICKET_KEYS_SIZE)
+                return false;
+            return SSL_CTX_set_tlsext_ticket_keys(ctx, const_cast<char *>(keys.data()), static_cast<long>(keys.size())) == 1;
+        }
+
+        std::string TLSContext::get_ticket_keys() const
+        {
+            std::string keys(TICKET_KEYS_SIZE, '\0');
+            if (SSL_CTX_get_tlsext_ticket_keys(ctx, keys.data(), static_cast<long>(keys.size())) != 1)
+                return std::string();
+            return keys;
+        }
+
+        TLSSession::TLSSession(const TLSContext &context, int fd)
+            : ssl(SSL_new(context.native()))
+        {
+            if (ssl != nullptr)
+                SSL_set_fd(ssl, fd);
+        }
+
+        TLSSession::~TLSSession()
+        {
+            if (ssl != nullptr)
+                SSL_free(ssl);
+        }
+
+        int TLSSession::handshake()
+        {
+            std::lock_guard<std::mutex> lk(mtx);
+            if (ssl == nullptr)
+                return -1;
+            if (established)
+                return 1;
+
+            ERR_clear_error();
+            int code = SSL_accept(ssl);
+            if (code == 1)
+            {
+                established = true;
+                want_write = false;
+#ifdef BIO_get_ktls_send
+                ktls_send = BIO_get_ktls_send(SSL_get_wbio(ssl)) == 1;
+                ktls_recv = BIO_get_ktls_recv(SSL_get_rbio(ssl)) == 1;
+#endif
+                return 1;
+            }
+
+            switch (SSL_get_error(ssl, code))
+            {
+            case SSL_ERROR_WANT_READ:
+                want_write = false;
+                return 0;
+            case SSL_ERROR_WANT_WRITE:
+                want_write = true;
+                return 0;
+            default:
+                return -1;
+            }
+        }
+
+        ssize_t TLSSession::read(char *buf, size_t len)
+        {
+            std::lock_guard<std::mutex> lk(mtx);
+            ERR_clear_error();
+            int n = SSL_read(ssl, buf, static_cast<int>(std::min<size_t>(len, INT_MAX)));
+            if (n > 0)
+                return n;
+
+            switch (SSL_get_error(ssl, n))
+            {
+            case SSL_ERROR_ZERO_RETURN:
+                return 0;
+            case SSL_ERROR_WANT_READ:
+            case SSL_ERROR_WANT_WRITE:
+                errno = EAGAIN;
+                return -1;
+            case SSL_ERROR_SYSCALL:
+                if (errno == 0 || errno == EAGAIN)
+                    errno = ECONNRESET;
+                return -1;
+            default:
+                errno = EPROTO;
+                return -1;
+            }
+        }
+
+        ssize_t TLSSession::write(const char *buf, size_t len)
+        {
+            if (len == 0)
+                return 0;
+
+            std::lock_guard<std::mutex> lk(mtx);
+            ERR_clear_error();
+            int n = SSL_write(ssl, buf, static_cast<int>(std::min<size_t>(len, INT_MAX)));
+            if (n > 0)
+                return n;
+
+            switch (SSL_get_error(ssl, n))
+            {
+            case SSL_ERROR_WANT_READ:
+            case SSL_ERROR_WANT_WRITE:
+                return 0;
+            default:
+                return -1;
+            }
+        }
+
+        void TLSSession::shutdown()
+        {
+            std::lock_guard<std::mutex> lk(mtx);
+            if (established)
+            {
+                ERR_clear_error();
+                SSL_shutdown(ssl);
+            }
+        }
+
+        bool TLSSession::is_resumed() const
+        {
+            std::lock_guard<std::mutex> lk(mtx);
+            return established && SSL_session_reused(ssl) == 1;
+        }
+
+        std::string TLSSession::get_version() const
+        {
+            std::lock_guard<std::mutex> lk(mtx);
+            return ssl != nullptr ? SSL_get_version(ssl) : "";
+        }
+#else
+        std::shared_ptr<TLSContext> TLSContext::create(const std::string &, const std::string &, bool)
+        {
+            std::fprintf(stderr, "TLS: built without OpenSSL\n");
+            return nullptr;
+        }
+
+        TLSContext::~TLSContext() {}
+
+        bool TLSContext::set_ticket_keys(std::string_view) { return false; }
+
+        std::string TLSContext::get_ticket_keys() const { return std::string(); }
+
+        TLSSession::TLSSession(const TLSContext &, int) : ssl(nullptr) {}
+
+        TLSSession::~TLSSession() {}
+
+        int TLSSession::handshake() { return -1; }
+
+        ssize_t TLSSession::read(char *, size_t)
+        {
+            errno = EPROTO;
+            return -1;
+        }
+
+        ssize_t TLSSession::write(const char *, size_t) { return -1; }
+
+        void TLSSession::shutdown() {}
+
+        bool TLSSession::is_resumed() const { return false; }
+
+        std::string TLSSession::get_version() const { return std::string(); }
+#endif
+
+        bool TLSSession::is_established() const
+        {
+            std::lock_guard<std::mutex> lk(mtx);
+            return established;
+        }
+
+        bool TLSSession::wants_write() const
+        {
+            std::lock_guard<std::mutex> lk(mtx);
+            return want_write;
+        }
+
+        bool TLSSession::is_ktls_send() const
+        {
+            std::lock_guard<std::mutex> lk(mtx);
+            return ktls_send;
+        }
+
+        bool TLSSession::is_ktls_recv() const
+        {
+            std::lock_guard<std::mutex> lk(mtx);
+            return ktls_recv;
+        }
+    }
+}
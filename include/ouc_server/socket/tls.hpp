@@ -0,0 +1,151 @@
+/**
+ * @file tls.hpp
+ * @brief TLS for accepted sockets, on OpenSSL with kernel TLS offload.
+ *
+ * A TLSContext holds the certificate and the session ticket keys shared by
+ * every connection it serves, so a client resumes its session on any of
+ * them without a full handshake. A TLSSession drives one non-blocking
+ * connection: the handshake and reads go through OpenSSL; once the
+ * handshake is done and the kernel supports it, the record layer is handed
+ * to kTLS and plain send()/sendmsg() on the fd are encrypted by the kernel,
+ * which keeps the gathered-write path of TCPServer for encrypted traffic.
+ *
+ * Built without OpenSSL (OUC_SERVER_TLS undefined), TLSContext::create()
+ * always fails.
+ */
+
+#ifndef INCLUDE_OUC_SERVER_TLS
+#define INCLUDE_OUC_SERVER_TLS
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+#include <sys/types.h>
+
+typedef struct ssl_ctx_st SSL_CTX;
+typedef struct ssl_st SSL;
+
+namespace ouc_server
+{
+    namespace ouc_socket
+    {
+        /**
+         * @class TLSContext
+         * @brief Server certificate, protocol settings and session ticket keys.
+         */
+        class TLSContext
+        {
+        private:
+            SSL_CTX *ctx;
+
+            explicit TLSContext(SSL_CTX *p_ctx) : ctx(p_ctx) {}
+
+        public:
+            /// Size of the ticket key material, see set_ticket_keys().
+            static constexpr size_t TICKET_KEYS_SIZE = 80;
+
+            /**
+             * @brief Load a certificate chain and its private key, both PEM.
+             * @param cert_file Certificate chain file, leaf first.
+             * @param key_file Private key file.
+             * @param ktls Hand the record layer to the kernel where supported.
+             * @return The context, nullptr on failure (reported on stderr).
+             */
+            static std::shared_ptr<TLSContext> create(const std::string &cert_file, const std::string &key_file, bool ktls = true);
+
+            ~TLSContext();
+
+            TLSContext(const TLSContext &) = delete;
+            TLSContext &operator=(const TLSContext &) = delete;
+
+            /**
+             * @brief Replace the keys protecting session tickets.
+             *
+             * Processes given the same keys resume each other's sessions,
+             * e.g. the successor of a hand_off().
+             *
+             * @param keys TICKET_KEYS_SIZE bytes from get_ticket_keys() or a random source.
+             * @return false if the size is wrong or OpenSSL refused them.
+             */
+            bool set_ticket_keys(std::string_view keys);
+
+            /// Current ticket keys, empty on failure.
+            std::string get_ticket_keys() const;
+
+            SSL_CTX *native() const noexcept { return ctx; }
+        };
+
+        /**
+         * @class TLSSession
+         * @brief TLS state of one non-blocking connection.
+         *
+         * Calls are serialized internally, so one thread may read while
+         * another writes.
+         */
+        class TLSSession
+        {
+        private:
+            mutable std::mutex mtx;
+            SSL *ssl;
+            bool established = false;
+            bool want_write = false; ///< Handshake waits for the socket to become writable.
+            bool ktls_send = false;  ///< Kernel encrypts what is written to the fd.
+            bool ktls_recv = false;  ///< Kernel decrypts what is read from the fd.
+
+        public:
+            /**
+             * @param context Shared server context.
+             * @param fd Accepted, non-blocking socket, not owned.
+             */
+            TLSSession(const TLSContext &context, int fd);
+
+            ~TLSSession();
+
+            TLSSession(const TLSSession &) = delete;
+            TLSSession &operator=(const TLSSession &) = delete;
+
+            /**
+             * @brief Advance the server handshake.
+             * @return 1 once established, 0 while waiting for the socket
+             *         (see wants_write()), -1 on failure.
+             */
+            int handshake();
+
+            /**
+             * @brief Read decrypted bytes.
+             * @return Bytes read, 0 once the peer closed, -1 with errno EAGAIN
+             *         when nothing is available, -1 otherwise on error.
+             */
+            ssize_t read(char *buf, size_t len);
+
+            /**
+             * @brief Encrypt and write bytes in user space.
+             * @return Bytes taken, 0 if the socket is full, -1 on error.
+             */
+            ssize_t write(const char *buf, size_t len);
+
+            /// Send close_notify, best effort.
+            void shutdown();
+
+            bool is_established() const;
+
+            bool wants_write() const;
+
+            /// Writes may bypass OpenSSL: plain send() on the fd is encrypted by the kernel.
+            bool is_ktls_send() const;
+
+            bool is_ktls_recv() const;
+
+            /// The handshake resumed an earlier session.
+            bool is_resumed() const;
+
+            /// Negotiated protocol, e.g. "TLSv1.3".
+            std::string get_version() const;
+        };
+    }
+}
+
+#endif // INCLUDE_OUC_SERVER_TLS
@@ -0,0 +1,74 @@
+#ifndef INCLUDE_OUC_SERVER_BUFFER_POOL
+#define INCLUDE_OUC_SERVER_BUFFER_POOL
+
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace ouc_server
+{
+    namespace utils
+    {
+        /**
+         * @class BufferPool
+         * @brief Free list of byte buffers keeping their capacity between uses.
+         *
+         * Assembling messages of similar sizes over and over then stops
+         * reallocating; buffers grown beyond max_capacity are freed rather
+         * than kept, so one huge message does not pin its memory.
+         * Thread-safe.
+         */
+        class BufferPool
+        {
+        private:
+            std::mutex mtx;
+            std::vector<std::string> buffers;
+            size_t max_count;
+            size_t max_capacity;
+
+        public:
+            /**
+             * @param p_max_count Buffers kept at most.
+             * @param p_max_capacity Largest capacity worth keeping.
+             */
+            explicit BufferPool(size_t p_max_count = 64, size_t p_max_capacity = 1 << 20)
+                : max_count(p_max_count), max_capacity(p_max_capacity) {}
+
+            BufferPool(const BufferPool &) = delete;
+            BufferPool &operator=(const BufferPool &) = delete;
+
+            /// An empty buffer, with capacity left from earlier use if any.
+            std::string acquire()
+            {
+                std::lock_guard<std::mutex> lk(mtx);
+                if (buffers.empty())
+                    return std::string();
+
+                std::string buffer = std::move(buffers.back());
+                buffers.pop_back();
+                return buffer;
+            }
+
+            /// Hand a buffer back, its content is discarded.
+            void release(std::string &&buffer)
+            {
+                if (buffer.capacity() > max_capacity)
+                    return;
+
+                buffer.clear();
+                std::lock_guard<std::mutex> lk(mtx);
+                if (buffers.size() < max_count)
+                    buffers.push_back(std::move(buffer));
+            }
+
+            size_t size()
+            {
+                std::lock_guard<std::mutex> lk(mtx);
+                return buffers.size();
+            }
+        };
+    }
+}
+
+#endif // INCLUDE_OUC_SERVER_BUFFER_POOL
@@ -0,0 +1,101 @@
+#include <utils/cpu_affinity.hpp>
+
+#include <sched.h>
+#include <pthread.h>
+#include <dirent.h>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <fstream>
+
+namespace ouc_server
+{
+    namespace utils
+    {
+        std::vector<int> allowed_cpus()
+        {
+            std::vector<int> cpus;
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            if (sched_getaffinity(0, sizeof(set), &set) != 0)
+                return cpus;
+
+            for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+                if (CPU_ISSET(cpu, &set))
+                    cpus.push_back(cpu);
+            return cpus;
+        }
+
+        size_t default_thread_count()
+        {
+            size_t n = allowed_cpus().size();
+            if (n == 0)
+                n = std::thread::hardware_concurrency();
+            return n > 0 ? n : 1;
+        }
+
+        bool pin_current_thread(int cpu)
+        {
+            if (cpu < 0 || cpu >= CPU_SETSIZE)
+                return false;
+
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET(cpu, &set);
+            return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+        }
+
+        int numa_node_of(int cpu)
+        {
+            // The cpu directory holds a nodeN link to its node
+            std::string path = "/sys/devices/system/cpu/cpu" + std::to_string(cpu);
+            DIR *dir = opendir(path.c_str());
+            if (dir == nullptr)
+                return -1;
+
+            int node = -1;
+            while (dirent *entry = readdir(dir))
+            {
+                if (std::strncmp(entry->d_name, "node", 4) == 0 && entry->d_name[4] >= '0' && entry->d_name[4] <= '9')
+                {
+                    node = std::atoi(entry->d_name + 4);
+                    break;
+                }
+            }
+            closedir(dir);
+            return node;
+        }
+
+        std::vector<int> cpus_of_node(int node)
+        {
+            std::vector<int> cpus;
+            std::ifstream file("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+            std::string list;
+            if (!file || !std::getline(file, list))
+                return cpus;
+
+            // Format: "0-3,8-11"
+            std::vector<int> allowed = allowed_cpus();
+            size_t pos = 0;
+            while (pos < list.size())
+            {
+                size_t end = list.find(',', pos);
+                if (end == std::string::npos)
+                    end = list.size();
+
+                std::string range = list.substr(pos, end - pos);
+                size_t dash = range.find('-');
+                int first = std::atoi(range.c_str());
+                int last = dash == std::string::npos ? first : std::atoi(range.c_str() + dash + 1);
+                for (int cpu = first; cpu <= last; ++cpu)
+                    for (int a : allowed)
+                        if (a == cpu)
+                            cpus.push_back(cpu);
+
+                pos = end + 1;
+            }
+            return cpus;
+        }
+    }
+}
@@ -0,0 +1,48 @@
+/**
+ * @file cpu_affinity.hpp
+ * @brief CPU and NUMA placement helpers.
+ *
+ * Memory on Linux is placed on the node of the thread that first touches
+ * it, so a thread pinned before it allocates its buffers gets node-local
+ * memory without an explicit NUMA library.
+ */
+
+#ifndef INCLUDE_OUC_SERVER_CPU_AFFINITY
+#define INCLUDE_OUC_SERVER_CPU_AFFINITY
+
+#include <cstddef>
+#include <vector>
+
+namespace ouc_server
+{
+    namespace utils
+    {
+        /**
+         * @brief CPUs this process may run on, honouring taskset and cgroups.
+         */
+        std::vector<int> allowed_cpus();
+
+        /**
+         * @brief Default thread count: the number of allowed CPUs, at least 1.
+         */
+        size_t default_thread_count();
+
+        /**
+         * @brief Restrict the calling thread to one CPU.
+         * @return false if the CPU is not available.
+         */
+        bool pin_current_thread(int cpu);
+
+        /**
+         * @brief NUMA node a CPU belongs to, -1 if unknown.
+         */
+        int numa_node_of(int cpu);
+
+        /**
+         * @brief Allowed CPUs of a NUMA node, e.g. to keep a server on one socket.
+         */
+        std::vector<int> cpus_of_node(int node);
+    }
+}
+
+#endif // INCLUDE_OUC_SERVER_CPU_AFFINITY
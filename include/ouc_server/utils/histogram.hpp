@@ -0,0 +1,116 @@
+#ifndef INCLUDE_OUC_SERVER_HISTOGRAM
+#define INCLUDE_OUC_SERVER_HISTOGRAM
+
+#include <cstdint>
+#include <cstddef>
+#include <array>
+#include <limits>
+#include <algorithm>
+
+namespace ouc_server
+{
+    namespace utils
+    {
+        /**
+         * @class Histogram
+         * @brief Log-linear histogram of unsigned values, e.g. latencies in ns.
+         *
+         * Every power of two is split into 2^SUB_BUCKET_BITS linear buckets,
+         * which bounds the relative error of a reported percentile to about
+         * 6% over the whole 64-bit range with a fixed 8 KB footprint.
+         * Recording is a couple of shifts and an increment; the class is not
+         * thread-safe, keep one per thread and merge() them when reading.
+         */
+        class Histogram
+        {
+        public:
+            static constexpr unsigned SUB_BUCKET_BITS = 4;
+            static constexpr size_t SUB_BUCKET_COUNT = size_t(1) << SUB_BUCKET_BITS;
+            static constexpr size_t BUCKET_COUNT = (64 - SUB_BUCKET_BITS + 1) * SUB_BUCKET_COUNT;
+
+        private:
+            std::array<uint64_t, BUCKET_COUNT> buckets{};
+            uint64_t total = 0;
+            uint64_t sum = 0;
+            uint64_t min_value = std::numeric_limits<uint64_t>::max();
+            uint64_t max_value = 0;
+
+        public:
+            static size_t bucket_of(uint64_t value) noexcept
+            {
+                if (value < SUB_BUCKET_COUNT)
+                    return static_cast<size_t>(value);
+
+                unsigned msb = 63 - __builtin_clzll(value);
+                unsigned shift = msb - SUB_BUCKET_BITS;
+                size_t sub = static_cast<size_t>(value >> shift) & (SUB_BUCKET_COUNT - 1);
+                return (shift + 1) * SUB_BUCKET_COUNT + sub;
+            }
+
+            /// Largest value falling into a bucket.
+            static uint64_t upper_bound_of(size_t idx) noexcept
+            {
+                if (idx < SUB_BUCKET_COUNT)
+                    return idx;
+
+                unsigned shift = static_cast<unsigned>(idx / SUB_BUCKET_COUNT) - 1;
+                uint64_t low = (SUB_BUCKET_COUNT + idx % SUB_BUCKET_COUNT) << shift;
+                return low + ((uint64_t(1) << shift) - 1);
+            }
+
+        public:
+            void record(uint64_t value) noexcept
+            {
+                ++buckets[bucket_of(value)];
+                ++total;
+                sum += value;
+                min_value = std::min(min_value, value);
+                max_value = std::max(max_value, value);
+            }
+
+            void merge(const Histogram &other) noexcept
+            {
+                for (size_t i = 0; i < BUCKET_COUNT; ++i)
+                    buckets[i] += other.buckets[i];
+                total += other.total;
+                sum += other.sum;
+                min_value = std::min(min_value, other.min_value);
+                max_value = std::max(max_value, other.max_value);
+            }
+
+            void reset() noexcept { *this = Histogram(); }
+
+            /**
+             * @brief Value below which the given share of samples fall.
+             * @param p Percentile in [0, 100].
+             */
+            uint64_t percentile(double p) const noexcept
+            {
+                if (total == 0)
+                    return 0;
+
+                uint64_t rank = static_cast<uint64_t>(p / 100.0 * static_cast<double>(total) + 0.5);
+                rank = std::clamp<uint64_t>(rank, 1, total);
+
+                uint64_t seen = 0;
+                for (size_t i = 0; i < BUCKET_COUNT; ++i)
+                {
+                    seen += buckets[i];
+                    if (seen >= rank)
+                        return std::min(upper_bound_of(i), max_value);
+                }
+                return max_value;
+            }
+
+            uint64_t count() const noexcept { return total; }
+            uint64_t get_sum() const noexcept { return sum; }
+            uint64_t min() const noexcept { return total ? min_value : 0; }
+            uint64_t max() const noexcept { return max_value; }
+            double mean() const noexcept { return total ? static_cast<double>(sum) / total : 0.0; }
+
+            uint64_t bucket_count(size_t idx) const noexcept { return buckets[idx]; }
+        };
+    }
+}
+
+#endif // INCLUDE_OUC_SERVER_HISTOGRAM
@@ -0,0 +1,137 @@
+#include <utils/metrics.hpp>
+
+#include <cstdio>
+#include <cmath>
+
+namespace ouc_server
+{
+    namespace utils
+    {
+        size_t metric_shard() noexcept
+        {
+            static std::atomic<size_t> next{0};
+            thread_local size_t shard = next.fetch_add(1, std::memory_order_relaxed) % METRIC_SHARD_COUNT;
+            return shard;
+        }
+
+        uint64_t MetricHistogram::Snapshot::percentile(double p) const noexcept
+        {
+            if (count == 0)
+                return 0;
+
+            uint64_t rank = static_cast<uint64_t>(p / 100.0 * static_cast<double>(count) + 0.5);
+            if (rank < 1)
+                rank = 1;
+
+            uint64_t seen = 0;
+            for (size_t i = 0; i < BUCKET_COUNT; ++i)
+            {
+                seen += buckets[i];
+                if (seen >= rank)
+                    return upper_bound_of(i);
+            }
+            return upper_bound_of(BUCKET_COUNT - 1);
+        }
+
+        MetricHistogram::Snapshot MetricHistogram::snapshot() const noexcept
+        {
+            Snapshot snap;
+            for (auto &shard : shards)
+            {
+                for (size_t i = 0; i < BUCKET_COUNT; ++i)
+                    snap.buckets[i] += shard.buckets[i].load(std::memory_order_relaxed);
+                snap.sum += shard.sum.load(std::memory_order_relaxed);
+            }
+
+            // Derive the count from the buckets so the exported series
+            // stay consistent with each other under concurrent updates.
+            for (auto n : snap.buckets)
+                snap.count += n;
+            return snap;
+        }
+
+        namespace prometheus
+        {
+            namespace
+            {
+                void append_number(std::string &out, double value)
+                {
+                    // Integers exactly, anything else with enough digits for a bound
+                    char buf[32];
+                    int n = value == std::floor(value) && std::fabs(value) < 1e15
+                                ? std::snprintf(buf, sizeof(buf), "%.0f", value)
+                                : std::snprintf(buf, sizeof(buf), "%.9g", value);
+                    out.append(buf, n);
+                }
+
+                void append_series(std::string &out, std::string_view name, std::string_view suffix,
+                                   std::string_view labels, std::string_view extra_label)
+                {
+                    out.append(name).append(suffix);
+                    if (labels.empty() && extra_label.empty())
+                        return;
+
+                    out.push_back('{');
+                    out.append(labels);
+                    if (!labels.empty() && !extra_label.empty())
+                        out.push_back(',');
+                    out.append(extra_label);
+                    out.push_back('}');
+                }
+            }
+
+            void write_header(std::string &out, std::string_view name, std::string_view type, std::string_view help)
+            {
+                out.append("# HELP ").append(name).append(" ").append(help).append("\n");
+                out.append("# TYPE ").append(name).append(" ").append(type).append("\n");
+            }
+
+            void write_value(std::string &out, std::string_view name, std::string_view labels, double value)
+            {
+                append_series(out, name, "", labels, "");
+                out.push_back(' ');
+                append_number(out, value);
+                out.push_back('\n');
+            }
+
+            void write_histogram(std::string &out, std::string_view name, std::string_view labels,
+                                 const MetricHistogram::Snapshot &snap, double scale,
+                                 size_t first_bucket, size_t last_bucket)
+            {
+                uint64_t cumulative = 0;
+                for (size_t i = 0; i < first_bucket; ++i)
+                    cumulative += snap.buckets[i];
+
+                for (size_t i = first_bucket; i <= last_bucket && i < MetricHistogram::BUCKET_COUNT; ++i)
+                {
+                    cumulative += snap.buckets[i];
+
+                    // Buckets hold integers, so le = 2^i - 1 covers bucket i exactly
+                    std::string le = "le=\"";
+                    append_number(le, static_cast<double>(MetricHistogram::upper_bound_of(i)) * scale);
+                    le.push_back('"');
+
+                    append_series(out, name, "_bucket", labels, le);
+                    out.push_back(' ');
+                    append_number(out, static_cast<double>(cumulative));
+                    out.push_back('\n');
+                }
+
+                append_series(out, name, "_bucket", labels, "le=\"+Inf\"");
+                out.push_back(' ');
+                append_number(out, static_cast<double>(snap.count));
+                out.push_back('\n');
+
+                append_series(out, name, "_sum", labels, "");
+                out.push_back(' ');
+                append_number(out, static_cast<double>(snap.sum) * scale);
+                out.push_back('\n');
+
+                append_series(out, name, "_count", labels, "");
+                out.push_back(' ');
+                append_number(out, static_cast<double>(snap.count));
+                out.push_back('\n');
+            }
+        }
+    }
+}
@@ -0,0 +1,155 @@
+/**
+ * @file metrics.hpp
+ * @brief Low-overhead counters, gauges and histograms for runtime metrics.
+ *
+ * Every metric is split into METRIC_SHARD_COUNT cache-line sized shards and
+ * each thread updates the shard picked for it on first use, so hot paths do
+ * a relaxed atomic add on a line no other core is writing instead of
+ * bouncing a shared one. Shards are only summed when the metric is read.
+ */
+
+#ifndef INCLUDE_OUC_SERVER_METRICS
+#define INCLUDE_OUC_SERVER_METRICS
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <array>
+#include <atomic>
+
+namespace ouc_server
+{
+    namespace utils
+    {
+        constexpr size_t METRIC_SHARD_COUNT = 16;
+
+        /**
+         * @brief Shard index of the calling thread, assigned round-robin on first use.
+         */
+        size_t metric_shard() noexcept;
+
+        /// Monotonic event or byte count.
+        class Counter
+        {
+        private:
+            struct alignas(64) Shard
+            {
+                std::atomic<uint64_t> value{0};
+            };
+            std::array<Shard, METRIC_SHARD_COUNT> shards;
+
+        public:
+            void add(uint64_t n = 1) noexcept { shards[metric_shard()].value.fetch_add(n, std::memory_order_relaxed); }
+
+            uint64_t value() const noexcept
+            {
+                uint64_t sum = 0;
+                for (auto &shard : shards)
+                    sum += shard.value.load(std::memory_order_relaxed);
+                return sum;
+            }
+        };
+
+        /// Value going up and down, e.g. open connections.
+        class Gauge
+        {
+        private:
+            struct alignas(64) Shard
+            {
+                std::atomic<int64_t> value{0};
+            };
+            std::array<Shard, METRIC_SHARD_COUNT> shards;
+
+        public:
+            void add(int64_t n) noexcept { shards[metric_shard()].value.fetch_add(n, std::memory_order_relaxed); }
+            void inc() noexcept { add(1); }
+            void dec() noexcept { add(-1); }
+
+            int64_t value() const noexcept
+            {
+                int64_t sum = 0;
+                for (auto &shard : shards)
+                    sum += shard.value.load(std::memory_order_relaxed);
+                return sum;
+            }
+        };
+
+        /**
+         * @class MetricHistogram
+         * @brief Concurrent power-of-two histogram.
+         *
+         * Bucket i counts values in [2^(i-1), 2^i), bucket 0 counts zeros.
+         * Coarser than utils::Histogram but small enough to shard, which
+         * makes record() wait-free from any thread.
+         */
+        class MetricHistogram
+        {
+        public:
+            static constexpr size_t BUCKET_COUNT = 65;
+
+            /// Merged, plain copy of the shards.
+            struct Snapshot
+            {
+                std::array<uint64_t, BUCKET_COUNT> buckets{};
+                uint64_t count = 0;
+                uint64_t sum = 0;
+
+                /// Upper bound of the bucket holding the given percentile, p in [0, 100].
+                uint64_t percentile(double p) const noexcept;
+
+                double mean() const noexcept { return count ? static_cast<double>(sum) / count : 0.0; }
+            };
+
+        private:
+            struct alignas(64) Shard
+            {
+                std::array<std::atomic<uint64_t>, BUCKET_COUNT> buckets{};
+                std::atomic<uint64_t> sum{0};
+            };
+            std::array<Shard, METRIC_SHARD_COUNT> shards;
+
+        public:
+            static size_t bucket_of(uint64_t value) noexcept { return value ? 64 - __builtin_clzll(value) : 0; }
+
+            /// Largest value of a bucket.
+            static uint64_t upper_bound_of(size_t idx) noexcept
+            {
+                return idx >= 64 ? UINT64_MAX : (uint64_t(1) << idx) - 1;
+            }
+
+            void record(uint64_t value) noexcept
+            {
+                auto &shard = shards[metric_shard()];
+                shard.buckets[bucket_of(value)].fetch_add(1, std::memory_order_relaxed);
+                shard.sum.fetch_add(value, std::memory_order_relaxed);
+            }
+
+            Snapshot snapshot() const noexcept;
+        };
+
+        /**
+         * @brief Helpers appending metrics in the Prometheus text format.
+         *
+         * Names are used as given; labels, if any, are passed preformatted
+         * as `key="value",...` without braces.
+         */
+        namespace prometheus
+        {
+            void write_header(std::string &out, std::string_view name, std::string_view type, std::string_view help);
+
+            void write_value(std::string &out, std::string_view name, std::string_view labels, double value);
+
+            /**
+             * @brief Append the series of a histogram, without its header.
+             * @param scale Multiplier applied to bounds and sum, e.g. 1e-9 to export ns as seconds.
+             * @param first_bucket,last_bucket Range of power-of-two buckets written as `le` bounds.
+             */
+            void write_histogram(std::string &out, std::string_view name, std::string_view labels,
+                                 const MetricHistogram::Snapshot &snap, double scale,
+                                 size_t first_bucket, size_t last_bucket);
+        }
+    }
+}
+
+#endif // INCLUDE_OUC_SERVER_METRICS
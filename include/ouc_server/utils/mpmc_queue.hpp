@@ -7,12 +7,24 @@
 #include <utility>
 #include <optional>
 #include <iostream>
+#include <type_traits>
 
 namespace pjh_std
 {
+    /**
+     * @brief Bounded lock-free multi-producer multi-consumer queue.
+     *
+     * T must be nothrow move-constructible: a slot is claimed before the
+     * item is moved into it, and a throw there would leave a hole that
+     * wedges the queue. push(const T &) copies before claiming a slot, so
+     * a throwing copy leaves the queue untouched.
+     */
     template <typename T>
     class MPMCQueue
     {
+        static_assert(std::is_nothrow_move_constructible<T>::value,
+                      "MPMCQueue needs a nothrow move constructible T");
+
     private:
         struct Cell
         {
@@ -27,8 +39,8 @@ namespace pjh_std
 
     public:
         explicit MPMCQueue(size_t p_capacity)
-            : m_capacity(2),
-              m_buffer(nullptr)
+            : m_buffer(nullptr),
+              m_capacity(2)
         {
             while (m_capacity < p_capacity)
                 m_capacity <<= 1;
@@ -46,10 +58,11 @@ namespace pjh_std
         MPMCQueue &operator=(const MPMCQueue &) = delete;
 
         MPMCQueue(MPMCQueue &&other) noexcept
-            : m_capacity(other.m_capacity),
-              m_buffer(other.m_buffer),
-              m_head(other.m_head),
-              m_tail(other.m_tail)
+            : m_buffer(other.m_buffer),
+              m_capacity(other.m_capacity),
+              m_head(other.m_head.load(std::memory_order_relaxed)),
+              m_tail(other.m_tail.load(std::memory_order_relaxed)),
+              mask(other.mask)
         {
             other.m_capacity = 0;
             other.m_buffer = nullptr;
@@ -59,30 +72,30 @@ namespace pjh_std
             if (this == &other)
                 return *this;
 
+            drain();
+            delete[] m_buffer;
+
             m_capacity = other.m_capacity, other.m_capacity = 0;
             m_buffer = other.m_buffer, other.m_buffer = nullptr;
-            m_head = other.m_head;
-            m_tail = other.m_tail;
+            m_head.store(other.m_head.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            m_tail.store(other.m_tail.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            mask = other.mask;
 
             return *this;
         }
 
         ~MPMCQueue()
         {
-            for (size_t i = 0; i < m_capacity; ++i)
-            {
-                size_t seq = m_buffer[i].sequence.load(std::memory_order_relaxed);
-                if (seq <= m_tail)
-                {
-                    T *ptr = reinterpret_cast<T *>(&m_buffer[i].storage);
-                    ptr->~T();
-                }
-            }
+            drain();
             delete[] m_buffer;
         }
 
     public:
-        bool push(const T &val) { return push_impl(val); }
+        bool push(const T &val)
+        {
+            T copy(val);
+            return push_impl(std::move(copy));
+        }
         bool push(T &&val) { return push_impl(std::move(val)); }
 
         std::optional<T> pop()
@@ -94,7 +107,8 @@ namespace pjh_std
             {
                 cell = &m_buffer[pos & mask];
                 size_t seq = cell->sequence.load(std::memory_order_acquire);
-                intptr_t diff = (intptr_t)seq - (intptr_t)(pos + m_capacity);
+                // A cell holds the item pushed at pos once its sequence is pos + 1
+                intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
 
                 if (diff == 0)
                 {
@@ -119,7 +133,16 @@ namespace pjh_std
             return result;
         }
 
-    public:
+    private:
+        /// Destroy the items still queued.
+        void drain()
+        {
+            if (m_buffer == nullptr)
+                return;
+            while (pop())
+                ;
+        }
+
         template <typename U>
         bool push_impl(U &&val)
         {
@@ -147,17 +170,8 @@ namespace pjh_std
                     pos = m_tail.load(std::memory_order_relaxed);
             }
 
-            try
-            {
-                new (&cell->storage) U(std::forward<U>(val));
-                cell->sequence.store(pos + m_capacity, std::memory_order_release);
-            }
-            catch (...)
-            {
-                cell->sequence.store(pos, std::memory_order_release);
-                throw;
-            }
-
+            new (&cell->storage) T(std::forward<U>(val));
+            cell->sequence.store(pos + 1, std::memory_order_release);
             return true;
         }
     };
@@ -4,42 +4,97 @@ namespace ouc_server
 {
     namespace utils
     {
-        ThreadPool::ThreadPool(size_t n)
+        thread_local int64_t ThreadPool::current_wait_ns = 0;
+
+        ThreadPool::ThreadPool(size_t n, const std::vector<int> &cpus)
             : is_stop(false)
         {
+            if (n == 0)
+                n = default_thread_count();
+
+            worker_tasks.resize(n);
+            worker_cpus.assign(n, -1);
+            for (size_t idx = 0; idx < n && !cpus.empty(); ++idx)
+                worker_cpus[idx] = cpus[idx % cpus.size()];
+
+            workers.reserve(n);
             for (size_t idx = 0; idx < n; ++idx)
             {
-                workers.reserve(n);
                 workers.emplace_back(
-                    [this]()
+                    [this, idx]()
                     {
+                        // Pin before touching anything so the stack and
+                        // whatever the tasks allocate stay node-local.
+                        if (worker_cpus[idx] >= 0)
+                            pin_current_thread(worker_cpus[idx]);
+
+                        auto &own_tasks = this->worker_tasks[idx];
                         while (true)
                         {
-                            std::function<void()> task;
+                            Task task;
 
                             {
                                 std::unique_lock<std::mutex> lk(this->mtx);
 
                                 this->cv.wait(
                                     lk,
-                                    [this]
-                                    { return this->is_stop || (!this->tasks.empty()); });
+                                    [this, &own_tasks]
+                                    { return this->is_stop || !own_tasks.empty() || !this->tasks.empty(); });
 
-                                if (this->is_stop && this->tasks.empty())
+                                if (this->is_stop && own_tasks.empty() && this->tasks.empty())
                                     return;
 
-                                task = std::move(this->tasks.front());
-                                this->tasks.pop();
+                                // Bound tasks first, nobody else can run them
+                                auto &queue = own_tasks.empty() ? this->tasks : own_tasks;
+                                task = std::move(queue.front());
+                                queue.pop();
+
+                                if (codel_target_ns.load(std::memory_order_relaxed) > 0)
+                                    observe_sojourn(task.queued_at, std::chrono::steady_clock::now(), true);
                             }
 
-                            task();
+                            auto waited = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - task.queued_at).count();
+                            wait_ns.record(waited);
+                            sojourn_ns.store(waited, std::memory_order_relaxed);
+                            current_wait_ns = waited;
+                            executed_count.add();
+
+                            task.func();
+                            current_wait_ns = 0;
                         }
                         return;
                     });
             }
         }
 
+        void ThreadPool::observe_sojourn(std::chrono::steady_clock::time_point queued_at, std::chrono::steady_clock::time_point now, bool can_clear)
+        {
+            int64_t now_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(now.time_since_epoch()).count();
+            int64_t sojourn = std::chrono::duration_cast<std::chrono::nanoseconds>(now - queued_at).count();
+
+            if (sojourn < codel_target_ns.load(std::memory_order_relaxed))
+            {
+                // Back below target: the queue drained, leave overload at once
+                if (can_clear)
+                {
+                    above_target_until = 0;
+                    overloaded.store(false, std::memory_order_relaxed);
+                }
+                return;
+            }
+
+            if (above_target_until == 0)
+                above_target_until = now_ns + codel_interval_ns.load(std::memory_order_relaxed);
+            else if (now_ns >= above_target_until)
+                overloaded.store(true, std::memory_order_relaxed);
+        }
+
         ThreadPool::~ThreadPool()
+        {
+            shutdown();
+        }
+
+        void ThreadPool::shutdown()
         {
             {
                 std::lock_guard<std::mutex> lk(mtx);
@@ -48,8 +103,9 @@ namespace ouc_server
 
             cv.notify_all();
 
+            // A worker shutting down its own pool cannot join itself
             for (auto &worker : workers)
-                if (worker.joinable())
+                if (worker.joinable() && worker.get_id() != std::this_thread::get_id())
                     worker.join();
         }
     }
@@ -11,29 +11,146 @@
 #include <type_traits>
 #include <memory>
 #include <utility>
+#include <chrono>
+#include <atomic>
+
+#include <utils/metrics.hpp>
+#include <utils/cpu_affinity.hpp>
 
 namespace ouc_server
 {
     namespace utils
     {
+        /**
+         * @class ThreadPool
+         * @brief Fixed set of workers running submitted tasks.
+         *
+         * Workers may be pinned to CPUs. Besides the shared queue each worker
+         * has a queue of its own fed by sumbit_to(), which keeps related work
+         * on one core and its caches.
+         *
+         * Overload is detected CoDel-style from the sojourn time, how long a
+         * task waited in the queue: a queue that stays above the target for a
+         * whole interval is a standing queue the workers cannot work off, as
+         * opposed to a burst. The pool never drops tasks itself; callers ask
+         * is_overloaded() and shed the work they can answer cheaply.
+         */
         class ThreadPool
         {
         private:
+            struct Task
+            {
+                std::function<void()> func;
+                std::chrono::steady_clock::time_point queued_at; ///< For the queue wait metric.
+            };
+
             std::mutex mtx;
             bool is_stop;
             std::condition_variable cv;
 
             std::vector<std::thread> workers;
-            std::queue<std::function<void()>> tasks;
+            std::queue<Task> tasks;
+            std::vector<std::queue<Task>> worker_tasks; ///< Tasks bound to one worker.
+            std::vector<int> worker_cpus;               ///< CPU each worker is pinned to, -1 if none.
+
+            Counter executed_count;   ///< Tasks run so far.
+            MetricHistogram wait_ns;  ///< Time tasks spent queued, in ns.
+
+            std::atomic<int64_t> codel_target_ns{0};             ///< Acceptable sojourn, 0 disables detection.
+            std::atomic<int64_t> codel_interval_ns{100'000'000}; ///< Time above target that means overload.
+            int64_t above_target_until = 0;                      ///< Overload once reached, 0 while below target; guarded by mtx.
+            std::atomic<bool> overloaded{false};                 ///< Sojourn above target for a whole interval.
+            std::atomic<int64_t> sojourn_ns{0};                  ///< Wait of the most recently started task.
+
+            static thread_local int64_t current_wait_ns; ///< Wait of the task this worker runs.
 
         public:
-            ThreadPool(size_t);
+            /**
+             * @brief Start the workers.
+             * @param n Worker count, 0 for default_thread_count().
+             * @param cpus CPUs to pin workers to, round-robin; empty leaves them unpinned.
+             */
+            ThreadPool(size_t n, const std::vector<int> &cpus = {});
             ~ThreadPool();
 
+        public:
+            /**
+             * @brief Stop accepting tasks, run the queued ones and join workers.
+             *
+             * Idempotent; the destructor calls it as well.
+             */
+            void shutdown();
+
+            size_t get_thread_count() const noexcept { return workers.size(); }
+
+            /// CPU a worker is pinned to, -1 if unpinned.
+            int get_worker_cpu(size_t idx) const noexcept { return worker_cpus[idx]; }
+
+            /**
+             * @brief First worker pinned to a CPU.
+             * @return Its index, or -1 if no worker runs there.
+             */
+            int find_worker(int cpu) const noexcept
+            {
+                for (size_t i = 0; i < worker_cpus.size(); ++i)
+                    if (worker_cpus[i] == cpu && cpu >= 0)
+                        return static_cast<int>(i);
+                return -1;
+            }
+
+            /// Tasks submitted but not yet picked up by a worker.
+            size_t get_queue_depth()
+            {
+                std::lock_guard<std::mutex> lk(mtx);
+                size_t depth = tasks.size();
+                for (auto &q : worker_tasks)
+                    depth += q.size();
+                return depth;
+            }
+
+            uint64_t get_executed_count() const noexcept { return executed_count.value(); }
+
+            const MetricHistogram &get_wait_histogram() const noexcept { return wait_ns; }
+
+            /**
+             * @brief Turn on overload detection.
+             * @param target Sojourn time considered healthy, zero to disable.
+             * @param interval How long the sojourn must stay above target, about a worst-case handler time.
+             */
+            void set_overload_target(std::chrono::nanoseconds target, std::chrono::nanoseconds interval = std::chrono::milliseconds(100))
+            {
+                codel_interval_ns.store(interval.count());
+                codel_target_ns.store(target.count());
+                if (target.count() <= 0)
+                    overloaded.store(false);
+            }
+
+            std::chrono::nanoseconds get_overload_target() const noexcept { return std::chrono::nanoseconds(codel_target_ns.load()); }
+
+            /// The queue has stood above the target for an interval.
+            bool is_overloaded() const noexcept { return overloaded.load(std::memory_order_relaxed); }
+
+            /// How long the most recently started task waited in the queue.
+            std::chrono::nanoseconds get_sojourn() const noexcept { return std::chrono::nanoseconds(sojourn_ns.load(std::memory_order_relaxed)); }
+
+            /// How long the task running on the calling worker waited, zero outside a pool.
+            static std::chrono::nanoseconds current_task_wait() noexcept { return std::chrono::nanoseconds(current_wait_ns); }
+
         public:
             template <typename Func, typename... Args>
             auto sumbit(Func &&func, Args &&...args)
                 -> std::future<typename std::invoke_result_t<Func, Args...>>
+            {
+                return sumbit_to(-1, std::forward<Func>(func), std::forward<Args>(args)...);
+            }
+
+            /**
+             * @brief Submit a task to run on one particular worker.
+             * @param worker Worker index, -1 for whichever worker is free first.
+             */
+            template <typename Func, typename... Args>
+            auto sumbit_to(int worker, Func &&func, Args &&...args)
+                -> std::future<typename std::invoke_result_t<Func, Args...>>
             {
                 using Ret = typename std::invoke_result_t<Func, Args...>;
 
@@ -42,20 +159,40 @@ namespace ouc_server
                     std::bind(std::forward<Func>(func), std::forward<Args>(args)...));
 
                 std::future<Ret> res = task_ptr->get_future();
+                bool is_bound = worker >= 0 && static_cast<size_t>(worker) < worker_tasks.size();
                 {
                     std::unique_lock<std::mutex> lk(mtx);
 
                     if (is_stop)
                         throw std::runtime_error("ThreadPool has been stopped");
 
-                    tasks.emplace(
+                    auto now = std::chrono::steady_clock::now();
+                    auto &queue = is_bound ? worker_tasks[worker] : tasks;
+                    queue.push(Task{
                         [task_ptr]()
-                        { (*task_ptr)(); });
+                        { (*task_ptr)(); },
+                        now});
+
+                    // Workers all stuck: the head's age already tells, before anything is dequeued
+                    if (codel_target_ns.load(std::memory_order_relaxed) > 0)
+                        observe_sojourn(queue.front().queued_at, now, false);
                 }
-                cv.notify_one();
+
+                // Any worker can take a shared task, a bound one needs its owner
+                if (is_bound)
+                    cv.notify_all();
+                else
+                    cv.notify_one();
 
                 return res;
             }
+
+        private:
+            /**
+             * @brief Advance the overload state with one sojourn sample, mtx held.
+             * @param can_clear A dequeued task may end overload, the head's age only starts it.
+             */
+            void observe_sojourn(std::chrono::steady_clock::time_point queued_at, std::chrono::steady_clock::time_point now, bool can_clear);
         };
     }
 }
@@ -0,0 +1,147 @@
+#include <utils/trace.hpp>
+
+#include <cstdio>
+#include <fstream>
+
+namespace ouc_server
+{
+    namespace utils
+    {
+        namespace trace
+        {
+            namespace
+            {
+                std::atomic<TraceRing *> rings{nullptr};
+                std::atomic<uint32_t> ring_count{0};
+
+                /// Reference point converting ticks into wall time.
+                struct Epoch
+                {
+                    uint64_t ticks = now_ticks();
+                    std::chrono::steady_clock::time_point time = std::chrono::steady_clock::now();
+                };
+
+                const Epoch &epoch()
+                {
+                    static Epoch e;
+                    return e;
+                }
+
+                /// Chrome phase of an event: duration begin, end or instant.
+                char phase_of(TraceEvent event)
+                {
+                    switch (event)
+                    {
+                    case TraceEvent::EpollWaitBegin:
+                    case TraceEvent::CallbackBegin:
+                    case TraceEvent::HandlerBegin:
+                        return 'B';
+                    case TraceEvent::EpollWaitEnd:
+                    case TraceEvent::CallbackEnd:
+                    case TraceEvent::HandlerEnd:
+                        return 'E';
+                    default:
+                        return 'i';
+                    }
+                }
+            }
+
+            TraceRing *create_ring()
+            {
+                epoch();
+
+                auto *ring = new TraceRing();
+                ring->thread_index = ring_count.fetch_add(1, std::memory_order_relaxed);
+
+                // Lock-free push, rings live until the process exits so a
+                // dump still sees threads that already finished.
+                TraceRing *first = rings.load(std::memory_order_relaxed);
+                do
+                    ring->next = first;
+                while (!rings.compare_exchange_weak(first, ring, std::memory_order_release, std::memory_order_relaxed));
+
+                return ring;
+            }
+
+            const char *event_name(TraceEvent event) noexcept
+            {
+                switch (event)
+                {
+                case TraceEvent::EpollWaitBegin:
+                case TraceEvent::EpollWaitEnd:
+                    return "epoll_wait";
+                case TraceEvent::Dispatch:
+                    return "dispatch";
+                case TraceEvent::CallbackBegin:
+                case TraceEvent::CallbackEnd:
+                    return "fd_callback";
+                case TraceEvent::Accept:
+                    return "accept";
+                case TraceEvent::MessageQueued:
+                    return "message_queued";
+                case TraceEvent::HandlerBegin:
+                case TraceEvent::HandlerEnd:
+                    return "on_message";
+                default:
+                    return "unknown";
+                }
+            }
+
+            std::string dump_chrome_json()
+            {
+                // Tick rate measured over the whole run
+                const Epoch &start = epoch();
+                uint64_t ticks = now_ticks() - start.ticks;
+                auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start.time).count();
+                double ticks_per_us = ns > 0 ? static_cast<double>(ticks) * 1000.0 / static_cast<double>(ns) : 1.0;
+
+                std::string out = "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+                bool first = true;
+                char buf[192];
+
+                for (TraceRing *ring = rings.load(std::memory_order_acquire); ring; ring = ring->next)
+                {
+                    uint64_t head = ring->head.load(std::memory_order_acquire);
+                    uint64_t begin = head > TRACE_RING_SIZE ? head - TRACE_RING_SIZE : 0;
+
+                    for (uint64_t i = begin; i < head; ++i)
+                    {
+                        const TraceRecord &rec = ring->records[i & (TRACE_RING_SIZE - 1)];
+                        if (rec.event >= static_cast<uint16_t>(TraceEvent::Count))
+                            continue;
+
+                        auto event = static_cast<TraceEvent>(rec.event);
+                        char phase = phase_of(event);
+                        double ts = static_cast<double>(static_cast<int64_t>(rec.ticks - start.ticks)) / ticks_per_us;
+
+                        int n = std::snprintf(buf, sizeof(buf),
+                                              "%s{\"name\":\"%s\",\"ph\":\"%c\",%s\"ts\":%.3f,\"pid\":1,\"tid\":%u,\"args\":{\"fd\":%d}}",
+                                              first ? "" : ",", event_name(event), phase,
+                                              phase == 'i' ? "\"s\":\"t\"," : "",
+                                              ts, ring->thread_index, rec.fd);
+                        out.append(buf, n);
+                        first = false;
+                    }
+                }
+
+                out.append("]}\n");
+                return out;
+            }
+
+            bool dump_chrome_json(const std::string &path)
+            {
+                std::ofstream file(path, std::ios::binary | std::ios::trunc);
+                if (!file)
+                    return false;
+                file << dump_chrome_json();
+                return static_cast<bool>(file);
+            }
+
+            void clear()
+            {
+                for (TraceRing *ring = rings.load(std::memory_order_acquire); ring; ring = ring->next)
+                    ring->head.store(0, std::memory_order_release);
+            }
+        }
+    }
+}
@@ -0,0 +1,126 @@
+/**
+ * @file trace.hpp
+ * @brief Hot-path trace points recorded into per-thread ring buffers.
+ *
+ * Trace points are written with the OUC_TRACE(event, fd) macro, which compiles to
+ * nothing unless OUC_SERVER_TRACE is defined (cmake -DOUC_SERVER_TRACE=ON).
+ * When enabled, a trace point stores a 16 byte record (timestamp counter,
+ * event id, fd) into a ring buffer owned by the calling thread: no lock,
+ * no allocation after the first record, and old records are overwritten.
+ *
+ * dump_chrome_json() turns the buffers into the Chrome trace-event format,
+ * viewable in chrome://tracing or Perfetto. Take the dump once the traced
+ * threads are quiet; records written meanwhile may come out torn.
+ */
+
+#ifndef INCLUDE_OUC_SERVER_TRACE
+#define INCLUDE_OUC_SERVER_TRACE
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <atomic>
+#include <chrono>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace ouc_server
+{
+    namespace utils
+    {
+        namespace trace
+        {
+            enum class TraceEvent : uint16_t
+            {
+                EpollWaitBegin,  ///< Loop thread enters epoll_wait.
+                EpollWaitEnd,    ///< epoll_wait returned, fd holds the ready count.
+                Dispatch,        ///< Ready fd handed to the EpollLoop pool.
+                CallbackBegin,   ///< Pool thread starts the fd callback.
+                CallbackEnd,     ///< Pool thread finished the fd callback.
+                Accept,          ///< New client accepted.
+                MessageQueued,   ///< Received chunk handed to the task pool.
+                HandlerBegin,    ///< on_message starts.
+                HandlerEnd,      ///< on_message returned.
+                Count
+            };
+
+            struct TraceRecord
+            {
+                uint64_t ticks;   ///< Timestamp counter at the trace point.
+                uint16_t event;   ///< TraceEvent.
+                uint16_t reserved;
+                int32_t fd;       ///< Descriptor involved, -1 if none.
+            };
+
+            /// Records kept per thread, the oldest are overwritten.
+            constexpr size_t TRACE_RING_SIZE = 8192;
+
+            /// Ring buffer written by exactly one thread.
+            struct TraceRing
+            {
+                TraceRecord records[TRACE_RING_SIZE];
+                std::atomic<uint64_t> head{0}; ///< Records written so far.
+                uint32_t thread_index = 0;
+                TraceRing *next = nullptr;     ///< Registry link, rings are never freed.
+            };
+
+            inline uint64_t now_ticks() noexcept
+            {
+#if defined(__x86_64__) || defined(__i386__)
+                return __rdtsc();
+#else
+                return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                           std::chrono::steady_clock::now().time_since_epoch())
+                    .count();
+#endif
+            }
+
+            /**
+             * @brief Allocate and register the calling thread's ring.
+             */
+            TraceRing *create_ring();
+
+            inline TraceRing *local_ring()
+            {
+                thread_local TraceRing *ring = create_ring();
+                return ring;
+            }
+
+            inline void record(TraceEvent event, int fd) noexcept
+            {
+                TraceRing *ring = local_ring();
+                uint64_t head = ring->head.load(std::memory_order_relaxed);
+                ring->records[head & (TRACE_RING_SIZE - 1)] = TraceRecord{now_ticks(), static_cast<uint16_t>(event), 0, fd};
+                ring->head.store(head + 1, std::memory_order_release);
+            }
+
+            const char *event_name(TraceEvent event) noexcept;
+
+            /**
+             * @brief Render every thread's records as Chrome trace-event JSON.
+             */
+            std::string dump_chrome_json();
+
+            /**
+             * @brief Write dump_chrome_json() to a file.
+             * @return false if the file could not be written.
+             */
+            bool dump_chrome_json(const std::string &path);
+
+            /**
+             * @brief Drop all recorded events, the traced threads must be quiet.
+             */
+            void clear();
+        }
+    }
+}
+
+#ifdef OUC_SERVER_TRACE
+#define OUC_TRACE(event, fd) ::ouc_server::utils::trace::record(::ouc_server::utils::trace::TraceEvent::event, (fd))
+#else
+#define OUC_TRACE(event, fd) ((void)0)
+#endif
+
+#endif // INCLUDE_OUC_SERVER_TRACE
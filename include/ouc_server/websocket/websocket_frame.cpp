@@ -0,0 +1,321 @@
+#include <websocket/websocket_frame.hpp>
+
+#include <cstring>
+#include <algorithm>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace ouc_server
+{
+    namespace websocket
+    {
+        void unmask(char *dst, const char *src, size_t len, const uint8_t key[4], uint64_t offset)
+        {
+            // Rotate the key so byte 0 of src lines up with key[0]
+            uint8_t rotated[4];
+            for (int i = 0; i < 4; ++i)
+                rotated[i] = key[(offset + i) & 3];
+            uint32_t mask32;
+            std::memcpy(&mask32, rotated, 4);
+
+            size_t i = 0;
+#if defined(__AVX2__)
+            const __m256i mask256 = _mm256_set1_epi32(static_cast<int>(mask32));
+            for (; i + 32 <= len; i += 32)
+            {
+                __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i));
+                _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), _mm256_xor_si256(v, mask256));
+            }
+#endif
+#if defined(__SSE2__)
+            const __m128i mask128 = _mm_set1_epi32(static_cast<int>(mask32));
+            for (; i + 16 <= len; i += 16)
+            {
+                __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm_xor_si128(v, mask128));
+            }
+#endif
+            // Every step is a multiple of 4, the key stays aligned
+            const uint64_t mask64 = (static_cast<uint64_t>(mask32) << 32) | mask32;
+            for (; i + 8 <= len; i += 8)
+            {
+                uint64_t v;
+                std::memcpy(&v, src + i, 8);
+                v ^= mask64;
+                std::memcpy(dst + i, &v, 8);
+            }
+            for (; i < len; ++i)
+                dst[i] = static_cast<char>(src[i] ^ rotated[i & 3]);
+        }
+
+        bool is_valid_utf8(std::string_view text) noexcept
+        {
+            const auto *s = reinterpret_cast<const unsigned char *>(text.data());
+            size_t len = text.size();
+            size_t i = 0;
+            while (i < len)
+            {
+                // ASCII runs, the common case, eight bytes at a time
+                if (i + 8 <= len)
+                {
+                    uint64_t v;
+                    std::memcpy(&v, s + i, 8);
+                    if ((v & 0x8080808080808080ull) == 0)
+                    {
+                        i += 8;
+                        continue;
+                    }
+                }
+
+                unsigned char c = s[i];
+                if (c < 0x80)
+                {
+                    ++i;
+                    continue;
+                }
+
+                size_t n;
+                uint32_t cp;
+                if ((c & 0xE0) == 0xC0)
+                    n = 1, cp = c & 0x1F;
+                else if ((c & 0xF0) == 0xE0)
+                    n = 2, cp = c & 0x0F;
+                else if ((c & 0xF8) == 0xF0)
+                    n = 3, cp = c & 0x07;
+                else
+                    return false;
+                if (i + n >= len)
+                    return false;
+
+                for (size_t k = 1; k <= n; ++k)
+                {
+                    if ((s[i + k] & 0xC0) != 0x80)
+                        return false;
+                    cp = (cp << 6) | (s[i + k] & 0x3F);
+                }
+
+                // Overlong forms, UTF-16 surrogates and beyond U+10FFFF
+                static const uint32_t min_of[4] = {0, 0x80, 0x800, 0x10000};
+                if (cp < min_of[n] || (cp >= 0xD800 && cp <= 0xDFFF) || cp > 0x10FFFF)
+                    return false;
+                i += n + 1;
+            }
+            return true;
+        }
+
+        void encode_frame(std::string &out, Opcode opcode, std::string_view payload, bool fin)
+        {
+            char header[10];
+            size_t n = 2;
+            header[0] = static_cast<char>((fin ? 0x80 : 0x00) | static_cast<uint8_t>(opcode));
+            if (payload.size() < 126)
+                header[1] = static_cast<char>(payload.size());
+            else if (payload.size() <= 0xFFFF)
+            {
+                header[1] = 126;
+                header[2] = static_cast<char>(payload.size() >> 8);
+                header[3] = static_cast<char>(payload.size());
+                n = 4;
+            }
+            else
+            {
+                header[1] = 127;
+                for (int i = 0; i < 8; ++i)
+                    header[2 + i] = static_cast<char>(static_cast<uint64_t>(payload.size()) >> (56 - 8 * i));
+                n = 10;
+            }
+
+            out.reserve(out.size() + n + payload.size());
+            out.append(header, n);
+            out.append(payload);
+        }
+
+        std::string encode_frame(Opcode opcode, std::string_view payload, bool fin)
+        {
+            std::string out;
+            encode_frame(out, opcode, payload, fin);
+            return out;
+        }
+
+        std::string encode_close(uint16_t code, std::string_view reason)
+        {
+            // Control payloads are limited to 125 bytes
+            std::string payload;
+            payload.push_back(static_cast<char>(code >> 8));
+            payload.push_back(static_cast<char>(code));
+            payload.append(reason.substr(0, 123));
+            return encode_frame(Opcode::Close, payload);
+        }
+
+        FrameParser::FrameParser(size_t p_max_message_size, ouc_server::utils::BufferPool *p_pool, bool p_require_mask)
+            : max_message_size(p_max_message_size),
+              pool(p_pool),
+              require_mask(p_require_mask),
+              header_len(0),
+              in_payload(false),
+              opcode(Opcode::Continuation),
+              fin(false),
+              masked(false),
+              key{},
+              payload_len(0),
+              payload_done(0),
+              in_message(false),
+              message_opcode(Opcode::Text),
+              error_code(0)
+        {
+        }
+
+        FrameParser::~FrameParser()
+        {
+            if (pool && in_message)
+                pool->release(std::move(message));
+        }
+
+        bool FrameParser::feed(const char *data, size_t len)
+        {
+            size_t pos = 0;
+            while (pos < len)
+            {
+                if (error_code != 0)
+                    return false;
+
+                if (!in_payload)
+                {
+                    // Two fixed bytes tell how long the rest of the header is
+                    auto header_size = [this]() -> size_t
+                    {
+                        if (header_len < 2)
+                            return 2;
+                        uint8_t len7 = header[1] & 0x7F;
+                        return 2 + (len7 == 126 ? 2 : len7 == 127 ? 8 : 0) + ((header[1] & 0x80) ? 4 : 0);
+                    };
+
+                    size_t n = std::min(header_size() - header_len, len - pos);
+                    std::memcpy(header + header_len, data + pos, n);
+                    header_len += n;
+                    pos += n;
+
+                    if (header_len == header_size() && !begin_frame())
+                        return false;
+                    continue;
+                }
+
+                // Payload: unmask straight into the message or control buffer
+                std::string &target = static_cast<uint8_t>(opcode) >= 0x8 ? control : message;
+                size_t n = static_cast<size_t>(std::min<uint64_t>(payload_len - payload_done, len - pos));
+                size_t old = target.size();
+                target.append(data + pos, n);
+                if (masked)
+                    unmask(target.data() + old, target.data() + old, n, key, payload_done);
+                payload_done += n;
+                pos += n;
+
+                if (payload_done == payload_len)
+                    end_frame();
+            }
+            return error_code == 0;
+        }
+
+        bool FrameParser::begin_frame()
+        {
+            fin = (header[0] & 0x80) != 0;
+            opcode = static_cast<Opcode>(header[0] & 0x0F);
+            masked = (header[1] & 0x80) != 0;
+
+            size_t pos = 2;
+            uint8_t len7 = header[1] & 0x7F;
+            if (len7 == 126)
+            {
+                payload_len = (uint64_t(header[2]) << 8) | header[3];
+                pos = 4;
+            }
+            else if (len7 == 127)
+            {
+                payload_len = 0;
+                for (int i = 0; i < 8; ++i)
+                    payload_len = (payload_len << 8) | header[2 + i];
+                pos = 10;
+            }
+            else
+                payload_len = len7;
+            if (masked)
+                std::memcpy(key, header + pos, 4);
+
+            // No extension negotiated: reserved bits must be clear
+            if ((header[0] & 0x70) != 0 || (require_mask && !masked))
+                return fail(CLOSE_PROTOCOL_ERROR);
+
+            switch (opcode)
+            {
+            case Opcode::Close:
+            case Opcode::Ping:
+            case Opcode::Pong:
+                if (!fin || payload_len > 125)
+                    return fail(CLOSE_PROTOCOL_ERROR);
+                control.clear();
+                break;
+
+            case Opcode::Continuation:
+                if (!in_message)
+                    return fail(CLOSE_PROTOCOL_ERROR);
+                if (payload_len > max_message_size - message.size())
+                    return fail(CLOSE_TOO_BIG);
+                break;
+
+            case Opcode::Text:
+            case Opcode::Binary:
+                if (in_message)
+                    return fail(CLOSE_PROTOCOL_ERROR);
+                if (payload_len > max_message_size)
+                    return fail(CLOSE_TOO_BIG);
+                in_message = true;
+                message_opcode = opcode;
+                message = pool ? pool->acquire() : std::string();
+                message.reserve(static_cast<size_t>(payload_len));
+                break;
+
+            default:
+                return fail(CLOSE_PROTOCOL_ERROR);
+            }
+
+            in_payload = true;
+            payload_done = 0;
+            if (payload_len == 0)
+                end_frame();
+            return true;
+        }
+
+        void FrameParser::end_frame()
+        {
+            in_payload = false;
+            header_len = 0;
+
+            if (static_cast<uint8_t>(opcode) >= 0x8)
+            {
+                if (on_control_callback)
+                    on_control_callback(opcode, control);
+                return;
+            }
+            if (!fin)
+                return;
+
+            in_message = false;
+            if (message_opcode == Opcode::Text && !is_valid_utf8(message))
+                fail(CLOSE_INVALID_PAYLOAD);
+            else if (on_message_callback)
+                on_message_callback(message_opcode, message);
+
+            if (pool)
+                pool->release(std::move(message));
+            message = std::string();
+        }
+
+        bool FrameParser::fail(uint16_t code)
+        {
+            error_code = code;
+            return false;
+        }
+    }
+}
@@ -0,0 +1,159 @@
+/**
+ * @file websocket_frame.hpp
+ * @brief RFC 6455 frame encoding and incremental parsing.
+ *
+ * Client frames arrive masked: every payload byte is XORed with a 4-byte
+ * key. unmask() removes it 32 (AVX2) or 16 (SSE2) bytes per instruction,
+ * falling back to 8-byte words elsewhere. FrameParser unmasks payload
+ * straight into the message it reassembles, so each byte is touched once
+ * on its way from the connection buffer to the handler.
+ */
+
+#ifndef INCLUDE_OUC_SERVER_WEBSOCKET_FRAME
+#define INCLUDE_OUC_SERVER_WEBSOCKET_FRAME
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+
+#include <utils/buffer_pool.hpp>
+
+namespace ouc_server
+{
+    namespace websocket
+    {
+        enum class Opcode : uint8_t
+        {
+            Continuation = 0x0,
+            Text = 0x1,
+            Binary = 0x2,
+            Close = 0x8,
+            Ping = 0x9,
+            Pong = 0xA,
+        };
+
+        /// Status codes of close frames (RFC 6455 7.4.1).
+        constexpr uint16_t CLOSE_NORMAL = 1000;
+        constexpr uint16_t CLOSE_GOING_AWAY = 1001;
+        constexpr uint16_t CLOSE_PROTOCOL_ERROR = 1002;
+        constexpr uint16_t CLOSE_NO_STATUS = 1005;
+        constexpr uint16_t CLOSE_ABNORMAL = 1006;
+        constexpr uint16_t CLOSE_INVALID_PAYLOAD = 1007;
+        constexpr uint16_t CLOSE_TOO_BIG = 1009;
+
+        /**
+         * @brief XOR bytes with a masking key, as from a given payload offset.
+         * @param dst Output, may be src itself.
+         * @param src Masked (or unmasked) bytes.
+         * @param len Number of bytes.
+         * @param key Masking key as sent in the frame header.
+         * @param offset Position of src[0] within the frame payload.
+         */
+        void unmask(char *dst, const char *src, size_t len, const uint8_t key[4], uint64_t offset = 0);
+
+        /**
+         * @brief Whether text is well-formed UTF-8, as text messages must be.
+         */
+        bool is_valid_utf8(std::string_view text) noexcept;
+
+        /**
+         * @brief Append an unmasked frame, as a server sends them.
+         * @param out Buffer to append to.
+         * @param opcode Frame type.
+         * @param payload Payload bytes.
+         * @param fin Last frame of the message.
+         */
+        void encode_frame(std::string &out, Opcode opcode, std::string_view payload, bool fin = true);
+
+        std::string encode_frame(Opcode opcode, std::string_view payload, bool fin = true);
+
+        /**
+         * @brief A close frame carrying a status code and reason.
+         */
+        std::string encode_close(uint16_t code, std::string_view reason = {});
+
+        /**
+         * @class FrameParser
+         * @brief Push-style parser turning a byte stream into messages.
+         *
+         * Fragmented messages are reassembled into buffers taken from a
+         * BufferPool; control frames interleaved with the fragments are
+         * delivered on their own right away.
+         */
+        class FrameParser
+        {
+        public:
+            /// A complete Text or Binary message; the buffer may be moved from.
+            using MessageCallback = std::function<void(Opcode, std::string &)>;
+
+            /// A Close, Ping or Pong frame with its payload.
+            using ControlCallback = std::function<void(Opcode, std::string_view)>;
+
+        private:
+            size_t max_message_size;
+            ouc_server::utils::BufferPool *pool;
+            bool require_mask;
+
+            uint8_t header[14];   ///< Header bytes received so far.
+            size_t header_len;
+            bool in_payload;      ///< Header done, payload bytes follow.
+            Opcode opcode;        ///< Of the current frame.
+            bool fin;
+            bool masked;
+            uint8_t key[4];
+            uint64_t payload_len;
+            uint64_t payload_done; ///< Payload bytes of the current frame received.
+
+            bool in_message;       ///< Between the first and the last fragment.
+            Opcode message_opcode; ///< Text or Binary.
+            std::string message;   ///< Reassembled payload, from the pool.
+            std::string control;   ///< Payload of the current control frame.
+            uint16_t error_code;   ///< Close code describing the failure, 0 if none.
+
+            MessageCallback on_message_callback;
+            ControlCallback on_control_callback;
+
+        public:
+            /**
+             * @param p_max_message_size Largest message accepted, failing with CLOSE_TOO_BIG beyond it.
+             * @param p_pool Pool of message buffers, nullptr to allocate.
+             * @param p_require_mask Reject unmasked frames, as a server must.
+             */
+            explicit FrameParser(size_t p_max_message_size = 16 << 20, ouc_server::utils::BufferPool *p_pool = nullptr,
+                                 bool p_require_mask = true);
+
+            ~FrameParser();
+
+            FrameParser(const FrameParser &) = delete;
+            FrameParser &operator=(const FrameParser &) = delete;
+
+        public:
+            void on_message(MessageCallback &&callback) { on_message_callback = std::move(callback); }
+
+            void on_control(ControlCallback &&callback) { on_control_callback = std::move(callback); }
+
+            /**
+             * @brief Consume the next bytes of the stream.
+             * @return false once the stream violates the protocol or a limit.
+             */
+            bool feed(const char *data, size_t len);
+
+            bool feed(std::string_view data) { return feed(data.data(), data.size()); }
+
+            /// Close code to send after feed() failed, 0 if it did not.
+            uint16_t get_error_code() const noexcept { return error_code; }
+
+        private:
+            /// Validate a complete header and set up its payload.
+            bool begin_frame();
+
+            void end_frame();
+
+            bool fail(uint16_t code);
+        };
+    }
+}
+
+#endif // INCLUDE_OUC_SERVER_WEBSOCKET_FRAME
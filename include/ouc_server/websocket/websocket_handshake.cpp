@@ -0,0 +1,150 @@
+#include <websocket/websocket_handshake.hpp>
+
+#include <cstdint>
+#include <cstring>
+
+#include <http/http_headers.hpp>
+
+namespace ouc_server
+{
+    namespace websocket
+    {
+        namespace
+        {
+            constexpr const char *GUID = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+
+            uint32_t rotl(uint32_t x, int n) { return (x << n) | (x >> (32 - n)); }
+
+            /// SHA-1 of a short message, only ever used on handshake keys.
+            void sha1(std::string_view data, uint8_t digest[20])
+            {
+                uint32_t h[5] = {0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0};
+
+                std::string msg(data);
+                uint64_t bits = static_cast<uint64_t>(data.size()) * 8;
+                msg.push_back(static_cast<char>(0x80));
+                while (msg.size() % 64 != 56)
+                    msg.push_back(0);
+                for (int i = 7; i >= 0; --i)
+                    msg.push_back(static_cast<char>(bits >> (8 * i)));
+
+                for (size_t block = 0; block < msg.size(); block += 64)
+                {
+                    uint32_t w[80];
+                    for (int i = 0; i < 16; ++i)
+                    {
+                        const auto *p = reinterpret_cast<const uint8_t *>(msg.data() + block + 4 * i);
+                        w[i] = (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | p[3];
+                    }
+                    for (int i = 16; i < 80; ++i)
+                        w[i] = rotl(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+
+                    uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+                    for (int i = 0; i < 80; ++i)
+                    {
+                        uint32_t f, k;
+                        if (i < 20)
+                            f = (b & c) | (~b & d), k = 0x5A827999;
+                        else if (i < 40)
+                            f = b ^ c ^ d, k = 0x6ED9EBA1;
+                        else if (i < 60)
+                            f = (b & c) | (b & d) | (c & d), k = 0x8F1BBCDC;
+                        else
+                            f = b ^ c ^ d, k = 0xCA62C1D6;
+
+                        uint32_t t = rotl(a, 5) + f + e + k + w[i];
+                        e = d;
+                        d = c;
+                        c = rotl(b, 30);
+                        b = a;
+                        a = t;
+                    }
+                    h[0] += a;
+                    h[1] += b;
+                    h[2] += c;
+                    h[3] += d;
+                    h[4] += e;
+                }
+
+                for (int i = 0; i < 5; ++i)
+                    for (int j = 0; j < 4; ++j)
+                        digest[4 * i + j] = static_cast<uint8_t>(h[i] >> (24 - 8 * j));
+            }
+
+            std::string base64(const uint8_t *data, size_t len)
+            {
+                static const char table[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+                std::string out;
+                out.reserve((len + 2) / 3 * 4);
+                for (size_t i = 0; i < len; i += 3)
+                {
+                    uint32_t v = uint32_t(data[i]) << 16;
+                    if (i + 1 < len)
+                        v |= uint32_t(data[i + 1]) << 8;
+                    if (i + 2 < len)
+                        v |= data[i + 2];
+
+                    out.push_back(table[(v >> 18) & 0x3F]);
+                    out.push_back(table[(v >> 12) & 0x3F]);
+                    out.push_back(i + 1 < len ? table[(v >> 6) & 0x3F] : '=');
+                    out.push_back(i + 2 < len ? table[v & 0x3F] : '=');
+                }
+                return out;
+            }
+
+            /// Whether a comma-separated header value lists token.
+            bool has_token(std::string_view value, std::string_view token)
+            {
+                while (!value.empty())
+                {
+                    size_t comma = value.find(',');
+                    std::string_view item = value.substr(0, comma);
+                    while (!item.empty() && (item.front() == ' ' || item.front() == '\t'))
+                        item.remove_prefix(1);
+                    while (!item.empty() && (item.back() == ' ' || item.back() == '\t'))
+                        item.remove_suffix(1);
+                    if (ouc_server::http::iequals(item, token))
+                        return true;
+                    if (comma == std::string_view::npos)
+                        break;
+                    value.remove_prefix(comma + 1);
+                }
+                return false;
+            }
+        }
+
+        std::string accept_key(std::string_view key)
+        {
+            std::string input(key);
+            input += GUID;
+
+            uint8_t digest[20];
+            sha1(input, digest);
+            return base64(digest, sizeof(digest));
+        }
+
+        int check_upgrade(const ouc_server::http::HttpRequest &req)
+        {
+            using ouc_server::http::find_header;
+            using ouc_server::http::iequals;
+
+            if (req.method != ouc_server::http::HttpMethodType::Get || req.version != "HTTP/1.1")
+                return 400;
+
+            auto *upgrade = find_header(req.headers, "Upgrade");
+            auto *connection = find_header(req.headers, "Connection");
+            auto *version = find_header(req.headers, "Sec-WebSocket-Version");
+            if (!upgrade || !has_token(*upgrade, "websocket") || !connection || !has_token(*connection, "upgrade"))
+                return 426;
+            if (!version || *version != "13")
+                return 426;
+
+            // 16 random bytes, base64-encoded
+            auto *key = find_header(req.headers, "Sec-WebSocket-Key");
+            if (!key || key->size() != 24)
+                return 400;
+            return 0;
+        }
+    }
+}
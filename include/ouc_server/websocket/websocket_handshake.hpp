@@ -0,0 +1,34 @@
+/**
+ * @file websocket_handshake.hpp
+ * @brief Opening handshake of RFC 6455: validating the upgrade request.
+ */
+
+#ifndef INCLUDE_OUC_SERVER_WEBSOCKET_HANDSHAKE
+#define INCLUDE_OUC_SERVER_WEBSOCKET_HANDSHAKE
+
+#include <string>
+#include <string_view>
+
+#include <http/http_request.hpp>
+
+namespace ouc_server
+{
+    namespace websocket
+    {
+        /**
+         * @brief Sec-WebSocket-Accept value answering a Sec-WebSocket-Key.
+         * @param key Key sent by the client.
+         * @return base64(SHA-1(key + GUID)).
+         */
+        std::string accept_key(std::string_view key);
+
+        /**
+         * @brief Check a parsed request is a valid WebSocket upgrade.
+         * @param req Request with its headers.
+         * @return 0 if valid, otherwise the HTTP status to refuse it with.
+         */
+        int check_upgrade(const ouc_server::http::HttpRequest &req);
+    }
+}
+
+#endif // INCLUDE_OUC_SERVER_WEBSOCKET_HANDSHAKE
@@ -0,0 +1,351 @@
+#include <websocket/websocket_server.hpp>
+
+#include <vector>
+
+#include <http/http_headers.hpp>
+#include <http/http_request_parser.hpp>
+#include <http/http_response_writer.hpp>
+#include <websocket/websocket_handshake.hpp>
+
+namespace ouc_server
+{
+    namespace websocket
+    {
+        namespace
+        {
+            int64_t now_ns()
+            {
+                using namespace std::chrono;
+                return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+            }
+        }
+
+        WebSocketServer::WebSocketServer(const WebSocketConfig &p_config, size_t task_count)
+            : config(p_config), server(task_count)
+        {
+            using ouc_server::ouc_socket::TCPSocket;
+
+            server.on_connection(
+                [this](TCPSocket &client)
+                {
+                    auto session = std::make_shared<Session>(config.max_message_size, &pool);
+                    session->socket = &client;
+                    session->last_seen.store(now_ns());
+                    Session *raw = session.get();
+
+                    session->parser.on_message(
+                        [this, raw](Opcode opcode, std::string &data)
+                        {
+                            if (on_message_callback)
+                                on_message_callback(*raw->socket, data, opcode == Opcode::Binary);
+                        });
+                    session->parser.on_control(
+                        [this, raw](Opcode opcode, std::string_view payload)
+                        { handle_control(*raw, opcode, payload); });
+
+                    std::lock_guard<std::mutex> lk(sessions_mtx);
+                    sessions[client.get_fd()] = std::move(session);
+                });
+
+            server.on_message(
+                [this](TCPSocket &client, const std::string &data)
+                { handle_message(client, data); });
+
+            server.on_close(
+                [this](TCPSocket &client)
+                {
+                    std::shared_ptr<Session> session;
+                    {
+                        std::lock_guard<std::mutex> lk(sessions_mtx);
+                        auto it = sessions.find(client.get_fd());
+                        if (it == sessions.end())
+                            return;
+                        session = std::move(it->second);
+                        sessions.erase(it);
+                    }
+
+                    bool was_open;
+                    uint16_t code;
+                    {
+                        std::lock_guard<std::mutex> lk(session->mtx);
+                        was_open = session->open;
+                        code = session->close_code;
+                        session->open = false;
+                        session->closed = true;
+                    }
+                    if (was_open && on_close_callback)
+                        on_close_callback(client, code);
+                });
+        }
+
+        WebSocketServer::~WebSocketServer()
+        {
+            std::lock_guard<std::mutex> lk(timer_mtx);
+            closing = true;
+            if (ping_timer != 0)
+                server.get_loop().cancel_timer(ping_timer);
+        }
+
+        bool WebSocketServer::start(const std::string &address, uint16_t port)
+        {
+            if (!server.start(address, port))
+                return false;
+            arm_keepalive();
+            return true;
+        }
+
+        std::shared_ptr<WebSocketServer::Session> WebSocketServer::find_session(int fd)
+        {
+            std::lock_guard<std::mutex> lk(sessions_mtx);
+            auto it = sessions.find(fd);
+            return it == sessions.end() ? nullptr : it->second;
+        }
+
+        void WebSocketServer::handle_message(ouc_server::ouc_socket::TCPSocket &client, const std::string &data)
+        {
+            auto session = find_session(client.get_fd());
+            if (!session)
+                return;
+
+            // Messages of one connection are never dispatched concurrently,
+            // so handshake buffer and parser need no locking of their own.
+            session->socket = &client;
+            session->last_seen.store(now_ns(), std::memory_order_relaxed);
+
+            std::string_view frames = data;
+            bool is_open, refused;
+            {
+                std::lock_guard<std::mutex> lk(session->mtx);
+                is_open = session->open;
+                refused = session->close_sent;
+            }
+            if (refused)
+                return;
+            if (!is_open)
+            {
+                size_t scan_from = session->handshake.size() < 3 ? 0 : session->handshake.size() - 3;
+                session->handshake += data;
+                size_t end = session->handshake.find("\r\n\r\n", scan_from);
+                if (end == std::string::npos)
+                {
+                    if (session->handshake.size() > config.max_handshake_size)
+                        handshake(*session, 0);
+                    return;
+                }
+
+                size_t head_size = end + 4;
+                if (!handshake(*session, head_size > config.max_handshake_size ? 0 : head_size))
+                    return;
+
+                // Frames the client sent right behind its request
+                frames.remove_prefix(head_size - (session->handshake.size() - data.size()));
+                session->handshake = std::string();
+            }
+
+            if (!frames.empty() && !session->parser.feed(frames))
+            {
+                send_frame(*session, std::make_shared<const std::string>(encode_close(session->parser.get_error_code())), true);
+                server.close_after_flush(client);
+            }
+        }
+
+        bool WebSocketServer::handshake(Session &session, size_t head_size)
+        {
+            using ouc_server::http::HttpRequest;
+
+            auto *client = session.socket;
+            int code = 431;
+            HttpRequest req;
+            if (head_size != 0)
+            {
+                // A bodiless GET: the head alone is a whole request
+                ouc_server::http::HttpRequestParser parser;
+                bool parsed = false;
+                parser.on_headers([&](HttpRequest &r)
+                                  { req = r; parsed = true; });
+                code = parser.feed(session.handshake.data(), head_size) && parsed ? check_upgrade(req) : 400;
+                if (code == 0 && handshake_check && !handshake_check(req))
+                    code = 403;
+            }
+
+            if (code != 0)
+            {
+                {
+                    std::lock_guard<std::mutex> lk(session.mtx);
+                    session.close_sent = true;
+                }
+                ouc_server::http::HttpResponseWriter writer(
+                    [this, client](std::string &&data)
+                    { return server.send(*client, std::move(data)); });
+                writer.set_keep_alive(false);
+                writer.status(code);
+                if (code == 426)
+                    writer.header("Sec-WebSocket-Version", "13");
+                writer.end();
+                server.close_after_flush(*client);
+                return false;
+            }
+
+            std::string response = "HTTP/1.1 101 Switching Protocols\r\n"
+                                   "Upgrade: websocket\r\n"
+                                   "Connection: Upgrade\r\n"
+                                   "Sec-WebSocket-Accept: ";
+            response += accept_key(*ouc_server::http::find_header(req.headers, "Sec-WebSocket-Key"));
+            response += "\r\n\r\n";
+
+            {
+                std::lock_guard<std::mutex> lk(session.mtx);
+                if (session.closed)
+                    return false;
+                server.send(*client, std::move(response));
+                session.open = true;
+            }
+            if (on_open_callback)
+                on_open_callback(*client, req);
+            return true;
+        }
+
+        void WebSocketServer::handle_control(Session &session, Opcode opcode, std::string_view payload)
+        {
+            switch (opcode)
+            {
+            case Opcode::Ping:
+                send_frame(session, std::make_shared<const std::string>(encode_frame(Opcode::Pong, payload)));
+                break;
+
+            case Opcode::Close:
+            {
+                // A one-byte payload cannot hold a code
+                uint16_t code = CLOSE_NO_STATUS;
+                if (payload.size() >= 2)
+                    code = static_cast<uint16_t>((uint8_t(payload[0]) << 8) | uint8_t(payload[1]));
+                else if (payload.size() == 1)
+                    code = CLOSE_PROTOCOL_ERROR;
+                {
+                    std::lock_guard<std::mutex> lk(session.mtx);
+                    session.close_code = code;
+                }
+
+                // Echo the code back unless we started the handshake ourselves
+                uint16_t reply = code == CLOSE_NO_STATUS ? CLOSE_NORMAL : code;
+                send_frame(session, std::make_shared<const std::string>(encode_close(reply)), true);
+                server.close_after_flush(*session.socket);
+                break;
+            }
+
+            default:
+                break; // Pong: receiving it already refreshed last_seen
+            }
+        }
+
+        bool WebSocketServer::send_frame(Session &session, ouc_server::server::TCPServer::SharedBuffer frame, bool is_close,
+                                         std::optional<ouc_server::server::SlowConsumerPolicy> policy)
+        {
+            std::lock_guard<std::mutex> lk(session.mtx);
+            if (!session.open || session.close_sent || session.closed)
+                return false;
+            if (is_close)
+                session.close_sent = true;
+            if (policy)
+                return server.offer(*session.socket, std::move(frame), *policy);
+            return server.send(*session.socket, std::move(frame));
+        }
+
+        bool WebSocketServer::send(ouc_server::ouc_socket::TCPSocket &client, std::string_view data, bool binary)
+        {
+            auto session = find_session(client.get_fd());
+            if (!session)
+                return false;
+            return send_frame(*session, std::make_shared<const std::string>(encode_frame(binary ? Opcode::Binary : Opcode::Text, data)));
+        }
+
+        bool WebSocketServer::ping(ouc_server::ouc_socket::TCPSocket &client, std::string_view payload)
+        {
+            auto session = find_session(client.get_fd());
+            if (!session || payload.size() > 125)
+                return false;
+            return send_frame(*session, std::make_shared<const std::string>(encode_frame(Opcode::Ping, payload)));
+        }
+
+        bool WebSocketServer::close(ouc_server::ouc_socket::TCPSocket &client, uint16_t code, std::string_view reason)
+        {
+            auto session = find_session(client.get_fd());
+            if (!session || !send_frame(*session, std::make_shared<const std::string>(encode_close(code, reason)), true))
+                return false;
+            server.close_after_flush(client);
+            return true;
+        }
+
+        size_t WebSocketServer::broadcast(std::string_view data, bool binary, ouc_server::server::SlowConsumerPolicy policy)
+        {
+            std::vector<std::shared_ptr<Session>> targets;
+            {
+                std::lock_guard<std::mutex> lk(sessions_mtx);
+                targets.reserve(sessions.size());
+                for (auto &entry : sessions)
+                    targets.push_back(entry.second);
+            }
+
+            // One frame for everyone: each outbox holds a reference, not a copy
+            auto frame = std::make_shared<const std::string>(encode_frame(binary ? Opcode::Binary : Opcode::Text, data));
+            size_t count = 0;
+            for (auto &session : targets)
+                if (send_frame(*session, frame, false, policy))
+                    ++count;
+            return count;
+        }
+
+        size_t WebSocketServer::get_connection_count()
+        {
+            std::lock_guard<std::mutex> lk(sessions_mtx);
+            size_t count = 0;
+            for (auto &entry : sessions)
+            {
+                std::lock_guard<std::mutex> session_lk(entry.second->mtx);
+                if (entry.second->open && !entry.second->close_sent)
+                    ++count;
+            }
+            return count;
+        }
+
+        void WebSocketServer::keepalive()
+        {
+            std::vector<std::shared_ptr<Session>> targets;
+            {
+                std::lock_guard<std::mutex> lk(sessions_mtx);
+                for (auto &entry : sessions)
+                    targets.push_back(entry.second);
+            }
+
+            int64_t deadline = now_ns() - std::chrono::duration_cast<std::chrono::nanoseconds>(config.ping_interval + config.pong_timeout).count();
+            auto frame = std::make_shared<const std::string>(encode_frame(Opcode::Ping, {}));
+            for (auto &session : targets)
+            {
+                // Silent through a whole interval and the pong timeout: dead peer
+                if (session->last_seen.load(std::memory_order_relaxed) < deadline)
+                {
+                    std::lock_guard<std::mutex> lk(session->mtx);
+                    if (!session->closed && session->socket)
+                        session->socket->shutdown();
+                    continue;
+                }
+                // A peer too far behind to take a ping is about to time out anyway
+                send_frame(*session, frame, false, ouc_server::server::SlowConsumerPolicy::Drop);
+            }
+
+            arm_keepalive();
+        }
+
+        void WebSocketServer::arm_keepalive()
+        {
+            if (config.ping_interval.count() <= 0)
+                return;
+
+            std::lock_guard<std::mutex> lk(timer_mtx);
+            if (closing)
+                return;
+            ping_timer = server.get_loop().add_timer(config.ping_interval, [this]
+                                                     { keepalive(); });
+        }
+    }
+}
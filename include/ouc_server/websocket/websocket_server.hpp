@@ -0,0 +1,235 @@
+/**
+ * @file websocket_server.hpp
+ * @brief RFC 6455 WebSocket server built on top of TCPServer.
+ *
+ * Each connection starts with an HTTP upgrade handshake and then carries
+ * frames, parsed incrementally by a FrameParser. Message buffers come from
+ * a shared BufferPool, and broadcast() encodes a frame once and queues the
+ * same buffer on every connection instead of copying it per client.
+ */
+
+#ifndef INCLUDE_OUC_SERVER_WEBSOCKET_SERVER
+#define INCLUDE_OUC_SERVER_WEBSOCKET_SERVER
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include <server/tcp_server.hpp>
+#include <http/http_request.hpp>
+#include <utils/buffer_pool.hpp>
+#include <websocket/websocket_frame.hpp>
+
+namespace ouc_server
+{
+    namespace websocket
+    {
+        /**
+         * @brief Limits and keepalive timing of a WebSocketServer.
+         */
+        struct WebSocketConfig
+        {
+            size_t max_message_size = 16 << 20;   ///< Largest reassembled message, closed with 1009 beyond it.
+            size_t max_handshake_size = 8192;     ///< Largest upgrade request, answered with 431 beyond it.
+            std::chrono::milliseconds ping_interval{30000}; ///< Ping period, 0 disables keepalive.
+            std::chrono::milliseconds pong_timeout{10000};  ///< Silence after a ping before the connection is dropped.
+        };
+
+        /**
+         * @class WebSocketServer
+         * @brief Accepts WebSocket connections and dispatches their messages.
+         *
+         * Callbacks of one connection run in order and never concurrently,
+         * on the TCPServer worker threads. Pings are answered and close
+         * frames echoed automatically.
+         *
+         * Example:
+         * @code
+         * WebSocketServer server;
+         * server.on_message([&](TCPSocket &client, std::string &msg, bool binary){ server.send(client, msg, binary); });
+         * server.start("127.0.0.1", 8080);
+         * while(true) server.loop(10);
+         * @endcode
+         */
+        class WebSocketServer
+        {
+        public:
+            template <typename... Args>
+            using Callback = std::function<void(ouc_server::ouc_socket::TCPSocket &, Args...)>;
+
+            /// Decides whether an upgrade request is accepted, e.g. by its path or Origin.
+            using HandshakeCheck = std::function<bool(const ouc_server::http::HttpRequest &)>;
+
+        private:
+            /// Handshake and frame state bound to one client connection.
+            struct Session
+            {
+                std::mutex mtx;                                      ///< Orders outgoing frames against the close handshake.
+                ouc_server::ouc_socket::TCPSocket *socket = nullptr; ///< Connection currently being fed.
+                bool open = false;                                   ///< Handshake completed.
+                bool closed = false;                                 ///< Connection gone.
+                bool close_sent = false;                             ///< Our close frame is queued, nothing may follow.
+                uint16_t close_code = CLOSE_ABNORMAL;                ///< Code received from the peer.
+                std::string handshake;                               ///< Upgrade request bytes so far.
+                FrameParser parser;
+                std::atomic<int64_t> last_seen; ///< Last input, steady clock ns.
+
+                Session(size_t max_message_size, ouc_server::utils::BufferPool *pool)
+                    : parser(max_message_size, pool), last_seen(0) {}
+            };
+
+            WebSocketConfig config;
+            ouc_server::utils::BufferPool pool; ///< Message buffers shared by all sessions.
+
+            std::mutex sessions_mtx;                                    ///< Guards sessions.
+            std::unordered_map<int, std::shared_ptr<Session>> sessions; ///< State per client fd.
+
+            HandshakeCheck handshake_check;
+            Callback<const ouc_server::http::HttpRequest &> on_open_callback; ///< Callback once the handshake completed.
+            Callback<std::string &, bool> on_message_callback;                ///< Callback for each complete message.
+            Callback<uint16_t> on_close_callback;                             ///< Callback once an open connection is gone.
+
+            std::mutex timer_mtx;          ///< Guards ping_timer against the destructor.
+            uint64_t ping_timer = 0;       ///< Keepalive timer id, 0 if none.
+            bool closing = false;          ///< Destructor running, do not re-arm.
+
+            // Declared last so it is destroyed first: its worker threads are
+            // joined while the sessions and callbacks they use still exist.
+            ouc_server::server::TCPServer server; ///< Underlying TCP transport.
+
+        public:
+            /**
+             * @brief Construct a new WebSocketServer instance.
+             * @param p_config Limits and keepalive timing.
+             * @param task_count Number of thread in the thread pool, 0 for one per CPU.
+             */
+            explicit WebSocketServer(const WebSocketConfig &p_config = {}, size_t task_count = 0);
+
+            ~WebSocketServer();
+
+        public:
+            /**
+             * @brief Register callback checking upgrade requests, refused with 403 when it returns false.
+             */
+            void set_handshake_check(HandshakeCheck &&callback) { handshake_check = std::move(callback); }
+
+            /**
+             * @brief Register callback for completed handshakes.
+             * @param callback Function receiving the upgrade request, e.g. to read its path.
+             */
+            void on_open(Callback<const ouc_server::http::HttpRequest &> &&callback) { on_open_callback = std::move(callback); }
+
+            /**
+             * @brief Register callback for complete messages.
+             * @param callback Function receiving the payload, which it may move from, and whether it is binary.
+             */
+            void on_message(Callback<std::string &, bool> &&callback) { on_message_callback = std::move(callback); }
+
+            /**
+             * @brief Register callback for closed connections that completed the handshake.
+             * @param callback Function receiving the peer's close code, CLOSE_ABNORMAL if none was sent.
+             */
+            void on_close(Callback<uint16_t> &&callback) { on_close_callback = std::move(callback); }
+
+        public:
+            /**
+             * @brief Send a message to one client.
+             * @param client Connection to send to.
+             * @param data Payload, valid UTF-8 unless binary.
+             * @param binary Send a Binary rather than a Text message.
+             * @return false if the connection is not open or already closing.
+             */
+            bool send(ouc_server::ouc_socket::TCPSocket &client, std::string_view data, bool binary = false);
+
+            /**
+             * @brief Send a ping, answered by the client with a pong.
+             * @param payload At most 125 bytes echoed back.
+             */
+            bool ping(ouc_server::ouc_socket::TCPSocket &client, std::string_view payload = {});
+
+            /**
+             * @brief Start the close handshake: send a close frame and close once it is flushed.
+             * @param client Connection to close.
+             * @param code Status code.
+             * @param reason Short text for the peer.
+             */
+            bool close(ouc_server::ouc_socket::TCPSocket &client, uint16_t code = CLOSE_NORMAL, std::string_view reason = {});
+
+            /**
+             * @brief Send one message to every open connection.
+             *
+             * The frame is encoded once and the same buffer queued on all
+             * connections. Never blocks: clients too far behind get the
+             * policy applied instead, see TCPServer::offer().
+             *
+             * @param data Payload, valid UTF-8 unless binary.
+             * @param binary Send a Binary rather than a Text message.
+             * @param policy What to do with clients whose outbox is full.
+             * @return Number of connections it was queued on.
+             */
+            size_t broadcast(std::string_view data, bool binary = false,
+                             ouc_server::server::SlowConsumerPolicy policy = ouc_server::server::SlowConsumerPolicy::Drop);
+
+            /// Connections that completed the handshake and are not closing.
+            size_t get_connection_count();
+
+            ouc_server::utils::BufferPool &get_buffer_pool() noexcept { return pool; }
+
+        public:
+            /**
+             * @brief Start the server listening, see TCPServer::start().
+             */
+            bool start(const std::string &address, uint16_t port);
+
+            /**
+             * @brief Run the event loop for one time.
+             * @param timeout_ms Maximum time to block waiting for events.
+             */
+            void loop(int timeout_ms = 0) { server.loop(timeout_ms); }
+
+            void stop() { server.stop(); }
+
+            ouc_server::server::TCPServer &tcp_server() noexcept { return server; }
+
+        private:
+            std::shared_ptr<Session> find_session(int fd);
+
+            /**
+             * @brief Feed received bytes into the handshake or the frame parser.
+             */
+            void handle_message(ouc_server::ouc_socket::TCPSocket &client, const std::string &data);
+
+            /**
+             * @brief Answer a complete upgrade request.
+             * @return false if it was refused and the connection is closing.
+             */
+            bool handshake(Session &session, size_t head_size);
+
+            void handle_control(Session &session, Opcode opcode, std::string_view payload);
+
+            /**
+             * @brief Queue a frame unless the close frame already went out.
+             * @param session Session to send on.
+             * @param frame Encoded frame.
+             * @param is_close Frame is our close frame: nothing may follow it.
+             * @param policy Offer without blocking, see TCPServer::offer(); nullopt to wait for room.
+             */
+            bool send_frame(Session &session, ouc_server::server::TCPServer::SharedBuffer frame, bool is_close = false,
+                            std::optional<ouc_server::server::SlowConsumerPolicy> policy = std::nullopt);
+
+            /// Keepalive timer: ping everyone, drop connections silent for too long.
+            void keepalive();
+
+            void arm_keepalive();
+        };
+    }
+}
+
+#endif // INCLUDE_OUC_SERVER_WEBSOCKET_SERVER
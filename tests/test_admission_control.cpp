@@ -0,0 +1,209 @@
+#include <server/admission_control.hpp>
+#include <server/http_server.hpp>
+
+#include <unistd.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <string>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+
+constexpr uint16_t PORT = 18085;
+
+int failures = 0;
+
+void check(bool cond, const char *what)
+{
+    if (!cond)
+    {
+        std::cout << "FAILED: " << what << "\n";
+        ++failures;
+    }
+}
+
+sockaddr_storage make_addr(int family, const char *ip)
+{
+    sockaddr_storage ss{};
+    if (family == AF_INET)
+    {
+        auto &in = reinterpret_cast<sockaddr_in &>(ss);
+        in.sin_family = AF_INET;
+        inet_pton(AF_INET, ip, &in.sin_addr);
+    }
+    else
+    {
+        auto &in6 = reinterpret_cast<sockaddr_in6 &>(ss);
+        in6.sin6_family = AF_INET6;
+        inet_pton(AF_INET6, ip, &in6.sin6_addr);
+    }
+    return ss;
+}
+
+int connect_server()
+{
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(PORT);
+    inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+    if (connect(fd, (sockaddr *)&addr, sizeof(addr)) < 0)
+    {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/// True if the server closed the connection within timeout_ms.
+bool closed_by_server(int fd, int timeout_ms)
+{
+    pollfd pfd{fd, POLLIN, 0};
+    if (poll(&pfd, 1, timeout_ms) != 1)
+        return false;
+    char c;
+    return recv(fd, &c, 1, 0) == 0;
+}
+
+/// Send one request and return the status line of the answer.
+std::string request(int fd)
+{
+    std::string req = "GET / HTTP/1.1\r\nHost: x\r\n\r\n";
+    send(fd, req.data(), req.size(), MSG_NOSIGNAL);
+
+    std::string res;
+    char buf[512];
+    while (res.find("\r\n\r\n") == std::string::npos)
+    {
+        ssize_t n = recv(fd, buf, sizeof(buf), 0);
+        if (n <= 0)
+            return "";
+        res.append(buf, n);
+    }
+    // Consume the body so the next answer starts clean
+    size_t body_start = res.find("\r\n\r\n") + 4;
+    size_t cl = res.find("Content-Length: ");
+    size_t length = cl == std::string::npos ? 0 : std::stoul(res.substr(cl + 16));
+    if (res.size() - body_start < length)
+        recv(fd, buf, length - (res.size() - body_start), MSG_WAITALL);
+    return res.substr(0, res.find("\r\n"));
+}
+
+int main()
+{
+    using namespace ouc_server::server;
+
+    // Keys: IPv4, its IPv4-mapped form, an IPv6 /64
+    {
+        uint64_t v4 = AdmissionControl::key_of(make_addr(AF_INET, "192.0.2.1"));
+        check(v4 != 0, "IPv4 tracked");
+        check(AdmissionControl::key_of(make_addr(AF_INET6, "::ffff:192.0.2.1")) == v4, "mapped IPv4 shares the key");
+        check(AdmissionControl::key_of(make_addr(AF_INET6, "2001:db8::1")) ==
+                  AdmissionControl::key_of(make_addr(AF_INET6, "2001:db8::ffff")),
+              "same /64 shares the key");
+        check(AdmissionControl::key_of(make_addr(AF_INET6, "2001:db8:0:1::1")) !=
+                  AdmissionControl::key_of(make_addr(AF_INET6, "2001:db8::1")),
+              "other /64 differs");
+
+        sockaddr_storage unix_addr{};
+        unix_addr.ss_family = AF_UNIX;
+        check(AdmissionControl::key_of(unix_addr) == 0, "unix peers untracked");
+    }
+
+    // Connection caps per client
+    {
+        AdmissionConfig config;
+        config.max_connections_per_client = 2;
+        AdmissionControl admission(config);
+
+        int a, b, c, other;
+        check(admission.admit(42, a) && a >= 0, "first connection");
+        check(admission.admit(42, b) && b == a, "second connection, same slot");
+        check(!admission.admit(42, c), "third connection refused");
+        check(admission.admit(43, other) && other != a, "other client unaffected");
+
+        admission.release(a);
+        check(admission.admit(42, c), "admitted again after a release");
+    }
+
+    // Token bucket: burst, then refill at the configured rate
+    {
+        AdmissionConfig config;
+        config.requests_per_second = 100;
+        config.burst = 3;
+        AdmissionControl admission(config);
+
+        int slot;
+        admission.admit(7, slot);
+        check(admission.take(slot) && admission.take(slot) && admission.take(slot), "burst allowed");
+        check(!admission.take(slot), "over the burst refused");
+        std::this_thread::sleep_for(std::chrono::milliseconds(25));
+        check(admission.take(slot), "refilled after a while");
+        check(admission.take(-1), "untracked always passes");
+    }
+
+    // Enforced by the server
+    ouc_server::server::HttpServer server(2);
+    AdmissionConfig config;
+    config.max_connections_per_client = 2;
+    config.requests_per_second = 1;
+    config.burst = 2;
+    server.set_admission(config);
+    server.on_request(
+        [](ouc_server::http::HttpRequest &, ouc_server::http::HttpResponseWriter &res)
+        { res.end("ok"); });
+
+    if (!server.start("127.0.0.1", PORT))
+    {
+        std::cerr << "Failed to start server\n";
+        return 1;
+    }
+
+    std::atomic<bool> running{true};
+    std::thread loop(
+        [&]()
+        {
+            while (running.load())
+                server.loop(10);
+        });
+
+    int first = connect_server();
+    int second = connect_server();
+    int third = connect_server();
+    check(first >= 0 && second >= 0 && third >= 0, "connect");
+    check(closed_by_server(third, 1000), "connection over the per-client cap closed");
+
+    check(request(first) == "HTTP/1.1 200 OK", "first request served");
+    check(request(first) == "HTTP/1.1 200 OK", "second request served");
+    check(request(first) == "HTTP/1.1 429 Too Many Requests", "third request rate limited");
+    check(request(second) == "HTTP/1.1 429 Too Many Requests", "limit is per client, not per connection");
+
+    const auto &metrics = server.tcp_server().get_metrics();
+    check(metrics.admission_rejects.value() == 1, "one connection rejected");
+    check(metrics.rate_limited.value() == 2, "two requests rate limited");
+
+    close(first);
+    close(second);
+    close(third);
+
+    // Slots freed on close: two new connections fit again
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    int fourth = connect_server();
+    int fifth = connect_server();
+    check(!closed_by_server(fourth, 100) && !closed_by_server(fifth, 100), "slots released on close");
+    close(fourth);
+    close(fifth);
+
+    running.store(false);
+    loop.join();
+
+    if (failures == 0)
+        std::cout << "Test passed.\n";
+    else
+        std::cout << "Test failed.\n";
+
+    return failures == 0 ? 0 : 1;
+}
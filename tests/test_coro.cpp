@@ -0,0 +1,189 @@
+#include <coro/async_socket.hpp>
+
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <string>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <iostream>
+
+constexpr uint16_t PORT = 18087;
+
+int failures = 0;
+
+void check(bool cond, const char *what)
+{
+    if (!cond)
+    {
+        std::cout << "FAILED: " << what << "\n";
+        ++failures;
+    }
+}
+
+using namespace ouc_server::coro;
+
+Task<int> add(int a, int b) { co_return a + b; }
+
+Task<int> sum_to(int n)
+{
+    int total = 0;
+    for (int i = 1; i <= n; ++i)
+        total = co_await add(total, i);
+    co_return total;
+}
+
+Task<int> fail() { throw std::runtime_error("boom"); co_return 0; }
+
+Task<void> run_basics(std::atomic<int> &result, std::atomic<bool> &caught)
+{
+    result = co_await sum_to(100);
+    try
+    {
+        co_await fail();
+    }
+    catch (const std::runtime_error &)
+    {
+        caught = true;
+    }
+}
+
+int connect_server()
+{
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(PORT);
+    inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+    if (connect(fd, (sockaddr *)&addr, sizeof(addr)) < 0)
+    {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+std::string read_exactly(int fd, size_t len)
+{
+    std::string res;
+    char buf[65536];
+    while (res.size() < len)
+    {
+        ssize_t n = recv(fd, buf, std::min(sizeof(buf), len - res.size()), 0);
+        if (n <= 0)
+            break;
+        res.append(buf, n);
+    }
+    return res;
+}
+
+int main()
+{
+    using ouc_server::epoll::EpollLoop;
+    using ouc_server::ouc_socket::TCPSocket;
+
+    // Nested tasks, values and exceptions
+    {
+        std::atomic<int> result{0};
+        std::atomic<bool> caught{false};
+        spawn(run_basics(result, caught));
+        check(result.load() == 5050, "nested task values");
+        check(caught.load(), "exception reaches the awaiter");
+    }
+
+    // Freed frames are handed out again
+    {
+        void *a = FramePool::allocate(200);
+        FramePool::deallocate(a);
+        void *b = FramePool::allocate(190);
+        check(a == b, "frame reused from the pool");
+        FramePool::deallocate(b);
+    }
+
+    // One loop thread serves every connection
+    EpollLoop loop(1);
+    TCPSocket listener = TCPSocket::create();
+    if (!listener.bind("127.0.0.1", PORT) || !listener.listen())
+    {
+        std::cerr << "Failed to listen\n";
+        return 1;
+    }
+
+    const std::string big(4 * 1024 * 1024, 'x');
+    std::atomic<int> handlers{0};
+    std::atomic<bool> slept{false};
+    spawn(serve(loop, std::move(listener), [&](AsyncSocket conn) -> Task<void>
+                {
+                    ++handlers;
+                    while (true)
+                    {
+                        std::string line = co_await conn.read_until("\n");
+                        if (line.empty())
+                            co_return;
+
+                        if (line == "sleep\n")
+                        {
+                            auto start = std::chrono::steady_clock::now();
+                            co_await sleep_for(loop, std::chrono::milliseconds(30));
+                            slept = std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(29);
+                        }
+                        else if (line == "big\n")
+                        {
+                            if (!co_await conn.write_all(big))
+                                co_return;
+                            continue;
+                        }
+
+                        if (!co_await conn.write_all(line))
+                            co_return;
+                    }
+                }));
+
+    std::atomic<bool> running{true};
+    std::thread loop_thread(
+        [&]()
+        {
+            while (running.load())
+                loop.poll(10);
+        });
+
+    int a = connect_server();
+    int b = connect_server();
+    check(a >= 0 && b >= 0, "connect");
+
+    // Lines split over several sends and several lines in one send
+    send(a, "hel", 3, MSG_NOSIGNAL);
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    send(a, "lo\nworld\n", 9, MSG_NOSIGNAL);
+    check(read_exactly(a, 12) == "hello\nworld\n", "read_until across chunks");
+
+    // A sleeping handler does not hold up another connection
+    send(a, "sleep\n", 6, MSG_NOSIGNAL);
+    send(b, "quick\n", 6, MSG_NOSIGNAL);
+    check(read_exactly(b, 6) == "quick\n", "other connection served while one sleeps");
+    check(read_exactly(a, 6) == "sleep\n", "sleeping handler resumes");
+    check(slept.load(), "sleep_for waited");
+
+    // Larger than the socket buffers: write_all suspends until the client reads
+    send(b, "big\n", 4, MSG_NOSIGNAL);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    check(read_exactly(b, big.size()) == big, "write_all delivers everything");
+
+    close(a);
+    close(b);
+    check(handlers.load() == 2, "one handler per connection");
+
+    running.store(false);
+    loop_thread.join();
+    loop.shutdown();
+
+    if (failures == 0)
+        std::cout << "Test passed.\n";
+    else
+        std::cout << "Test failed.\n";
+
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,122 @@
+#include <epoll/epoll_loop.hpp>
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <iostream>
+
+int failures = 0;
+
+void check(bool cond, const char *what)
+{
+    if (!cond)
+    {
+        std::cout << "FAILED: " << what << "\n";
+        ++failures;
+    }
+}
+
+int main()
+{
+    using ouc_server::epoll::EpollLoop;
+    using Clock = std::chrono::steady_clock;
+
+    EpollLoop loop(2);
+
+    int fds[2];
+    if (pipe2(fds, O_NONBLOCK) != 0)
+        return 1;
+
+    std::atomic<int> fired{0};
+    loop.add_fd(fds[0], EPOLLIN | EPOLLONESHOT,
+                [&](int fd)
+                {
+                    char buf[64];
+                    while (read(fd, buf, sizeof(buf)) > 0)
+                        ;
+                    ++fired;
+                    loop.modify_fd(fd, EPOLLIN | EPOLLONESHOT);
+                });
+
+    auto wait_for_fired = [&](int n)
+    {
+        auto deadline = Clock::now() + std::chrono::seconds(1);
+        while (fired.load() < n && Clock::now() < deadline)
+            std::this_thread::yield();
+        return fired.load() >= n;
+    };
+
+    // wakeup() releases a poll blocked without timeout
+    std::thread poller(
+        [&]()
+        { loop.poll(-1); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    loop.wakeup();
+    poller.join();
+    check(fired.load() == 0, "wakeup runs no callback");
+
+    // Events right after activity are picked up while spinning
+    loop.set_busy_poll(std::chrono::milliseconds(500));
+    (void)!write(fds[1], "a", 1);
+    loop.poll(100);
+    check(wait_for_fired(1), "first event delivered");
+
+    std::thread writer(
+        [&]()
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            (void)!write(fds[1], "b", 1);
+        });
+    loop.poll(100);
+    writer.join();
+    check(wait_for_fired(2), "second event delivered");
+    check(loop.get_spin_hits() >= 1, "event found while spinning");
+
+    // A quiet loop still honours the timeout
+    loop.set_busy_poll(std::chrono::microseconds(200));
+    auto start = Clock::now();
+    loop.poll(30);
+    auto elapsed = Clock::now() - start;
+    check(elapsed >= std::chrono::milliseconds(25) && elapsed < std::chrono::milliseconds(500), "timeout honoured after spinning");
+
+    // An event pending once the window has passed is an ordinary wakeup
+    uint64_t hits = loop.get_spin_hits();
+    (void)!write(fds[1], "c", 1);
+    loop.poll(100);
+    check(wait_for_fired(3), "third event delivered");
+    check(loop.get_spin_hits() == hits, "wakeup after the window not counted as a spin hit");
+
+    // Timers fire from poll() in deadline order, cancelled ones never
+    loop.set_busy_poll(std::chrono::microseconds(0));
+    std::atomic<int> order{0}, first{0}, second{0}, cancelled{0};
+    loop.add_timer(std::chrono::milliseconds(20), [&]()
+                   { second = ++order; });
+    loop.add_timer(std::chrono::milliseconds(5), [&]()
+                   { first = ++order; });
+    uint64_t id = loop.add_timer(std::chrono::milliseconds(10), [&]()
+                                 { ++cancelled; });
+    check(id != 0, "timer id");
+    check(loop.cancel_timer(id), "cancel pending timer");
+    check(!loop.cancel_timer(id), "cancel only once");
+
+    start = Clock::now();
+    while (second.load() == 0 && Clock::now() - start < std::chrono::seconds(1))
+        loop.poll(50);
+    elapsed = Clock::now() - start;
+    check(first.load() == 1 && second.load() == 2, "timers fire in deadline order");
+    check(elapsed >= std::chrono::milliseconds(19), "timer not early");
+    check(cancelled.load() == 0, "cancelled timer silent");
+
+    loop.shutdown();
+    close(fds[0]);
+    close(fds[1]);
+
+    if (failures == 0)
+        std::cout << "Test passed.\n";
+    else
+        std::cout << "Test failed.\n";
+
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,360 @@
+#include <server/tcp_server.hpp>
+#include <socket/tls.hpp>
+
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <string>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <iostream>
+
+#ifdef OUC_SERVER_TLS
+#include <openssl/ssl.h>
+#include <openssl/x509.h>
+#include <openssl/pem.h>
+#include <openssl/evp.h>
+#endif
+
+constexpr uint16_t PORT = 18097;
+constexpr uint16_t TLS_PORT = 18101;
+constexpr size_t BLOCK = 16 * 1024;
+
+int failures = 0;
+
+void check(bool cond, const char *what)
+{
+    if (!cond)
+    {
+        std::cout << "FAILED: " << what << "\n";
+        ++failures;
+    }
+}
+
+int connect_to_server(int rcvbuf = 0, uint16_t port = PORT)
+{
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (rcvbuf > 0)
+        setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+    timeval tv{5, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+    if (connect(fd, (sockaddr *)&addr, sizeof(addr)) < 0)
+    {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/// Read until the stream holds expected, false on timeout or close.
+bool read_until(int fd, std::string &got, const std::string &expected)
+{
+    char buf[4096];
+    while (got.size() < expected.size())
+    {
+        ssize_t n = recv(fd, buf, sizeof(buf), 0);
+        if (n <= 0)
+            return false;
+        got.append(buf, n);
+    }
+    return got == expected;
+}
+
+/// Read whole blocks of one letter each until the 'Z' block, false if any block is torn.
+bool read_blocks(int fd, size_t &blocks)
+{
+    std::string pending;
+    char buf[16384];
+    blocks = 0;
+    while (true)
+    {
+        ssize_t n = recv(fd, buf, sizeof(buf), 0);
+        if (n <= 0)
+            return false;
+        pending.append(buf, n);
+        while (pending.size() >= BLOCK)
+        {
+            if (pending.find_first_not_of(pending[0], 0) < BLOCK)
+                return false;
+            ++blocks;
+            if (pending[0] == 'Z')
+                return pending.size() == BLOCK;
+            pending.erase(0, BLOCK);
+        }
+    }
+}
+
+std::shared_ptr<const std::string> block_of(char c)
+{
+    return std::make_shared<const std::string>(BLOCK, c);
+}
+
+#ifdef OUC_SERVER_TLS
+/// Write a self-signed P-256 certificate for localhost and its key.
+bool make_certificate(const std::string &cert_file, const std::string &key_file)
+{
+    EVP_PKEY *key = EVP_EC_gen("P-256");
+    X509 *cert = X509_new();
+    if (key == nullptr || cert == nullptr)
+        return false;
+
+    ASN1_INTEGER_set(X509_get_serialNumber(cert), 1);
+    X509_gmtime_adj(X509_getm_notBefore(cert), 0);
+    X509_gmtime_adj(X509_getm_notAfter(cert), 3600);
+    X509_set_pubkey(cert, key);
+    X509_NAME *name = X509_get_subject_name(cert);
+    X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC, reinterpret_cast<const unsigned char *>("localhost"), -1, -1, 0);
+    X509_set_issuer_name(cert, name);
+    bool ok = X509_sign(cert, key, EVP_sha256()) > 0;
+
+    FILE *f = std::fopen(cert_file.c_str(), "w");
+    ok = ok && f && PEM_write_X509(f, cert);
+    if (f)
+        std::fclose(f);
+    f = std::fopen(key_file.c_str(), "w");
+    ok = ok && f && PEM_write_PrivateKey(f, key, nullptr, nullptr, 0, nullptr, nullptr);
+    if (f)
+        std::fclose(f);
+
+    X509_free(cert);
+    EVP_PKEY_free(key);
+    return ok;
+}
+
+/// read_blocks() over TLS for blocks of size bytes, pausing between records
+/// so the server's socket stays full: a torn block or a failed read ends it.
+bool read_tls_blocks(SSL *ssl, size_t size, size_t &blocks)
+{
+    std::string pending;
+    char buf[16384];
+    blocks = 0;
+    while (true)
+    {
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+        int n = SSL_read(ssl, buf, sizeof(buf));
+        if (n <= 0)
+            return false;
+        pending.append(buf, n);
+        while (pending.size() >= size)
+        {
+            if (pending.find_first_not_of(pending[0], 0) < size)
+                return false;
+            ++blocks;
+            if (pending[0] == 'Z')
+                return pending.size() == size;
+            pending.erase(0, size);
+        }
+    }
+}
+
+/// Coalesce on a TLS connection written through OpenSSL: a chunk that
+/// SSL_write() is retrying must not be swapped for another one.
+void test_tls_coalesce()
+{
+    using namespace ouc_server::server;
+    using namespace ouc_server::ouc_socket;
+
+    const std::string cert_file = "/tmp/ouc_server_test_fanout_cert.pem";
+    const std::string key_file = "/tmp/ouc_server_test_fanout_key.pem";
+    check(make_certificate(cert_file, key_file), "certificate generated");
+    auto context = TLSContext::create(cert_file, key_file);
+    check(context != nullptr, "tls context created");
+    if (context == nullptr)
+        return;
+
+    TCPServer server(2);
+    server.set_tls(context);
+    server.set_socket_options(SocketOptions().send_buffer(16 * 1024));
+    server.on_connection([&](TCPSocket &client)
+                         { server.subscribe(client, "feed"); });
+    if (!server.start("127.0.0.1", TLS_PORT))
+    {
+        check(false, "tls server started");
+        return;
+    }
+
+    std::atomic<bool> running{true};
+    std::thread loop_thread(
+        [&]()
+        {
+            while (running.load())
+                server.loop(10);
+        });
+
+    SSL_CTX *ctx = SSL_CTX_new(TLS_client_method());
+    int fd = connect_to_server(4096, TLS_PORT);
+    SSL *ssl = SSL_new(ctx);
+    SSL_set_fd(ssl, fd);
+    check(SSL_connect(ssl) == 1, "tls handshake");
+    for (int i = 0; i < 200 && server.get_subscriber_count("feed") != 1; ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+
+    // Messages over the outbox limit: each one is alone in the outbox, so
+    // coalescing targets the front chunk, often while SSL_write() retries it.
+    // The reader drains slowly so the socket keeps filling up.
+    const size_t big = TCPServer::MAX_OUTBOX_BYTES + BLOCK;
+    std::atomic<bool> reading{true};
+    size_t blocks = 0;
+    bool whole = false;
+    std::thread reader(
+        [&]
+        {
+            whole = read_tls_blocks(ssl, big, blocks);
+            reading.store(false);
+        });
+
+    for (int i = 0; i < 400 && reading.load(); ++i)
+    {
+        server.publish("feed", std::make_shared<const std::string>(big, static_cast<char>('a' + i % 25)), SlowConsumerPolicy::Coalesce);
+        std::this_thread::sleep_for(std::chrono::microseconds(100 * (i % 20)));
+    }
+    server.publish("feed", std::make_shared<const std::string>(big, 'Z'), SlowConsumerPolicy::Coalesce);
+    reader.join();
+
+    check(server.get_metrics().fanout_coalesced.value() > 0, "tls client had messages coalesced");
+    check(whole, "tls client gets whole messages and the last one");
+
+    SSL_shutdown(ssl);
+    SSL_free(ssl);
+    close(fd);
+    SSL_CTX_free(ctx);
+
+    running.store(false);
+    loop_thread.join();
+    std::remove(cert_file.c_str());
+    std::remove(key_file.c_str());
+}
+#endif
+
+int main()
+{
+    using namespace ouc_server::server;
+    using namespace ouc_server::ouc_socket;
+
+    TCPServer server(2);
+    server.on_connection([&](TCPSocket &client)
+                         { server.subscribe(client, "feed"); });
+
+    if (!server.start("127.0.0.1", PORT))
+    {
+        std::cerr << "Failed to start server\n";
+        return 1;
+    }
+
+    std::atomic<bool> running{true};
+    std::thread loop_thread(
+        [&]()
+        {
+            while (running.load())
+                server.loop(10);
+        });
+
+    auto wait_subscribers = [&](size_t count)
+    {
+        for (int i = 0; i < 200 && server.get_subscriber_count("feed") != count; ++i)
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        return server.get_subscriber_count("feed") == count;
+    };
+
+    // Many small messages to several clients: one shared buffer each, in order
+    {
+        int fds[3];
+        for (int &fd : fds)
+            fd = connect_to_server();
+        check(wait_subscribers(3), "three subscribers");
+
+        std::string expected;
+        for (int i = 0; i < 500; ++i)
+        {
+            auto message = std::make_shared<const std::string>("m" + std::to_string(i) + ";");
+            expected += *message;
+            check(server.publish("feed", message) == 3, "published to every subscriber");
+        }
+        check(server.broadcast(std::make_shared<const std::string>("all")) == 3, "broadcast to every connection");
+        expected += "all";
+        check(server.publish("other", std::make_shared<const std::string>("x")) == 0, "no subscribers, nothing queued");
+
+        for (int fd : fds)
+        {
+            std::string got;
+            check(read_until(fd, got, expected), "messages arrive whole and in order");
+            close(fd);
+        }
+        check(wait_subscribers(0), "closing a client ends its subscriptions");
+    }
+
+    // Coalesce: a client that stops reading never stalls the publisher and
+    // still ends up with the latest message
+    {
+        int slow = connect_to_server(4096);
+        int fast = connect_to_server();
+        check(wait_subscribers(2), "slow and fast subscribers");
+
+        size_t fast_blocks = 0;
+        bool fast_ok = false;
+        std::thread fast_reader([&]
+                                { fast_ok = read_blocks(fast, fast_blocks); });
+
+        auto start = std::chrono::steady_clock::now();
+        int published = 0;
+        while (server.get_metrics().fanout_coalesced.value() == 0 && published < 8000)
+            server.publish("feed", block_of(static_cast<char>('a' + published++ % 25)), SlowConsumerPolicy::Coalesce);
+        server.publish("feed", block_of('Z'), SlowConsumerPolicy::Coalesce);
+        auto elapsed = std::chrono::steady_clock::now() - start;
+
+        check(server.get_metrics().fanout_coalesced.value() > 0, "lagging client had messages coalesced");
+        check(elapsed < std::chrono::seconds(3), "publishing never waited for the slow client");
+
+        size_t slow_blocks = 0;
+        check(read_blocks(slow, slow_blocks), "slow client gets whole blocks and the last one");
+        check(slow_blocks < static_cast<size_t>(published) + 1, "slow client skipped superseded blocks");
+
+        fast_reader.join();
+        check(fast_ok, "fast client gets whole blocks and the last one");
+        close(slow);
+        close(fast);
+        check(wait_subscribers(0), "both unsubscribed on close");
+    }
+
+    // Drop and Disconnect
+    {
+        int slow = connect_to_server(4096);
+        check(wait_subscribers(1), "one slow subscriber");
+
+        uint64_t dropped = server.get_metrics().fanout_dropped.value();
+        for (int i = 0; i < 8000 && server.get_metrics().fanout_dropped.value() == dropped; ++i)
+            server.publish("feed", block_of('d'), SlowConsumerPolicy::Drop);
+        check(server.get_metrics().fanout_dropped.value() > dropped, "lagging client had messages dropped");
+        check(server.get_subscriber_count("feed") == 1, "dropping keeps the client");
+
+        check(server.publish("feed", block_of('x'), SlowConsumerPolicy::Disconnect) == 0, "lagging client refused");
+        check(server.get_metrics().slow_disconnects.value() == 1, "slow disconnect counted");
+        check(wait_subscribers(0), "disconnected client removed");
+
+        char buf[16384];
+        ssize_t n;
+        while ((n = recv(slow, buf, sizeof(buf), 0)) > 0)
+            ;
+        check(n == 0 || errno != EAGAIN, "disconnected client sees the connection end");
+        close(slow);
+    }
+
+    running.store(false);
+    loop_thread.join();
+
+#ifdef OUC_SERVER_TLS
+    test_tls_coalesce();
+#endif
+
+    std::cout << (failures == 0 ? "Test passed.\n" : "Test failed.\n");
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,136 @@
+#include <server/framed_server.hpp>
+#include <codec/length_prefixed_codec.hpp>
+
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <string>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+
+constexpr uint16_t PORT = 18098;
+
+int failures = 0;
+
+void check(bool cond, const char *what)
+{
+    if (!cond)
+    {
+        std::cout << "FAILED: " << what << "\n";
+        ++failures;
+    }
+}
+
+int connect_to_server()
+{
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    timeval tv{5, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(PORT);
+    inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+    if (connect(fd, (sockaddr *)&addr, sizeof(addr)) < 0)
+    {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+void send_all(int fd, const std::string &data)
+{
+    size_t sent = 0;
+    while (sent < data.size())
+    {
+        ssize_t n = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0)
+            return;
+        sent += n;
+    }
+}
+
+int main()
+{
+    using namespace ouc_server::server;
+    using namespace ouc_server::codec;
+    using ouc_server::ouc_socket::TCPSocket;
+
+    LengthPrefixedConfig config{LengthPrefix::Varint, 4096};
+    FramedServer server([config]
+                        { return std::make_unique<LengthPrefixedCodec>(config); },
+                        2);
+
+    // Echo every frame twice, batched into one write
+    server.on_frame([&](TCPSocket &client, std::string_view frame)
+                    { server.send(client, std::vector<std::string_view>{frame, frame}); });
+
+    if (!server.start("127.0.0.1", PORT))
+    {
+        std::cerr << "Failed to start server\n";
+        return 1;
+    }
+
+    std::atomic<bool> running{true};
+    std::thread loop_thread(
+        [&]()
+        {
+            while (running.load())
+                server.loop(10);
+        });
+
+    LengthPrefixedCodec client_codec(config);
+
+    // Frames dribbled in byte by byte come back whole
+    {
+        int fd = connect_to_server();
+        std::string wire;
+        for (int i = 0; i < 50; ++i)
+            client_codec.encode(wire, "frame-" + std::to_string(i) + std::string(i * 40, '.'));
+        for (size_t i = 0; i < wire.size(); i += 7)
+            send_all(fd, wire.substr(i, 7));
+
+        std::vector<std::string> got;
+        char buf[4096];
+        while (got.size() < 100)
+        {
+            ssize_t n = recv(fd, buf, sizeof(buf), 0);
+            if (n <= 0 || !client_codec.decode(std::string_view(buf, n), [&](std::string_view frame)
+                                               { got.emplace_back(frame); }))
+                break;
+        }
+
+        bool in_order = got.size() == 100;
+        for (size_t i = 0; in_order && i < got.size(); ++i)
+            in_order = got[i] == "frame-" + std::to_string(i / 2) + std::string(i / 2 * 40, '.');
+        check(in_order, "every frame echoed twice, in order");
+        close(fd);
+    }
+
+    // A frame over the limit closes the connection
+    {
+        int fd = connect_to_server();
+        std::string wire;
+        client_codec.encode(wire, std::string(5000, 'x'));
+        send_all(fd, wire);
+
+        char buf[4096];
+        check(recv(fd, buf, sizeof(buf), 0) <= 0, "connection closed on an oversized frame");
+        close(fd);
+
+        std::string metrics;
+        server.write_metrics(metrics);
+        check(metrics.find("ouc_framed_codec_errors_total 1") != std::string::npos, "codec error counted");
+    }
+
+    running.store(false);
+    loop_thread.join();
+
+    std::cout << (failures == 0 ? "Test passed.\n" : "Test failed.\n");
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,54 @@
+#include <utils/histogram.hpp>
+
+#include <iostream>
+
+int failures = 0;
+
+void check(bool cond, const char *what)
+{
+    if (!cond)
+    {
+        std::cout << "FAILED: " << what << "\n";
+        ++failures;
+    }
+}
+
+int main()
+{
+    using ouc_server::utils::Histogram;
+
+    // Every value maps into a bucket whose bound covers it within ~6%
+    for (uint64_t v : {0ull, 1ull, 15ull, 16ull, 17ull, 1000ull, 123456789ull, ~0ull})
+    {
+        size_t idx = Histogram::bucket_of(v);
+        uint64_t upper = Histogram::upper_bound_of(idx);
+        check(idx < Histogram::BUCKET_COUNT, "bucket index in range");
+        check(upper >= v, "upper bound covers value");
+        check(upper - v <= v / 16 + 1, "relative error bounded");
+    }
+
+    Histogram a, b;
+    for (uint64_t i = 1; i <= 1000; ++i)
+        a.record(i * 1000);
+    for (uint64_t i = 0; i < 10; ++i)
+        b.record(10'000'000);
+
+    check(a.count() == 1000 && a.min() == 1000 && a.max() == 1'000'000, "count, min and max");
+    uint64_t p50 = a.percentile(50);
+    check(p50 >= 500'000 && p50 <= 500'000 * 17 / 16, "p50 within a bucket");
+
+    a.merge(b);
+    check(a.count() == 1010, "merge adds counts");
+    check(a.percentile(99.9) == 10'000'000, "tail comes from merged samples");
+    check(a.percentile(100) == a.max(), "p100 is the max");
+
+    a.reset();
+    check(a.count() == 0 && a.percentile(99) == 0, "reset");
+
+    if (failures == 0)
+        std::cout << "Test passed.\n";
+    else
+        std::cout << "Test failed.\n";
+
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,150 @@
+#include <http/http_compression.hpp>
+#include <http/http_response_writer.hpp>
+
+#include <string>
+#include <iostream>
+
+#ifdef OUC_SERVER_ZLIB
+#include <zlib.h>
+#endif
+
+int failures = 0;
+
+void check(bool cond, const char *what)
+{
+    if (!cond)
+    {
+        std::cout << "FAILED: " << what << "\n";
+        ++failures;
+    }
+}
+
+#ifdef OUC_SERVER_ZLIB
+/// Undo compress(), accepting either wrapper.
+std::string inflate_all(std::string_view in)
+{
+    z_stream stream{};
+    inflateInit2(&stream, 15 + 32);
+    stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(in.data()));
+    stream.avail_in = static_cast<uInt>(in.size());
+
+    std::string out;
+    char buf[16384];
+    int code = Z_OK;
+    while (code == Z_OK)
+    {
+        stream.next_out = reinterpret_cast<Bytef *>(buf);
+        stream.avail_out = sizeof(buf);
+        code = inflate(&stream, Z_NO_FLUSH);
+        out.append(buf, sizeof(buf) - stream.avail_out);
+    }
+    inflateEnd(&stream);
+    return code == Z_STREAM_END ? out : std::string();
+}
+#endif
+
+int main()
+{
+    using namespace ouc_server::http;
+
+    // Negotiation
+    {
+        check(negotiate_encoding("") == ContentEncoding::Identity, "no header, no coding");
+        check(negotiate_encoding("gzip, deflate, br") == ContentEncoding::Gzip, "gzip preferred on a tie");
+        check(negotiate_encoding("deflate") == ContentEncoding::Deflate, "deflate alone");
+        check(negotiate_encoding("gzip;q=0.5, deflate;q=0.8") == ContentEncoding::Deflate, "q-values honored");
+        check(negotiate_encoding("gzip;q=0, deflate;q=0") == ContentEncoding::Identity, "q=0 refuses");
+        check(negotiate_encoding("*") == ContentEncoding::Gzip, "wildcard accepts gzip");
+        check(negotiate_encoding("br, *;q=0") == ContentEncoding::Identity, "wildcard q=0 refuses the rest");
+        check(negotiate_encoding("GZIP") == ContentEncoding::Gzip, "coding names ignore case");
+
+        check(is_compressible("text/html; charset=utf-8"), "text compressible");
+        check(is_compressible("application/json") && is_compressible("application/problem+json"), "json compressible");
+        check(!is_compressible("image/png") && !is_compressible("application/octet-stream"), "binary not compressible");
+    }
+
+    std::string text;
+    for (int i = 0; i < 400; ++i)
+        text += "{\"id\":" + std::to_string(i) + ",\"name\":\"item\"},";
+
+#ifdef OUC_SERVER_ZLIB
+    // Round trip through the per-thread streams, twice to exercise the reset
+    {
+        for (auto encoding : {ContentEncoding::Gzip, ContentEncoding::Deflate, ContentEncoding::Gzip})
+        {
+            std::string packed;
+            check(compress(encoding, text, packed), "compressed");
+            check(packed.size() < text.size() / 4, "repetitive text shrinks");
+            check(inflate_all(packed) == text, "round trip");
+        }
+        std::string packed;
+        check(compress(ContentEncoding::Gzip, text, packed, 1) && inflate_all(packed) == text, "level change");
+    }
+
+    // Cache: compressed once per key and coding
+    {
+        CompressionCache cache;
+        auto first = cache.get("/data", ContentEncoding::Gzip, text);
+        auto second = cache.get("/data", ContentEncoding::Gzip, text);
+        auto other = cache.get("/data", ContentEncoding::Deflate, text);
+        check(first && first == second, "cached variant reused");
+        check(other && other != first, "one variant per coding");
+        check(cache.get_hits() == 1 && cache.get_misses() == 2, "hits and misses counted");
+
+        CompressionConfig small;
+        small.cache_bytes = first->size() + 1;
+        CompressionCache tiny(small);
+        tiny.get("a", ContentEncoding::Gzip, text);
+        tiny.get("b", ContentEncoding::Gzip, text);
+        check(tiny.get_bytes() <= small.cache_bytes, "cache stays within its budget");
+        tiny.get("b", ContentEncoding::Gzip, text);
+        check(tiny.get_hits() == 1, "most recent entry kept");
+    }
+
+    // Writer: whole bodies compressed, headers adjusted
+    {
+        CompressionCache cache;
+        std::string out;
+        HttpResponseWriter writer([&](std::string &&data)
+                                  { out.append(data); return true; });
+        writer.set_compression(ContentEncoding::Gzip, &cache);
+        writer.header("Content-Type", "application/json").cache_as("/items").end(text);
+
+        size_t split = out.find("\r\n\r\n");
+        std::string head = out.substr(0, split);
+        std::string body = out.substr(split + 4);
+        check(head.find("Content-Encoding: gzip") != std::string::npos, "Content-Encoding set");
+        check(head.find("Vary: Accept-Encoding") != std::string::npos, "Vary set");
+        check(head.find("Content-Length: " + std::to_string(body.size())) != std::string::npos, "length of the compressed body");
+        check(inflate_all(body) == text, "writer body decompresses");
+        check(cache.get_misses() == 1, "writer used the cache");
+    }
+#endif
+
+    // Writer: identity client, small and binary bodies stay raw
+    {
+        CompressionCache cache;
+        auto run = [&](ContentEncoding encoding, const char *type, const std::string &body)
+        {
+            std::string out;
+            HttpResponseWriter writer([&](std::string &&data)
+                                      { out.append(data); return true; });
+            writer.set_compression(encoding, &cache);
+            writer.header("Content-Type", type).end(body);
+            return out;
+        };
+
+        std::string out = run(ContentEncoding::Identity, "text/plain", text);
+        check(out.find("Content-Encoding") == std::string::npos && out.find("Vary: Accept-Encoding") != std::string::npos,
+              "identity client gets the raw body with Vary");
+        check(run(ContentEncoding::Gzip, "text/plain", "tiny").find("Content-Encoding") == std::string::npos, "small body raw");
+        check(run(ContentEncoding::Gzip, "image/png", text).find("Content-Encoding") == std::string::npos, "binary body raw");
+    }
+
+    if (failures == 0)
+        std::cout << "Test passed.\n";
+    else
+        std::cout << "Test failed.\n";
+
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,117 @@
+#include <http/http_format.hpp>
+#include <http/http_response.hpp>
+#include <http/http_response_writer.hpp>
+
+#include <cstdint>
+#include <string>
+#include <iostream>
+
+int failures = 0;
+
+void check(bool cond, const char *what)
+{
+    if (!cond)
+    {
+        std::cout << "FAILED: " << what << "\n";
+        ++failures;
+    }
+}
+
+int main()
+{
+    using namespace ouc_server::http;
+
+    // Integers: every digit count, both ends of the range
+    {
+        bool all_match = true;
+        for (uint64_t v : {0ull, 7ull, 10ull, 99ull, 100ull, 1234ull, 99999ull, 1000000ull,
+                           4294967296ull, 18446744073709551615ull})
+        {
+            std::string out = "x";
+            append_uint(out, v);
+            all_match = all_match && out == "x" + std::to_string(v);
+        }
+        check(all_match, "append_uint matches std::to_string");
+
+        std::string hex;
+        append_hex(hex, 0);
+        hex.push_back(' ');
+        append_hex(hex, 26);
+        hex.push_back(' ');
+        append_hex(hex, UINT64_MAX);
+        check(hex == "0 1a ffffffffffffffff", "append_hex");
+    }
+
+    // Status lines: precomputed for standard codes only
+    {
+        check(status_line(200) == "HTTP/1.1 200 OK\r\n", "200 status line");
+        check(status_line(431) == "HTTP/1.1 431 Request Header Fields Too Large\r\n", "431 status line");
+        check(status_line(299).empty() && status_line(42).empty() && status_line(1000).empty(), "no line for unknown codes");
+        check(reason_phrase(404) != nullptr && std::string(reason_phrase(404)) == "Not Found", "reason phrase");
+        check(reason_phrase(599) == nullptr, "no phrase for unknown codes");
+
+        std::string out;
+        append_status_line(out, "HTTP/1.0", 200, "OK");
+        append_status_line(out, "HTTP/1.1", 200, "Fine");
+        append_status_line(out, "HTTP/1.1", 299, "Custom");
+        check(out == "HTTP/1.0 200 OK\r\nHTTP/1.1 200 Fine\r\nHTTP/1.1 299 Custom\r\n", "custom status lines kept");
+    }
+
+    // Dates: IMF-fixdate, the RFC 7231 example and a leap day
+    {
+        char text[HTTP_DATE_SIZE];
+        format_http_date(784111777, text);
+        check(std::string(text, HTTP_DATE_SIZE) == "Sun, 06 Nov 1994 08:49:37 GMT", "RFC 7231 example date");
+        format_http_date(951782400, text);
+        check(std::string(text, HTTP_DATE_SIZE) == "Tue, 29 Feb 2000 00:00:00 GMT", "leap day");
+
+        DateCache date;
+        std::string out;
+        date.append_header(out);
+        check(out.size() == 6 + HTTP_DATE_SIZE + 2 && out.compare(0, 6, "Date: ") == 0 &&
+                  out.compare(out.size() - 6, 6, " GMT\r\n") == 0,
+              "date header shape");
+
+        auto delay = date.refresh();
+        check(delay.count() > 0 && delay <= std::chrono::seconds(1), "refresh delay within a second");
+    }
+
+    // HttpResponse::to_string: same bytes as before, without iostream
+    {
+        auto res = HttpResponse::create().stus_code(404).stus_msg("Not Found").header("Server", "ouc").body("gone").build();
+        check(res.to_string() == "HTTP/1.1 404 Not Found\r\nServer: ouc\r\n\r\ngone", "to_string");
+    }
+
+    // Writer: Date added once, a handler's own Date wins
+    {
+        DateCache date;
+        std::string out;
+        HttpResponseWriter writer([&](std::string &&data)
+                                  {
+                                      out += data;
+                                      return true; });
+        writer.set_date(&date);
+        writer.status(201).end("abc");
+        check(out.compare(0, 22, "HTTP/1.1 201 Created\r\n") == 0, "standard reason phrase");
+        check(out.find("\r\nDate: ") != std::string::npos, "date header added");
+        check(out.find("Content-Length: 3\r\n") != std::string::npos, "content-length formatted");
+
+        std::string own;
+        HttpResponseWriter fixed([&](std::string &&data)
+                                 {
+                                     own += data;
+                                     return true; });
+        fixed.set_date(&date);
+        fixed.header("Date", "Sun, 06 Nov 1994 08:49:37 GMT").end();
+        check(own.find("Date: Sun, 06 Nov 1994 08:49:37 GMT\r\n") != std::string::npos &&
+                  own.find("Date: ") == own.rfind("Date: "),
+              "handler date kept");
+    }
+
+    if (failures == 0)
+        std::cout << "Test passed.\n";
+    else
+        std::cout << "Test failed.\n";
+
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,217 @@
+#include <http/http_request_parser.hpp>
+
+#include <string>
+#include <vector>
+#include <iostream>
+
+int failures = 0;
+
+void check(bool cond, const char *what)
+{
+    if (!cond)
+    {
+        std::cout << "FAILED: " << what << "\n";
+        ++failures;
+    }
+}
+
+int main()
+{
+    using namespace ouc_server::http;
+
+    // Content-Length body fed one byte at a time
+    {
+        std::string raw =
+            "POST /upload HTTP/1.1\r\n"
+            "Host: localhost\r\n"
+            "Content-Length: 11\r\n"
+            "\r\n"
+            "hello\r\nbody";
+
+        HttpRequestParser parser;
+        std::string body, path;
+        int completed = 0;
+        parser.on_body(
+            [&](HttpRequest &, std::string_view chunk)
+            { body.append(chunk); });
+        parser.on_complete(
+            [&](HttpRequest &req)
+            {
+                path = req.path;
+                ++completed;
+            });
+
+        for (char c : raw)
+            parser.feed(&c, 1);
+
+        check(completed == 1, "content-length request completes");
+        check(path == "/upload", "request path parsed");
+        check(body == "hello\r\nbody", "body delivered byte-exact");
+        check(parser.is_idle(), "parser idle after request");
+    }
+
+    // Chunked body with extension and trailer, followed by a pipelined GET
+    {
+        std::string raw =
+            "PUT /file HTTP/1.1\r\n"
+            "Transfer-Encoding: chunked\r\n"
+            "\r\n"
+            "5;name=x\r\nhello\r\n"
+            "6\r\n world\r\n"
+            "0\r\n"
+            "X-Trailer: 1\r\n"
+            "\r\n"
+            "GET /next HTTP/1.1\r\n"
+            "\r\n";
+
+        HttpRequestParser parser;
+        std::string body;
+        std::vector<std::string> paths;
+        parser.on_body(
+            [&](HttpRequest &, std::string_view chunk)
+            { body.append(chunk); });
+        parser.on_complete(
+            [&](HttpRequest &req)
+            { paths.push_back(req.path); });
+
+        check(parser.feed(raw), "chunked stream accepted");
+        check(body == "hello world", "chunked body reassembled");
+        check(paths.size() == 2 && paths[0] == "/file" && paths[1] == "/next", "pipelined requests split");
+    }
+
+    // pause() stops feed() after the current request, the rest is fed again later
+    {
+        std::string first = "GET /a HTTP/1.1\r\n\r\n";
+        std::string raw = first + "GET /b HTTP/1.1\r\n\r\n";
+
+        HttpRequestParser parser;
+        std::vector<std::string> paths;
+        parser.on_complete(
+            [&](HttpRequest &req)
+            {
+                paths.push_back(req.path);
+                parser.pause();
+            });
+
+        check(parser.feed(raw), "paused feed succeeds");
+        check(paths.size() == 1 && parser.get_consumed() == first.size(), "feed stops after the paused request");
+        check(parser.feed(std::string_view(raw).substr(parser.get_consumed())), "rest accepted");
+        check(paths.size() == 2 && paths[1] == "/b", "rest parsed after the pause");
+    }
+
+    // Oversized Content-Length is rejected before any body byte
+    {
+        HttpParserConfig config;
+        config.max_body_size = 1024;
+        HttpRequestParser parser(config);
+        bool got_body = false;
+        parser.on_body(
+            [&](HttpRequest &, std::string_view)
+            { got_body = true; });
+
+        bool ok = parser.feed(std::string(
+            "POST / HTTP/1.1\r\n"
+            "Content-Length: 4096\r\n"
+            "\r\n"
+            "xxxx"));
+        check(!ok && parser.get_error_code() == 413, "oversized content-length rejected with 413");
+        check(!got_body, "no body delivered after rejection");
+    }
+
+    // Oversized chunked body is rejected once the limit is crossed
+    {
+        HttpParserConfig config;
+        config.max_body_size = 8;
+        HttpRequestParser parser(config);
+        bool ok = parser.feed(std::string(
+            "POST / HTTP/1.1\r\n"
+            "Transfer-Encoding: chunked\r\n"
+            "\r\n"
+            "5\r\nhello\r\n"
+            "5\r\nworld\r\n"));
+        check(!ok && parser.get_error_code() == 413, "oversized chunked body rejected with 413");
+    }
+
+    // Malformed header line
+    {
+        HttpRequestParser parser;
+        bool ok = parser.feed(std::string("GET / HTTP/1.1\r\nbroken header\r\n\r\n"));
+        check(!ok && parser.get_error_code() == 400, "header without colon rejected with 400");
+    }
+
+    // Size limits fail as soon as the partial line crosses them
+    {
+        HttpParserConfig config;
+        config.max_request_line = 64;
+        config.max_header_size = 256;
+        config.max_header_count = 4;
+
+        HttpRequestParser line_parser(config);
+        bool ok = line_parser.feed("GET /" + std::string(100, 'a'));
+        check(!ok && line_parser.get_error_code() == 414, "long request line rejected with 414 before its end");
+
+        HttpRequestParser size_parser(config);
+        ok = size_parser.feed("GET / HTTP/1.1\r\nX-Big: " + std::string(300, 'b'));
+        check(!ok && size_parser.get_error_code() == 431, "header bytes rejected with 431 before the line ends");
+
+        HttpRequestParser count_parser(config);
+        ok = count_parser.feed(std::string("GET / HTTP/1.1\r\nA: 1\r\nB: 2\r\nC: 3\r\nD: 4\r\nE: 5\r\n"));
+        check(!ok && count_parser.get_error_code() == 431, "header count rejected with 431");
+    }
+
+    // Strict framing: anything two hops could read differently is refused
+    {
+        auto error_of = [](const std::string &raw, bool strict = true)
+        {
+            HttpParserConfig config;
+            config.strict = strict;
+            HttpRequestParser parser(config);
+            return parser.feed(raw) ? 0 : parser.get_error_code();
+        };
+
+        check(error_of("POST / HTTP/1.1\r\nContent-Length: 5\r\nTransfer-Encoding: chunked\r\n\r\n") == 400,
+              "content-length with transfer-encoding rejected");
+        check(error_of("POST / HTTP/1.1\r\nContent-Length: 5\r\nContent-Length: 6\r\n\r\n", false) == 400,
+              "differing content-lengths rejected even when lenient");
+        check(error_of("POST / HTTP/1.1\r\nContent-Length: 3\r\nContent-Length: 3\r\n\r\nabc") == 0,
+              "repeated identical content-length accepted");
+        check(error_of("POST / HTTP/1.1\r\nTransfer-Encoding: chunked, gzip\r\n\r\n") == 400,
+              "chunked not last rejected");
+        check(error_of("POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\nTransfer-Encoding: chunked\r\n\r\n") == 400,
+              "chunked applied twice rejected");
+        check(error_of("POST / HTTP/1.0\r\nTransfer-Encoding: chunked\r\n\r\n") == 400,
+              "transfer-encoding on HTTP/1.0 rejected");
+        check(error_of("GET / HTTP/1.1\r\nContent-Length : 5\r\n\r\n") == 400, "space before colon rejected");
+        check(error_of("GET / HTTP/1.1\r\nX-A: 1\r\n folded\r\n\r\n") == 400, "obs-fold rejected");
+        check(error_of("GET / HTTP/1.1\nHost: a\n\n") == 400, "bare LF rejected");
+        check(error_of("GET / HTTP/1.1\r\nHost: a\r\nHost: b\r\n\r\n") == 400, "repeated host rejected");
+        check(error_of("GET / HTTP/1.1\r\nX-A: a\rb\r\n\r\n") == 400, "CR inside a value rejected");
+        check(error_of("BREW /pot HTTP/1.1\r\n\r\n") == 501, "unknown method rejected with 501");
+        check(error_of("GET / HTTP/2.0\r\n\r\n") == 505, "unsupported version rejected with 505");
+        check(error_of("GET /a b HTTP/1.1\r\n\r\n") == 400, "space in target rejected");
+
+        check(error_of("GET / HTTP/1.1\nX-A : 1\nHost: a\nHost: b\n\n", false) == 0, "lenient mode tolerates legacy syntax");
+        check(error_of("POST / HTTP/1.1\r\nContent-Length: 5\r\nTransfer-Encoding: chunked\r\n\r\n0\r\n\r\n", false) == 0,
+              "lenient mode lets transfer-encoding win");
+    }
+
+    // from_string keeps the body intact and trims header values
+    {
+        auto req = HttpRequest::from_string(
+            "POST /a HTTP/1.1\r\n"
+            "Content-Type:text/plain\r\n"
+            "Content-Length: 4\r\n"
+            "\r\n"
+            "a\r\nb");
+        check(req.method == HttpMethodType::Post, "from_string method");
+        check(req.headers["Content-Type"] == "text/plain", "header without space after colon");
+        check(req.body == "a\r\nb", "from_string body byte-exact");
+    }
+
+    if (failures == 0)
+        std::cout << "Test passed.\n";
+    else
+        std::cout << "Test failed.\n";
+
+    return failures == 0 ? 0 : 1;
+}
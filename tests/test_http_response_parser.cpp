@@ -0,0 +1,122 @@
+#include <http/http_response_parser.hpp>
+
+#include <string>
+#include <iostream>
+
+int failures = 0;
+
+void check(bool cond, const char *what)
+{
+    if (!cond)
+    {
+        std::cout << "FAILED: " << what << "\n";
+        ++failures;
+    }
+}
+
+int main()
+{
+    using namespace ouc_server::http;
+
+    // Content-Length body fed one byte at a time, after an interim 100
+    {
+        std::string raw =
+            "HTTP/1.1 100 Continue\r\n"
+            "\r\n"
+            "HTTP/1.1 201 Created\r\n"
+            "Content-Length: 11\r\n"
+            "Location: /x\r\n"
+            "\r\n"
+            "hello\r\nbody";
+
+        HttpResponseParser parser;
+        std::string body;
+        int code = 0, heads = 0;
+        parser.on_headers(
+            [&](HttpResponse &res)
+            {
+                code = res.stus_code;
+                ++heads;
+            });
+        parser.on_body([&](HttpResponse &, std::string_view chunk) { body.append(chunk); });
+
+        bool ok = true;
+        for (char c : raw)
+            ok = parser.feed(&c, 1) && ok;
+
+        check(ok, "fed without error");
+        check(heads == 1 && code == 201, "interim response skipped");
+        check(parser.response().stus_msg == "Created", "reason phrase parsed");
+        check(parser.response().headers["Location"] == "/x", "header parsed");
+        check(body == "hello\r\nbody", "body delivered byte-exact");
+        check(parser.is_complete(), "complete at the declared length");
+        check(!parser.feed("x"), "bytes past the response rejected");
+    }
+
+    // Chunked body with extension and trailer
+    {
+        std::string raw =
+            "HTTP/1.1 200 OK\r\n"
+            "Transfer-Encoding: chunked\r\n"
+            "\r\n"
+            "5;name=x\r\nhello\r\n"
+            "6\r\n world\r\n"
+            "0\r\n"
+            "Trailer: yes\r\n"
+            "\r\n";
+
+        HttpResponseParser parser;
+        std::string body;
+        int completed = 0;
+        parser.on_body([&](HttpResponse &, std::string_view chunk) { body.append(chunk); });
+        parser.on_complete([&](HttpResponse &) { ++completed; });
+
+        check(parser.feed(raw), "chunked fed");
+        check(body == "hello world", "chunked body reassembled");
+        check(completed == 1 && parser.is_complete(), "chunked response completes");
+    }
+
+    // No framing: the body runs until the connection closes
+    {
+        HttpResponseParser parser;
+        std::string body;
+        parser.on_body([&](HttpResponse &, std::string_view chunk) { body.append(chunk); });
+
+        check(parser.feed("HTTP/1.0 200 OK\r\n\r\nsome "), "until-close head fed");
+        check(parser.is_until_close(), "until-close detected");
+        check(parser.feed("data"), "until-close body fed");
+        check(parser.finish() && parser.is_complete(), "close ends the body");
+        check(body == "some data", "until-close body delivered");
+    }
+
+    // HEAD and 204 carry no body whatever the headers say
+    {
+        HttpResponseParser parser;
+        parser.reset(true);
+        check(parser.feed("HTTP/1.1 200 OK\r\nContent-Length: 100\r\n\r\n"), "head response fed");
+        check(parser.is_complete(), "head response has no body");
+
+        parser.reset();
+        check(parser.feed("HTTP/1.1 204 No Content\r\n\r\n") && parser.is_complete(), "204 has no body");
+    }
+
+    // Malformed or cut short
+    {
+        HttpResponseParser parser;
+        check(!parser.feed("HTTP/1.1 2x0 OK\r\n"), "bad status code rejected");
+
+        parser.reset();
+        check(!parser.feed("garbage\r\n"), "missing version rejected");
+
+        parser.reset();
+        parser.feed("HTTP/1.1 200 OK\r\nContent-Length: 10\r\n\r\nshort");
+        check(!parser.finish(), "truncated body detected");
+    }
+
+    if (failures == 0)
+        std::cout << "Test passed.\n";
+    else
+        std::cout << "Test failed.\n";
+
+    return failures == 0 ? 0 : 1;
+}
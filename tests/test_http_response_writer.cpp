@@ -0,0 +1,151 @@
+#include <http/http_response_writer.hpp>
+
+#include <string>
+#include <iostream>
+
+int failures = 0;
+
+void check(bool cond, const char *what)
+{
+    if (!cond)
+    {
+        std::cout << "FAILED: " << what << "\n";
+        ++failures;
+    }
+}
+
+int main()
+{
+    using namespace ouc_server::http;
+
+    // Unknown length: headers first, then chunked pieces
+    {
+        std::string out;
+        int sends = 0;
+        bool ended_keep_alive = false;
+        HttpResponseWriter writer(
+            [&](std::string &&data)
+            {
+                out += data;
+                ++sends;
+                return true;
+            },
+            [&](bool keep_alive)
+            { ended_keep_alive = keep_alive; });
+
+        writer.status(200, "OK").header("Content-Type", "text/plain");
+        writer.write_head();
+        check(out.find("Transfer-Encoding: chunked\r\n") != std::string::npos, "chunked header added");
+        check(out.size() >= 4 && out.substr(out.size() - 4) == "\r\n\r\n", "head sent alone");
+
+        writer.write("hello");
+        writer.write(std::string(26, 'a'));
+        writer.end();
+
+        std::string body = out.substr(out.find("\r\n\r\n") + 4);
+        check(body == "5\r\nhello\r\n1a\r\n" + std::string(26, 'a') + "\r\n0\r\n\r\n", "chunk framing");
+        check(sends == 4, "one send per call");
+        check(ended_keep_alive, "keep-alive reported on end");
+    }
+
+    // Whole body at end(): Content-Length instead of chunking, one send
+    {
+        std::string out;
+        int sends = 0;
+        HttpResponseWriter writer(
+            [&](std::string &&data)
+            {
+                out += data;
+                ++sends;
+                return true;
+            });
+        writer.end("hello");
+        check(out.find("Content-Length: 5\r\n") != std::string::npos, "content-length computed");
+        check(out.find("Transfer-Encoding") == std::string::npos, "no chunking for known body");
+        check(out.substr(out.size() - 5) == "hello" && sends == 1, "head and body in a single send");
+    }
+
+    // HTTP/1.0 style response without length closes the connection
+    {
+        std::string out;
+        bool ended_keep_alive = true;
+        HttpResponseWriter writer(
+            [&](std::string &&data)
+            {
+                out += data;
+                return true;
+            },
+            [&](bool keep_alive)
+            { ended_keep_alive = keep_alive; });
+        writer.header("Transfer-Encoding", "identity");
+        writer.write("raw");
+        writer.end();
+        check(out.find("Connection: close\r\n") != std::string::npos, "close-delimited body");
+        check(!ended_keep_alive, "connection not reusable");
+        check(out.substr(out.size() - 3) == "raw", "identity body unframed");
+    }
+
+    // HEAD keeps the headers of the equivalent GET but sends no body
+    {
+        std::string out;
+        HttpResponseWriter writer(
+            [&](std::string &&data)
+            {
+                out += data;
+                return true;
+            });
+        writer.set_head_only(true);
+        writer.end("hello");
+        check(out.find("Content-Length: 5\r\n") != std::string::npos, "HEAD keeps content-length");
+        check(out.substr(out.size() - 4) == "\r\n\r\n", "HEAD sends no body");
+    }
+
+    // 204 and 304 never carry a body, nor a length for 204
+    {
+        for (int code : {204, 304})
+        {
+            std::string out;
+            bool ended_keep_alive = false;
+            HttpResponseWriter writer(
+                [&](std::string &&data)
+                {
+                    out += data;
+                    return true;
+                },
+                [&](bool keep_alive)
+                { ended_keep_alive = keep_alive; });
+            writer.status(code).end();
+            check(out.find("Content-Length") == std::string::npos, "no content-length on 204/304");
+            check(out.find("Transfer-Encoding") == std::string::npos, "no chunking on 204/304");
+            check(out.substr(out.size() - 4) == "\r\n\r\n", "no body on 204/304");
+            check(ended_keep_alive, "204/304 keep the connection");
+        }
+
+        std::string out;
+        HttpResponseWriter writer(
+            [&](std::string &&data)
+            {
+                out += data;
+                return true;
+            });
+        writer.status(204).header("Content-Length", "0").end("stray");
+        check(out.find("Content-Length") == std::string::npos, "relayed length dropped on 204");
+        check(out.find("stray") == std::string::npos, "stray body dropped on 204");
+    }
+
+    // A failing sink is reported to the producer
+    {
+        HttpResponseWriter writer(
+            [&](std::string &&)
+            { return false; });
+        check(!writer.write("x"), "write fails once peer is gone");
+        check(!writer.write("y"), "subsequent writes keep failing");
+    }
+
+    if (failures == 0)
+        std::cout << "Test passed.\n";
+    else
+        std::cout << "Test failed.\n";
+
+    return failures == 0 ? 0 : 1;
+}
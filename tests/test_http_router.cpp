@@ -0,0 +1,124 @@
+#include <http/http_router.hpp>
+
+#include <string>
+#include <stdexcept>
+#include <iostream>
+
+int failures = 0;
+
+void check(bool cond, const char *what)
+{
+    if (!cond)
+    {
+        std::cout << "FAILED: " << what << "\n";
+        ++failures;
+    }
+}
+
+int main()
+{
+    using namespace ouc_server::http;
+
+    HttpRouter router;
+    std::string hit;
+    auto route = [&hit](const char *name)
+    {
+        return [&hit, name](HttpRequest &, HttpResponseWriter &, const HttpRouteParams &)
+        { hit = name; };
+    };
+
+    router.add(HttpMethodType::Get, "/", route("root"));
+    router.add(HttpMethodType::Get, "/users", route("users"));
+    router.add(HttpMethodType::Get, "/users/new", route("users_new"));
+    router.add(HttpMethodType::Get, "/users/:id", route("user"));
+    router.add(HttpMethodType::Get, "/users/:id/posts/:post", route("post"));
+    router.add(HttpMethodType::Get, "/uploads", route("uploads"));
+    router.add(HttpMethodType::Get, "/static/*filepath", route("static"));
+    router.add(HttpMethodType::Get, "/files/:name/raw", route("raw"));
+    router.add(HttpMethodType::Get, "/files/*rest", route("files"));
+    router.add(HttpMethodType::Post, "/users", route("create"));
+
+    // Duplicate and conflicting routes are refused
+    bool threw = false;
+    try
+    {
+        router.add(HttpMethodType::Get, "/users/:id", route("again"));
+    }
+    catch (const std::invalid_argument &)
+    {
+        threw = true;
+    }
+    check(threw, "duplicate route rejected");
+
+    threw = false;
+    try
+    {
+        router.add(HttpMethodType::Get, "/users/:uid/x", route("conflict"));
+    }
+    catch (const std::invalid_argument &)
+    {
+        threw = true;
+    }
+    check(threw, "conflicting capture name rejected");
+
+    router.freeze();
+
+    HttpRouteParams params;
+    auto find = [&](HttpMethodType method, std::string_view path) -> std::string
+    {
+        hit.clear();
+        auto *handler = router.lookup(method, path, params);
+        if (handler == nullptr)
+            return "";
+        HttpRequest req;
+        HttpResponseWriter res([](std::string &&)
+                               { return true; });
+        (*handler)(req, res, params);
+        return hit;
+    };
+
+    check(find(HttpMethodType::Get, "/") == "root", "root");
+    check(find(HttpMethodType::Get, "/users") == "users", "static");
+    check(find(HttpMethodType::Get, "/users/new") == "users_new", "static beats param");
+    check(find(HttpMethodType::Get, "/uploads") == "uploads", "split static edge");
+
+    std::string path = "/users/42/posts/7?sort=asc";
+    check(find(HttpMethodType::Get, path) == "post", "nested params");
+    check(params.get("id") == "42" && params.get("post") == "7", "param values");
+    check(params.get("id").data() == path.data() + 7, "captures are views into the path");
+
+    check(find(HttpMethodType::Get, "/static/css/site.css") == "static", "wildcard");
+    check(params.get("filepath") == "css/site.css", "wildcard value");
+
+    check(find(HttpMethodType::Get, "/files/a/raw") == "raw", "param branch");
+    check(find(HttpMethodType::Get, "/files/a/b") == "files", "backtrack to wildcard");
+    check(params.size() == 1 && params.get("rest") == "a/b", "failed branch leaves no captures");
+
+    check(find(HttpMethodType::Get, "/users/") == "", "empty param segment does not match");
+    check(find(HttpMethodType::Get, "/nope") == "", "unknown path");
+    check(find(HttpMethodType::Post, "/users") == "create", "per-method routes");
+    check(find(HttpMethodType::Delete, "/users") == "", "method without routes");
+
+    // handle() answers 405 with Allow for a known path
+    {
+        std::string out;
+        HttpRequest req;
+        req.method = HttpMethodType::Delete;
+        req.path = "/users";
+        HttpResponseWriter res([&](std::string &&data)
+                               {
+                                   out += data;
+                                   return true;
+                               });
+        check(!router.handle(req, res), "unmatched request not handled");
+        check(out.find("405 Method Not Allowed") != std::string::npos, "405 status");
+        check(out.find("Allow: GET, POST") != std::string::npos, "Allow header");
+    }
+
+    if (failures == 0)
+        std::cout << "Test passed.\n";
+    else
+        std::cout << "Test failed.\n";
+
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,360 @@
+#include <server/http_server.hpp>
+#include <http/http_response.hpp>
+
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+
+constexpr uint16_t PORT = 18081;
+constexpr int STREAM_PIECES = 512;
+
+int connect_to_server()
+{
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(PORT);
+    inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+    if (connect(fd, (sockaddr *)&addr, sizeof(addr)) < 0)
+    {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+void send_all(int fd, const std::string &data)
+{
+    size_t sent = 0;
+    while (sent < data.size())
+    {
+        ssize_t n = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0)
+            return;
+        sent += n;
+    }
+}
+
+std::string read_response(int fd)
+{
+    // Read until the peer closes or a full header block plus body arrives
+    std::string res;
+    char buf[4096];
+    while (true)
+    {
+        ssize_t n = recv(fd, buf, sizeof(buf), 0);
+        if (n <= 0)
+            break;
+        res.append(buf, n);
+
+        auto end = res.find("\r\n\r\n");
+        auto pos = res.find("Content-Length: ");
+        if (end != std::string::npos && pos != std::string::npos)
+        {
+            size_t len = std::stoul(res.substr(pos + 16));
+            if (res.size() >= end + 4 + len)
+                break;
+        }
+    }
+    return res;
+}
+
+int main()
+{
+    using namespace ouc_server::server;
+    using namespace ouc_server::ouc_socket;
+    using namespace ouc_server::http;
+
+    HttpServer server(4);
+    HttpParserConfig config;
+    config.max_body_size = 1024 * 1024;
+    server.set_parser_config(config);
+    server.serve_metrics();
+
+    std::atomic<size_t> max_chunk{0};
+    size_t received = 0;
+
+    std::atomic<size_t> produced{0};
+    std::atomic<HttpResponseWriter *> deferred{nullptr};
+
+    server.on_body(
+        [&](HttpRequest &, HttpResponseWriter &, std::string_view chunk)
+        {
+            received += chunk.size();
+            if (chunk.size() > max_chunk.load())
+                max_chunk.store(chunk.size());
+        });
+
+    server.on_request(
+        [&](HttpRequest &req, HttpResponseWriter &res)
+        {
+            if (req.path == "/slow")
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(200));
+                res.end("slow done");
+                return;
+            }
+
+            if (req.path == "/deferred")
+            {
+                // Answered later from the test thread
+                res.defer();
+                deferred.store(&res);
+                return;
+            }
+
+            if (req.path == "/stream")
+            {
+                // Produce far more than any buffer holds; a slow reader must block us
+                std::string piece(64 * 1024, 'y');
+                res.write_head();
+                for (int i = 0; i < STREAM_PIECES; ++i)
+                {
+                    if (!res.write(piece))
+                        return;
+                    produced += piece.size();
+                }
+                res.end();
+                return;
+            }
+
+            std::string body = std::to_string(received);
+            received = 0;
+            res.send(HttpResponse::create().body(body).build());
+        });
+
+    if (!server.start("127.0.0.1", PORT))
+    {
+        std::cerr << "Failed to start server\n";
+        return 1;
+    }
+
+    std::atomic<bool> running{true};
+    std::thread loop_thread(
+        [&]()
+        {
+            while (running.load())
+                server.loop(10);
+        });
+
+    bool passed = true;
+
+    // Stream a chunked upload close to the limit
+    {
+        int fd = connect_to_server();
+        std::string head =
+            "POST /upload HTTP/1.1\r\n"
+            "Transfer-Encoding: chunked\r\n"
+            "\r\n";
+        send_all(fd, head);
+
+        std::string piece(16 * 1024, 'x');
+        char size_line[32];
+        snprintf(size_line, sizeof(size_line), "%zx\r\n", piece.size());
+        for (int i = 0; i < 48; ++i)
+            send_all(fd, size_line + piece + "\r\n");
+        send_all(fd, "0\r\n\r\n");
+
+        std::string res = read_response(fd);
+        std::string expect = std::to_string(48 * piece.size());
+        if (res.find("200 OK") == std::string::npos ||
+            res.substr(res.size() - expect.size()) != expect)
+        {
+            std::cout << "FAILED: chunked upload, got: " << res << "\n";
+            passed = false;
+        }
+        close(fd);
+    }
+
+    // Oversized declared body is refused before the client sends it
+    {
+        int fd = connect_to_server();
+        send_all(fd,
+                 "POST /upload HTTP/1.1\r\n"
+                 "Content-Length: 104857600\r\n"
+                 "Expect: 100-continue\r\n"
+                 "\r\n");
+
+        std::string res = read_response(fd);
+        if (res.find("413") == std::string::npos || res.find("100 Continue") != std::string::npos)
+        {
+            std::cout << "FAILED: early 413, got: " << res << "\n";
+            passed = false;
+        }
+        close(fd);
+    }
+
+    // Endless header line is refused once it passes the limit, not buffered
+    {
+        int fd = connect_to_server();
+        send_all(fd, "GET / HTTP/1.1\r\nX-Filler: " + std::string(config.max_header_size + 1024, 'a'));
+
+        std::string res = read_response(fd);
+        if (res.find("431 Request Header Fields Too Large") == std::string::npos ||
+            res.find("Connection: close") == std::string::npos)
+        {
+            std::cout << "FAILED: early 431, got: " << res << "\n";
+            passed = false;
+        }
+        close(fd);
+    }
+
+    // Chunked download to a client that stalls: the producer gets throttled
+    {
+        int fd = connect_to_server();
+        send_all(fd, "GET /stream HTTP/1.1\r\n\r\n");
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(300));
+        size_t stalled_at = produced.load();
+        size_t total = size_t(STREAM_PIECES) * 64 * 1024;
+        if (stalled_at >= total)
+        {
+            std::cout << "FAILED: producer not throttled by a stalled client\n";
+            passed = false;
+        }
+
+        // Now drain everything and count the de-chunked body
+        std::string raw;
+        char buf[65536];
+        while (raw.size() < 5 || raw.compare(raw.size() - 5, 5, "0\r\n\r\n") != 0)
+        {
+            ssize_t n = recv(fd, buf, sizeof(buf), 0);
+            if (n <= 0)
+                break;
+            raw.append(buf, n);
+        }
+
+        size_t body = 0;
+        size_t pos = raw.find("\r\n\r\n") + 4;
+        while (pos < raw.size())
+        {
+            size_t len = std::strtoul(raw.c_str() + pos, nullptr, 16);
+            pos = raw.find("\r\n", pos) + 2 + len + 2;
+            body += len;
+            if (len == 0)
+                break;
+        }
+        if (body != total)
+        {
+            std::cout << "FAILED: streamed " << body << " of " << total << " bytes\n";
+            passed = false;
+        }
+        close(fd);
+    }
+
+    // Metrics endpoint reflects the traffic so far, without reaching on_request
+    {
+        int fd = connect_to_server();
+        send_all(fd, "GET /metrics HTTP/1.1\r\nConnection: close\r\n\r\n");
+
+        std::string res;
+        char buf[4096];
+        ssize_t n;
+        while ((n = recv(fd, buf, sizeof(buf), 0)) > 0)
+            res.append(buf, n);
+
+        if (res.find("200 OK") == std::string::npos ||
+            res.find("ouc_http_requests_total 3") == std::string::npos ||
+            res.find("ouc_tcp_accepts_total 5") == std::string::npos ||
+            res.find("ouc_http_rejected_requests_total 2") == std::string::npos ||
+            res.find("ouc_pool_wait_seconds_count{pool=\"tasks\"}") == std::string::npos)
+        {
+            std::cout << "FAILED: metrics endpoint, got: " << res << "\n";
+            passed = false;
+        }
+        close(fd);
+    }
+
+    // Deferred response ends after its handler returned; the pipelined
+    // request behind it is answered only afterwards
+    {
+        int fd = connect_to_server();
+        send_all(fd, "GET /deferred HTTP/1.1\r\n\r\nGET /ping HTTP/1.1\r\nConnection: close\r\n\r\n");
+        for (int i = 0; i < 2000 && deferred.load() == nullptr; ++i)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        if (HttpResponseWriter *res = deferred.exchange(nullptr))
+            res->end("deferred done");
+
+        std::string res;
+        char buf[4096];
+        ssize_t n;
+        while ((n = recv(fd, buf, sizeof(buf), 0)) > 0)
+            res.append(buf, n);
+
+        size_t body = res.find("deferred done");
+        if (body == std::string::npos || res.find("HTTP/1.1 200", body) == std::string::npos)
+        {
+            std::cout << "FAILED: deferred response, got: " << res << "\n";
+            passed = false;
+        }
+        close(fd);
+    }
+
+    // Graceful drain: the in-flight request completes, the idle keep-alive
+    // connection is closed and no new connection is accepted.
+    {
+        int idle_fd = connect_to_server();
+        send_all(idle_fd, "GET /ping HTTP/1.1\r\n\r\n");
+        read_response(idle_fd);
+
+        int busy_fd = connect_to_server();
+        send_all(busy_fd, "GET /slow HTTP/1.1\r\n\r\n");
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+        server.stop();
+
+        int late_fd = connect_to_server();
+        if (late_fd >= 0)
+        {
+            std::cout << "FAILED: connection accepted after stop\n";
+            passed = false;
+            close(late_fd);
+        }
+
+        if (!server.drain(std::chrono::milliseconds(2000)))
+        {
+            std::cout << "FAILED: drain timed out\n";
+            passed = false;
+        }
+
+        std::string res;
+        char buf[4096];
+        ssize_t n;
+        while ((n = recv(busy_fd, buf, sizeof(buf), 0)) > 0)
+            res.append(buf, n);
+        if (res.size() < 9 || res.compare(res.size() - 9, 9, "slow done") != 0)
+        {
+            std::cout << "FAILED: in-flight request during drain, got: " << res << "\n";
+            passed = false;
+        }
+
+        if (recv(idle_fd, buf, sizeof(buf), 0) != 0)
+        {
+            std::cout << "FAILED: idle keep-alive connection not closed\n";
+            passed = false;
+        }
+        close(busy_fd);
+        close(idle_fd);
+    }
+
+    running.store(false);
+    loop_thread.join();
+
+    // Body must never be handed out in pieces larger than a read
+    if (max_chunk.load() > 4096)
+    {
+        std::cout << "FAILED: body chunk of " << max_chunk.load() << " bytes\n";
+        passed = false;
+    }
+
+    std::cout << (passed ? "Test passed.\n" : "Test failed.\n");
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,91 @@
+#include <codec/length_prefixed_codec.hpp>
+
+#include <string>
+#include <vector>
+#include <iostream>
+
+int failures = 0;
+
+void check(bool cond, const char *what)
+{
+    if (!cond)
+    {
+        std::cout << "FAILED: " << what << "\n";
+        ++failures;
+    }
+}
+
+int main()
+{
+    using namespace ouc_server::codec;
+
+    for (LengthPrefix prefix : {LengthPrefix::Fixed32, LengthPrefix::Varint})
+    {
+        LengthPrefixedCodec codec({prefix, 1 << 20});
+
+        std::vector<std::string> frames = {"", "a", std::string(127, 'b'), std::string(128, 'c'), std::string(70000, 'd'), "tail"};
+        std::string wire;
+        codec.encode(wire, std::vector<std::string_view>(frames.begin(), frames.end()));
+
+        // Whole stream in one read: every frame is a view into it
+        {
+            std::vector<std::string> got;
+            bool views = true;
+            bool ok = codec.decode(wire, [&](std::string_view frame)
+                                   {
+                                       got.emplace_back(frame);
+                                       if (!frame.empty())
+                                           views = views && frame.data() >= wire.data() && frame.data() < wire.data() + wire.size();
+                                   });
+            check(ok && got == frames, "whole stream decoded");
+            check(views, "frames within one read are not copied");
+        }
+
+        // Every split point, including inside headers
+        {
+            bool all = true;
+            for (size_t step : {1, 2, 3, 5, 4096})
+            {
+                codec.reset();
+                std::vector<std::string> got;
+                for (size_t pos = 0; pos < wire.size(); pos += step)
+                    all = codec.decode(std::string_view(wire).substr(pos, step), [&](std::string_view frame)
+                                       { got.emplace_back(frame); }) && all;
+                all = all && got == frames;
+            }
+            check(all, "stream decoded in pieces of any size");
+        }
+
+        // Frame over the limit
+        {
+            LengthPrefixedCodec small({prefix, 16});
+            std::string big;
+            small.encode(big, std::string(17, 'x'));
+            int count = 0;
+            check(!small.decode(big, [&](std::string_view)
+                                { ++count; }) &&
+                      count == 0,
+                  "oversized frame rejected before its payload");
+            check(!small.decode("\x01", {}), "stream stays failed");
+            small.reset();
+            std::string fits;
+            small.encode(fits, std::string(16, 'y'));
+            check(small.decode(fits, {}), "reset recovers");
+        }
+    }
+
+    // Varint header sizes and malformed varints
+    {
+        char buf[10];
+        check(LengthPrefixedCodec::write_header(buf, LengthPrefix::Varint, 127) == 1, "7 bits in one byte");
+        check(LengthPrefixedCodec::write_header(buf, LengthPrefix::Varint, 300) == 2 && uint8_t(buf[0]) == 0xAC && buf[1] == 0x02,
+              "300 encodes as AC 02");
+        check(LengthPrefixedCodec::write_header(buf, LengthPrefix::Varint, UINT64_MAX) == 10, "64 bits in ten bytes");
+
+        LengthPrefixedCodec codec({LengthPrefix::Varint, SIZE_MAX});
+        check(!codec.decode(std::string(11, '\x80'), {}), "unterminated varint rejected");
+    }
+
+    std::cout << (failures == 0 ? "Test passed.\n" : "Test failed.\n");
+    return failures == 0 ? 0 : 1;
+}
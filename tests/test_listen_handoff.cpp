@@ -0,0 +1,174 @@
+#include <server/tcp_server.hpp>
+#include <socket/listen_handoff.hpp>
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <cstdlib>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+
+constexpr uint16_t PORT = 18082;
+const std::string HANDOFF_PATH = "/tmp/ouc_server_test_handoff.sock";
+
+int failures = 0;
+
+void check(bool cond, const char *what)
+{
+    if (!cond)
+    {
+        std::cout << "FAILED: " << what << "\n";
+        ++failures;
+    }
+}
+
+/// Send a line and return what the server echoes, empty on failure.
+std::string round_trip(const std::string &msg)
+{
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(PORT);
+    inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+    if (connect(fd, (sockaddr *)&addr, sizeof(addr)) < 0)
+    {
+        close(fd);
+        return "";
+    }
+
+    send(fd, msg.data(), msg.size(), MSG_NOSIGNAL);
+    std::string res;
+    char buf[256];
+    while (res.size() < msg.size())
+    {
+        ssize_t n = recv(fd, buf, sizeof(buf), 0);
+        if (n <= 0)
+            break;
+        res.append(buf, n);
+    }
+    close(fd);
+    return res;
+}
+
+int main()
+{
+    using namespace ouc_server::server;
+    using namespace ouc_server::ouc_socket;
+
+    // Old and new server tag their replies so we can tell who answered
+    auto make_server = [](TCPServer &server, const std::string &tag)
+    {
+        server.on_message(
+            [&server, tag](TCPSocket &client, const std::string &msg)
+            { server.send(client, tag + msg); });
+    };
+
+    TCPServer old_server(2);
+    make_server(old_server, "old:");
+    if (!old_server.start("127.0.0.1", PORT))
+    {
+        std::cerr << "Failed to start server\n";
+        return 1;
+    }
+
+    std::atomic<bool> running{true};
+    std::thread old_loop(
+        [&]()
+        {
+            while (running.load())
+                old_server.loop(10);
+        });
+
+    check(round_trip("ping") == "old:ping", "old server answers");
+
+    // Successor fetches the listener while the old server waits to hand it off
+    TCPServer new_server(2);
+    make_server(new_server, "new:");
+    TCPSocket inherited;
+    std::thread successor(
+        [&]()
+        { inherited = receive_listener(HANDOFF_PATH, 2000); });
+
+    bool handed = old_server.hand_off(HANDOFF_PATH, std::chrono::milliseconds(2000));
+    successor.join();
+    check(handed, "hand_off succeeded");
+    check(old_server.is_stopped(), "old server stopped accepting");
+    check(inherited.get_fd() >= 0, "listener received");
+    check((fcntl(inherited.get_fd(), F_GETFL) & O_NONBLOCK) != 0, "received listener is non-blocking");
+
+    check(new_server.start(std::move(inherited)), "new server starts on the inherited socket");
+    std::thread new_loop(
+        [&]()
+        {
+            while (running.load())
+                new_server.loop(10);
+        });
+
+    check(round_trip("pong") == "new:pong", "new server answers on the same port");
+    check(old_server.drain(std::chrono::milliseconds(500)), "old server drains");
+
+    running.store(false);
+    old_loop.join();
+    new_loop.join();
+
+    // A successor that connects but never acknowledges cannot hang the handoff
+    {
+        TCPSocket listener = TCPSocket::create();
+        listener.bind("127.0.0.1", 0);
+        listener.listen();
+
+        std::atomic<bool> done{false};
+        std::thread silent(
+            [&]()
+            {
+                sockaddr_un addr{};
+                addr.sun_family = AF_UNIX;
+                std::snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", HANDOFF_PATH.c_str());
+                int fd = -1;
+                while (!done.load())
+                {
+                    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+                    if (connect(fd, (sockaddr *)&addr, sizeof(addr)) == 0)
+                        break;
+                    close(fd);
+                    fd = -1;
+                    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+                }
+                // Hold the connection open without ever sending the ack
+                while (!done.load())
+                    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+                if (fd >= 0)
+                    close(fd);
+            });
+
+        auto start = std::chrono::steady_clock::now();
+        bool sent = send_listener(HANDOFF_PATH, listener.get_fd(), 300);
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        done.store(true);
+        silent.join();
+
+        check(!sent, "handoff without an ack fails");
+        check(elapsed < std::chrono::milliseconds(1500), "missing ack bounded by the timeout");
+    }
+
+    // Nothing to inherit unless LISTEN_PID names this process
+    setenv("LISTEN_PID", "1", 1);
+    setenv("LISTEN_FDS", "1", 1);
+    check(listen_fds_from_env().empty(), "foreign LISTEN_PID ignored");
+    unsetenv("LISTEN_PID");
+    unsetenv("LISTEN_FDS");
+
+    if (failures == 0)
+        std::cout << "Test passed.\n";
+    else
+        std::cout << "Test failed.\n";
+
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,128 @@
+#include <server/http_server.hpp>
+
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+
+constexpr uint16_t PORT = 18086;
+
+int failures = 0;
+
+void check(bool cond, const char *what)
+{
+    if (!cond)
+    {
+        std::cout << "FAILED: " << what << "\n";
+        ++failures;
+    }
+}
+
+int connect_server()
+{
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(PORT);
+    inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+    if (connect(fd, (sockaddr *)&addr, sizeof(addr)) < 0)
+    {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/// Status code of the answer to a request already sent, 0 on failure.
+int read_status(int fd)
+{
+    char buf[512];
+    ssize_t n = recv(fd, buf, sizeof(buf) - 1, 0);
+    if (n < 12)
+        return 0;
+    return std::stoi(std::string(buf + 9, 3));
+}
+
+int main()
+{
+    using namespace std::chrono;
+
+    // One handler thread, far slower than requests arrive
+    ouc_server::server::HttpServer server(ouc_server::server::TCPServerConfig::with_threads(1, 1));
+    server.set_load_shedding(milliseconds(2), milliseconds(10));
+    std::atomic<int> served{0};
+    server.on_request(
+        [&](ouc_server::http::HttpRequest &, ouc_server::http::HttpResponseWriter &res)
+        {
+            std::this_thread::sleep_for(milliseconds(20));
+            ++served;
+            res.end("ok");
+        });
+
+    if (!server.start("127.0.0.1", PORT))
+    {
+        std::cerr << "Failed to start server\n";
+        return 1;
+    }
+
+    std::atomic<bool> running{true};
+    std::thread loop(
+        [&]()
+        {
+            while (running.load())
+                server.loop(10);
+        });
+
+    const std::string req = "GET / HTTP/1.1\r\nHost: x\r\n\r\n";
+    std::vector<int> fds;
+    for (int i = 0; i < 12; ++i)
+    {
+        int fd = connect_server();
+        check(fd >= 0, "connect");
+        if (fd >= 0)
+        {
+            send(fd, req.data(), req.size(), MSG_NOSIGNAL);
+            fds.push_back(fd);
+        }
+    }
+
+    auto start = steady_clock::now();
+    int ok = 0, unavailable = 0;
+    for (int fd : fds)
+    {
+        int status = read_status(fd);
+        ok += status == 200;
+        unavailable += status == 503;
+        close(fd);
+    }
+    auto elapsed = steady_clock::now() - start;
+
+    check(ok >= 1, "early requests served");
+    check(unavailable >= 1, "requests shed once the queue stood");
+    check(ok + unavailable == static_cast<int>(fds.size()), "every request answered");
+    check(elapsed < milliseconds(12 * 20), "shedding answered faster than serving all");
+    check(server.tcp_server().get_metrics().shed.value() == static_cast<uint64_t>(unavailable), "shed counted");
+
+    // Queue drained: served normally again
+    int fd = connect_server();
+    send(fd, req.data(), req.size(), MSG_NOSIGNAL);
+    check(read_status(fd) == 200, "served after the overload");
+    check(!server.tcp_server().is_overloaded(), "overload cleared");
+    close(fd);
+
+    running.store(false);
+    loop.join();
+
+    if (failures == 0)
+        std::cout << "Test passed.\n";
+    else
+        std::cout << "Test failed.\n";
+
+    return failures == 0 ? 0 : 1;
+}
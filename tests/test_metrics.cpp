@@ -0,0 +1,89 @@
+#include <utils/metrics.hpp>
+
+#include <thread>
+#include <vector>
+#include <string>
+#include <iostream>
+
+int failures = 0;
+
+void check(bool cond, const char *what)
+{
+    if (!cond)
+    {
+        std::cout << "FAILED: " << what << "\n";
+        ++failures;
+    }
+}
+
+bool contains(const std::string &text, const std::string &needle)
+{
+    return text.find(needle) != std::string::npos;
+}
+
+int main()
+{
+    using namespace ouc_server::utils;
+
+    constexpr size_t THREADS = 8;
+    constexpr size_t PER_THREAD = 100'000;
+
+    Counter counter;
+    Gauge gauge;
+    MetricHistogram hist;
+
+    // Concurrent updates from more threads than there are shards' worth of work
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < THREADS; ++t)
+        threads.emplace_back(
+            [&]()
+            {
+                for (size_t i = 0; i < PER_THREAD; ++i)
+                {
+                    counter.add();
+                    gauge.inc();
+                    hist.record(i % 1024);
+                }
+                for (size_t i = 0; i < PER_THREAD / 2; ++i)
+                    gauge.dec();
+            });
+    for (auto &t : threads)
+        t.join();
+
+    check(counter.value() == THREADS * PER_THREAD, "counter sums all shards");
+    check(gauge.value() == static_cast<int64_t>(THREADS * PER_THREAD / 2), "gauge sums increments and decrements");
+
+    auto snap = hist.snapshot();
+    check(snap.count == THREADS * PER_THREAD, "histogram count");
+    check(snap.buckets[0] > 0 && snap.buckets[MetricHistogram::bucket_of(1023)] > 0, "histogram spreads values");
+    check(snap.percentile(100) == 1023, "p100 is the bound of the top bucket");
+    check(snap.percentile(50) >= 511 && snap.percentile(50) <= 1023, "p50 within a bucket");
+
+    // Each bucket bound covers its values
+    for (uint64_t v : {0ull, 1ull, 2ull, 3ull, 1000ull, ~0ull})
+        check(MetricHistogram::upper_bound_of(MetricHistogram::bucket_of(v)) >= v, "bucket bound covers value");
+
+    std::string text;
+    prometheus::write_header(text, "test_total", "counter", "A counter.");
+    prometheus::write_value(text, "test_total", "kind=\"a\"", 42);
+    check(contains(text, "# TYPE test_total counter\n"), "type line");
+    check(contains(text, "test_total{kind=\"a\"} 42\n"), "labelled value");
+
+    MetricHistogram small;
+    small.record(1);
+    small.record(3);
+    small.record(100);
+    text.clear();
+    prometheus::write_histogram(text, "test_size", "", small.snapshot(), 1, 0, 3);
+    check(contains(text, "test_size_bucket{le=\"1\"} 1\n"), "first bucket");
+    check(contains(text, "test_size_bucket{le=\"3\"} 2\n"), "buckets are cumulative");
+    check(contains(text, "test_size_bucket{le=\"+Inf\"} 3\n"), "+Inf bucket holds everything");
+    check(contains(text, "test_size_sum 104\n") && contains(text, "test_size_count 3\n"), "sum and count");
+
+    if (failures == 0)
+        std::cout << "Test passed.\n";
+    else
+        std::cout << "Test failed.\n";
+
+    return failures == 0 ? 0 : 1;
+}
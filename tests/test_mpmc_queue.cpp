@@ -11,8 +11,79 @@ constexpr size_t PRODUCER_COUNT = 4;
 constexpr size_t CONSUMER_COUNT = 4;
 constexpr size_t ITEMS_PER_PRODUCER = 100;
 
+/// Counts live instances, so leaked or double-destroyed items show up.
+struct Counted
+{
+    static std::atomic<int> live;
+    int value;
+
+    explicit Counted(int p_value) : value(p_value) { ++live; }
+    Counted(const Counted &other) : value(other.value) { ++live; }
+    Counted(Counted &&other) noexcept : value(other.value) { ++live; }
+    ~Counted() { --live; }
+};
+
+std::atomic<int> Counted::live{0};
+
+/// A full queue refuses pushes until a pop frees a slot.
+bool test_full_queue()
+{
+    bool passed = true;
+    pjh_std::MPMCQueue<int> queue(4);
+    for (int i = 0; i < 4; ++i)
+        passed = queue.push(i) && passed;
+    if (!passed || queue.push(4))
+    {
+        std::cout << "FAILED: full queue accepted a push\n";
+        return false;
+    }
+
+    auto first = queue.pop();
+    if (!first || *first != 0 || !queue.push(4))
+    {
+        std::cout << "FAILED: slot not reusable after a pop\n";
+        return false;
+    }
+
+    for (int expect = 1; expect <= 4; ++expect)
+    {
+        auto val = queue.pop();
+        if (!val || *val != expect)
+        {
+            std::cout << "FAILED: order after wrap-around\n";
+            return false;
+        }
+    }
+    if (queue.pop())
+    {
+        std::cout << "FAILED: empty queue returned an item\n";
+        return false;
+    }
+    return true;
+}
+
+/// Items left in a queue are destroyed with it.
+bool test_destructor()
+{
+    {
+        pjh_std::MPMCQueue<Counted> queue(8);
+        for (int i = 0; i < 5; ++i)
+            queue.push(Counted(i));
+        queue.pop();
+    }
+    if (Counted::live.load() != 0)
+    {
+        std::cout << "FAILED: " << Counted::live.load() << " items leaked by the destructor\n";
+        return false;
+    }
+    return true;
+}
+
 int main()
 {
+    bool passed = test_full_queue();
+    passed = test_destructor() && passed;
+
     pjh_std::MPMCQueue<int> queue(1024);
 
     // 生产者线程
@@ -62,10 +133,13 @@ int main()
     std::cout << "Total produced: " << PRODUCER_COUNT * ITEMS_PER_PRODUCER << "\n";
     std::cout << "Total consumed: " << consumed.load() << "\n";
 
-    if (consumed.load() == PRODUCER_COUNT * ITEMS_PER_PRODUCER)
+    if (passed && consumed.load() == PRODUCER_COUNT * ITEMS_PER_PRODUCER)
         std::cout << "Test passed.\n";
     else
+    {
         std::cout << "Test failed.\n";
+        return 1;
+    }
 
     return 0;
 }
\ No newline at end of file
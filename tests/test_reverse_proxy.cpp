@@ -0,0 +1,393 @@
+#include <server/http_server.hpp>
+#include <server/reverse_proxy.hpp>
+#include <http/http_response_parser.hpp>
+
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <iostream>
+
+constexpr uint16_t PROXY_PORT = 18090;
+constexpr uint16_t UPSTREAM_A_PORT = 18091;
+constexpr uint16_t UPSTREAM_B_PORT = 18092;
+constexpr uint16_t HASH_PROXY_PORT = 18093;
+constexpr uint16_t DEAD_PROXY_PORT = 18094;
+constexpr uint16_t DEAD_UPSTREAM_PORT = 18095;
+constexpr uint16_t LIMITED_PROXY_PORT = 18102;
+constexpr uint16_t SLOW_UPSTREAM_PORT = 18103;
+constexpr uint16_t CONCURRENT_PROXY_PORT = 18104;
+constexpr uint16_t SILENT_UPSTREAM_PORT = 18105;
+constexpr uint16_t TIMEOUT_PROXY_PORT = 18106;
+constexpr uint16_t LEAST_PROXY_PORT = 18107;
+
+using ouc_server::server::HttpServer;
+using ouc_server::server::ReverseProxy;
+using ouc_server::server::ReverseProxyConfig;
+using ouc_server::server::BalancePolicy;
+using ouc_server::http::HttpRequest;
+using ouc_server::http::HttpResponse;
+using ouc_server::http::HttpResponseWriter;
+
+int failures = 0;
+
+void check(bool cond, const char *what)
+{
+    if (!cond)
+    {
+        std::cout << "FAILED: " << what << "\n";
+        ++failures;
+    }
+}
+
+struct Reply
+{
+    int code = 0;
+    std::string body;
+    std::string forwarded_for;
+    std::string seen_hop;
+};
+
+/// Send a raw request on a new connection and parse the answer.
+Reply request(uint16_t port, const std::string &raw)
+{
+    Reply reply;
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+    if (connect(fd, (sockaddr *)&addr, sizeof(addr)) < 0)
+    {
+        close(fd);
+        return reply;
+    }
+
+    timeval tv{5, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    for (size_t sent = 0; sent < raw.size();)
+    {
+        ssize_t n = send(fd, raw.data() + sent, raw.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0)
+            break;
+        sent += n;
+    }
+
+    ouc_server::http::HttpResponseParser parser;
+    parser.on_body([&](HttpResponse &, std::string_view chunk) { reply.body.append(chunk); });
+    char buf[16384];
+    while (!parser.is_complete())
+    {
+        ssize_t n = recv(fd, buf, sizeof(buf), 0);
+        if (n <= 0)
+        {
+            parser.finish();
+            break;
+        }
+        if (!parser.feed(buf, n))
+            break;
+    }
+    close(fd);
+
+    if (parser.is_complete())
+    {
+        reply.code = parser.response().stus_code;
+        reply.forwarded_for = parser.response().headers["X-Seen-Forwarded-For"];
+        reply.seen_hop = parser.response().headers["X-Seen-Hop"];
+    }
+    return reply;
+}
+
+/// Listening socket that accepts connections and never answers.
+int make_silent_upstream(uint16_t port)
+{
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+    if (bind(fd, (sockaddr *)&addr, sizeof(addr)) < 0 || listen(fd, 16) < 0)
+    {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/// Wait until cond holds, at most a few seconds.
+template <typename Cond>
+bool wait_for(Cond cond)
+{
+    for (int i = 0; i < 3000 && !cond(); ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    return cond();
+}
+
+/// Upstream answering GET with its name and echoing request bodies as they stream in.
+std::unique_ptr<HttpServer> make_upstream(const std::string &name, uint16_t port)
+{
+    auto server = std::make_unique<HttpServer>(ouc_server::server::TCPServerConfig::with_threads(1, 1));
+    server->on_headers(
+        [name](HttpRequest &req, HttpResponseWriter &res)
+        {
+            auto it = req.headers.find("X-Forwarded-For");
+            auto hop = req.headers.find("X-Hop");
+            res.header("X-Upstream", name).header("X-Seen-Forwarded-For", it == req.headers.end() ? "" : it->second);
+            res.header("X-Seen-Hop", hop == req.headers.end() ? "" : hop->second);
+        });
+    server->on_body([](HttpRequest &, HttpResponseWriter &res, std::string_view chunk) { res.write(chunk); });
+    server->on_request(
+        [name](HttpRequest &req, HttpResponseWriter &res)
+        {
+            if (req.method == ouc_server::http::HttpMethodType::Get)
+                res.end(name);
+            else
+                res.end();
+        });
+    if (!server->start("127.0.0.1", port))
+        return nullptr;
+    return server;
+}
+
+int main()
+{
+    auto upstream_a = make_upstream("a", UPSTREAM_A_PORT);
+    auto upstream_b = make_upstream("b", UPSTREAM_B_PORT);
+
+    HttpServer proxy_server(ouc_server::server::TCPServerConfig::with_threads(1, 2));
+    ReverseProxy proxy(proxy_server.tcp_server().get_loop());
+    proxy.add_upstream("127.0.0.1", UPSTREAM_A_PORT);
+    proxy.add_upstream("127.0.0.1", UPSTREAM_B_PORT);
+    proxy.attach(proxy_server);
+
+    ReverseProxyConfig hash_config;
+    hash_config.policy = BalancePolicy::ConsistentHash;
+    hash_config.hash_header = "X-User";
+    HttpServer hash_server(ouc_server::server::TCPServerConfig::with_threads(1, 2));
+    ReverseProxy hash_proxy(hash_server.tcp_server().get_loop(), hash_config);
+    hash_proxy.add_upstream("127.0.0.1", UPSTREAM_A_PORT);
+    hash_proxy.add_upstream("127.0.0.1", UPSTREAM_B_PORT);
+    hash_proxy.attach(hash_server);
+
+    HttpServer dead_server(ouc_server::server::TCPServerConfig::with_threads(1, 1));
+    ReverseProxy dead_proxy(dead_server.tcp_server().get_loop());
+    dead_proxy.add_upstream("127.0.0.1", DEAD_UPSTREAM_PORT);
+    dead_proxy.attach(dead_server);
+
+    // Upstream holding each request until told to answer
+    std::atomic<int> slow_entered{0};
+    std::atomic<bool> slow_release{false};
+    HttpServer slow_upstream(ouc_server::server::TCPServerConfig::with_threads(1, 8));
+    slow_upstream.on_request(
+        [&](HttpRequest &, HttpResponseWriter &res)
+        {
+            ++slow_entered;
+            while (!slow_release.load())
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            res.end("slow");
+        });
+
+    // A single worker: requests waiting on the upstream must not hold it
+    HttpServer concurrent_server(ouc_server::server::TCPServerConfig::with_threads(1, 1));
+    ReverseProxy concurrent_proxy(concurrent_server.tcp_server().get_loop());
+    concurrent_proxy.add_upstream("127.0.0.1", SLOW_UPSTREAM_PORT);
+    concurrent_proxy.attach(concurrent_server);
+
+    ReverseProxyConfig limited_config;
+    limited_config.max_exchanges = 1;
+    HttpServer limited_server(ouc_server::server::TCPServerConfig::with_threads(1, 1));
+    ReverseProxy limited_proxy(limited_server.tcp_server().get_loop(), limited_config);
+    limited_proxy.add_upstream("127.0.0.1", SLOW_UPSTREAM_PORT);
+    limited_proxy.attach(limited_server);
+
+    int silent_fd = make_silent_upstream(SILENT_UPSTREAM_PORT);
+    ReverseProxyConfig timeout_config;
+    timeout_config.response_timeout = std::chrono::milliseconds(200);
+    HttpServer timeout_server(ouc_server::server::TCPServerConfig::with_threads(1, 1));
+    ReverseProxy timeout_proxy(timeout_server.tcp_server().get_loop(), timeout_config);
+    timeout_proxy.add_upstream("127.0.0.1", SILENT_UPSTREAM_PORT);
+    timeout_proxy.attach(timeout_server);
+
+    ReverseProxyConfig least_config;
+    least_config.policy = BalancePolicy::LeastConnections;
+    HttpServer least_server(ouc_server::server::TCPServerConfig::with_threads(1, 1));
+    ReverseProxy least_proxy(least_server.tcp_server().get_loop(), least_config);
+    least_proxy.add_upstream("127.0.0.1", SLOW_UPSTREAM_PORT);
+    least_proxy.add_upstream("127.0.0.1", UPSTREAM_A_PORT);
+    least_proxy.attach(least_server);
+
+    if (!upstream_a || !upstream_b || !proxy_server.start("127.0.0.1", PROXY_PORT) ||
+        !hash_server.start("127.0.0.1", HASH_PROXY_PORT) || !dead_server.start("127.0.0.1", DEAD_PROXY_PORT) ||
+        !slow_upstream.start("127.0.0.1", SLOW_UPSTREAM_PORT) || !limited_server.start("127.0.0.1", LIMITED_PROXY_PORT) ||
+        !concurrent_server.start("127.0.0.1", CONCURRENT_PROXY_PORT) || silent_fd < 0 ||
+        !timeout_server.start("127.0.0.1", TIMEOUT_PROXY_PORT) || !least_server.start("127.0.0.1", LEAST_PROXY_PORT))
+    {
+        std::cerr << "Failed to start servers\n";
+        return 1;
+    }
+
+    std::atomic<bool> running{true};
+    std::vector<std::thread> loops;
+    for (HttpServer *server : {upstream_a.get(), upstream_b.get(), &proxy_server, &hash_server, &dead_server,
+                               &slow_upstream, &limited_server, &concurrent_server, &timeout_server, &least_server})
+        loops.emplace_back(
+            [&running, server]()
+            {
+                while (running.load())
+                    server->loop(10);
+            });
+
+    // Round robin over both upstreams, on kept-alive upstream connections
+    {
+        int a = 0, b = 0;
+        for (int i = 0; i < 10; ++i)
+        {
+            Reply reply = request(PROXY_PORT, "GET / HTTP/1.1\r\nHost: x\r\nConnection: close\r\n\r\n");
+            check(reply.code == 200, "proxied GET answered");
+            a += reply.body == "a";
+            b += reply.body == "b";
+        }
+        check(a == 5 && b == 5, "round robin alternates");
+
+        // The last body byte reaches the client just before the connection is released
+        auto idle = [&] { return proxy.get_upstream(0).get_active_count() == 0 && proxy.get_upstream(1).get_active_count() == 0; };
+        for (int i = 0; i < 100 && !idle(); ++i)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        check(idle(), "connections returned to the pools");
+        check(proxy.get_upstream(0).get_connect_count() + proxy.get_upstream(1).get_connect_count() <= 4,
+              "upstream connections reused");
+
+        Reply reply = request(PROXY_PORT, "GET / HTTP/1.1\r\nHost: x\r\nX-Forwarded-For: 10.0.0.1\r\n\r\n");
+        check(reply.forwarded_for == "10.0.0.1, 127.0.0.1", "client address appended to X-Forwarded-For");
+
+        reply = request(PROXY_PORT, "GET / HTTP/1.1\r\nHost: x\r\nConnection: X-Hop\r\nX-Hop: secret\r\n\r\n");
+        check(reply.code == 200 && reply.seen_hop.empty(), "header named in Connection not forwarded");
+
+        reply = request(PROXY_PORT, "HEAD / HTTP/1.1\r\nHost: x\r\n\r\n");
+        check(reply.code == 200 && reply.body.empty(), "HEAD proxied without body");
+    }
+
+    // Bodies stream through both ways, Content-Length and chunked
+    {
+        std::string body(1 << 20, '\0');
+        for (size_t i = 0; i < body.size(); ++i)
+            body[i] = static_cast<char>('a' + i % 26);
+
+        Reply reply = request(PROXY_PORT, "POST /echo HTTP/1.1\r\nHost: x\r\nContent-Length: " +
+                                              std::to_string(body.size()) + "\r\n\r\n" + body);
+        check(reply.code == 200 && reply.body == body, "large body echoed through the proxy");
+
+        reply = request(PROXY_PORT,
+                        "POST /echo HTTP/1.1\r\nHost: x\r\nTransfer-Encoding: chunked\r\n\r\n"
+                        "5\r\nhello\r\n6\r\n world\r\n0\r\n\r\n");
+        check(reply.code == 200 && reply.body == "hello world", "chunked body echoed through the proxy");
+    }
+
+    // Consistent hash: one key always lands on the same upstream
+    {
+        bool stable = true;
+        std::string seen[4];
+        for (int round = 0; round < 3; ++round)
+            for (int user = 0; user < 4; ++user)
+            {
+                Reply reply = request(HASH_PROXY_PORT, "GET / HTTP/1.1\r\nHost: x\r\nX-User: user" + std::to_string(user) + "\r\n\r\n");
+                if (round == 0)
+                    seen[user] = reply.body;
+                stable = stable && reply.code == 200 && reply.body == seen[user];
+            }
+        check(stable, "hash key sticks to one upstream");
+    }
+
+    // Nothing listening upstream: 502, then the upstream is marked down
+    {
+        for (int i = 0; i < 3; ++i)
+            check(request(DEAD_PROXY_PORT, "GET / HTTP/1.1\r\nHost: x\r\n\r\n").code == 502, "dead upstream answered with 502");
+        check(!dead_proxy.get_upstream(0).is_healthy(), "dead upstream marked down");
+        check(request(DEAD_PROXY_PORT, "GET / HTTP/1.1\r\nHost: x\r\n\r\n").code == 502, "down upstream fails fast");
+        check(dead_proxy.get_upstream(0).get_connect_count() == 3, "no connect while down");
+    }
+
+    // Requests waiting on a slow upstream hold no worker: all reach it at once
+    {
+        std::vector<Reply> replies(4);
+        std::vector<std::thread> clients;
+        for (auto &reply : replies)
+            clients.emplace_back([&reply] { reply = request(CONCURRENT_PROXY_PORT, "GET / HTTP/1.1\r\nHost: x\r\n\r\n"); });
+        check(wait_for([&] { return slow_entered.load() == 4; }), "slow requests forwarded concurrently by one worker");
+
+        slow_release.store(true);
+        for (auto &t : clients)
+            t.join();
+        bool all = true;
+        for (auto &reply : replies)
+            all = all && reply.code == 200 && reply.body == "slow";
+        check(all, "slow requests all answered");
+    }
+
+    // max_exchanges refuses what is over the limit at once
+    {
+        slow_entered.store(0);
+        slow_release.store(false);
+        Reply held;
+        std::thread first([&] { held = request(LIMITED_PROXY_PORT, "GET / HTTP/1.1\r\nHost: x\r\n\r\n"); });
+        wait_for([&] { return slow_entered.load() == 1; });
+        check(limited_proxy.get_exchange_count() == 1, "held request counted");
+
+        auto start = std::chrono::steady_clock::now();
+        Reply refused = request(LIMITED_PROXY_PORT, "GET / HTTP/1.1\r\nHost: x\r\n\r\n");
+        check(refused.code == 503, "request over max_exchanges answered with 503");
+        check(std::chrono::steady_clock::now() - start < std::chrono::seconds(1), "refusal does not wait for the upstream");
+
+        slow_release.store(true);
+        first.join();
+        check(held.code == 200 && held.body == "slow", "held request completes");
+        check(wait_for([&] { return limited_proxy.get_exchange_count() == 0; }), "exchange slot released");
+        check(request(LIMITED_PROXY_PORT, "GET / HTTP/1.1\r\nHost: x\r\n\r\n").code == 200, "proxy accepts again once the slot is free");
+    }
+
+    // Least connections: with one upstream busy, requests go to the other
+    {
+        slow_entered.store(0);
+        slow_release.store(false);
+        Reply held;
+        std::thread first([&] { held = request(LEAST_PROXY_PORT, "GET / HTTP/1.1\r\nHost: x\r\n\r\n"); });
+        check(wait_for([&] { return slow_entered.load() == 1; }), "first request on the first upstream");
+
+        for (int i = 0; i < 2; ++i)
+        {
+            Reply reply = request(LEAST_PROXY_PORT, "GET / HTTP/1.1\r\nHost: x\r\n\r\n");
+            check(reply.code == 200 && reply.body == "a", "least loaded upstream chosen");
+        }
+
+        slow_release.store(true);
+        first.join();
+        check(held.code == 200 && held.body == "slow", "busy upstream's request completes");
+    }
+
+    // An upstream silent past response_timeout: 504
+    {
+        auto start = std::chrono::steady_clock::now();
+        check(request(TIMEOUT_PROXY_PORT, "GET / HTTP/1.1\r\nHost: x\r\n\r\n").code == 504, "silent upstream answered with 504");
+        check(std::chrono::steady_clock::now() - start < std::chrono::seconds(2), "timeout honoured");
+    }
+
+    running.store(false);
+    for (auto &t : loops)
+        t.join();
+    close(silent_fd);
+
+    if (failures == 0)
+        std::cout << "Test passed.\n";
+    else
+        std::cout << "Test failed.\n";
+
+    return failures == 0 ? 0 : 1;
+}
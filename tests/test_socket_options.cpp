@@ -0,0 +1,199 @@
+#include <server/tcp_server.hpp>
+#include <socket/socket_options.hpp>
+
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <atomic>
+#include <iostream>
+
+constexpr uint16_t PORT = 18083;
+const std::string UNIX_PATH = "/tmp/ouc_server_test_options.sock";
+
+int failures = 0;
+
+void check(bool cond, const char *what)
+{
+    if (!cond)
+    {
+        std::cout << "FAILED: " << what << "\n";
+        ++failures;
+    }
+}
+
+int get_int(int fd, int level, int name)
+{
+    int value = -1;
+    socklen_t len = sizeof(value);
+    getsockopt(fd, level, name, &value, &len);
+    return value;
+}
+
+/// Send a message on a connected fd and return what comes back, empty on failure.
+std::string round_trip(int fd, const std::string &msg)
+{
+    send(fd, msg.data(), msg.size(), MSG_NOSIGNAL);
+    std::string res;
+    char buf[256];
+    while (res.size() < msg.size())
+    {
+        ssize_t n = recv(fd, buf, sizeof(buf), 0);
+        if (n <= 0)
+            break;
+        res.append(buf, n);
+    }
+    close(fd);
+    return res;
+}
+
+int connect_ipv6()
+{
+    int fd = socket(AF_INET6, SOCK_STREAM, 0);
+    sockaddr_in6 addr{};
+    addr.sin6_family = AF_INET6;
+    addr.sin6_port = htons(PORT);
+    inet_pton(AF_INET6, "::1", &addr.sin6_addr);
+    if (connect(fd, (sockaddr *)&addr, sizeof(addr)) < 0)
+    {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int connect_unix()
+{
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    std::strcpy(addr.sun_path, UNIX_PATH.c_str());
+    if (connect(fd, (sockaddr *)&addr, sizeof(addr)) < 0)
+    {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/// Echo server that records the options seen on its accepted sockets.
+struct EchoServer
+{
+    ouc_server::server::TCPServer server{2};
+    std::atomic<int> nodelay{-1};
+    std::atomic<int> keepalive{-1};
+    std::atomic<bool> running{true};
+    std::thread thread;
+
+    explicit EchoServer(const ouc_server::ouc_socket::SocketOptions &options)
+    {
+        using ouc_server::ouc_socket::TCPSocket;
+        server.set_socket_options(options);
+        server.on_connection(
+            [this](TCPSocket &client)
+            {
+                nodelay.store(get_int(client.get_fd(), IPPROTO_TCP, TCP_NODELAY));
+                keepalive.store(get_int(client.get_fd(), SOL_SOCKET, SO_KEEPALIVE));
+            });
+        server.on_message(
+            [this](TCPSocket &client, const std::string &msg)
+            { server.send(client, msg); });
+    }
+
+    void run()
+    {
+        thread = std::thread(
+            [this]()
+            {
+                while (running.load())
+                    server.loop(10);
+            });
+    }
+
+    ~EchoServer()
+    {
+        running.store(false);
+        if (thread.joinable())
+            thread.join();
+    }
+};
+
+int main()
+{
+    using namespace ouc_server::ouc_socket;
+
+    check(TCPSocket::family_of("127.0.0.1") == AF_INET, "IPv4 address");
+    check(TCPSocket::family_of("::") == AF_INET6, "IPv6 address");
+    check(TCPSocket::family_of("[::1]") == AF_INET6, "bracketed IPv6 address");
+    check(TCPSocket::family_of("unix:/tmp/a.sock") == AF_UNIX, "unix: prefix");
+    check(TCPSocket::family_of("/tmp/a.sock") == AF_UNIX, "absolute path");
+
+    SocketOptions options;
+    options.tcp_nodelay().keepalive(30, 5, 3).send_buffer(64 * 1024);
+
+    // Options applied to a plain socket
+    {
+        TCPSocket sock = TCPSocket::create();
+        check(options.apply(sock.get_fd()), "apply succeeds");
+        check(get_int(sock.get_fd(), IPPROTO_TCP, TCP_NODELAY) == 1, "TCP_NODELAY set");
+        check(get_int(sock.get_fd(), IPPROTO_TCP, TCP_KEEPIDLE) == 30, "TCP_KEEPIDLE set");
+        check(get_int(sock.get_fd(), SOL_SOCKET, SO_SNDBUF) >= 64 * 1024, "SO_SNDBUF set");
+    }
+
+    // IPv6 loopback, skipped where the kernel has no IPv6
+    {
+        TCPSocket probe = TCPSocket::create(AF_INET6);
+        bool has_ipv6 = probe.get_fd() >= 0 && probe.bind("::1", 0);
+        probe.close();
+
+        if (has_ipv6)
+        {
+            EchoServer echo(options);
+            check(echo.server.start("[::1]", PORT), "IPv6 server starts");
+            echo.run();
+
+            int fd = connect_ipv6();
+            check(fd >= 0, "IPv6 connect");
+            if (fd >= 0)
+                check(round_trip(fd, "six") == "six", "IPv6 echo");
+            check(echo.nodelay.load() == 1, "accepted socket has TCP_NODELAY");
+            check(echo.keepalive.load() == 1, "accepted socket has SO_KEEPALIVE");
+        }
+        else
+            std::cout << "IPv6 unavailable, skipped.\n";
+    }
+
+    // Unix-domain socket, a stale file from an earlier run is replaced
+    {
+        int stale = socket(AF_UNIX, SOCK_STREAM, 0);
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        std::strcpy(addr.sun_path, UNIX_PATH.c_str());
+        unlink(UNIX_PATH.c_str());
+        bind(stale, (sockaddr *)&addr, sizeof(addr));
+        close(stale);
+
+        EchoServer echo(options);
+        check(echo.server.start("unix:" + UNIX_PATH, 0), "unix server starts over a stale file");
+        echo.run();
+
+        int fd = connect_unix();
+        check(fd >= 0, "unix connect");
+        if (fd >= 0)
+            check(round_trip(fd, "local") == "local", "unix echo");
+        check(echo.nodelay.load() == -1, "TCP options skipped on unix sockets");
+    }
+    unlink(UNIX_PATH.c_str());
+
+    if (failures == 0)
+        std::cout << "Test passed.\n";
+    else
+        std::cout << "Test failed.\n";
+
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,165 @@
+#include <server/tcp_server.hpp>
+#include <client/tcp_client.hpp>
+#include <client/upstream_pool.hpp>
+
+#include <string>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <iostream>
+
+constexpr uint16_t PORT = 18088;
+constexpr uint16_t CLOSED_PORT = 18089;
+
+using ouc_server::client::TCPClient;
+using ouc_server::client::UpstreamPool;
+using ouc_server::client::UpstreamPoolConfig;
+
+int failures = 0;
+
+void check(bool cond, const char *what)
+{
+    if (!cond)
+    {
+        std::cout << "FAILED: " << what << "\n";
+        ++failures;
+    }
+}
+
+template <typename T>
+bool ready(std::future<T> &f)
+{
+    return f.wait_for(std::chrono::seconds(2)) == std::future_status::ready;
+}
+
+/// Write a line and collect the echo.
+std::string round_trip(const std::shared_ptr<TCPClient> &client, const std::string &line)
+{
+    std::promise<std::string> reply;
+    auto got = reply.get_future();
+    client->write(std::string(line));
+    client->read([&](std::string_view data) { reply.set_value(std::string(data)); });
+    return ready(got) ? got.get() : std::string();
+}
+
+int main()
+{
+    using namespace std::chrono;
+
+    ouc_server::server::TCPServer server(ouc_server::server::TCPServerConfig::with_threads(1, 1));
+    server.on_message([&](ouc_server::ouc_socket::TCPSocket &sock, const std::string &msg) { server.send(sock, msg); });
+    if (!server.start("127.0.0.1", PORT))
+    {
+        std::cerr << "Failed to start server\n";
+        return 1;
+    }
+
+    ouc_server::epoll::EpollLoop loop(1);
+    std::atomic<bool> running{true};
+    std::thread server_thread(
+        [&]()
+        {
+            while (running.load())
+                server.loop(10);
+        });
+    std::thread client_thread(
+        [&]()
+        {
+            while (running.load())
+                loop.poll(10);
+        });
+
+    // Connect, write, read
+    {
+        std::promise<std::shared_ptr<TCPClient>> connected;
+        auto f = connected.get_future();
+        TCPClient::connect(loop, "127.0.0.1", PORT, milliseconds(1000),
+                           [&](std::shared_ptr<TCPClient> client, int) { connected.set_value(client); });
+        check(ready(f), "connect completes");
+        auto client = f.get();
+        check(client && client->is_open(), "connected");
+        if (client)
+        {
+            check(round_trip(client, "hello") == "hello", "echo");
+            check(client->get_pending_bytes() == 0, "outbox drained");
+            check(client->is_reusable(), "idle connection reusable");
+            client->close();
+            check(!client->is_open() && !client->is_reusable(), "closed");
+        }
+    }
+
+    // Nobody listening
+    {
+        std::promise<int> result;
+        auto f = result.get_future();
+        TCPClient::connect(loop, "127.0.0.1", CLOSED_PORT, milliseconds(1000),
+                           [&](std::shared_ptr<TCPClient> client, int err) { result.set_value(client ? 0 : err); });
+        check(ready(f) && f.get() == ECONNREFUSED, "refused connect reports ECONNREFUSED");
+    }
+
+    // Pool: the released connection is handed out again
+    {
+        UpstreamPool pool(loop, "127.0.0.1", PORT);
+        std::shared_ptr<TCPClient> first, second;
+        {
+            std::promise<std::shared_ptr<TCPClient>> p;
+            auto f = p.get_future();
+            pool.acquire([&](std::shared_ptr<TCPClient> c) { p.set_value(c); });
+            first = ready(f) ? f.get() : nullptr;
+        }
+        check(first != nullptr, "pool connects");
+        check(pool.get_active_count() == 1, "one active");
+        if (first)
+            check(round_trip(first, "pooled") == "pooled", "pooled echo");
+        pool.release(first);
+        check(pool.get_idle_count() == 1 && pool.get_active_count() == 0, "parked");
+        {
+            std::promise<std::shared_ptr<TCPClient>> p;
+            auto f = p.get_future();
+            pool.acquire([&](std::shared_ptr<TCPClient> c) { p.set_value(c); });
+            second = ready(f) ? f.get() : nullptr;
+        }
+        check(second == first, "keep-alive reuse");
+        check(pool.get_connect_count() == 1, "single connect");
+        pool.release(second, false);
+        check(pool.get_idle_count() == 0, "unclean release closes");
+    }
+
+    // Pool: failures mark the upstream down, then acquire fails at once
+    {
+        UpstreamPoolConfig config;
+        config.max_failures = 2;
+        config.down_time = milliseconds(200);
+        UpstreamPool pool(loop, "127.0.0.1", CLOSED_PORT, config);
+        for (int i = 0; i < 2; ++i)
+        {
+            std::promise<bool> p;
+            auto f = p.get_future();
+            pool.acquire([&](std::shared_ptr<TCPClient> c) { p.set_value(c != nullptr); });
+            check(ready(f) && !f.get(), "refused acquire fails");
+        }
+        check(!pool.is_healthy(), "marked down");
+        check(pool.get_active_count() == 0, "failed connects not active");
+
+        std::promise<bool> p;
+        auto f = p.get_future();
+        pool.acquire([&](std::shared_ptr<TCPClient> c) { p.set_value(c != nullptr); });
+        check(f.wait_for(milliseconds(0)) == std::future_status::ready && !f.get(), "down upstream fails fast");
+        check(pool.get_connect_count() == 2, "no connect while down");
+
+        std::this_thread::sleep_for(milliseconds(250));
+        check(pool.is_healthy(), "probe allowed after down_time");
+    }
+
+    running.store(false);
+    server_thread.join();
+    client_thread.join();
+
+    if (failures == 0)
+        std::cout << "Test passed.\n";
+    else
+        std::cout << "Test failed.\n";
+
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,132 @@
+#include <server/tcp_server.hpp>
+
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <string>
+#include <thread>
+#include <atomic>
+#include <iostream>
+
+constexpr uint16_t PORT = 18084;
+constexpr size_t BIG = 4 * 1024 * 1024;
+
+int failures = 0;
+
+void check(bool cond, const char *what)
+{
+    if (!cond)
+    {
+        std::cout << "FAILED: " << what << "\n";
+        ++failures;
+    }
+}
+
+std::string pattern(size_t len)
+{
+    std::string s(len, '\0');
+    for (size_t i = 0; i < len; ++i)
+        s[i] = static_cast<char>('a' + i % 26);
+    return s;
+}
+
+/// Read exactly len bytes, fewer if the peer closes.
+std::string read_exactly(int fd, size_t len)
+{
+    std::string res;
+    char buf[65536];
+    while (res.size() < len)
+    {
+        ssize_t n = recv(fd, buf, std::min(sizeof(buf), len - res.size()), 0);
+        if (n <= 0)
+            break;
+        res.append(buf, n);
+    }
+    return res;
+}
+
+int connect_server()
+{
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(PORT);
+    inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+    if (connect(fd, (sockaddr *)&addr, sizeof(addr)) < 0)
+    {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int main()
+{
+    using namespace ouc_server::server;
+    using namespace ouc_server::ouc_socket;
+
+    // String overloads send the whole string, not sizeof(pointer) bytes
+    {
+        int fds[2];
+        socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, fds);
+        TCPSocket a(fds[0]);
+
+        const char *text = "a string longer than a pointer";
+        check(a.send(text) == static_cast<ssize_t>(std::string(text).size()), "send(const char*) length");
+        std::string str = "and a std::string one too";
+        check(a.send(str) == static_cast<ssize_t>(str.size()), "send(std::string) length");
+        check(read_exactly(fds[1], std::string(text).size() + str.size()) == std::string(text) + str, "bytes received");
+        close(fds[1]);
+    }
+
+    TCPServer server(2);
+    server.set_zerocopy_threshold(16 * 1024);
+    const std::string body = pattern(BIG);
+    server.on_message(
+        [&](TCPSocket &client, const std::string &msg)
+        {
+            // Header corked until the body follows
+            server.send(client, "HEAD" + msg, true);
+            server.send(client, body);
+        });
+
+    if (!server.start("127.0.0.1", PORT))
+    {
+        std::cerr << "Failed to start server\n";
+        return 1;
+    }
+
+    std::atomic<bool> running{true};
+    std::thread loop(
+        [&]()
+        {
+            while (running.load())
+                server.loop(10);
+        });
+
+    int fd = connect_server();
+    check(fd >= 0, "connect");
+    for (int round = 0; round < 3 && fd >= 0; ++round)
+    {
+        send(fd, "!", 1, MSG_NOSIGNAL);
+        check(read_exactly(fd, 5) == "HEAD!", "corked header");
+        check(read_exactly(fd, BIG) == body, "large body intact");
+    }
+    if (fd >= 0)
+        close(fd);
+
+    const auto &metrics = server.get_metrics();
+    check(metrics.bytes_out.value() == 3 * (5 + BIG), "bytes_out counted");
+    std::cout << "zero-copy bytes: " << metrics.bytes_zerocopy.value() << "\n";
+
+    running.store(false);
+    loop.join();
+
+    if (failures == 0)
+        std::cout << "Test passed.\n";
+    else
+        std::cout << "Test failed.\n";
+
+    return failures == 0 ? 0 : 1;
+}
@@ -44,9 +44,7 @@ int main()
         [](TCPSocket &client)
         { std::cout << "Client disconnected, fd=" << client.get_fd() << "\n"; });
 
+    // Block in epoll_wait instead of sleeping between polls
     while (true)
-    {
-        server.loop();
-        std::this_thread::sleep_for(std::chrono::milliseconds(50));
-    }
+        server.loop(50);
 }
@@ -1,21 +1,120 @@
 #include <utils/thread_pool.hpp>
+#include <utils/cpu_affinity.hpp>
+
+#include <sched.h>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+int failures = 0;
+
+void check(bool cond, const char *what)
+{
+    if (!cond)
+    {
+        std::cout << "FAILED: " << what << "\n";
+        ++failures;
+    }
+}
 
 int main()
 {
     using namespace ouc_server::utils;
-    ThreadPool pool(4);
 
-    auto f1 = pool.sumbit(
-        []()
-        { puts("Hello world from thread pool!"); });
+    {
+        ThreadPool pool(4);
+        auto sum = pool.sumbit(
+            [](int a, int b)
+            {
+                return a + b;
+            },
+            1, 2);
+        check(sum.get() == 3, "task result");
+    }
+
+    check(default_thread_count() >= 1, "default thread count");
+    check(ThreadPool(0).get_thread_count() == default_thread_count(), "zero means one per CPU");
 
-    auto f2 = pool.sumbit(
-        [](int a, int b)
+    // Workers pinned round-robin over the allowed CPUs run there
+    std::vector<int> cpus = allowed_cpus();
+    check(!cpus.empty(), "allowed cpus");
+    if (cpus.empty())
+    {
+        std::cout << "Test failed.\n";
+        return 1;
+    }
+    {
+        ThreadPool pool(2 * cpus.size(), cpus);
+        for (size_t i = 0; i < pool.get_thread_count(); ++i)
         {
-            return a + b;
-        },
-        1, 2);
+            int expected = cpus[i % cpus.size()];
+            check(pool.get_worker_cpu(i) == expected, "worker cpu assignment");
+            check(pool.sumbit_to(static_cast<int>(i), []()
+                                 { return sched_getcpu(); })
+                          .get() == expected,
+                  "bound task runs on its worker's cpu");
+        }
+        check(pool.find_worker(cpus[0]) == 0, "find worker by cpu");
+        check(pool.find_worker(-1) == -1, "no worker for unknown cpu");
+    }
+
+    // Tasks bound to one worker all run on the same thread
+    {
+        ThreadPool pool(4);
+        std::vector<std::future<std::thread::id>> ids;
+        for (int i = 0; i < 32; ++i)
+            ids.push_back(pool.sumbit_to(2, []()
+                                         { return std::this_thread::get_id(); }));
+        std::thread::id first = ids[0].get();
+        bool same = true;
+        for (size_t i = 1; i < ids.size(); ++i)
+            same = same && ids[i].get() == first;
+        check(same, "bound tasks share one worker");
+    }
+
+    // Each CPU with a known node is listed among that node's CPUs
+    for (int cpu : cpus)
+    {
+        int node = numa_node_of(cpu);
+        if (node < 0)
+            continue;
+        std::vector<int> node_cpus = cpus_of_node(node);
+        check(std::find(node_cpus.begin(), node_cpus.end(), cpu) != node_cpus.end(), "cpu listed in its numa node");
+    }
+    check(numa_node_of(-1) == -1, "no numa node for an invalid cpu");
+
+    // Overload: a standing queue for longer than the interval, cleared once it drains
+    {
+        using namespace std::chrono;
+        ThreadPool pool(1);
+        pool.set_overload_target(milliseconds(1), milliseconds(10));
+
+        std::vector<std::future<nanoseconds>> waits;
+        for (int i = 0; i < 8; ++i)
+            waits.push_back(pool.sumbit(
+                []()
+                {
+                    std::this_thread::sleep_for(milliseconds(5));
+                    return ThreadPool::current_task_wait();
+                }));
+        nanoseconds last_wait{0};
+        for (auto &w : waits)
+            last_wait = w.get();
+        check(last_wait > milliseconds(20), "task sees its own queue wait");
+        check(pool.is_overloaded(), "standing queue detected");
+        check(pool.get_sojourn() > milliseconds(1), "sojourn exposed");
+
+        pool.sumbit([]() {}).get();
+        check(!pool.is_overloaded(), "overload cleared once the queue drained");
+        check(ThreadPool::current_task_wait() == nanoseconds(0), "no wait outside a worker");
+    }
+
+    if (failures == 0)
+        std::cout << "Test passed.\n";
+    else
+        std::cout << "Test failed.\n";
 
-    f1.get();
-    printf("f2 result: %d\n", f2.get());
-}
\ No newline at end of file
+    return failures == 0 ? 0 : 1;
+}
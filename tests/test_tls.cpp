@@ -0,0 +1,251 @@
+#include <server/http_server.hpp>
+#include <socket/tls.hpp>
+
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+
+#ifdef OUC_SERVER_TLS
+#include <openssl/ssl.h>
+#include <openssl/x509.h>
+#include <openssl/pem.h>
+#include <openssl/evp.h>
+#endif
+
+constexpr uint16_t PORT = 18099;
+constexpr uint16_t SECOND_PORT = 18100;
+
+int failures = 0;
+
+void check(bool cond, const char *what)
+{
+    if (!cond)
+    {
+        std::cout << "FAILED: " << what << "\n";
+        ++failures;
+    }
+}
+
+#ifdef OUC_SERVER_TLS
+/// Write a self-signed P-256 certificate for localhost and its key.
+bool make_certificate(const std::string &cert_file, const std::string &key_file)
+{
+    EVP_PKEY *key = EVP_EC_gen("P-256");
+    X509 *cert = X509_new();
+    if (key == nullptr || cert == nullptr)
+        return false;
+
+    ASN1_INTEGER_set(X509_get_serialNumber(cert), 1);
+    X509_gmtime_adj(X509_getm_notBefore(cert), 0);
+    X509_gmtime_adj(X509_getm_notAfter(cert), 3600);
+    X509_set_pubkey(cert, key);
+    X509_NAME *name = X509_get_subject_name(cert);
+    X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC, reinterpret_cast<const unsigned char *>("localhost"), -1, -1, 0);
+    X509_set_issuer_name(cert, name);
+    bool ok = X509_sign(cert, key, EVP_sha256()) > 0;
+
+    FILE *f = std::fopen(cert_file.c_str(), "w");
+    ok = ok && f && PEM_write_X509(f, cert);
+    if (f)
+        std::fclose(f);
+    f = std::fopen(key_file.c_str(), "w");
+    ok = ok && f && PEM_write_PrivateKey(f, key, nullptr, nullptr, 0, nullptr, nullptr);
+    if (f)
+        std::fclose(f);
+
+    X509_free(cert);
+    EVP_PKEY_free(key);
+    return ok;
+}
+
+int connect_to(uint16_t port)
+{
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    timeval tv{5, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+    if (connect(fd, (sockaddr *)&addr, sizeof(addr)) < 0)
+    {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+struct Result
+{
+    bool handshake = false;
+    bool resumed = false;
+    std::string response;
+};
+
+/// One HTTPS request; session is resumed if given and replaced by the new one.
+Result https_get(SSL_CTX *ctx, uint16_t port, const std::string &path, SSL_SESSION **session)
+{
+    Result result;
+    int fd = connect_to(port);
+    SSL *ssl = SSL_new(ctx);
+    SSL_set_fd(ssl, fd);
+    if (*session)
+        SSL_set_session(ssl, *session);
+
+    result.handshake = SSL_connect(ssl) == 1;
+    if (result.handshake)
+    {
+        result.resumed = SSL_session_reused(ssl) == 1;
+        std::string request = "GET " + path + " HTTP/1.1\r\nHost: localhost\r\nConnection: close\r\n\r\n";
+        SSL_write(ssl, request.data(), static_cast<int>(request.size()));
+
+        char buf[16384];
+        int n;
+        while ((n = SSL_read(ssl, buf, sizeof(buf))) > 0)
+            result.response.append(buf, n);
+
+        // Tickets arrive after the handshake: take the session once they were read
+        if (*session)
+            SSL_SESSION_free(*session);
+        *session = SSL_get1_session(ssl);
+
+        // Freed without close_notify, OpenSSL would mark the session not resumable
+        SSL_shutdown(ssl);
+    }
+
+    SSL_free(ssl);
+    close(fd);
+    return result;
+}
+#endif
+
+int main()
+{
+    using namespace ouc_server::server;
+    using namespace ouc_server::ouc_socket;
+    using namespace ouc_server::http;
+
+#ifndef OUC_SERVER_TLS
+    check(TLSContext::create("cert.pem", "key.pem") == nullptr, "no TLS without OpenSSL");
+#else
+    std::string prefix = "/tmp/ouc_test_tls_" + std::to_string(getpid());
+    std::string cert_file = prefix + "_cert.pem", key_file = prefix + "_key.pem";
+    check(make_certificate(cert_file, key_file), "self-signed certificate written");
+
+    auto context = TLSContext::create(cert_file, key_file);
+    check(context != nullptr, "context loads certificate and key");
+    check(TLSContext::create(cert_file, prefix + "_missing.pem") == nullptr, "missing key refused");
+    if (!context)
+    {
+        std::cout << "Test failed.\n";
+        return 1;
+    }
+
+    // A second server sharing only the ticket keys, as a restarted process would
+    auto second_context = TLSContext::create(cert_file, key_file);
+    std::string keys = context->get_ticket_keys();
+    check(keys.size() == TLSContext::TICKET_KEYS_SIZE, "ticket keys exported");
+    check(second_context && second_context->set_ticket_keys(keys), "ticket keys imported");
+    check(!context->set_ticket_keys("short"), "malformed ticket keys refused");
+
+    std::string big(1 << 20, 'x');
+    for (size_t i = 0; i < big.size(); i += 997)
+        big[i] = static_cast<char>('a' + i % 26);
+
+    HttpServer server(2), second(2);
+    server.tcp_server().set_tls(context);
+    second.tcp_server().set_tls(second_context);
+    for (HttpServer *s : {&server, &second})
+        s->on_request([&](HttpRequest &req, HttpResponseWriter &res)
+                      { res.end(req.path == "/big" ? big : std::string("hello over tls")); });
+
+    if (!server.start("127.0.0.1", PORT) || !second.start("127.0.0.1", SECOND_PORT))
+    {
+        std::cerr << "Failed to start server\n";
+        return 1;
+    }
+
+    std::atomic<bool> running{true};
+    std::thread loop_thread(
+        [&]()
+        {
+            while (running.load())
+            {
+                server.loop(5);
+                second.loop(5);
+            }
+        });
+
+    SSL_CTX *client_ctx = SSL_CTX_new(TLS_client_method());
+    SSL_CTX_set_verify(client_ctx, SSL_VERIFY_NONE, nullptr);
+    SSL_CTX_set_session_cache_mode(client_ctx, SSL_SESS_CACHE_CLIENT);
+    SSL_SESSION *session = nullptr;
+
+    // Full handshake, then a request
+    {
+        Result r = https_get(client_ctx, PORT, "/", &session);
+        check(r.handshake && !r.resumed, "full handshake");
+        check(r.response.find("200") != std::string::npos &&
+                  r.response.size() >= 14 && r.response.compare(r.response.size() - 14, 14, "hello over tls") == 0,
+              "response decrypted");
+    }
+
+    // Large body: written in pieces as the socket drains
+    {
+        SSL_SESSION *none = nullptr;
+        Result r = https_get(client_ctx, PORT, "/big", &none);
+        check(r.response.size() > big.size() && r.response.compare(r.response.size() - big.size(), big.size(), big) == 0,
+              "1 MiB body intact");
+        if (none)
+            SSL_SESSION_free(none);
+    }
+
+    // Resumption with the ticket, on the same server and on the one sharing its keys
+    {
+        Result r = https_get(client_ctx, PORT, "/", &session);
+        check(r.handshake && r.resumed, "session resumed");
+
+        Result other = https_get(client_ctx, SECOND_PORT, "/", &session);
+        check(other.handshake && other.resumed, "session resumed on a server sharing the ticket keys");
+    }
+
+    // Not TLS at all: the handshake fails and the connection is closed
+    {
+        int fd = connect_to(PORT);
+        std::string plain = "GET / HTTP/1.1\r\nHost: localhost\r\n\r\n";
+        send(fd, plain.data(), plain.size(), MSG_NOSIGNAL);
+        char buf[256];
+        ssize_t n;
+        while ((n = recv(fd, buf, sizeof(buf), 0)) > 0)
+            ;
+        check(n == 0 || errno != EAGAIN, "plain HTTP on the TLS port closed");
+        close(fd);
+    }
+
+    running.store(false);
+    loop_thread.join();
+
+    auto &metrics = server.tcp_server().get_metrics();
+    check(metrics.tls_handshakes.value() == 3, "three handshakes on the first server");
+    check(metrics.tls_resumed.value() == 1, "one of them resumed");
+    check(metrics.tls_failures.value() == 1, "one failed handshake");
+    std::cout << "kTLS connections: " << metrics.tls_ktls.value() << "\n";
+
+    SSL_SESSION_free(session);
+    SSL_CTX_free(client_ctx);
+    std::remove(cert_file.c_str());
+    std::remove(key_file.c_str());
+#endif
+
+    std::cout << (failures == 0 ? "Test passed.\n" : "Test failed.\n");
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,72 @@
+// Trace points are compiled in here regardless of the build option;
+// with it ON the library already defines the macro for us.
+#ifndef OUC_SERVER_TRACE
+#define OUC_SERVER_TRACE
+#endif
+#include <utils/trace.hpp>
+
+#include <thread>
+#include <vector>
+#include <string>
+#include <iostream>
+
+int failures = 0;
+
+void check(bool cond, const char *what)
+{
+    if (!cond)
+    {
+        std::cout << "FAILED: " << what << "\n";
+        ++failures;
+    }
+}
+
+size_t count_of(const std::string &text, const std::string &needle)
+{
+    size_t n = 0;
+    for (size_t pos = text.find(needle); pos != std::string::npos; pos = text.find(needle, pos + 1))
+        ++n;
+    return n;
+}
+
+int main()
+{
+    using namespace ouc_server::utils::trace;
+
+    // Every thread gets a ring of its own
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t)
+        threads.emplace_back(
+            [t]()
+            {
+                OUC_TRACE(HandlerBegin, 100 + t);
+                OUC_TRACE(HandlerEnd, 100 + t);
+            });
+    for (auto &t : threads)
+        t.join();
+
+    std::string json = dump_chrome_json();
+    check(json.rfind("{\"displayTimeUnit\"", 0) == 0 && json.find("]}") != std::string::npos, "json envelope");
+    check(count_of(json, "\"name\":\"on_message\",\"ph\":\"B\"") == 4, "one begin per thread");
+    check(count_of(json, "\"name\":\"on_message\",\"ph\":\"E\"") == 4, "one end per thread");
+    check(json.find("\"args\":{\"fd\":103}") != std::string::npos, "fd recorded");
+
+    // A full ring keeps only the newest records
+    clear();
+    for (size_t i = 0; i < TRACE_RING_SIZE + 10; ++i)
+        OUC_TRACE(Dispatch, static_cast<int>(i));
+    json = dump_chrome_json();
+    check(count_of(json, "\"name\":\"dispatch\"") == TRACE_RING_SIZE, "ring bounded");
+    check(json.find("\"fd\":9}") == std::string::npos, "oldest records overwritten");
+    check(json.find("\"fd\":" + std::to_string(TRACE_RING_SIZE + 9) + "}") != std::string::npos, "newest record kept");
+
+    // Instants are thread-scoped
+    check(json.find("\"ph\":\"i\",\"s\":\"t\"") != std::string::npos, "instant scope");
+
+    if (failures == 0)
+        std::cout << "Test passed.\n";
+    else
+        std::cout << "Test failed.\n";
+
+    return failures == 0 ? 0 : 1;
+}
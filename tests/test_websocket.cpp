@@ -0,0 +1,334 @@
+#include <websocket/websocket_server.hpp>
+#include <websocket/websocket_handshake.hpp>
+
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <string>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+
+constexpr uint16_t PORT = 18096;
+
+int failures = 0;
+
+void check(bool cond, const char *what)
+{
+    if (!cond)
+    {
+        std::cout << "FAILED: " << what << "\n";
+        ++failures;
+    }
+}
+
+using ouc_server::websocket::Opcode;
+
+/// A frame as clients send them: masked.
+std::string client_frame(Opcode opcode, std::string_view payload, bool fin = true, bool masked = true)
+{
+    std::string frame = ouc_server::websocket::encode_frame(opcode, payload, fin);
+    if (!masked)
+        return frame;
+
+    size_t header = frame.size() - payload.size();
+    const uint8_t key[4] = {0x37, 0xfa, 0x21, 0x3d};
+    frame[1] = static_cast<char>(frame[1] | 0x80);
+    frame.insert(header, reinterpret_cast<const char *>(key), 4);
+    for (size_t i = 0; i < payload.size(); ++i)
+        frame[header + 4 + i] = static_cast<char>(payload[i] ^ key[i % 4]);
+    return frame;
+}
+
+struct Client
+{
+    int fd = -1;
+    std::string buffer;
+
+    bool connect_and_upgrade(const std::string &path = "/chat")
+    {
+        fd = socket(AF_INET, SOCK_STREAM, 0);
+        timeval tv{2, 0};
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(PORT);
+        inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+        if (connect(fd, (sockaddr *)&addr, sizeof(addr)) < 0)
+            return false;
+
+        send_all("GET " + path + " HTTP/1.1\r\nHost: localhost\r\nUpgrade: websocket\r\nConnection: keep-alive, Upgrade\r\n"
+                 "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\nSec-WebSocket-Version: 13\r\n\r\n");
+        std::string head = read_head();
+        return head.find("101 Switching Protocols") != std::string::npos &&
+               head.find("Sec-WebSocket-Accept: s3pPLMBiTxaQ9kYGzzhZRbK+xOo=") != std::string::npos;
+    }
+
+    void send_all(const std::string &data)
+    {
+        size_t sent = 0;
+        while (sent < data.size())
+        {
+            ssize_t n = ::send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+            if (n <= 0)
+                return;
+            sent += n;
+        }
+    }
+
+    bool fill()
+    {
+        char buf[4096];
+        ssize_t n = recv(fd, buf, sizeof(buf), 0);
+        if (n <= 0)
+            return false;
+        buffer.append(buf, n);
+        return true;
+    }
+
+    std::string read_head()
+    {
+        size_t end;
+        while ((end = buffer.find("\r\n\r\n")) == std::string::npos)
+            if (!fill())
+                return buffer;
+        std::string head = buffer.substr(0, end + 4);
+        buffer.erase(0, end + 4);
+        return head;
+    }
+
+    /// Next server frame, false once the connection ends.
+    bool read_frame(Opcode &opcode, std::string &payload)
+    {
+        while (buffer.size() < 2)
+            if (!fill())
+                return false;
+        size_t len = uint8_t(buffer[1]) & 0x7F, header = 2;
+        if (len == 126)
+        {
+            while (buffer.size() < 4)
+                if (!fill())
+                    return false;
+            len = (size_t(uint8_t(buffer[2])) << 8) | uint8_t(buffer[3]);
+            header = 4;
+        }
+        while (buffer.size() < header + len)
+            if (!fill())
+                return false;
+        opcode = static_cast<Opcode>(buffer[0] & 0x0F);
+        payload = buffer.substr(header, len);
+        buffer.erase(0, header + len);
+        return true;
+    }
+
+    ~Client()
+    {
+        if (fd >= 0)
+            close(fd);
+    }
+};
+
+int main()
+{
+    using namespace ouc_server::websocket;
+
+    // RFC 6455 1.3 example
+    check(accept_key("dGhlIHNhbXBsZSBub25jZQ==") == "s3pPLMBiTxaQ9kYGzzhZRbK+xOo=", "accept key matches the RFC example");
+
+    // Vector paths agree with byte-at-a-time XOR at every length and key phase
+    {
+        const uint8_t key[4] = {0x12, 0x34, 0x56, 0x78};
+        bool same = true;
+        for (size_t len = 0; len < 100 && same; ++len)
+            for (uint64_t offset = 0; offset < 4 && same; ++offset)
+            {
+                std::string src(len, 0), dst(len, 0);
+                for (size_t i = 0; i < len; ++i)
+                    src[i] = static_cast<char>(i * 7 + 3);
+                unmask(dst.data(), src.data(), len, key, offset);
+                for (size_t i = 0; i < len; ++i)
+                    if (dst[i] != static_cast<char>(src[i] ^ key[(offset + i) % 4]))
+                        same = false;
+            }
+        check(same, "unmask matches scalar XOR");
+    }
+
+    // UTF-8 validation
+    {
+        check(is_valid_utf8("plain ascii text, long enough for words"), "ascii is valid");
+        check(is_valid_utf8("caf\xc3\xa9 \xe2\x82\xac \xf0\x9f\x98\x80"), "multi-byte sequences are valid");
+        check(!is_valid_utf8("\xc0\xaf"), "overlong form rejected");
+        check(!is_valid_utf8("\xed\xa0\x80"), "surrogate rejected");
+        check(!is_valid_utf8("abc\xe2\x82"), "truncated sequence rejected");
+    }
+
+    // Parser: fragments fed byte by byte, with a ping between them
+    {
+        FrameParser parser;
+        std::string message;
+        int pings = 0;
+        parser.on_message([&](Opcode, std::string &data)
+                          { message = std::move(data); });
+        parser.on_control([&](Opcode opcode, std::string_view payload)
+                          { pings += opcode == Opcode::Ping && payload == "hb"; });
+
+        std::string stream = client_frame(Opcode::Text, "Hello, ", false) +
+                             client_frame(Opcode::Ping, "hb") +
+                             client_frame(Opcode::Continuation, std::string(300, 'w'));
+        bool ok = true;
+        for (char c : stream)
+            ok = ok && parser.feed(&c, 1);
+        check(ok && message == "Hello, " + std::string(300, 'w'), "fragmented message reassembled");
+        check(pings == 1, "interleaved ping delivered");
+    }
+
+    // Parser errors
+    {
+        FrameParser unmasked;
+        check(!unmasked.feed(client_frame(Opcode::Text, "x", true, false)) &&
+                  unmasked.get_error_code() == CLOSE_PROTOCOL_ERROR,
+              "unmasked client frame rejected");
+
+        FrameParser big(16);
+        check(!big.feed(client_frame(Opcode::Binary, std::string(17, 'b'))) && big.get_error_code() == CLOSE_TOO_BIG,
+              "oversized message rejected");
+
+        FrameParser text;
+        check(!text.feed(client_frame(Opcode::Text, "\xff")) && text.get_error_code() == CLOSE_INVALID_PAYLOAD,
+              "invalid UTF-8 text rejected");
+
+        FrameParser orphan;
+        check(!orphan.feed(client_frame(Opcode::Continuation, "x")), "continuation without a message rejected");
+
+        FrameParser control;
+        check(!control.feed(client_frame(Opcode::Ping, "x", false)), "fragmented control frame rejected");
+    }
+
+    WebSocketConfig config;
+    config.ping_interval = std::chrono::milliseconds(200);
+    config.pong_timeout = std::chrono::milliseconds(5000);
+    WebSocketServer server(config, 4);
+
+    std::atomic<int> opened{0}, closed{0};
+    std::atomic<uint16_t> last_code{0};
+    server.set_handshake_check([](const ouc_server::http::HttpRequest &req)
+                               { return req.path != "/forbidden"; });
+    server.on_open([&](ouc_server::ouc_socket::TCPSocket &, const ouc_server::http::HttpRequest &)
+                   { ++opened; });
+    server.on_message(
+        [&](ouc_server::ouc_socket::TCPSocket &client, std::string &data, bool binary)
+        {
+            if (data == "bye")
+                server.close(client, CLOSE_GOING_AWAY, "bye");
+            else
+                server.send(client, "echo:" + data, binary);
+        });
+    server.on_close([&](ouc_server::ouc_socket::TCPSocket &, uint16_t code)
+                    { last_code.store(code); ++closed; });
+
+    if (!server.start("127.0.0.1", PORT))
+    {
+        std::cerr << "Failed to start server\n";
+        return 1;
+    }
+
+    std::atomic<bool> running{true};
+    std::thread loop_thread(
+        [&]()
+        {
+            while (running.load())
+                server.loop(10);
+        });
+
+    // Echo of a fragmented masked message, sent together with the handshake's tail
+    {
+        Client client;
+        check(client.connect_and_upgrade(), "handshake accepted");
+        client.send_all(client_frame(Opcode::Binary, "ab", false) + client_frame(Opcode::Continuation, "cd"));
+
+        Opcode opcode;
+        std::string payload;
+        bool got = client.read_frame(opcode, payload);
+        while (got && opcode == Opcode::Ping)
+            got = client.read_frame(opcode, payload);
+        check(got && opcode == Opcode::Binary && payload == "echo:abcd", "fragmented message echoed");
+
+        client.send_all(client_frame(Opcode::Ping, "beat"));
+        got = client.read_frame(opcode, payload);
+        while (got && opcode == Opcode::Ping)
+            got = client.read_frame(opcode, payload);
+        check(got && opcode == Opcode::Pong && payload == "beat", "ping answered with pong");
+
+        // Keepalive pings arrive on their own
+        got = client.read_frame(opcode, payload);
+        check(got && opcode == Opcode::Ping, "server sends keepalive pings");
+
+        // Client-initiated close: echoed, then the connection ends
+        client.send_all(client_frame(Opcode::Close, std::string("\x03\xe8", 2)));
+        got = client.read_frame(opcode, payload);
+        while (got && opcode == Opcode::Ping)
+            got = client.read_frame(opcode, payload);
+        check(got && opcode == Opcode::Close && payload == std::string("\x03\xe8", 2), "close frame echoed");
+        check(!client.fill(), "connection closed after the close handshake");
+    }
+
+    // Broadcast reaches every open connection
+    {
+        Client a, b;
+        check(a.connect_and_upgrade() && b.connect_and_upgrade(), "two clients connected");
+        for (int i = 0; i < 100 && server.get_connection_count() < 2; ++i)
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        check(server.broadcast("news") == 2, "broadcast queued on both");
+
+        for (Client *c : {&a, &b})
+        {
+            Opcode opcode;
+            std::string payload;
+            bool got = c->read_frame(opcode, payload);
+            while (got && opcode == Opcode::Ping)
+                got = c->read_frame(opcode, payload);
+            check(got && opcode == Opcode::Text && payload == "news", "broadcast received");
+        }
+
+        // Server-initiated close
+        a.send_all(client_frame(Opcode::Text, "bye"));
+        Opcode opcode;
+        std::string payload;
+        bool got = a.read_frame(opcode, payload);
+        while (got && opcode == Opcode::Ping)
+            got = a.read_frame(opcode, payload);
+        check(got && opcode == Opcode::Close && payload.substr(0, 2) == std::string("\x03\xe9", 2), "server close carries its code");
+    }
+
+    // Refused handshakes
+    {
+        Client forbidden;
+        check(!forbidden.connect_and_upgrade("/forbidden"), "handshake check refuses");
+
+        Client plain;
+        plain.fd = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(PORT);
+        inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+        connect(plain.fd, (sockaddr *)&addr, sizeof(addr));
+        plain.send_all("GET / HTTP/1.1\r\nHost: localhost\r\n\r\n");
+        std::string head = plain.read_head();
+        check(head.find("426") != std::string::npos && head.find("Sec-WebSocket-Version: 13") != std::string::npos,
+              "plain request told to upgrade");
+    }
+
+    for (int i = 0; i < 100 && closed.load() < 3; ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    check(opened.load() == 3, "three handshakes completed");
+    check(closed.load() == 3, "three open connections closed");
+
+    running.store(false);
+    loop_thread.join();
+
+    std::cout << (failures == 0 ? "Test passed.\n" : "Test failed.\n");
+    return failures == 0 ? 0 : 1;
+}